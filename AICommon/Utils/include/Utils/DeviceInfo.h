@@ -13,6 +13,7 @@
 #ifndef __DEVICE_INFO_H_
 #define __DEVICE_INFO_H_
 #include <memory>
+#include <string>
 
 namespace aisdk {
 namespace utils {
@@ -13,6 +13,7 @@
  
 #ifndef _DIALOG_UXSTATE_RELAY_H_
 #define _DIALOG_UXSTATE_RELAY_H_
+#include <atomic>
 #include <memory>
 #include <unordered_set>
 
@@ -38,6 +39,9 @@ public:
      */
     DialogUXStateRelay();
 
+    /// Destructor.
+    ~DialogUXStateRelay();
+
     /**
      * Adds an observer to be notified of UX state changes.
      *
@@ -88,14 +92,17 @@ private:
 	/// An internal executor
 	threading::Executor m_executor;
 	
-    /// The current overall UX state.
-    dialogRelay::DialogUXStateObserverInterface::DialogUXState m_currentState;
+    /// The current overall UX state, atomic so that the @c IntrospectionServer can read it from its thread.
+    std::atomic<dialogRelay::DialogUXStateObserverInterface::DialogUXState> m_currentState;
 
     /// Contains the current state of the @c SoundAi as reported by @c SoundAiObserverInterface
     soundai::SoundAiObserverInterface::State m_soundAiState;
 
 	/// Contains the current state of the @c SpeechSynthesizer as reported by @c SpeechSynthesizerObserverInterface
     dmInterface::SpeechSynthesizerObserverInterface::SpeechSynthesizerState m_speechSynthesizerState;
+
+    /// The id of the section published to the @c IntrospectionServer.
+    size_t m_introspectionId;
 };
 
 }	// namespace dialogRelay
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef _INTROSPECTION_INTROSPECTION_SERVER_H_
+#define _INTROSPECTION_INTROSPECTION_SERVER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace aisdk {
+namespace utils {
+namespace introspection {
+
+/**
+ * A Unix domain socket server which lets a developer look at the live state of the SDK on a device.
+ *
+ * Components publish their state as sections: a category such as "executors", a name, and a provider returning the
+ * current state as a JSON value.  A client connects to the socket and sends one command per line; every command is
+ * answered with one line of JSON.  The commands are:
+ *
+ *   - @c status: every section, grouped by category, and the metrics.
+ *   - @c metrics: the metrics only.
+ *   - @c loglevel @c <LEVEL>: change the level of the log sink.
+ *   - @c trace @c start @c <file> and @c trace @c stop: control the @c TraceEventRecorder.
+ *   - @c help: the list of commands.
+ *
+ * The server runs on its own thread at the lowest scheduling priority.  Providers run on that thread, so they must
+ * read hot-path state only through atomics and never block on the locks of an audio or decoding path.  Sections can
+ * be registered whether or not the server is running.
+ */
+class IntrospectionServer {
+public:
+    /// A function returning the current state of a section as a JSON value.
+    using Provider = std::function<std::string()>;
+
+    /// The id returned by @c addSection(), for @c removeSection().
+    using SectionId = size_t;
+
+    /**
+     * Return the one and only @c IntrospectionServer instance.
+     *
+     * @return The one and only @c IntrospectionServer instance.
+     */
+    static IntrospectionServer& instance();
+
+    /// Destructor.  Stops the server, if running.
+    ~IntrospectionServer();
+
+    /**
+     * Publish the state of a component.
+     *
+     * @param category The category of the section, the key it is listed under by @c status.
+     * @param name The name of the component.
+     * @param provider The function returning the state of the component.  It must not add or remove sections.
+     * @return The id of the section.
+     */
+    SectionId addSection(const std::string& category, const std::string& name, Provider provider);
+
+    /**
+     * Stop publishing a section.  When this returns, the provider of the section is not running and will not be
+     * called again, so the component may be destroyed.
+     *
+     * @param id The id returned by @c addSection().
+     */
+    void removeSection(SectionId id);
+
+    /**
+     * Start serving on a Unix domain socket.  An existing file at the path is replaced.
+     *
+     * @param socketPath The path of the socket.
+     * @return Whether the server was started; @c false if it is already running or the socket could not be created.
+     */
+    bool start(const std::string& socketPath);
+
+    /// Stop serving and remove the socket file.
+    void stop();
+
+    /**
+     * Run one command, as the server does for each line received.
+     *
+     * @param command The command line, without its line terminator.
+     * @return The answer, a JSON object with an "ok" member.
+     */
+    std::string handleCommand(const std::string& command);
+
+    /**
+     * Quote a string as a JSON string literal, for use by providers.
+     *
+     * @param value The string to quote.
+     * @return The JSON string literal.
+     */
+    static std::string quote(const std::string& value);
+
+private:
+    /// A published section.
+    struct Section {
+        /// The category of the section.
+        std::string category;
+        /// The name of the component.
+        std::string name;
+        /// The function returning the state of the component.
+        Provider provider;
+    };
+
+    /// Constructor.
+    IntrospectionServer();
+
+    /**
+     * Render every section grouped by category.
+     *
+     * @return A JSON object with one array of sections per category.
+     */
+    std::string renderSections();
+
+    /// Loop of the server thread.
+    void serveLoop();
+
+    /**
+     * Answer the commands of a client until it disconnects or the server stops.
+     *
+     * @param clientFd The socket of the client.
+     */
+    void serveClient(int clientFd);
+
+    /// Serializes access to @c m_sections and calls to the providers.
+    std::mutex m_sectionsMutex;
+
+    /// The published sections, by id.
+    std::map<SectionId, Section> m_sections;
+
+    /// The id of the next section.
+    SectionId m_nextSectionId;
+
+    /// Serializes @c start() and @c stop().
+    std::mutex m_serverMutex;
+
+    /// The listening socket, or -1 when the server is not running.
+    int m_listenFd;
+
+    /// The path of the socket.
+    std::string m_socketPath;
+
+    /// Whether the server thread should exit.
+    std::atomic<bool> m_isStopping;
+
+    /// The server thread.
+    std::thread m_serverThread;
+};
+
+}  // namespace introspection
+}  // namespace utils
+}  // namespace aisdk
+
+#endif  // _INTROSPECTION_INTROSPECTION_SERVER_H_
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __LOGGER_FILELOGGER_H_
+#define __LOGGER_FILELOGGER_H_
+
+#include <condition_variable>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Utils/Logging/Logger.h"
+#include "Utils/Logging/LogStringFormatter.h"
+
+// If @c ACSDK_FILE_LOGGER_PATH was not defined, log to a file under /tmp.
+#ifndef ACSDK_FILE_LOGGER_PATH
+#define ACSDK_FILE_LOGGER_PATH "/tmp/aisdk.log"
+#endif
+
+// If @c ACSDK_FILE_LOGGER_MAX_SIZE was not defined, rotate the log file once it reaches 4 MB.
+#ifndef ACSDK_FILE_LOGGER_MAX_SIZE
+#define ACSDK_FILE_LOGGER_MAX_SIZE (4 * 1024 * 1024)
+#endif
+
+// If @c ACSDK_FILE_LOGGER_MAX_FILES was not defined, keep the current log file and 3 rotated ones.
+#ifndef ACSDK_FILE_LOGGER_MAX_FILES
+#define ACSDK_FILE_LOGGER_MAX_FILES 4
+#endif
+
+namespace aisdk {
+namespace utils {
+namespace logging {
+
+/**
+ * A @c Logger that appends formatted log lines to a file.
+ *
+ * @c emit() only queues the formatted line.  A writer thread hands all lines queued during a flush interval to the
+ * kernel with a single @c writev() on a file opened with @c O_APPEND.  Entries of level @c ERROR or above wake the
+ * writer thread at once, which writes them and follows them with an @c fsync(), so they survive a crash that follows
+ * them without the thread which logged them waiting for the disk.
+ *
+ * When the file grows beyond the maximum size it is rotated: @c <path>.1 becomes @c <path>.2 and so on, the current
+ * file becomes @c <path>.1 and a new file is started.  At most the configured number of files is kept.
+ */
+class FileLogger : public Logger {
+public:
+    /// Interval between two flushes of queued lines.
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{200};
+
+    /// Amount of queued text which triggers a flush before the interval has elapsed.
+    static constexpr size_t FLUSH_THRESHOLD_IN_BYTES = 64 * 1024;
+
+    /**
+     * Return the one and only @c FileLogger instance.
+     *
+     * @return The one and only @c FileLogger instance.
+     */
+    static std::shared_ptr<Logger> instance();
+
+    /// Destructor.  Flushes any queued lines and stops the writer thread.
+    ~FileLogger();
+
+    void emit(Level level, std::chrono::system_clock::time_point time, const char* threadMoniker, const char* text)
+        override;
+
+    /**
+     * Change where logs are written and how they are rotated.  The current file is flushed and closed first.
+     *
+     * @param path The path of the log file.
+     * @param maxFileSize The size at which the log file is rotated.
+     * @param maxFiles The number of files to keep, including the current one.
+     * @return Whether the new log file could be opened.
+     */
+    bool configure(const std::string& path, size_t maxFileSize, unsigned int maxFiles);
+
+    /**
+     * Write all queued lines to the log file.
+     *
+     * @param sync Whether to @c fsync() the file after writing.
+     */
+    void flush(bool sync = false);
+
+private:
+    /// Constructor.
+    FileLogger();
+
+    /// Loop of the writer thread, flushing queued lines every @c FLUSH_INTERVAL.
+    void writerLoop();
+
+    /**
+     * Write queued lines to the log file.  @c m_fileMutex must be held.
+     *
+     * @param lines The lines to write.
+     * @param sync Whether to @c fsync() the file after writing.
+     */
+    void writeLocked(std::vector<std::string>& lines, bool sync);
+
+    /**
+     * Open the log file in append mode.  @c m_fileMutex must be held.
+     *
+     * @return Whether the file was opened.
+     */
+    bool openLocked();
+
+    /**
+     * Rotate the log files and open a new, empty log file.  @c m_fileMutex must be held.
+     */
+    void rotateLocked();
+
+    /// Serializes access to @c m_pending, @c m_pendingBytes, @c m_isSyncRequested and @c m_isStopping.
+    std::mutex m_pendingMutex;
+
+    /// Wakes the writer thread when a flush is due or the logger is stopping.
+    std::condition_variable m_wakeTrigger;
+
+    /// Formatted lines waiting to be written.
+    std::vector<std::string> m_pending;
+
+    /// Number of bytes in @c m_pending.
+    size_t m_pendingBytes;
+
+    /// Whether an entry of level @c ERROR or above was queued since the last @c fsync() of the writer thread.
+    bool m_isSyncRequested;
+
+    /// Whether the writer thread should exit.
+    bool m_isStopping;
+
+    /// Serializes access to the log file and the fields describing it.
+    std::mutex m_fileMutex;
+
+    /// Path of the log file.
+    std::string m_path;
+
+    /// Size at which the log file is rotated.
+    size_t m_maxFileSize;
+
+    /// Number of files kept, including the current one.
+    unsigned int m_maxFiles;
+
+    /// File descriptor of the log file, or -1 if it is not open.
+    int m_fd;
+
+    /// Current size of the log file.
+    size_t m_fileSize;
+
+    /// Object to format log strings correctly.
+    LogStringFormatter m_logFormatter;
+
+    /// The thread which writes queued lines to the log file.
+    std::thread m_writerThread;
+};
+
+/**
+ * Return the singleton instance of @c FileLogger.
+ *
+ * @return The singleton instance of @c FileLogger.
+ */
+std::shared_ptr<Logger> getFileLogger();
+
+}  // namespace logging
+}  // namespace utils
+}  // namespace aisdk
+
+#endif  // __LOGGER_FILELOGGER_H_
@@ -0,0 +1,252 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __LOGGER_FLIGHTRECORDER_H_
+#define __LOGGER_FLIGHTRECORDER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Utils/Logging/Level.h"
+
+namespace aisdk {
+namespace utils {
+namespace logging {
+
+/**
+ * @c FlightRecorder keeps the most recent log entries of every severity level in a preallocated in-memory ring,
+ * independently of the level configured on the @c Logger that emits them.  Entries are stored unformatted
+ * (raw time, level, thread moniker and text) and are only turned into text when the ring is dumped.
+ *
+ * The ring is dumped to a file:
+ * - when @c dump() is called,
+ * - when an entry at or above the dump level (@c Level::ERROR by default) is recorded, at most once per
+ *   @c MIN_ERROR_DUMP_INTERVAL, by a background thread so that the thread which logged the entry does not wait for
+ *   the disk, and
+ * - when the process receives a fatal signal, if @c installFatalSignalHandlers() has been called.
+ *
+ * Every dump starts a new file and keeps the earlier ones: @c <path>.1 becomes @c <path>.2 and so on, the previous
+ * dump becomes @c <path>.1, and at most @c MAX_DUMP_FILES files are kept, so that the dump of the first error of a
+ * burst is not overwritten by the dump of a later one.
+ *
+ * Recording is lock-free: writers claim a slot with a single atomic increment and publish it with a per-slot
+ * sequence number, so the recorder never blocks a logging thread.  When the ring wraps, the oldest entries are
+ * overwritten.
+ */
+class FlightRecorder {
+public:
+    /// Default capacity of the ring.
+    static constexpr size_t DEFAULT_CAPACITY_IN_BYTES = 2 * 1024 * 1024;
+
+    /// Maximum number of characters of text kept per entry.  Longer text is truncated.
+    static constexpr size_t MAX_TEXT_SIZE_IN_BYTES = 224;
+
+    /// Default file the ring is dumped to.
+    static constexpr const char* DEFAULT_DUMP_FILE_PATH = "/tmp/aisdk_flight_recorder.log";
+
+    /// Minimum time between two dumps triggered by logged errors.
+    static constexpr std::chrono::seconds MIN_ERROR_DUMP_INTERVAL{5};
+
+    /// Number of dump files kept, including the latest one.
+    static constexpr unsigned int MAX_DUMP_FILES = 4;
+
+    /**
+     * Return the one and only @c FlightRecorder instance.
+     *
+     * @return The one and only @c FlightRecorder instance.
+     */
+    static FlightRecorder& instance();
+
+    /// Destructor.  Stops the thread which writes the dumps triggered by logged errors.
+    ~FlightRecorder();
+
+    /**
+     * Allocate the ring, start the dump thread and start recording.  Calling this while already recording has no
+     * effect.
+     *
+     * @param capacityInBytes The amount of memory to dedicate to the ring.
+     * @return Whether the recorder is recording.
+     */
+    bool enable(size_t capacityInBytes = DEFAULT_CAPACITY_IN_BYTES);
+
+    /**
+     * Stop recording.  The ring is kept so it can still be dumped.
+     */
+    void disable();
+
+    /**
+     * Check whether entries are being recorded.  This is cheap enough to be called for every log line.
+     *
+     * @return Whether entries are being recorded.
+     */
+    static inline bool isRecording();
+
+    /**
+     * Record one log entry.
+     *
+     * @param level The severity Level of the entry.
+     * @param time The time that the event to log occurred.
+     * @param threadMoniker Moniker of the thread that generated the event.
+     * @param text The unformatted text of the entry.
+     */
+    void record(Level level, std::chrono::system_clock::time_point time, const char* threadMoniker, const char* text);
+
+    /**
+     * Set the file that the ring is dumped to.
+     *
+     * @param path The path of the dump file.
+     * @return Whether the path was accepted.
+     */
+    bool setDumpFilePath(const std::string& path);
+
+    /**
+     * Set the lowest severity level that triggers an automatic dump.  Use @c Level::NONE to disable.
+     *
+     * @param level The lowest severity level that triggers a dump.
+     */
+    void setDumpLevel(Level level);
+
+    /**
+     * Dump the ring to the configured dump file.
+     *
+     * @return Whether the dump was written.
+     */
+    bool dump();
+
+    /**
+     * Dump the ring to an already open file descriptor, oldest entry first.  Only async-signal-safe calls are
+     * made, so this may be used from a signal handler.
+     *
+     * @param fd The file descriptor to write to.
+     * @return Whether the dump was written.
+     */
+    bool dumpToFd(int fd);
+
+    /**
+     * Dump the ring to the configured dump file from a fatal signal handler.  Unlike @c dump() this does not
+     * wait for a dump already in progress, since that dump may belong to the thread that crashed.
+     */
+    void dumpOnSignal();
+
+    /**
+     * Install handlers for SIGSEGV, SIGBUS, SIGFPE, SIGILL and SIGABRT which dump the ring and then re-raise the
+     * signal with its default action.
+     *
+     * @return Whether the handlers were installed.
+     */
+    bool installFatalSignalHandlers();
+
+private:
+    /// One entry of the ring.
+    struct Slot {
+        /// Odd while the slot is being written, otherwise twice the (1-based) index of the entry it holds.
+        std::atomic<uint64_t> sequence;
+
+        /// Time of the entry, in milliseconds since epoch.
+        int64_t timeMs;
+
+        /// Severity of the entry.
+        Level level;
+
+        /// Moniker of the thread that recorded the entry.
+        char threadMoniker[8];
+
+        /// Number of valid characters in @c text.
+        uint16_t length;
+
+        /// The text of the entry, not null terminated.
+        char text[MAX_TEXT_SIZE_IN_BYTES];
+    };
+
+    /// Constructor.
+    FlightRecorder();
+
+    /**
+     * Ask the dump thread for a dump if @c level triggers a dump and the last triggered dump is old enough.
+     *
+     * @param level The severity Level of the entry just recorded.
+     */
+    void maybeDumpOnLevel(Level level);
+
+    /// Loop of the dump thread, writing a dump whenever @c maybeDumpOnLevel() asks for one.
+    void dumpLoop();
+
+    /**
+     * Rotate the earlier dumps, then open a new dump file at the configured path and write the ring to it.  Only
+     * async-signal-safe calls are made.
+     *
+     * @return Whether the dump was written.
+     */
+    bool dumpToPath();
+
+    /**
+     * Shift @c <path>.N-1 to @c <path>.N, dropping the oldest, then move the latest dump to @c <path>.1.  Only
+     * async-signal-safe calls are made.
+     */
+    void rotateDumpFiles();
+
+    /// Flag checked on every log line, kept outside the instance so the check needs no initialization guard.
+    static std::atomic<bool> m_recording;
+
+    /// The preallocated ring.
+    std::unique_ptr<Slot[]> m_slots;
+
+    /// Number of slots in @c m_slots.
+    size_t m_slotCount;
+
+    /// Number of entries recorded so far, used to claim the next slot.
+    std::atomic<uint64_t> m_writeIndex;
+
+    /// Lowest severity level that triggers a dump.
+    std::atomic<Level> m_dumpLevel;
+
+    /// Time of the last dump triggered by a logged entry, in milliseconds of the steady clock.
+    std::atomic<int64_t> m_lastLevelDumpMs;
+
+    /// Set while a dump is being written, so concurrent dumps do not interleave.
+    std::atomic_flag m_dumping;
+
+    /// Dump file path, kept in a fixed buffer so a signal handler can use it.
+    char m_dumpFilePath[256];
+
+    /// Serializes access to @c m_isDumpRequested, @c m_isStopping and the start of @c m_dumpThread.
+    std::mutex m_dumpThreadMutex;
+
+    /// Wakes the dump thread when a dump is requested or the recorder is destroyed.
+    std::condition_variable m_dumpTrigger;
+
+    /// Whether a logged entry asked for a dump which is not written yet.
+    bool m_isDumpRequested;
+
+    /// Whether the dump thread should exit.
+    bool m_isStopping;
+
+    /// The thread which writes the dumps triggered by logged entries.
+    std::thread m_dumpThread;
+};
+
+bool FlightRecorder::isRecording() {
+    return m_recording.load(std::memory_order_relaxed);
+}
+
+}  // namespace logging
+}  // namespace utils
+}  // namespace aisdk
+
+#endif  // __LOGGER_FLIGHTRECORDER_H_
@@ -15,6 +15,7 @@
 
 #include <sstream>
 #include <string>
+#include <type_traits>
 
 #include "Utils/Logging/LogEntryStream.h"
 
@@ -25,6 +26,24 @@ namespace logging {
 /// LogEntry is used to compile the log entry text to log via Logger.
 class LogEntry {
 public:
+    /**
+     * While an instance of this class exists, the entries built by its thread are only recorded by the
+     * @c FlightRecorder, and are captured raw: strings are copied without escaping, integers are converted without the
+     * stream, and nothing is added once the text is longer than the recorder keeps.
+     */
+    class RawCapture {
+    public:
+        /// Constructor.
+        RawCapture();
+
+        /// Destructor, which restores the capture of the entries enclosing this one.
+        ~RawCapture();
+
+    private:
+        /// Whether the thread was capturing raw entries when this instance was created.
+        const bool m_wasCapturingRaw;
+    };
+
     /**
      * Constructor.
      *
@@ -154,6 +173,55 @@ private:
     /// Add the appropriate prefix for a key,value pair that is about to be appended to the text of this LogEntry.
     void prefixKeyValuePair();
 
+    /**
+     * Append a string to a raw entry, without escaping it, and without growing the entry past the text the
+     * @c FlightRecorder keeps.
+     *
+     * @param in The string to append.
+     * @param length The length of @c in.
+     */
+    void appendRaw(const char* in, size_t length);
+
+    /**
+     * Append the key of a key,value pair to a raw entry, with its prefix and separator.
+     *
+     * @param key The key.
+     * @return Whether the value should be appended, which is not the case once the entry is full.
+     */
+    bool prefixRawValue(const char* key);
+
+    /**
+     * Append a signed integer to a raw entry.
+     *
+     * @param value The integer.
+     */
+    void appendRawInteger(long long value);
+
+    /**
+     * Append an unsigned integer to a raw entry.
+     *
+     * @param value The integer.
+     */
+    void appendRawInteger(unsigned long long value);
+
+    /**
+     * Append an integer value to a raw entry.
+     *
+     * @param value The value.
+     */
+    template <typename ValueType>
+    inline typename std::enable_if<std::is_integral<ValueType>::value && !std::is_same<ValueType, char>::value>::type
+    appendRawValue(const ValueType& value);
+
+    /**
+     * Append a value of another type to a raw entry, which the stream formats.
+     *
+     * @param value The value.
+     */
+    template <typename ValueType>
+    inline typename std::enable_if<!std::is_integral<ValueType>::value || std::is_same<ValueType, char>::value>::type
+    appendRawValue(const ValueType& value);
+
     /// Add the appropriate prefix for an arbitrary message that is about to be appended to the text of this LogEntry.
     void prefixMessage();
 
@@ -170,6 +238,9 @@ private:
     /// Character used to separate @c key from @c value text in metadata.
     static const char KEY_VALUE_SEPARATOR = '=';
 
+    /// Whether this LogEntry is captured raw for the @c FlightRecorder, see @c RawCapture.
+    const bool m_isRaw;
+
     /// Flag indicating (if true) that some metadata has already been appended to this LogEntry.
     bool m_hasMetadata;
 
@@ -179,11 +250,30 @@ private:
 
 template <typename ValueType>
 LogEntry& LogEntry::d(const char* key, const ValueType& value) {
+    if (m_isRaw) {
+        if (prefixRawValue(key)) {
+            appendRawValue(value);
+        }
+        return *this;
+    }
     prefixKeyValuePair();
     m_stream << key << KEY_VALUE_SEPARATOR << value;
     return *this;
 }
 
+template <typename ValueType>
+typename std::enable_if<std::is_integral<ValueType>::value && !std::is_same<ValueType, char>::value>::type
+LogEntry::appendRawValue(const ValueType& value) {
+    using WideType = typename std::conditional<std::is_signed<ValueType>::value, long long, unsigned long long>::type;
+    appendRawInteger(static_cast<WideType>(value));
+}
+
+template <typename ValueType>
+typename std::enable_if<!std::is_integral<ValueType>::value || std::is_same<ValueType, char>::value>::type
+LogEntry::appendRawValue(const ValueType& value) {
+    m_stream << value;
+}
+
 // Define AISDK_EMIT_SENSITIVE_LOGS if you want to include sensitive data in log output.
 #ifdef AISDK_EMIT_SENSITIVE_LOGS
 
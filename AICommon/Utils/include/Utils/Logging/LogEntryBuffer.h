@@ -13,6 +13,7 @@
 #ifndef __LOG_ENTRY_BUFFER_H_
 #define __LOG_ENTRY_BUFFER_H_
 
+#include <cstddef>
 #include <memory>
 #include <streambuf>
 #include <vector>
@@ -52,6 +53,13 @@ public:
      */
     const char* c_str() const;
 
+    /**
+     * Get the size of the accumulated buffer.
+     *
+     * @return The number of characters accumulated, without the null terminator.
+     */
+    size_t size() const;
+
 private:
     /// A small embedded buffer used unless the data to be buffered grows beyond its capacity.
     char m_smallBuffer[LOG_ENTRY_BUFFER_SMALL_BUFFER_SIZE];
@@ -37,6 +37,13 @@ public:
      * for the lifetime of this LogEntryStream, and only as long as no further modifications are made to it.
      */
     const char* c_str() const;
+
+    /**
+     * Get the size of the accumulated stream.
+     *
+     * @return The number of characters accumulated, without the null terminator.
+     */
+    size_t size() const;
 };
 
 }  // namespace logging
@@ -19,6 +19,7 @@
 #include <sstream>
 #include <vector>
 
+#include "Utils/Logging/FlightRecorder.h"
 #include "Utils/Logging/Level.h"
 #include "Utils/Logging/LogEntry.h"
 
@@ -136,13 +137,23 @@ public:
     inline bool shouldLog(Level level) const;
 
     /**
-     * Send a log entry to this Logger.
+     * Send a log entry to this Logger.  The entry is also handed to the @c FlightRecorder when it is recording,
+     * whatever the level of this Logger.
      *
      * @param level The severity Level to associate with this log entry.
      * @param entry Object used to build the text of this log entry.
      */
     void log(Level level, const LogEntry& entry);
 
+    /**
+     * Hand a log entry which this Logger does not emit to the @c FlightRecorder, if it is recording.  The entry is
+     * expected to be built within a @c LogEntry::RawCapture.
+     *
+     * @param level The severity Level to associate with this log entry.
+     * @param entry Object used to build the text of this log entry.
+     */
+    void record(Level level, const LogEntry& entry);
+
     /**
      * Send a log entry to this Logger while program is exiting.
      *
@@ -243,10 +254,18 @@ inline Logger& ACSDK_GET_LOGGER_FUNCTION() {
         auto& loggerInstance = aisdk::utils::logging::ACSDK_GET_LOGGER_FUNCTION(); \
         if (loggerInstance.shouldLog(level)) {                                                        \
             loggerInstance.log(level, entry);                                                         \
+        } else if (aisdk::utils::logging::FlightRecorder::isRecording()) {                            \
+            aisdk::utils::logging::LogEntry::RawCapture rawCapture;                                   \
+            loggerInstance.record(level, entry);                                                      \
         }                                                                                             \
     } while (false)
 
-#ifdef AISDK_DEBUG_LOG_ENABLED
+/*
+ * The DEBUG macros are compiled out of release builds.  Building with AISDK_FLIGHT_RECORDER_DEBUG_LOG_ENABLED compiles
+ * them in, so that the @c FlightRecorder keeps the DEBUG history leading to an error: the entries the @c Logger does
+ * not emit are then captured raw, and only while the recorder is recording.
+ */
+#if defined(AISDK_DEBUG_LOG_ENABLED) || defined(AISDK_FLIGHT_RECORDER_DEBUG_LOG_ENABLED)
 
 /**
  * Send a DEBUG5 severity log line.
@@ -304,7 +323,7 @@ inline Logger& ACSDK_GET_LOGGER_FUNCTION() {
  */
 #define AISDK_DEBUG(entry) ACSDK_LOG(aisdk::utils::logging::Level::DEBUG0, entry)
 
-#else  // AISDK_DEBUG_LOG_ENABLED
+#else  // AISDK_DEBUG_LOG_ENABLED || AISDK_FLIGHT_RECORDER_DEBUG_LOG_ENABLED
 
 /**
  * Compile out a DEBUG5 severity log line.
@@ -362,7 +381,7 @@ inline Logger& ACSDK_GET_LOGGER_FUNCTION() {
  */
 #define AISDK_DEBUG(entry)
 
-#endif  // AISDK_DEBUG_LOG_ENABLED
+#endif  // AISDK_DEBUG_LOG_ENABLED || AISDK_FLIGHT_RECORDER_DEBUG_LOG_ENABLED
 
 /**
  * Send a INFO severity log line.
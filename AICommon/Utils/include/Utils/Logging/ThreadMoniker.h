@@ -14,6 +14,7 @@
 #define __LOGGER_THREADMONIKER_H_
 
 #include <iomanip>
+#include <map>
 #include <string>
 #include <sstream>
 #include <thread>
@@ -29,11 +30,24 @@ namespace logging {
  */
 class ThreadMoniker {
 public:
+    /// A thread named with @c setThisThreadName().
+    struct NamedThread {
+        /// The moniker of the thread.
+        std::string moniker;
+        /// The name of the component running the thread.
+        std::string name;
+    };
+
     /**
      * Constructor.
      */
     ThreadMoniker();
 
+    /**
+     * Destructor.  Forgets the name of the thread, if it was given one.
+     */
+    ~ThreadMoniker();
+
     /**
      * Get the moniker for @c std::this_thread.
      *
@@ -41,9 +55,36 @@ public:
      */
     static inline const std::string getThisThreadMoniker();
 
+    /**
+     * Name @c std::this_thread after the component running it.  The name is kept until the thread exits, and is also
+     * given to the thread in the OS (truncated to 15 characters) so that tools like top show it.
+     *
+     * @param name The name of the component running the thread.
+     */
+    static void setThisThreadName(const std::string& name);
+
+    /**
+     * Get the threads which are named and still running.
+     *
+     * @return The named threads, keyed by their OS thread id.
+     */
+    static std::map<int, NamedThread> getNamedThreads();
+
 private:
+#ifndef _WIN32
+    /**
+     * Get the instance of @c std::this_thread.
+     *
+     * @return The instance of @c std::this_thread.
+     */
+    static inline ThreadMoniker& getThisThread();
+#endif
+
     /// The current thread's moniker.
     std::string m_moniker;
+
+    /// The OS thread id of the current thread if it was named, otherwise zero.
+    int m_namedThreadId;
 };
 
 const std::string ThreadMoniker::getThisThreadMoniker() {
@@ -52,12 +93,18 @@ const std::string ThreadMoniker::getThisThreadMoniker() {
     winThreadID << std::setw(3) << std::hex << std::right << std::this_thread::get_id();
     return winThreadID.str();
 #else
+    return getThisThread().m_moniker;
+#endif
+}
+
+#ifndef _WIN32
+ThreadMoniker& ThreadMoniker::getThisThread() {
     /// Per-thread static instance so that @c m_threadMoniker.m_moniker is @c std::this_thread's moniker.
     static thread_local ThreadMoniker m_threadMoniker;
 
-    return m_threadMoniker.m_moniker;
-#endif
+    return m_threadMoniker;
 }
+#endif
 
 }  // namespace logging
 }  // namespace utils
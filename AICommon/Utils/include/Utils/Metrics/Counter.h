@@ -0,0 +1,60 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef _METRICS_COUNTER_H_
+#define _METRICS_COUNTER_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace aisdk {
+namespace utils {
+namespace metrics {
+
+/**
+ * A monotonically increasing count, such as the number of overruns.  Updating it is a single relaxed atomic add, so it
+ * may be used from any thread, including hot paths.
+ */
+class Counter {
+public:
+    /// Constructor.
+    Counter() : m_value{0} {
+    }
+
+    /**
+     * Add to the count.
+     *
+     * @param amount The amount to add.
+     */
+    void increment(uint64_t amount = 1) {
+        m_value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    /**
+     * Get the current count.
+     *
+     * @return The current count.
+     */
+    uint64_t value() const {
+        return m_value.load(std::memory_order_relaxed);
+    }
+
+private:
+    /// The count.
+    std::atomic<uint64_t> m_value;
+};
+
+}  // namespace metrics
+}  // namespace utils
+}  // namespace aisdk
+
+#endif  // _METRICS_COUNTER_H_
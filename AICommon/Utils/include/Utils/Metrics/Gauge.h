@@ -0,0 +1,69 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef _METRICS_GAUGE_H_
+#define _METRICS_GAUGE_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace aisdk {
+namespace utils {
+namespace metrics {
+
+/**
+ * A value which goes up and down, such as a queue depth.  Updating it is a single relaxed atomic operation, so it may
+ * be used from any thread, including hot paths.
+ */
+class Gauge {
+public:
+    /// Constructor.
+    Gauge() : m_value{0} {
+    }
+
+    /**
+     * Set the value.
+     *
+     * @param value The new value.
+     */
+    void set(int64_t value) {
+        m_value.store(value, std::memory_order_relaxed);
+    }
+
+    /**
+     * Add to the value.
+     *
+     * @param amount The amount to add, may be negative.
+     */
+    void add(int64_t amount) {
+        m_value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    /**
+     * Get the current value.
+     *
+     * @return The current value.
+     */
+    int64_t value() const {
+        return m_value.load(std::memory_order_relaxed);
+    }
+
+private:
+    /// The value.
+    std::atomic<int64_t> m_value;
+};
+
+}  // namespace metrics
+}  // namespace utils
+}  // namespace aisdk
+
+#endif  // _METRICS_GAUGE_H_
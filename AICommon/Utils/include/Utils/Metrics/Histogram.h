@@ -0,0 +1,123 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef _METRICS_HISTOGRAM_H_
+#define _METRICS_HISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace aisdk {
+namespace utils {
+namespace metrics {
+
+/**
+ * A distribution of non-negative integer values, such as latencies in microseconds, with buckets in the style of
+ * HdrHistogram: values below @c 2^SUB_BUCKET_BITS get a bucket each, and every power of two above is split into
+ * @c 2^(SUB_BUCKET_BITS-1) linear buckets.  This keeps the relative error of any percentile below about 3% over the
+ * whole range of @c uint64_t with a fixed, small number of buckets.
+ *
+ * Recording a value is a handful of relaxed atomic operations and never locks or allocates, so it may be used from
+ * any thread, including hot paths.
+ */
+class Histogram {
+public:
+    /// Number of bits of a value kept exactly.
+    static constexpr unsigned int SUB_BUCKET_BITS = 5;
+
+    /// Number of buckets.
+    static constexpr size_t NUM_BUCKETS =
+        (1u << SUB_BUCKET_BITS) + (64 - SUB_BUCKET_BITS) * (1u << (SUB_BUCKET_BITS - 1));
+
+    /// A consistent-enough copy of a @c Histogram, taken by @c snapshot().
+    struct Snapshot {
+        /// Number of values recorded.
+        uint64_t count;
+        /// Sum of the values recorded.
+        uint64_t sum;
+        /// Smallest value recorded, or zero if none was.
+        uint64_t min;
+        /// Largest value recorded, or zero if none was.
+        uint64_t max;
+        /// Number of values in each bucket.
+        std::vector<uint64_t> buckets;
+
+        /**
+         * Estimate a percentile from the buckets.
+         *
+         * @param percentile The percentile to estimate, between 0 and 100.
+         * @return The upper bound of the bucket holding the percentile, capped by the largest value recorded.
+         */
+        uint64_t percentile(double percentile) const;
+
+        /// @return The mean of the values recorded, or zero if none was.
+        double mean() const;
+    };
+
+    /// Constructor.
+    Histogram();
+
+    /**
+     * Record a value.
+     *
+     * @param value The value to record.
+     */
+    void record(uint64_t value);
+
+    /**
+     * Take a copy of the histogram.  Values recorded concurrently may or may not be included.
+     *
+     * @return The copy.
+     */
+    Snapshot snapshot() const;
+
+    /**
+     * Get the bucket a value is counted in.
+     *
+     * @param value The value.
+     * @return The index of the bucket.
+     */
+    static size_t bucketIndex(uint64_t value);
+
+    /**
+     * Get the largest value counted in a bucket.
+     *
+     * @param index The index of the bucket.
+     * @return The largest value of the bucket.
+     */
+    static uint64_t bucketUpperBound(size_t index);
+
+private:
+    /// Number of values in each bucket.
+    std::array<std::atomic<uint64_t>, NUM_BUCKETS> m_buckets;
+
+    /// Number of values recorded.
+    std::atomic<uint64_t> m_count;
+
+    /// Sum of the values recorded.
+    std::atomic<uint64_t> m_sum;
+
+    /// Smallest value recorded, @c UINT64_MAX if none was.
+    std::atomic<uint64_t> m_min;
+
+    /// Largest value recorded.
+    std::atomic<uint64_t> m_max;
+};
+
+}  // namespace metrics
+}  // namespace utils
+}  // namespace aisdk
+
+#endif  // _METRICS_HISTOGRAM_H_
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef _METRICS_MEMORY_ACCOUNTING_H_
+#define _METRICS_MEMORY_ACCOUNTING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace aisdk {
+namespace utils {
+namespace metrics {
+
+/**
+ * Keeps count of the bytes held by each subsystem of the SDK, to size devices and find leaks.
+ *
+ * Subsystems report what they allocate and release, directly or through a @c MemoryCharge.  The current and peak
+ * bytes of every subsystem are available from @c getUsage() and are exported as the @c aisdk_memory_bytes and
+ * @c aisdk_memory_peak_bytes gauges, labelled by subsystem.  Reporting is a few relaxed atomic operations, so it may
+ * be done from any thread, including hot paths.
+ */
+class MemoryAccounting {
+public:
+    /// The subsystems memory is accounted to.
+    enum class Subsystem {
+        /// Buffers of @c SharedBuffer instances which do not belong to an attachment.
+        SHARED_BUFFER,
+        /// Buffers of @c InProcessAttachment instances.
+        ATTACHMENT,
+        /// Audio frames held by the @c FFmpegDecoder instances.
+        DECODER,
+        /// Tasks waiting in the queues of the @c Executor instances.
+        EXECUTOR_QUEUE,
+        /// The flight recorder and the lines waiting to be written by the file logger.
+        LOGGER
+    };
+
+    /// Number of @c Subsystem values.
+    static constexpr size_t NUM_SUBSYSTEMS = 5;
+
+    /// The memory held by a subsystem.
+    struct Usage {
+        /// Bytes held now.
+        uint64_t currentBytes;
+        /// Most bytes held at any time.
+        uint64_t peakBytes;
+    };
+
+    /**
+     * Account bytes allocated by a subsystem.
+     *
+     * @param subsystem The subsystem.
+     * @param bytes The number of bytes.
+     */
+    static void allocate(Subsystem subsystem, size_t bytes);
+
+    /**
+     * Account bytes released by a subsystem.
+     *
+     * @param subsystem The subsystem.
+     * @param bytes The number of bytes, which must have been accounted by @c allocate().
+     */
+    static void release(Subsystem subsystem, size_t bytes);
+
+    /**
+     * Get the memory held by a subsystem.
+     *
+     * @param subsystem The subsystem.
+     * @return The memory held by the subsystem.
+     */
+    static Usage getUsage(Subsystem subsystem);
+};
+
+/**
+ * Holds bytes accounted to a subsystem for as long as it lives, so that they are released on every path.
+ *
+ * A copy holds the same number of bytes again, which matches the memory of an object copied along with its charge.
+ */
+class MemoryCharge {
+public:
+    /**
+     * Constructor.
+     *
+     * @param subsystem The subsystem the bytes are accounted to.
+     * @param bytes The number of bytes held.
+     */
+    explicit MemoryCharge(MemoryAccounting::Subsystem subsystem, size_t bytes = 0);
+
+    /**
+     * Copy constructor.  Accounts the bytes of @c other once more.
+     *
+     * @param other The charge to copy.
+     */
+    MemoryCharge(const MemoryCharge& other);
+
+    /**
+     * Copy assignment.  Releases the bytes held and accounts the bytes of @c other once more.
+     *
+     * @param other The charge to copy.
+     * @return This charge.
+     */
+    MemoryCharge& operator=(const MemoryCharge& other);
+
+    /// Destructor.  Releases the bytes held.
+    ~MemoryCharge();
+
+    /**
+     * Change the number of bytes held.
+     *
+     * @param bytes The new number of bytes held.
+     */
+    void resize(size_t bytes);
+
+    /**
+     * Account the bytes held to another subsystem.
+     *
+     * @param subsystem The new subsystem.
+     */
+    void moveTo(MemoryAccounting::Subsystem subsystem);
+
+    /**
+     * Get the number of bytes held.
+     *
+     * @return The number of bytes held.
+     */
+    size_t bytes() const {
+        return m_bytes;
+    }
+
+private:
+    /// The subsystem the bytes are accounted to.
+    MemoryAccounting::Subsystem m_subsystem;
+
+    /// The number of bytes held.
+    size_t m_bytes;
+};
+
+/**
+ * Write a @c Subsystem value to an @c ostream as a string.
+ *
+ * @param stream The stream to write the value to.
+ * @param subsystem The subsystem value to write to the @c ostream as a string.
+ * @return The @c ostream that was passed in and written to.
+ */
+std::ostream& operator<<(std::ostream& stream, MemoryAccounting::Subsystem subsystem);
+
+}  // namespace metrics
+}  // namespace utils
+}  // namespace aisdk
+
+#endif  // _METRICS_MEMORY_ACCOUNTING_H_
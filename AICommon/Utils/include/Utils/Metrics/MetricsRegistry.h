@@ -0,0 +1,259 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef _METRICS_METRICS_REGISTRY_H_
+#define _METRICS_METRICS_REGISTRY_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Utils/Metrics/Counter.h"
+#include "Utils/Metrics/Gauge.h"
+#include "Utils/Metrics/Histogram.h"
+
+namespace aisdk {
+namespace utils {
+namespace metrics {
+
+/**
+ * The process wide registry of metrics.
+ *
+ * Metrics are registered by name and labels; asking for the same name and labels again returns the same object, so
+ * components look their metrics up once and keep the returned pointer.  Updating a metric never touches the registry.
+ * A name is bound to one @c Type: asking for a name already registered with another type fails.
+ *
+ * The registry can render all metrics in the Prometheus text exposition format or as JSON, and can write them to a
+ * file periodically for a collector to pick up.
+ */
+class MetricsRegistry {
+public:
+    /// The labels of a metric, sorted by name.
+    using Labels = std::map<std::string, std::string>;
+
+    /// The types of metric.
+    enum class Type {
+        /// A @c Counter.
+        COUNTER,
+        /// A @c Gauge.
+        GAUGE,
+        /// A @c Histogram, exposed as a Prometheus summary.
+        HISTOGRAM
+    };
+
+    /// The formats metrics can be rendered in.
+    enum class Format {
+        /// The Prometheus text exposition format.
+        PROMETHEUS,
+        /// A JSON array with one object per metric.
+        JSON
+    };
+
+    /// The value of one metric at the time of @c snapshot().
+    struct MetricSnapshot {
+        /// The name of the metric.
+        std::string name;
+        /// The labels of the metric.
+        Labels labels;
+        /// The description of the metric.
+        std::string help;
+        /// The type of the metric.
+        Type type;
+        /// The value of a @c COUNTER or @c GAUGE.
+        int64_t value;
+        /// The distribution of a @c HISTOGRAM.
+        Histogram::Snapshot histogram;
+    };
+
+    /**
+     * Return the one and only @c MetricsRegistry instance.
+     *
+     * @return The one and only @c MetricsRegistry instance.
+     */
+    static MetricsRegistry& instance();
+
+    /// Destructor.  Stops the file export, if any.
+    ~MetricsRegistry();
+
+    /**
+     * Get or create a counter.
+     *
+     * @param name The name of the metric, in the Prometheus naming style.
+     * @param labels The labels of the metric.
+     * @param help The description of the metric, used when it is created.
+     * @return The counter, or @c nullptr if the name is invalid or registered with another type.
+     */
+    std::shared_ptr<Counter> getCounter(
+        const std::string& name,
+        const Labels& labels = Labels(),
+        const std::string& help = "");
+
+    /**
+     * Get or create a gauge.
+     *
+     * @param name The name of the metric, in the Prometheus naming style.
+     * @param labels The labels of the metric.
+     * @param help The description of the metric, used when it is created.
+     * @return The gauge, or @c nullptr if the name is invalid or registered with another type.
+     */
+    std::shared_ptr<Gauge> getGauge(
+        const std::string& name,
+        const Labels& labels = Labels(),
+        const std::string& help = "");
+
+    /**
+     * Get or create a histogram.
+     *
+     * @param name The name of the metric, in the Prometheus naming style, ending with the unit of the values.
+     * @param labels The labels of the metric.
+     * @param help The description of the metric, used when it is created.
+     * @return The histogram, or @c nullptr if the name is invalid or registered with another type.
+     */
+    std::shared_ptr<Histogram> getHistogram(
+        const std::string& name,
+        const Labels& labels = Labels(),
+        const std::string& help = "");
+
+    /**
+     * Take the value of every metric, ordered by name and labels.
+     *
+     * @return The values of the metrics.
+     */
+    std::vector<MetricSnapshot> snapshot();
+
+    /**
+     * Render the value of every metric.
+     *
+     * @param format The format to render in.
+     * @return The rendered metrics.
+     */
+    std::string dump(Format format = Format::PROMETHEUS);
+
+    /**
+     * Write the metrics to a file every @c interval, replacing the file atomically each time.  Replaces a file export
+     * started before.
+     *
+     * @param filePath The file to write.
+     * @param interval The time between two writes.
+     * @param format The format to write in.
+     * @return Whether the export was started.
+     */
+    bool startFileExport(const std::string& filePath, std::chrono::milliseconds interval, Format format);
+
+    /// Stop the file export, writing the file one last time.
+    void stopFileExport();
+
+    /**
+     * Render metric values in a format.
+     *
+     * @param metrics The values, as returned by @c snapshot().
+     * @param format The format to render in.
+     * @param stream The stream to render to.
+     */
+    static void render(const std::vector<MetricSnapshot>& metrics, Format format, std::ostream& stream);
+
+private:
+    /// A registered metric.
+    struct Entry {
+        /// The name of the metric.
+        std::string name;
+        /// The labels of the metric.
+        Labels labels;
+        /// The description of the metric.
+        std::string help;
+        /// The type of the metric.
+        Type type;
+        /// The metric, if @c type is @c COUNTER.
+        std::shared_ptr<Counter> counter;
+        /// The metric, if @c type is @c GAUGE.
+        std::shared_ptr<Gauge> gauge;
+        /// The metric, if @c type is @c HISTOGRAM.
+        std::shared_ptr<Histogram> histogram;
+    };
+
+    /// Constructor.
+    MetricsRegistry();
+
+    /**
+     * Find or create the entry of a metric.
+     *
+     * @param name The name of the metric.
+     * @param labels The labels of the metric.
+     * @param help The description of the metric.
+     * @param type The type of the metric.
+     * @return The entry, or @c nullptr if the name is invalid or registered with another type.
+     */
+    Entry* getEntry(const std::string& name, const Labels& labels, const std::string& help, Type type);
+
+    /**
+     * Write the metrics to the export file.
+     *
+     * @param filePath The file to write.
+     * @param format The format to write in.
+     * @return Whether the file was written.
+     */
+    bool writeFile(const std::string& filePath, Format format);
+
+    /// Loop of the file export thread.
+    void exportLoop();
+
+    /// Serializes access to @c m_entries and @c m_types.
+    std::mutex m_mutex;
+
+    /// The registered metrics, keyed by name and labels so that metrics with the same name are adjacent.
+    std::map<std::string, Entry> m_entries;
+
+    /// The type each registered name is bound to.
+    std::map<std::string, Type> m_types;
+
+    /// Serializes access to the file export members below.
+    std::mutex m_exportMutex;
+
+    /// Wakes the file export thread when it should stop.
+    std::condition_variable m_exportWakeTrigger;
+
+    /// The file the metrics are exported to.
+    std::string m_exportFilePath;
+
+    /// The time between two writes of the export file.
+    std::chrono::milliseconds m_exportInterval;
+
+    /// The format of the export file.
+    Format m_exportFormat;
+
+    /// Whether the file export thread should exit.
+    bool m_isExportStopping;
+
+    /// The file export thread.
+    std::thread m_exportThread;
+};
+
+/**
+ * Write a @c Type value to an @c ostream as a string.
+ *
+ * @param stream The stream to write the value to.
+ * @param type The type value to write to the @c ostream as a string.
+ * @return The @c ostream that was passed in and written to.
+ */
+std::ostream& operator<<(std::ostream& stream, MetricsRegistry::Type type);
+
+}  // namespace metrics
+}  // namespace utils
+}  // namespace aisdk
+
+#endif  // _METRICS_METRICS_REGISTRY_H_
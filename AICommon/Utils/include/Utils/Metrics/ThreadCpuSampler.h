@@ -0,0 +1,158 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef _METRICS_THREAD_CPU_SAMPLER_H_
+#define _METRICS_THREAD_CPU_SAMPLER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Utils/Metrics/Counter.h"
+#include "Utils/Metrics/Gauge.h"
+
+namespace aisdk {
+namespace utils {
+namespace metrics {
+
+/**
+ * Samples the CPU use and scheduling of every thread of the process from @c /proc/self/task, and exports it to the
+ * @c MetricsRegistry per component:
+ *
+ *   - @c aisdk_thread_cpu_usage_permille: CPU used over the last interval, in thousandths of a core.
+ *   - @c aisdk_thread_cpu_microseconds_total: CPU used.
+ *   - @c aisdk_thread_voluntary_context_switches_total and @c aisdk_thread_involuntary_context_switches_total.
+ *   - @c aisdk_thread_runqueue_delay_microseconds_total: time spent runnable but waiting for a CPU.
+ *
+ * A thread is attributed to the name given with @c ThreadMoniker::setThisThreadName(), or to the OS name of the
+ * thread if it has none; threads sharing a name are added up.  Sampling runs on its own thread, so the sampled
+ * threads are never interrupted.
+ */
+class ThreadCpuSampler {
+public:
+    /**
+     * Return the one and only @c ThreadCpuSampler instance.
+     *
+     * @return The one and only @c ThreadCpuSampler instance.
+     */
+    static ThreadCpuSampler& instance();
+
+    /// Destructor.  Stops sampling, if running.
+    ~ThreadCpuSampler();
+
+    /**
+     * Sample every @c interval.  Replaces sampling started before.
+     *
+     * @param interval The time between two samples.
+     * @return Whether sampling was started.
+     */
+    bool start(std::chrono::milliseconds interval);
+
+    /// Stop sampling.
+    void stop();
+
+    /// Take one sample now and update the metrics.
+    void sample();
+
+private:
+    /// The counters of one thread read from @c /proc.
+    struct ThreadSample {
+        /// The component the thread is attributed to.
+        std::string name;
+        /// CPU time in user and system mode, in clock ticks.
+        uint64_t cpuTicks;
+        /// Number of voluntary context switches.
+        uint64_t voluntarySwitches;
+        /// Number of involuntary context switches.
+        uint64_t involuntarySwitches;
+        /// Time spent waiting on a run queue, in nanoseconds.
+        uint64_t runQueueDelayNs;
+    };
+
+    /// The metrics of one component.
+    struct ComponentMetrics {
+        /// CPU used over the last interval.
+        std::shared_ptr<Gauge> cpuUsage;
+        /// CPU used.
+        std::shared_ptr<Counter> cpuTime;
+        /// Voluntary context switches.
+        std::shared_ptr<Counter> voluntarySwitches;
+        /// Involuntary context switches.
+        std::shared_ptr<Counter> involuntarySwitches;
+        /// Time spent waiting on a run queue.
+        std::shared_ptr<Counter> runQueueDelay;
+    };
+
+    /// Constructor.
+    ThreadCpuSampler();
+
+    /**
+     * Read the counters of a thread.
+     *
+     * @param tid The OS id of the thread.
+     * @param[out] sample The counters, except for the name which is only set from the OS name of the thread.
+     * @return Whether the thread still existed.
+     */
+    static bool readThread(int tid, ThreadSample* sample);
+
+    /**
+     * Get the metrics of a component, registering them on first use.
+     *
+     * @param name The name of the component.
+     * @return The metrics of the component.
+     */
+    ComponentMetrics& getComponentMetrics(const std::string& name);
+
+    /// Loop of the sampling thread.
+    void samplingLoop();
+
+    /// Serializes calls to @c sample().
+    std::mutex m_sampleMutex;
+
+    /// The counters of each thread at the previous sample, keyed by OS thread id.
+    std::map<int, ThreadSample> m_previousSamples;
+
+    /// When the previous sample was taken.
+    std::chrono::steady_clock::time_point m_previousSampleTime;
+
+    /// Whether a sample was taken before.
+    bool m_hasPreviousSample;
+
+    /// The metrics of each component seen.
+    std::map<std::string, ComponentMetrics> m_components;
+
+    /// Serializes access to the sampling thread members below.
+    std::mutex m_threadMutex;
+
+    /// Wakes the sampling thread when it should stop.
+    std::condition_variable m_wakeTrigger;
+
+    /// The time between two samples.
+    std::chrono::milliseconds m_interval;
+
+    /// Whether the sampling thread should exit.
+    bool m_isStopping;
+
+    /// The sampling thread.
+    std::thread m_samplingThread;
+};
+
+}  // namespace metrics
+}  // namespace utils
+}  // namespace aisdk
+
+#endif  // _METRICS_THREAD_CPU_SAMPLER_H_
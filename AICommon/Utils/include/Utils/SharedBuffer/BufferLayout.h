@@ -19,6 +19,8 @@
 #include <condition_variable>
 #include <vector>
 
+#include "Utils/Metrics/MemoryAccounting.h"
+
 namespace aisdk {
 namespace utils {
 namespace sharedbuffer {
@@ -33,11 +35,20 @@ public:
      * performed by the @c init()/@c attach() functions.
      *
      * @param buffer The raw buffer which holds (or will hold) the header, arrays, and circular data buffer.
+     * @param subsystem The subsystem of the @c MemoryAccounting the @c Buffer is accounted to.
      */
-    BufferLayout(std::shared_ptr<Buffer> buffer);
+    BufferLayout(std::shared_ptr<Buffer> buffer, metrics::MemoryAccounting::Subsystem subsystem);
 
     /// The destructor ensures the BufferLayout is @c detach()es from the Buffer.
     ~BufferLayout();
+
+    /**
+     * Account the @c Buffer to another subsystem of the @c MemoryAccounting.  This function must be called before the
+     * stream is shared with other threads.
+     *
+     * @param subsystem The subsystem the @c Buffer is accounted to.
+     */
+    void setMemorySubsystem(metrics::MemoryAccounting::Subsystem subsystem);
 	/**
      * This structure defines the header fields for the @c Buffer.
      */
@@ -239,6 +250,9 @@ private:
 
     /// Precalculated pointer to the circular data.
     uint8_t* m_data;
+
+    /// The bytes of @c m_buffer, accounted for as long as this layout refers to it.
+    metrics::MemoryCharge m_memoryCharge;
 };
 
 }	// namespace sharedbuffer
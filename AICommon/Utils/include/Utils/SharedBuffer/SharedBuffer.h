@@ -29,7 +29,8 @@ public:
     static std::unique_ptr<SharedBuffer> create(
     std::shared_ptr<Buffer> buffer,
     size_t wordSize = 1,
-    size_t maxReaders = 1);
+    size_t maxReaders = 1,
+    metrics::MemoryAccounting::Subsystem subsystem = metrics::MemoryAccounting::Subsystem::SHARED_BUFFER);
 
 	static size_t calculateBufferSize(size_t nWords, size_t wordSize = 1, size_t maxReaders = 1);
 
@@ -72,6 +73,13 @@ public:
 	 */
 	std::unique_ptr<Reader> createReader(Reader::Policy policy, bool startWithNewData = false);
 
+	/**
+	 * This function accounts the @c Buffer of the stream to another subsystem of the @c MemoryAccounting than the one
+	 * given to @c create().  It must be called before any @c Reader or @c Writer is created.
+	 * @param subsystem The subsystem the @c Buffer is accounted to.
+	 */
+	void setMemorySubsystem(metrics::MemoryAccounting::Subsystem subsystem);
+
 	/// Destructor.
 	~SharedBuffer();
 private:
@@ -79,7 +87,7 @@ private:
      * Constructs a new @c SharedBuffer using the provided @c Buffer.  The constructor does not attempt to
      * initialize or verify the contents of the @c Buffer; that functionality is implemented by @c create().
      */
-	SharedBuffer(std::shared_ptr<Buffer> buffer);
+	SharedBuffer(std::shared_ptr<Buffer> buffer, metrics::MemoryAccounting::Subsystem subsystem);
 
 	// This function adds a @c Reader to the stream using a specific id.
     std::unique_ptr<Reader> createReaderLocked(
@@ -88,9 +96,15 @@ private:
         bool startWithNewData,
         bool forceReplacement,
         std::unique_lock<std::mutex>* lock);
+
+	/// This function publishes the writer and reader cursors to the @c IntrospectionServer.
+	void publishState();
 	
     /// The @c BufferLayout of the shared buffer.
     std::shared_ptr<BufferLayout> m_bufferLayout;
+
+    /// The id of the section published to the @c IntrospectionServer.
+    size_t m_introspectionId;
 };
 }	// namespace sharebuffer
 }	//utils
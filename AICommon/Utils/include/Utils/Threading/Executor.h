@@ -15,6 +15,7 @@
 #define _THREADING_EXECUTOR_H_
 
 #include <future>
+#include <string>
 #include <utility>
 
 #include "TaskThread.h"
@@ -34,6 +35,13 @@ public:
      */
     Executor();
 
+    /**
+     * Constructs an Executor whose tasks are named after the component owning it in traces.
+     *
+     * @param name The name of the component owning the Executor.
+     */
+    explicit Executor(const std::string& name);
+
     /**
      * Destructs an Executor.
      */
@@ -73,11 +81,21 @@ public:
     bool isShutdown();
 
 private:
+    /**
+     * Publish the queue depth of the Executor to the @c IntrospectionServer.
+     *
+     * @param name The name the Executor is listed under.
+     */
+    void publishState(const std::string& name);
+
     /// The queue of tasks to execute.
     std::shared_ptr<TaskQueue> m_taskQueue;
 
     /// The thread to execute tasks on.
     std::unique_ptr<TaskThread> m_taskThread;
+
+    /// The id of the section published to the @c IntrospectionServer.
+    size_t m_introspectionId;
 };
 
 template <typename Task, typename... Args>
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef _STALL_WATCHDOG_H_
+#define _STALL_WATCHDOG_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Utils/Metrics/Counter.h"
+
+namespace aisdk {
+namespace utils {
+namespace threading {
+
+/**
+ * The heartbeat of a processing loop, watched by the @c StallWatchdog.
+ *
+ * The loop calls @c beat() with the name of the stage it enters, typically before each call into a third-party SDK,
+ * and @c idle() before it blocks waiting for work.  A loop which is not idle and has not beaten within its deadline is
+ * reported as stalled in its last stage.  Both calls are a few relaxed atomic stores and may be made every iteration.
+ * The heartbeat is watched from construction, as idle, to destruction.
+ */
+class Heartbeat {
+public:
+    /**
+     * Constructor.
+     *
+     * @param name The name of the component running the loop.
+     * @param deadline How long the loop may stay in one stage, or zero for the deadline of the @c StallWatchdog.
+     */
+    explicit Heartbeat(const std::string& name, std::chrono::milliseconds deadline = std::chrono::milliseconds::zero());
+
+    /// Destructor.  Stops watching the loop.
+    ~Heartbeat();
+
+    /**
+     * Note that the loop made progress and entered a stage.
+     *
+     * @param stage The name of the stage, which must be a string literal.
+     */
+    void beat(const char* stage) {
+        m_lastBeat.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        m_stage.store(stage, std::memory_order_relaxed);
+        // Released after the time, so that the watchdog never pairs a busy loop with the time of an old beat.
+        m_isIdle.store(false, std::memory_order_release);
+    }
+
+    /// Note that the loop is about to wait for work, which is never a stall.
+    void idle() {
+        m_isIdle.store(true, std::memory_order_release);
+    }
+
+private:
+    friend class StallWatchdog;
+
+    /// Not copyable, as the @c StallWatchdog refers to it.
+    Heartbeat(const Heartbeat&) = delete;
+    Heartbeat& operator=(const Heartbeat&) = delete;
+
+    /// The name of the component running the loop.
+    const std::string m_name;
+
+    /// How long the loop may stay in one stage, or zero for the deadline of the @c StallWatchdog.
+    const std::chrono::milliseconds m_deadline;
+
+    /// The @c steady_clock time of the last beat, in ticks since its epoch.
+    std::atomic<std::chrono::steady_clock::rep> m_lastBeat;
+
+    /// The stage of the last beat.
+    std::atomic<const char*> m_stage;
+
+    /// Whether the loop is waiting for work.
+    std::atomic<bool> m_isIdle;
+
+    /// The time of the beat a stall was reported for, or zero.  Only used by the @c StallWatchdog, under its lock.
+    std::chrono::steady_clock::rep m_reportedBeat;
+
+    /// The id of the heartbeat in the @c StallWatchdog.
+    size_t m_id;
+
+    /// The stall counter of the component, fetched once so that the @c StallWatchdog does not look it up.
+    const std::shared_ptr<metrics::Counter> m_stallCounter;
+};
+
+/**
+ * Watches the @c Heartbeat of the processing loops of the SDK and reports those which stopped progressing, for
+ * example inside a hung call into a third-party SDK.
+ *
+ * A stall is logged as an error once, with the component and its last stage, which also gets the @c FlightRecorder
+ * history onto the disk, and is counted by the @c aisdk_thread_stalls_total counter labelled by component.  The
+ * recovery of a stalled loop is logged too.  The heartbeats are also published to the @c IntrospectionServer in the
+ * "watchdog" category.
+ */
+class StallWatchdog {
+public:
+    /**
+     * Return the one and only @c StallWatchdog instance.  It is never destroyed, so that heartbeats owned by static
+     * objects can still be destroyed while the process exits.
+     *
+     * @return The one and only @c StallWatchdog instance.
+     */
+    static StallWatchdog& instance();
+
+    /**
+     * Check the heartbeats every @c checkInterval.  Replaces watching started before.
+     *
+     * @param deadline How long a loop may stay in one stage, unless its @c Heartbeat has its own deadline.
+     * @param checkInterval The time between two checks.
+     * @return Whether watching was started.
+     */
+    bool start(std::chrono::milliseconds deadline, std::chrono::milliseconds checkInterval);
+
+    /// Stop watching.
+    void stop();
+
+    /**
+     * Check the heartbeats now and report the loops which stalled or recovered.  The reports are logged and counted
+     * once the heartbeats are unlocked, as logging a stall dumps the @c FlightRecorder history.
+     */
+    void check();
+
+private:
+    friend class Heartbeat;
+
+    /// Constructor.
+    StallWatchdog();
+
+    /**
+     * Start watching a heartbeat.
+     *
+     * @param heartbeat The heartbeat.
+     */
+    void add(Heartbeat* heartbeat);
+
+    /**
+     * Stop watching a heartbeat.  When this returns, the heartbeat is not in use and may be destroyed.
+     *
+     * @param heartbeat The heartbeat.
+     */
+    void remove(Heartbeat* heartbeat);
+
+    /**
+     * Render the heartbeats for the @c IntrospectionServer.
+     *
+     * @return A JSON array with the state of every heartbeat.
+     */
+    std::string renderState();
+
+    /// Loop of the watchdog thread.
+    void watchLoop();
+
+    /// Serializes access to the heartbeats.
+    std::mutex m_heartbeatsMutex;
+
+    /// The watched heartbeats, by id.
+    std::map<size_t, Heartbeat*> m_heartbeats;
+
+    /// The id of the next heartbeat.
+    size_t m_nextId;
+
+    /// How long a loop may stay in one stage, unless its @c Heartbeat has its own deadline.
+    std::atomic<std::chrono::steady_clock::rep> m_deadline;
+
+    /// Serializes access to the watchdog thread members below.
+    std::mutex m_threadMutex;
+
+    /// Wakes the watchdog thread when it should stop.
+    std::condition_variable m_wakeTrigger;
+
+    /// The time between two checks.
+    std::chrono::milliseconds m_checkInterval;
+
+    /// Whether the watchdog thread should exit.
+    bool m_isStopping;
+
+    /// The watchdog thread.
+    std::thread m_watchThread;
+};
+
+}  // namespace threading
+}  // namespace utils
+}  // namespace aisdk
+
+#endif  // _STALL_WATCHDOG_H_
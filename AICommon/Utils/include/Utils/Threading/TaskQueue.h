@@ -23,6 +23,8 @@
 #include <mutex>
 #include <utility>
 
+#include "Utils/Metrics/MemoryAccounting.h"
+
 namespace aisdk {
 namespace utils {
 namespace threading {
@@ -77,6 +79,14 @@ public:
      */
     bool isShutdown();
 
+    /**
+     * Returns the number of tasks waiting in the queue.  This does not lock the queue, so it can be called from any
+     * thread without delaying the tasks.
+     *
+     * @returns The number of tasks waiting in the queue.
+     */
+    size_t size() const;
+
 private:
     /// Define the queue type alias.
     using Queue = std::deque<std::unique_ptr<std::function<void()>>>;
@@ -103,6 +113,9 @@ private:
 
     /// A flag for whether or not the queue is expecting more tasks.
     std::atomic_bool m_shutdown;
+
+    /// A copy of the size of @c m_queue, updated whenever it changes.
+    std::atomic<size_t> m_size;
 };
 
 template <typename Task, typename... Args>
@@ -153,8 +166,15 @@ auto TaskQueue::pushTo(bool front, Task task, Args&&... args) -> std::future<dec
     auto cleanupPromise = std::make_shared<std::promise<decltype(task(args...))>>();
     auto cleanupFuture = cleanupPromise->get_future();
 
+    // Account the task for as long as the queued function holds it.  The charge is copied along with the lambda, and
+    // every copy but the queued one is destroyed when this function returns.
+    metrics::MemoryCharge memoryCharge{metrics::MemoryAccounting::Subsystem::EXECUTOR_QUEUE,
+                                       sizeof(std::function<void()>) + sizeof(packaged_task) + sizeof(cleanupPromise) +
+                                           sizeof(metrics::MemoryCharge) + sizeof(PackagedTaskType) + sizeof(bindTask) +
+                                           sizeof(std::promise<decltype(task(args...))>)};
+
     // Remove the return type from the task by wrapping it in a lambda with no return value.
-    auto translated_task = [packaged_task, cleanupPromise]() mutable {
+    auto translated_task = [packaged_task, cleanupPromise, memoryCharge]() mutable {
         // Execute the task.
         packaged_task->operator()();
         // Note the future for the task's result.
@@ -172,6 +192,7 @@ auto TaskQueue::pushTo(bool front, Task task, Args&&... args) -> std::future<dec
         if (!m_shutdown) {
 			// Inplace a task to taskqueue
             m_queue.emplace(front ? m_queue.begin() : m_queue.end(), new std::function<void()>(translated_task));
+            m_size = m_queue.size();
         } else {
         	// The queue is shutdown and return an invaild @c future
             using FutureType = decltype(task(args...));
@@ -16,8 +16,10 @@
 
 #include <atomic>
 #include <memory>
+#include <string>
 #include <thread>
 
+#include "StallWatchdog.h"
 #include "TaskQueue.h"
 
 namespace aisdk {
@@ -33,8 +35,9 @@ public:
      * Constructs
      *
      * @params taskQueue A TaskQueue to take tasks from to execute.
+     * @params name The name of the thread and its tasks in traces.
      */
-    TaskThread(std::shared_ptr<TaskQueue> taskQueue);
+    TaskThread(std::shared_ptr<TaskQueue> taskQueue, const std::string& name = "TaskThread");
 
     /**
      * Destructs the TaskThread.
@@ -65,6 +68,12 @@ private:
     /// A flag to message the task thread to stop executing.
     std::atomic_bool m_shutdown;
 
+    /// The name of the thread and its tasks in traces.
+    std::string m_name;
+
+    /// The heartbeat of @c processTasksLoop(), watched by the @c StallWatchdog.
+    Heartbeat m_heartbeat;
+
     /// The thread to run tasks on.
     std::thread m_thread;
 };
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef _TRACING_DIALOG_TURN_TRACER_H_
+#define _TRACING_DIALOG_TURN_TRACER_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#include "Utils/Metrics/Histogram.h"
+
+namespace aisdk {
+namespace utils {
+namespace tracing {
+
+/**
+ * @c DialogTurnTracer breaks the latency of a dialog turn, from the keyword being detected to the first answer audio
+ * being handed to the output device, into stages.
+ *
+ * A turn is started by @c beginTurn() when the keyword is detected.  Each component then calls @c mark() when the turn
+ * reaches one of its stages; only the first mark of a stage counts, so marking from inside a loop is cheap and safe.
+ * Once the session id of the turn is known it is bound with @c bindTraceId(), after which marks carrying a different
+ * trace id (a late result of an earlier turn, for example) are ignored.  The turn completes when it reaches
+ * @c Stage::FIRST_AUDIO_OUTPUT, or when the next turn begins.
+ *
+ * On completion the time of each stage is added to two histograms per stage, which are registered in the
+ * @c MetricsRegistry as @c aisdk_dialog_turn_stage_milliseconds: one measured from the keyword and one measured from
+ * the previous stage reached in the same turn.  A one line summary of the turn is logged as well.
+ */
+class DialogTurnTracer {
+public:
+    /// The stages of a dialog turn, in the order they are expected to happen.
+    enum class Stage {
+        /// The keyword detector reported the keyword.
+        KEYWORD_DETECTED,
+        /// The speech recognizer started recognizing.
+        RECOGNIZE_STARTED,
+        /// The first chunk of captured audio was sent to the recognizer.
+        FIRST_AUDIO_UPLOADED,
+        /// The end of speech was detected.
+        VAD_END,
+        /// The NLP result was received.
+        NLP_RESULT,
+        /// The first chunk of TTS audio was written to the attachment.
+        FIRST_TTS_CHUNK_WRITTEN,
+        /// The @c SpeechSynthesizer acquired the foreground focus.
+        FOCUS_ACQUIRED,
+        /// The media player was asked to play the answer.
+        PLAY_STARTED,
+        /// The first answer audio was handed to the output device.
+        FIRST_AUDIO_OUTPUT
+    };
+
+    /// Number of values of @c Stage.
+    static constexpr size_t NUM_STAGES = 9;
+
+    /**
+     * Return the one and only @c DialogTurnTracer instance.
+     *
+     * @return The one and only @c DialogTurnTracer instance.
+     */
+    static DialogTurnTracer& instance();
+
+    /**
+     * Start a new turn at @c Stage::KEYWORD_DETECTED.  A turn still in progress is completed with the stages it
+     * reached.
+     */
+    void beginTurn();
+
+    /**
+     * Bind the trace id (the dialog session id / @c NLPDomain message id) to the current turn.
+     *
+     * @param traceId The trace id of the current turn.
+     */
+    void bindTraceId(const std::string& traceId);
+
+    /**
+     * Record that the current turn reached a stage.
+     *
+     * @param stage The stage reached.
+     */
+    void mark(Stage stage);
+
+    /**
+     * Record that the turn with the given trace id reached a stage.  Ignored if the current turn is bound to another
+     * trace id.
+     *
+     * @param stage The stage reached.
+     * @param traceId The trace id of the turn which reached the stage.
+     */
+    void mark(Stage stage, const std::string& traceId);
+
+    /**
+     * Get the histogram of a stage measured from the keyword.
+     *
+     * @param stage The stage.
+     * @return A copy of the histogram, empty for @c Stage::KEYWORD_DETECTED.
+     */
+    metrics::Histogram::Snapshot getLatencyFromKeyword(Stage stage);
+
+    /**
+     * Get the histogram of a stage measured from the previous stage reached in the same turn.
+     *
+     * @param stage The stage.
+     * @return A copy of the histogram, empty for @c Stage::KEYWORD_DETECTED.
+     */
+    metrics::Histogram::Snapshot getLatencyFromPreviousStage(Stage stage);
+
+    /**
+     * Render the histograms of every stage as text, one stage per line.
+     *
+     * @return The report.
+     */
+    std::string getReport();
+
+    /// Abandon the current turn.  The histograms belong to the @c MetricsRegistry and are kept.
+    void reset();
+
+    /**
+     * Convert a @c Stage to its name.
+     *
+     * @param stage The stage.
+     * @return The name of the stage.
+     */
+    static std::string stageToString(Stage stage);
+
+private:
+    /// Constructor.
+    DialogTurnTracer();
+
+    /**
+     * Record a stage of the current turn.  @c m_mutex must be held.
+     *
+     * @param stage The stage reached.
+     */
+    void markLocked(Stage stage);
+
+    /// Add the current turn to the histograms, log it and end it.  @c m_mutex must be held.
+    void completeTurnLocked();
+
+    /// Bit of @c m_markedStages set while a turn is in progress.
+    static constexpr uint32_t TURN_ACTIVE_BIT = 1u << 31;
+
+    /// Bits of the stages reached by the current turn, plus @c TURN_ACTIVE_BIT.  Allows @c mark() to return
+    /// without locking once a stage has been recorded.
+    std::atomic<uint32_t> m_markedStages;
+
+    /// Serializes access to the members below.
+    std::mutex m_mutex;
+
+    /// The trace id bound to the current turn, empty if none was bound yet.
+    std::string m_traceId;
+
+    /// The time each stage of the current turn was reached.
+    std::array<std::chrono::steady_clock::time_point, NUM_STAGES> m_stageTimes;
+
+    /// Per stage latency measured from the keyword, fetched from the @c MetricsRegistry once.  None for the keyword.
+    std::array<std::shared_ptr<metrics::Histogram>, NUM_STAGES> m_fromKeyword;
+
+    /// Per stage latency measured from the previous stage reached, fetched from the @c MetricsRegistry once.  None
+    /// for the keyword.
+    std::array<std::shared_ptr<metrics::Histogram>, NUM_STAGES> m_fromPreviousStage;
+};
+
+/**
+ * Write a @c Stage value to an @c ostream as a string.
+ *
+ * @param stream The stream to write the value to.
+ * @param stage The stage value to write to the @c ostream as a string.
+ * @return The @c ostream that was passed in and written to.
+ */
+inline std::ostream& operator<<(std::ostream& stream, DialogTurnTracer::Stage stage) {
+    return stream << DialogTurnTracer::stageToString(stage);
+}
+
+}  // namespace tracing
+}  // namespace utils
+}  // namespace aisdk
+
+#endif  // _TRACING_DIALOG_TURN_TRACER_H_
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef _TRACING_TRACE_EVENT_RECORDER_H_
+#define _TRACING_TRACE_EVENT_RECORDER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace aisdk {
+namespace utils {
+namespace tracing {
+
+/**
+ * @c TraceEventRecorder records spans of work per thread and writes them as Chrome trace-event JSON, which can be
+ * loaded into chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Each thread appends to its own buffer, so recording an event never contends with other threads.  Events are only
+ * recorded between @c startTracing() and @c stopTracing(); the latter collects the buffers of all threads and writes
+ * the JSON file.  Threads are identified by their @c ThreadMoniker, the same id printed in the log.
+ *
+ * Code is instrumented with the @c AISDK_TRACE_SCOPE and @c AISDK_TRACE_INSTANT macros, which compile to nothing
+ * unless the SDK is built with @c AISDK_TRACING_ENABLED.  Category and event names must outlive the recorder: pass
+ * string literals, or names returned by @c internName().
+ */
+class TraceEventRecorder {
+public:
+    /// Maximum number of events kept per thread and tracing session.  Further events are dropped and counted.
+    static constexpr size_t MAX_EVENTS_PER_THREAD = 64 * 1024;
+
+    /**
+     * Start recording events.  Events of a previous session which was not stopped are discarded.
+     *
+     * @param filePath The file the trace is written to by @c stopTracing().
+     * @return Whether tracing was started; @c false if the file path is empty.
+     */
+    static bool startTracing(const std::string& filePath);
+
+    /**
+     * Stop recording events and write the events recorded since @c startTracing() to the trace file.
+     *
+     * @return Whether the trace file was written.
+     */
+    static bool stopTracing();
+
+    /**
+     * Whether events are being recorded.
+     *
+     * @return Whether events are being recorded.
+     */
+    static bool isTracing() {
+        return m_tracing.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Name the calling thread in the trace, in place of its moniker.
+     *
+     * @param name The name of the thread.  Must outlive the recorder, see @c internName().
+     */
+    static void setThreadName(const char* name);
+
+    /**
+     * Get a copy of a dynamic name which lives as long as the process, for use as an event or thread name.  Interning
+     * the same name twice returns the same pointer.
+     *
+     * @param name The name to intern.
+     * @return The interned name.
+     */
+    static const char* internName(const std::string& name);
+
+    /**
+     * Record a span of work which ended now.
+     *
+     * @param category The category of the event.
+     * @param name The name of the event.
+     * @param start The time the span started.
+     */
+    static void recordComplete(const char* category, const char* name, std::chrono::steady_clock::time_point start);
+
+    /**
+     * Record an event without duration.
+     *
+     * @param category The category of the event.
+     * @param name The name of the event.
+     */
+    static void recordInstant(const char* category, const char* name);
+
+private:
+    /// Whether events are being recorded.
+    static std::atomic<bool> m_tracing;
+};
+
+/// Records the span from its construction to its destruction as a complete event.
+class ScopedTraceEvent {
+public:
+    /**
+     * Constructor.
+     *
+     * @param category The category of the event.
+     * @param name The name of the event.
+     */
+    ScopedTraceEvent(const char* category, const char* name) :
+            m_category{category},
+            m_name{name},
+            m_active{TraceEventRecorder::isTracing()} {
+        if (m_active) {
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    /// Destructor.
+    ~ScopedTraceEvent() {
+        if (m_active) {
+            TraceEventRecorder::recordComplete(m_category, m_name, m_start);
+        }
+    }
+
+private:
+    /// The category of the event.
+    const char* m_category;
+
+    /// The name of the event.
+    const char* m_name;
+
+    /// Whether tracing was on when the span started.
+    bool m_active;
+
+    /// The time the span started.
+    std::chrono::steady_clock::time_point m_start;
+};
+
+}  // namespace tracing
+}  // namespace utils
+}  // namespace aisdk
+
+/// Helpers to give every @c AISDK_TRACE_SCOPE variable a unique name.
+#define AISDK_TRACE_CONCAT_INNER(a, b) a##b
+#define AISDK_TRACE_CONCAT(a, b) AISDK_TRACE_CONCAT_INNER(a, b)
+
+#ifdef AISDK_TRACING_ENABLED
+
+/**
+ * Trace the rest of the enclosing scope as a span.
+ *
+ * @param category The category of the span, a string literal.
+ * @param name The name of the span, a string literal or an interned name.
+ */
+#define AISDK_TRACE_SCOPE(category, name) \
+    aisdk::utils::tracing::ScopedTraceEvent AISDK_TRACE_CONCAT(aisdkTraceScope, __LINE__)(category, name)
+
+/**
+ * Trace an event without duration.
+ *
+ * @param category The category of the event, a string literal.
+ * @param name The name of the event, a string literal or an interned name.
+ */
+#define AISDK_TRACE_INSTANT(category, name)                                           \
+    do {                                                                              \
+        if (aisdk::utils::tracing::TraceEventRecorder::isTracing()) {                 \
+            aisdk::utils::tracing::TraceEventRecorder::recordInstant(category, name); \
+        }                                                                             \
+    } while (false)
+
+#else  // AISDK_TRACING_ENABLED
+
+#define AISDK_TRACE_SCOPE(category, name)
+#define AISDK_TRACE_INSTANT(category, name) \
+    do {                                    \
+    } while (false)
+
+#endif  // AISDK_TRACING_ENABLED
+
+#endif  // _TRACING_TRACE_EVENT_RECORDER_H_
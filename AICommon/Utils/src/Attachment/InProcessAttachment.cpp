@@ -19,13 +19,16 @@ namespace attachment {
 
 //using namespace utils::memory;
 
+// Attachments are accounted apart from other streams, so that those which never get both a reader and a writer show up.
 InProcessAttachment::InProcessAttachment(const std::string& id, std::unique_ptr<SDSType> sds) :
         Attachment(id),
         m_sds{std::move(sds)} {
     if (!m_sds) {
         auto buffSize = SDSType::calculateBufferSize(SDS_BUFFER_DEFAULT_SIZE_IN_BYTES);
         auto buff = std::make_shared<SDSBufferType>(buffSize);
-        m_sds = SDSType::create(buff);
+        m_sds = SDSType::create(buff, 1, 1, metrics::MemoryAccounting::Subsystem::ATTACHMENT);
+    } else {
+        m_sds->setMemorySubsystem(metrics::MemoryAccounting::Subsystem::ATTACHMENT);
     }
 }
 
@@ -11,8 +11,18 @@
  * express or implied. See the License for the specific language governing
  * permissions and limitations under the License.
  */
-#include <iostream>
 #include "Utils/DeviceInfo.h"
+#include "Utils/Logging/Logger.h"
+
+/// String to identify log entries originating from this file.
+static const std::string TAG("DeviceInfo");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
 
 namespace aisdk {
 namespace utils {
@@ -22,7 +32,7 @@ std::unique_ptr<DeviceInfo> DeviceInfo::create(std::string &configFile){
     std::string deviceSerialNumber;
 
 	if(configFile.empty()){
-		std::cout << "Device info config file is null" << std::endl;
+		AISDK_ERROR(LX("createFailed").d("reason", "emptyConfigFile"));
 		return nullptr;
 	}
 
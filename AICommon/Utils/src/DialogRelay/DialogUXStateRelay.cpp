@@ -14,6 +14,7 @@
 #include <iostream>
 #include <unistd.h>
 
+#include "Utils/Introspection/IntrospectionServer.h"
 #include "Utils/Logging/Logger.h"
 #include "Utils/DialogRelay/DialogUXStateRelay.h"
 
@@ -28,7 +29,15 @@ DialogUXStateRelay::DialogUXStateRelay()
 	:m_currentState{DialogUXStateObserverInterface::DialogUXState::IDLE},
 	m_soundAiState{soundai::SoundAiObserverInterface::State::IDLE},
 	m_speechSynthesizerState{dmInterface::SpeechSynthesizerObserverInterface::SpeechSynthesizerState::FINISHED} {
+	m_introspectionId = introspection::IntrospectionServer::instance().addSection(
+		"dialogUXState", "DialogUXStateRelay", [this]() {
+			return introspection::IntrospectionServer::quote(
+				DialogUXStateObserverInterface::stateToString(m_currentState.load()));
+		});
+}
 
+DialogUXStateRelay::~DialogUXStateRelay() {
+	introspection::IntrospectionServer::instance().removeSection(m_introspectionId);
 }
 
 void DialogUXStateRelay::addObserver(
@@ -134,7 +143,7 @@ void DialogUXStateRelay::setState(dialogRelay::DialogUXStateObserverInterface::D
 	if(m_currentState == newState)
 		return;
 
-	AISDK_INFO(LX("setState").d("Dialog state from", m_currentState).d("to", newState));
+	AISDK_INFO(LX("setState").d("Dialog state from", m_currentState.load()).d("to", newState));
 	m_currentState = newState;
 	notifyObserversOfState();
 }
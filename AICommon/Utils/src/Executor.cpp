@@ -12,6 +12,7 @@
  */
 
 
+#include "Utils/Introspection/IntrospectionServer.h"
 #include "Utils/Threading/Memory.h"
 #include "Utils/Threading/Executor.h"
 
@@ -21,11 +22,22 @@ namespace threading {
 
 Executor::Executor() :
         m_taskQueue{std::make_shared<TaskQueue>()},
-        m_taskThread{memory::make_unique<TaskThread>(m_taskQueue)} {
+        m_taskThread{memory::make_unique<TaskThread>(m_taskQueue)},
+        m_introspectionId{0} {
+    publishState("Executor");
+    m_taskThread->start();
+}
+
+Executor::Executor(const std::string& name) :
+        m_taskQueue{std::make_shared<TaskQueue>()},
+        m_taskThread{memory::make_unique<TaskThread>(m_taskQueue, name)},
+        m_introspectionId{0} {
+    publishState(name);
     m_taskThread->start();
 }
 
 Executor::~Executor() {
+    introspection::IntrospectionServer::instance().removeSection(m_introspectionId);
     shutdown();
 }
 
@@ -48,6 +60,15 @@ bool Executor::isShutdown() {
     return m_taskQueue->isShutdown();
 }
 
+void Executor::publishState(const std::string& name) {
+    // Only the queue's atomic size is read, so listing the executors never delays their tasks.
+    auto taskQueue = m_taskQueue;
+    m_introspectionId = introspection::IntrospectionServer::instance().addSection("executors", name, [taskQueue]() {
+        return "{\"queueDepth\":" + std::to_string(taskQueue->size()) +
+               ",\"shutdown\":" + (taskQueue->isShutdown() ? "true" : "false") + "}";
+    });
+}
+
 }  // namespace threading
 }  // namespace utils
 }  // namespace aisdk
@@ -0,0 +1,355 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Utils/Introspection/IntrospectionServer.h"
+#include "Utils/Logging/Logger.h"
+#include "Utils/Logging/ThreadMoniker.h"
+#include "Utils/Metrics/MetricsRegistry.h"
+#include "Utils/Tracing/TraceEventRecorder.h"
+
+/// String to identify log entries originating from this file.
+static const std::string TAG("IntrospectionServer");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
+namespace aisdk {
+namespace utils {
+namespace introspection {
+
+/// The nice value of the server thread, the lowest priority.
+static const int SERVER_THREAD_NICE_VALUE = 19;
+
+/// How long the server thread waits for a connection or a command before checking whether it should stop.
+static const int POLL_TIMEOUT_MS = 200;
+
+/// The longest command accepted; a client sending a longer line is disconnected.
+static const size_t MAX_COMMAND_LENGTH = 4096;
+
+/// The answer to @c help.
+static const char* HELP_ANSWER =
+    "{\"ok\":true,\"commands\":[\"status\",\"metrics\",\"loglevel <LEVEL>\",\"trace start <file>\","
+    "\"trace stop\",\"help\"]}";
+
+/**
+ * Build the answer to a failed command.
+ *
+ * @param reason Why the command failed.
+ * @return The answer.
+ */
+static std::string errorAnswer(const std::string& reason) {
+    return "{\"ok\":false,\"error\":" + IntrospectionServer::quote(reason) + "}";
+}
+
+/**
+ * Render the metrics on one line, as every answer must fit on one line.
+ *
+ * @return The metrics as a JSON array.
+ */
+static std::string renderMetrics() {
+    auto json = metrics::MetricsRegistry::instance().dump(metrics::MetricsRegistry::Format::JSON);
+    // Line breaks in the JSON rendering are whitespace between tokens; strings escape theirs.
+    json.erase(std::remove(json.begin(), json.end(), '\n'), json.end());
+    return json;
+}
+
+/**
+ * Write a whole answer to a client.
+ *
+ * @param fd The socket of the client.
+ * @param answer The answer, without its line terminator.
+ * @return Whether the answer was written.
+ */
+static bool writeAnswer(int fd, std::string answer) {
+    answer += '\n';
+    size_t written = 0;
+    while (written < answer.size()) {
+        auto result = send(fd, answer.data() + written, answer.size() - written, MSG_NOSIGNAL);
+        if (result < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return false;
+        }
+        written += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+IntrospectionServer& IntrospectionServer::instance() {
+    static IntrospectionServer singleIntrospectionServer;
+    return singleIntrospectionServer;
+}
+
+IntrospectionServer::IntrospectionServer() : m_nextSectionId{1}, m_listenFd{-1}, m_isStopping{false} {
+}
+
+IntrospectionServer::~IntrospectionServer() {
+    stop();
+}
+
+IntrospectionServer::SectionId IntrospectionServer::addSection(
+    const std::string& category,
+    const std::string& name,
+    Provider provider) {
+    std::lock_guard<std::mutex> lock(m_sectionsMutex);
+    auto id = m_nextSectionId++;
+    m_sections[id] = Section{category, name, provider};
+    return id;
+}
+
+void IntrospectionServer::removeSection(SectionId id) {
+    std::lock_guard<std::mutex> lock(m_sectionsMutex);
+    m_sections.erase(id);
+}
+
+bool IntrospectionServer::start(const std::string& socketPath) {
+    std::lock_guard<std::mutex> lock(m_serverMutex);
+    if (m_listenFd >= 0) {
+        AISDK_ERROR(LX("startFailed").d("reason", "alreadyRunning").d("socketPath", m_socketPath));
+        return false;
+    }
+
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        AISDK_ERROR(LX("startFailed").d("reason", "invalidSocketPath").d("socketPath", socketPath));
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        AISDK_ERROR(LX("startFailed").d("reason", "socketFailed").d("errno", errno));
+        return false;
+    }
+    unlink(socketPath.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(fd, 4) < 0) {
+        AISDK_ERROR(LX("startFailed").d("reason", "bindFailed").d("socketPath", socketPath).d("errno", errno));
+        close(fd);
+        return false;
+    }
+
+    m_listenFd = fd;
+    m_socketPath = socketPath;
+    m_isStopping = false;
+    m_serverThread = std::thread(&IntrospectionServer::serveLoop, this);
+    AISDK_INFO(LX("started").d("socketPath", socketPath));
+    return true;
+}
+
+void IntrospectionServer::stop() {
+    std::lock_guard<std::mutex> lock(m_serverMutex);
+    if (m_listenFd < 0) {
+        return;
+    }
+    m_isStopping = true;
+    if (m_serverThread.joinable()) {
+        m_serverThread.join();
+    }
+    close(m_listenFd);
+    m_listenFd = -1;
+    unlink(m_socketPath.c_str());
+    AISDK_INFO(LX("stopped").d("socketPath", m_socketPath));
+}
+
+std::string IntrospectionServer::handleCommand(const std::string& command) {
+    std::istringstream words(command);
+    std::string verb;
+    words >> verb;
+
+    if ("status" == verb) {
+        return "{\"ok\":true,\"sections\":" + renderSections() + ",\"metrics\":" + renderMetrics() + "}";
+    }
+    if ("metrics" == verb) {
+        return "{\"ok\":true,\"metrics\":" + renderMetrics() + "}";
+    }
+    if ("loglevel" == verb) {
+        std::string levelName;
+        words >> levelName;
+        auto level = logging::convertNameToLevel(levelName);
+        if (logging::Level::UNKNOWN == level) {
+            return errorAnswer("unknown log level: " + levelName);
+        }
+        logging::ACSDK_GET_LOGGER_FUNCTION().setLevel(level);
+        AISDK_INFO(LX("logLevelChanged").d("level", levelName));
+        return "{\"ok\":true,\"level\":" + quote(logging::convertLevelToName(level)) + "}";
+    }
+    if ("trace" == verb) {
+        std::string action;
+        words >> action;
+        if ("start" == action) {
+            std::string filePath;
+            words >> filePath;
+            if (!tracing::TraceEventRecorder::startTracing(filePath)) {
+                return errorAnswer("cannot start tracing to: " + filePath);
+            }
+            return "{\"ok\":true,\"tracing\":true,\"file\":" + quote(filePath) + "}";
+        }
+        if ("stop" == action) {
+            if (!tracing::TraceEventRecorder::isTracing()) {
+                return errorAnswer("not tracing");
+            }
+            if (!tracing::TraceEventRecorder::stopTracing()) {
+                return errorAnswer("cannot write the trace file");
+            }
+            return "{\"ok\":true,\"tracing\":false}";
+        }
+        return errorAnswer("usage: trace start <file> | trace stop");
+    }
+    if ("help" == verb) {
+        return HELP_ANSWER;
+    }
+    return errorAnswer("unknown command: " + verb);
+}
+
+std::string IntrospectionServer::quote(const std::string& value) {
+    std::string quoted = "\"";
+    for (auto c : value) {
+        if ('"' == c || '\\' == c) {
+            quoted += '\\';
+            quoted += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            quoted += escaped;
+        } else {
+            quoted += c;
+        }
+    }
+    quoted += '"';
+    return quoted;
+}
+
+std::string IntrospectionServer::renderSections() {
+    // Group the sections by category, keeping the order in which they were added within a category.
+    std::map<std::string, std::vector<std::string>> categories;
+    {
+        std::lock_guard<std::mutex> lock(m_sectionsMutex);
+        for (const auto& entry : m_sections) {
+            const auto& section = entry.second;
+            auto state = section.provider ? section.provider() : std::string();
+            categories[section.category].push_back(
+                "{\"name\":" + quote(section.name) + ",\"state\":" + (state.empty() ? "null" : state) + "}");
+        }
+    }
+
+    std::string json = "{";
+    bool firstCategory = true;
+    for (const auto& category : categories) {
+        json += (firstCategory ? "" : ",") + quote(category.first) + ":[";
+        firstCategory = false;
+        bool firstSection = true;
+        for (const auto& section : category.second) {
+            json += (firstSection ? "" : ",") + section;
+            firstSection = false;
+        }
+        json += "]";
+    }
+    json += "}";
+    return json;
+}
+
+void IntrospectionServer::serveLoop() {
+    // Applies to this thread only: on Linux the nice value is per thread.
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), SERVER_THREAD_NICE_VALUE) < 0) {
+        AISDK_WARN(LX("serveLoop").d("reason", "setpriorityFailed").d("errno", errno));
+    }
+    logging::ThreadMoniker::setThisThreadName("IntrospectionServer");
+    tracing::TraceEventRecorder::setThreadName("IntrospectionServer");
+
+    while (!m_isStopping) {
+        pollfd listenPoll{m_listenFd, POLLIN, 0};
+        auto result = poll(&listenPoll, 1, POLL_TIMEOUT_MS);
+        if (result <= 0) {
+            if (result < 0 && EINTR != errno) {
+                AISDK_ERROR(LX("serveLoopFailed").d("reason", "pollFailed").d("errno", errno));
+                return;
+            }
+            continue;
+        }
+        int clientFd = accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (clientFd < 0) {
+            AISDK_WARN(LX("serveLoop").d("reason", "acceptFailed").d("errno", errno));
+            continue;
+        }
+        serveClient(clientFd);
+        close(clientFd);
+    }
+}
+
+void IntrospectionServer::serveClient(int clientFd) {
+    AISDK_DEBUG0(LX("clientConnected"));
+    std::string pending;
+    char buffer[512];
+    while (!m_isStopping) {
+        pollfd clientPoll{clientFd, POLLIN, 0};
+        auto result = poll(&clientPoll, 1, POLL_TIMEOUT_MS);
+        if (result < 0 && EINTR != errno) {
+            return;
+        }
+        if (result <= 0) {
+            continue;
+        }
+        auto received = recv(clientFd, buffer, sizeof(buffer), 0);
+        if (received < 0 && EINTR == errno) {
+            continue;
+        }
+        if (received <= 0) {
+            AISDK_DEBUG0(LX("clientDisconnected"));
+            return;
+        }
+        pending.append(buffer, static_cast<size_t>(received));
+
+        size_t lineEnd;
+        while ((lineEnd = pending.find('\n')) != std::string::npos) {
+            auto command = pending.substr(0, lineEnd);
+            pending.erase(0, lineEnd + 1);
+            if (!command.empty() && '\r' == command.back()) {
+                command.pop_back();
+            }
+            if (command.empty()) {
+                continue;
+            }
+            if (!writeAnswer(clientFd, handleCommand(command))) {
+                return;
+            }
+        }
+        if (pending.size() > MAX_COMMAND_LENGTH) {
+            writeAnswer(clientFd, errorAnswer("command too long"));
+            return;
+        }
+    }
+}
+
+}  // namespace introspection
+}  // namespace utils
+}  // namespace aisdk
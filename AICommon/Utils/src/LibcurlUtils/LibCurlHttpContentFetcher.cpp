@@ -18,6 +18,7 @@
 #include <Utils/LibcurlUtils/LibCurlHttpContentFetcher.h>
 #include <Utils/Threading/Memory.h>
 #include <Utils/Logging/Logger.h>
+#include <Utils/Logging/ThreadMoniker.h>
 
 // delete Sven
 //#include <AICommon/Utils/SDS/InProcessSDS.h>
@@ -212,6 +213,7 @@ std::unique_ptr<utils::HTTPContent> LibCurlHttpContentFetcher::getContent(
             }
 
             m_thread = std::thread([this]() {
+                utils::logging::ThreadMoniker::setThisThreadName("LibCurlHttpContentFetcher");
                 auto curlMultiHandle = utils::libcurlUtils::CurlMultiHandleWrapper::create();
                 if (!curlMultiHandle) {
                     AISDK_ERROR(LX("getContentFailed").d("reason", "curlMultiHandleWrapperCreateFailed"));
@@ -293,6 +295,7 @@ std::unique_ptr<utils::HTTPContent> LibCurlHttpContentFetcher::getContent(
                 return nullptr;
             }
             m_thread = std::thread([this]() {
+                utils::logging::ThreadMoniker::setThisThreadName("LibCurlHttpContentFetcher");
                 auto curlMultiHandle = utils::libcurlUtils::CurlMultiHandleWrapper::create();
                 if (!curlMultiHandle) {
                     AISDK_ERROR(LX("getContentFailed").d("reason", "curlMultiHandleWrapperCreateFailed"));
@@ -0,0 +1,261 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "Utils/Logging/FileLogger.h"
+#include "Utils/Logging/ThreadMoniker.h"
+#include "Utils/Metrics/MemoryAccounting.h"
+
+namespace aisdk {
+namespace utils {
+namespace logging {
+
+// The definition for these static class members.
+constexpr std::chrono::milliseconds FileLogger::FLUSH_INTERVAL;
+constexpr size_t FileLogger::FLUSH_THRESHOLD_IN_BYTES;
+
+/// Maximum number of buffers passed to a single @c writev() call.
+#ifdef IOV_MAX
+static const size_t MAX_IOVECS = IOV_MAX;
+#else
+static const size_t MAX_IOVECS = 1024;
+#endif
+
+std::shared_ptr<Logger> FileLogger::instance() {
+    static std::shared_ptr<Logger> singleFileLogger = std::shared_ptr<FileLogger>(new FileLogger);
+    return singleFileLogger;
+}
+
+FileLogger::FileLogger() :
+        Logger(Level::UNKNOWN),
+        m_pendingBytes{0},
+        m_isSyncRequested{false},
+        m_isStopping{false},
+        m_path{ACSDK_FILE_LOGGER_PATH},
+        m_maxFileSize{ACSDK_FILE_LOGGER_MAX_SIZE},
+        m_maxFiles{ACSDK_FILE_LOGGER_MAX_FILES},
+        m_fd{-1},
+        m_fileSize{0} {
+#ifdef DEBUG
+    setLevel(Level::DEBUG5);
+#else
+    setLevel(Level::INFO);
+#endif  // DEBUG
+    {
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+        openLocked();
+    }
+    m_writerThread = std::thread(&FileLogger::writerLoop, this);
+    std::string ver{"v1.0.1"};
+    std::string currentVersionLogEntry("sdkVersion: " + ver);
+    emit(aisdk::utils::logging::Level::INFO, std::chrono::system_clock::now(), "1", currentVersionLogEntry.c_str());
+}
+
+FileLogger::~FileLogger() {
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        m_isStopping = true;
+    }
+    m_wakeTrigger.notify_one();
+    if (m_writerThread.joinable()) {
+        m_writerThread.join();
+    }
+    flush(true);
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+void FileLogger::emit(
+    Level level,
+    std::chrono::system_clock::time_point time,
+    const char* threadMoniker,
+    const char* text) {
+    auto line = m_logFormatter.format(level, time, threadMoniker, text);
+    line.push_back('\n');
+    bool flushNow = false;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        m_pendingBytes += line.size();
+        metrics::MemoryAccounting::allocate(metrics::MemoryAccounting::Subsystem::LOGGER, line.size());
+        m_pending.push_back(std::move(line));
+        if (level >= Level::ERROR && level < Level::NONE) {
+            // Errors often precede a crash, so the writer thread gets them (and everything before them) onto the disk
+            // right away, while the thread which logged them goes on.
+            m_isSyncRequested = true;
+        }
+        flushNow = m_isSyncRequested || m_pendingBytes >= FLUSH_THRESHOLD_IN_BYTES;
+    }
+    if (flushNow) {
+        m_wakeTrigger.notify_one();
+    }
+}
+
+bool FileLogger::configure(const std::string& path, size_t maxFileSize, unsigned int maxFiles) {
+    if (path.empty() || !maxFileSize || !maxFiles) {
+        return false;
+    }
+    flush(true);
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_path = path;
+    m_maxFileSize = maxFileSize;
+    m_maxFiles = maxFiles;
+    return openLocked();
+}
+
+void FileLogger::flush(bool sync) {
+    // Take the file lock first so lines are written in the order they were queued.
+    std::lock_guard<std::mutex> fileLock(m_fileMutex);
+    std::vector<std::string> lines;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        lines.swap(m_pending);
+        metrics::MemoryAccounting::release(metrics::MemoryAccounting::Subsystem::LOGGER, m_pendingBytes);
+        m_pendingBytes = 0;
+    }
+    writeLocked(lines, sync);
+}
+
+void FileLogger::writerLoop() {
+    ThreadMoniker::setThisThreadName("FileLogger");
+    std::unique_lock<std::mutex> lock(m_pendingMutex);
+    while (!m_isStopping) {
+        m_wakeTrigger.wait_for(lock, FLUSH_INTERVAL, [this] {
+            return m_isStopping || m_isSyncRequested || m_pendingBytes >= FLUSH_THRESHOLD_IN_BYTES;
+        });
+        if (m_pending.empty() && !m_isSyncRequested) {
+            continue;
+        }
+        bool sync = m_isSyncRequested;
+        m_isSyncRequested = false;
+        lock.unlock();
+        flush(sync);
+        lock.lock();
+    }
+}
+
+void FileLogger::writeLocked(std::vector<std::string>& lines, bool sync) {
+    if (lines.empty() && !sync) {
+        return;
+    }
+    if (m_fd < 0 && !openLocked()) {
+        return;
+    }
+
+    std::vector<struct iovec> iovecs;
+    iovecs.reserve(std::min(lines.size(), MAX_IOVECS));
+    size_t next = 0;
+    while (next < lines.size()) {
+        // Batch as many lines as fit in one writev() without going past the rotation size.
+        iovecs.clear();
+        size_t batchBytes = 0;
+        while (next < lines.size() && iovecs.size() < MAX_IOVECS) {
+            auto& line = lines[next];
+            if (!iovecs.empty() && m_fileSize + batchBytes + line.size() > m_maxFileSize) {
+                break;
+            }
+            iovecs.push_back({const_cast<char*>(line.data()), line.size()});
+            batchBytes += line.size();
+            ++next;
+        }
+
+        size_t first = 0;
+        while (first < iovecs.size()) {
+            auto written = ::writev(m_fd, &iovecs[first], static_cast<int>(iovecs.size() - first));
+            if (written < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                std::fprintf(stderr, "FileLogger: writev to %s failed, errno=%d\n", m_path.c_str(), errno);
+                return;
+            }
+            m_fileSize += static_cast<size_t>(written);
+            // Skip the buffers that were written completely and trim a partially written one.
+            auto remaining = static_cast<size_t>(written);
+            while (first < iovecs.size() && remaining >= iovecs[first].iov_len) {
+                remaining -= iovecs[first].iov_len;
+                ++first;
+            }
+            if (first < iovecs.size()) {
+                iovecs[first].iov_base = static_cast<char*>(iovecs[first].iov_base) + remaining;
+                iovecs[first].iov_len -= remaining;
+            }
+        }
+
+        if (m_fileSize >= m_maxFileSize) {
+            if (sync) {
+                ::fsync(m_fd);
+            }
+            rotateLocked();
+            if (m_fd < 0) {
+                return;
+            }
+        }
+    }
+    if (sync) {
+        ::fsync(m_fd);
+    }
+}
+
+bool FileLogger::openLocked() {
+    m_fd = ::open(m_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        // Logging through the logger itself would recurse, so report straight to stderr.
+        std::fprintf(stderr, "FileLogger: cannot open %s, errno=%d\n", m_path.c_str(), errno);
+        m_fileSize = 0;
+        return false;
+    }
+    struct stat fileStat;
+    m_fileSize = (0 == ::fstat(m_fd, &fileStat)) ? static_cast<size_t>(fileStat.st_size) : 0;
+    return true;
+}
+
+void FileLogger::rotateLocked() {
+    ::close(m_fd);
+    m_fd = -1;
+    if (m_maxFiles > 1) {
+        // Shift <path>.N-1 to <path>.N, dropping the oldest, then move the current file to <path>.1.
+        for (auto index = m_maxFiles - 1; index > 1; --index) {
+            auto from = m_path + "." + std::to_string(index - 1);
+            auto to = m_path + "." + std::to_string(index);
+            ::rename(from.c_str(), to.c_str());
+        }
+        auto to = m_path + ".1";
+        ::rename(m_path.c_str(), to.c_str());
+    } else {
+        ::unlink(m_path.c_str());
+    }
+    openLocked();
+}
+
+std::shared_ptr<Logger> getFileLogger() {
+    return FileLogger::instance();
+}
+
+}  // namespace logging
+}  // namespace utils
+}  // namespace aisdk
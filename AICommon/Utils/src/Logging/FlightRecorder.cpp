@@ -0,0 +1,364 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "Utils/Logging/FlightRecorder.h"
+#include "Utils/Logging/ThreadMoniker.h"
+#include "Utils/Metrics/MemoryAccounting.h"
+
+namespace aisdk {
+namespace utils {
+namespace logging {
+
+// The definition for these static class members.
+constexpr size_t FlightRecorder::DEFAULT_CAPACITY_IN_BYTES;
+constexpr size_t FlightRecorder::MAX_TEXT_SIZE_IN_BYTES;
+constexpr const char* FlightRecorder::DEFAULT_DUMP_FILE_PATH;
+constexpr std::chrono::seconds FlightRecorder::MIN_ERROR_DUMP_INTERVAL;
+constexpr unsigned int FlightRecorder::MAX_DUMP_FILES;
+static_assert(FlightRecorder::MAX_DUMP_FILES < 10, "The rotated dumps are named with a single digit.");
+std::atomic<bool> FlightRecorder::m_recording{false};
+
+/// The signals which dump the ring before the process dies.
+static const int FATAL_SIGNALS[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+/// Header written at the start of every dump.
+static const char DUMP_HEADER[] = "---- flight recorder dump (time is ms since epoch) ----\n";
+
+/// Size of the buffer used to render one slot as a line of text.
+static const size_t LINE_BUFFER_SIZE = 320;
+
+/// Size of the buffers holding the path of a rotated dump: the dump file path and a one digit suffix.
+static const size_t ROTATED_PATH_BUFFER_SIZE = 256 + 3;
+
+/**
+ * Append the decimal representation of a number to a buffer.  Unlike snprintf() this is async-signal-safe.
+ *
+ * @param value The number to append.
+ * @param out The buffer to append to.
+ * @return The number of characters appended.
+ */
+static size_t appendNumber(int64_t value, char* out) {
+    char digits[24];
+    size_t count = 0;
+    bool negative = value < 0;
+    uint64_t magnitude = negative ? static_cast<uint64_t>(-(value + 1)) + 1 : static_cast<uint64_t>(value);
+    do {
+        digits[count++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    size_t length = 0;
+    if (negative) {
+        out[length++] = '-';
+    }
+    while (count) {
+        out[length++] = digits[--count];
+    }
+    return length;
+}
+
+/**
+ * Write a whole buffer to a file descriptor, retrying on partial writes.
+ *
+ * @param fd The file descriptor to write to.
+ * @param data The data to write.
+ * @param size The number of bytes to write.
+ * @return Whether all of the data was written.
+ */
+static bool writeFully(int fd, const char* data, size_t size) {
+    while (size) {
+        auto written = ::write(fd, data, size);
+        if (written < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+/**
+ * Handler for fatal signals.  Dumps the ring, restores the default action and re-raises the signal.
+ *
+ * @param signalNumber The signal received.
+ */
+static void fatalSignalHandler(int signalNumber) {
+    FlightRecorder::instance().dumpOnSignal();
+    ::signal(signalNumber, SIG_DFL);
+    ::raise(signalNumber);
+}
+
+FlightRecorder& FlightRecorder::instance() {
+    static FlightRecorder singleFlightRecorder;
+    return singleFlightRecorder;
+}
+
+FlightRecorder::FlightRecorder() :
+        m_slotCount{0},
+        m_writeIndex{0},
+        m_dumpLevel{Level::ERROR},
+        m_lastLevelDumpMs{0},
+        m_isDumpRequested{false},
+        m_isStopping{false} {
+    m_dumping.clear();
+    std::strncpy(m_dumpFilePath, DEFAULT_DUMP_FILE_PATH, sizeof(m_dumpFilePath) - 1);
+    m_dumpFilePath[sizeof(m_dumpFilePath) - 1] = '\0';
+}
+
+FlightRecorder::~FlightRecorder() {
+    {
+        std::lock_guard<std::mutex> lock(m_dumpThreadMutex);
+        m_isStopping = true;
+    }
+    m_dumpTrigger.notify_one();
+    if (m_dumpThread.joinable()) {
+        m_dumpThread.join();
+    }
+}
+
+bool FlightRecorder::enable(size_t capacityInBytes) {
+    if (isRecording()) {
+        return true;
+    }
+    if (!m_slots) {
+        auto slotCount = capacityInBytes / sizeof(Slot);
+        if (!slotCount) {
+            return false;
+        }
+        m_slots.reset(new (std::nothrow) Slot[slotCount]);
+        if (!m_slots) {
+            return false;
+        }
+        for (size_t i = 0; i < slotCount; ++i) {
+            m_slots[i].sequence.store(0, std::memory_order_relaxed);
+        }
+        m_slotCount = slotCount;
+        // The slots are kept until the process exits, so they are never released from the accounting.
+        metrics::MemoryAccounting::allocate(metrics::MemoryAccounting::Subsystem::LOGGER, slotCount * sizeof(Slot));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_dumpThreadMutex);
+        if (!m_dumpThread.joinable()) {
+            m_dumpThread = std::thread(&FlightRecorder::dumpLoop, this);
+        }
+    }
+    m_recording.store(true, std::memory_order_release);
+    return true;
+}
+
+void FlightRecorder::disable() {
+    m_recording.store(false, std::memory_order_release);
+}
+
+void FlightRecorder::record(
+    Level level,
+    std::chrono::system_clock::time_point time,
+    const char* threadMoniker,
+    const char* text) {
+    if (!isRecording()) {
+        return;
+    }
+    auto index = m_writeIndex.fetch_add(1, std::memory_order_relaxed);
+    auto& slot = m_slots[index % m_slotCount];
+
+    // Mark the slot as being written so that a concurrent dump skips it.
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+    slot.level = level;
+    std::strncpy(slot.threadMoniker, threadMoniker ? threadMoniker : "", sizeof(slot.threadMoniker));
+    size_t length = text ? strnlen(text, sizeof(slot.text)) : 0;
+    if (length) {
+        std::memcpy(slot.text, text, length);
+    }
+    slot.length = static_cast<uint16_t>(length);
+
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+
+    maybeDumpOnLevel(level);
+}
+
+bool FlightRecorder::setDumpFilePath(const std::string& path) {
+    if (path.empty() || path.size() >= sizeof(m_dumpFilePath)) {
+        return false;
+    }
+    std::memcpy(m_dumpFilePath, path.c_str(), path.size() + 1);
+    return true;
+}
+
+void FlightRecorder::setDumpLevel(Level level) {
+    m_dumpLevel = level;
+}
+
+bool FlightRecorder::dump() {
+    if (m_dumping.test_and_set(std::memory_order_acquire)) {
+        // Another thread is writing a dump right now; it will contain the same entries.
+        return false;
+    }
+    bool result = dumpToPath();
+    m_dumping.clear(std::memory_order_release);
+    return result;
+}
+
+void FlightRecorder::dumpOnSignal() {
+    // The thread which crashed may hold @c m_dumping, so do not wait for it.
+    dumpToPath();
+}
+
+bool FlightRecorder::dumpToPath() {
+    rotateDumpFiles();
+    int fd = ::open(m_dumpFilePath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    bool result = dumpToFd(fd);
+    ::fsync(fd);
+    ::close(fd);
+    return result;
+}
+
+void FlightRecorder::rotateDumpFiles() {
+    if (MAX_DUMP_FILES <= 1) {
+        return;
+    }
+    char from[ROTATED_PATH_BUFFER_SIZE];
+    char to[ROTATED_PATH_BUFFER_SIZE];
+    auto pathLength = strnlen(m_dumpFilePath, sizeof(m_dumpFilePath) - 1);
+    std::memcpy(from, m_dumpFilePath, pathLength);
+    std::memcpy(to, m_dumpFilePath, pathLength);
+    from[pathLength] = '.';
+    to[pathLength] = '.';
+    from[pathLength + 2] = '\0';
+    to[pathLength + 2] = '\0';
+    for (auto index = MAX_DUMP_FILES - 1; index > 1; --index) {
+        from[pathLength + 1] = static_cast<char>('0' + index - 1);
+        to[pathLength + 1] = static_cast<char>('0' + index);
+        ::rename(from, to);
+    }
+    to[pathLength + 1] = '1';
+    ::rename(m_dumpFilePath, to);
+}
+
+bool FlightRecorder::dumpToFd(int fd) {
+    if (!m_slots) {
+        return false;
+    }
+    if (!writeFully(fd, DUMP_HEADER, sizeof(DUMP_HEADER) - 1)) {
+        return false;
+    }
+    auto end = m_writeIndex.load(std::memory_order_acquire);
+    auto begin = end > m_slotCount ? end - m_slotCount : 0;
+    char line[LINE_BUFFER_SIZE];
+    for (auto index = begin; index < end; ++index) {
+        const auto& slot = m_slots[index % m_slotCount];
+        auto expected = 2 * index + 2;
+        if (slot.sequence.load(std::memory_order_acquire) != expected) {
+            // Still being written, or already overwritten by a newer entry.
+            continue;
+        }
+
+        size_t length = appendNumber(slot.timeMs, line);
+        line[length++] = ' ';
+        line[length++] = '[';
+        auto monikerLength = strnlen(slot.threadMoniker, sizeof(slot.threadMoniker));
+        std::memcpy(line + length, slot.threadMoniker, monikerLength);
+        length += monikerLength;
+        line[length++] = ']';
+        line[length++] = ' ';
+        line[length++] = convertLevelToChar(slot.level);
+        line[length++] = ' ';
+        auto textLength = std::min<size_t>(slot.length, sizeof(slot.text));
+        std::memcpy(line + length, slot.text, textLength);
+        length += textLength;
+        line[length++] = '\n';
+
+        // Drop the line if the slot was reused while it was being copied.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != expected) {
+            continue;
+        }
+        if (!writeFully(fd, line, length)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FlightRecorder::installFatalSignalHandlers() {
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = fatalSignalHandler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESETHAND;
+    bool result = true;
+    for (auto signalNumber : FATAL_SIGNALS) {
+        if (sigaction(signalNumber, &action, nullptr) != 0) {
+            result = false;
+        }
+    }
+    return result;
+}
+
+void FlightRecorder::maybeDumpOnLevel(Level level) {
+    auto dumpLevel = m_dumpLevel.load();
+    if (Level::NONE == dumpLevel || level < dumpLevel || level >= Level::NONE) {
+        return;
+    }
+    auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now().time_since_epoch())
+                     .count();
+    auto lastMs = m_lastLevelDumpMs.load();
+    auto intervalMs = std::chrono::duration_cast<std::chrono::milliseconds>(MIN_ERROR_DUMP_INTERVAL).count();
+    if (lastMs && nowMs - lastMs < intervalMs) {
+        return;
+    }
+    if (!m_lastLevelDumpMs.compare_exchange_strong(lastMs, nowMs)) {
+        // Another thread is dumping for the same burst of errors.
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_dumpThreadMutex);
+        m_isDumpRequested = true;
+    }
+    m_dumpTrigger.notify_one();
+}
+
+void FlightRecorder::dumpLoop() {
+    ThreadMoniker::setThisThreadName("FlightRecorder");
+    std::unique_lock<std::mutex> lock(m_dumpThreadMutex);
+    while (true) {
+        m_dumpTrigger.wait(lock, [this] { return m_isStopping || m_isDumpRequested; });
+        if (m_isStopping) {
+            return;
+        }
+        m_isDumpRequested = false;
+        lock.unlock();
+        dump();
+        lock.lock();
+    }
+}
+
+}  // namespace logging
+}  // namespace utils
+}  // namespace aisdk
@@ -13,9 +13,12 @@
 
 #include "Utils/Logging/LogEntry.h"
 
+#include <algorithm>
 #include <cstring>
 #include <iomanip>
 
+#include "Utils/Logging/FlightRecorder.h"
+
 namespace aisdk {
 namespace utils {
 namespace logging {
@@ -50,14 +53,44 @@ static const std::string BOOL_TRUE = "true";
 /// String for boolean FALSE
 static const std::string BOOL_FALSE = "false";
 
-LogEntry::LogEntry(const std::string& source, const char* event) : m_hasMetadata(false) {
+/// The longest text of a raw entry, which is what the @c FlightRecorder keeps of an entry.
+static const size_t MAX_RAW_TEXT_SIZE = FlightRecorder::MAX_TEXT_SIZE_IN_BYTES - 1;
+
+/// Whether the entries built by this thread are captured raw, see @c LogEntry::RawCapture.
+static thread_local bool isCapturingRaw = false;
+
+LogEntry::RawCapture::RawCapture() : m_wasCapturingRaw{isCapturingRaw} {
+    isCapturingRaw = true;
+}
+
+LogEntry::RawCapture::~RawCapture() {
+    isCapturingRaw = m_wasCapturingRaw;
+}
+
+LogEntry::LogEntry(const std::string& source, const char* event) : m_isRaw{isCapturingRaw}, m_hasMetadata(false) {
+    if (m_isRaw) {
+        appendRaw(source.c_str(), source.size());
+        appendRaw(&SECTION_SEPARATOR, 1);
+        if (event) {
+            appendRaw(event, strlen(event));
+        }
+        return;
+    }
     m_stream << source << SECTION_SEPARATOR;
     if (event) {
         m_stream << event;
     }
 }
 
-LogEntry::LogEntry(const std::string& source, const std::string& event) : m_hasMetadata(false) {
+LogEntry::LogEntry(const std::string& source, const std::string& event) :
+        m_isRaw{isCapturingRaw},
+        m_hasMetadata(false) {
+    if (m_isRaw) {
+        appendRaw(source.c_str(), source.size());
+        appendRaw(&SECTION_SEPARATOR, 1);
+        appendRaw(event.c_str(), event.size());
+        return;
+    }
     m_stream << source << SECTION_SEPARATOR << event;
 }
 
@@ -70,6 +103,12 @@ LogEntry& LogEntry::d(const char* key, char* value) {
 }
 
 LogEntry& LogEntry::d(const char* key, const char* value) {
+    if (m_isRaw) {
+        if (prefixRawValue(key) && value) {
+            appendRaw(value, strlen(value));
+        }
+        return *this;
+    }
     prefixKeyValuePair();
     if (!key) {
         key = "";
@@ -96,6 +135,16 @@ LogEntry& LogEntry::d(const char* key, bool value) {
 }
 
 LogEntry& LogEntry::m(const char* message) {
+    if (m_isRaw) {
+        if (!m_hasMetadata) {
+            appendRaw(&SECTION_SEPARATOR, 1);
+        }
+        appendRaw(&SECTION_SEPARATOR, 1);
+        if (message) {
+            appendRaw(message, strlen(message));
+        }
+        return *this;
+    }
     prefixMessage();
     if (message) {
         m_stream << message;
@@ -104,6 +153,9 @@ LogEntry& LogEntry::m(const char* message) {
 }
 
 LogEntry& LogEntry::m(const std::string& message) {
+    if (m_isRaw) {
+        return m(message.c_str());
+    }
     prefixMessage();
     m_stream << message;
     return *this;
@@ -122,6 +174,49 @@ void LogEntry::prefixKeyValuePair() {
     }
 }
 
+void LogEntry::appendRaw(const char* in, size_t length) {
+    auto size = m_stream.size();
+    if (size < MAX_RAW_TEXT_SIZE) {
+        m_stream.write(in, std::min(length, MAX_RAW_TEXT_SIZE - size));
+    }
+}
+
+bool LogEntry::prefixRawValue(const char* key) {
+    if (m_stream.size() >= MAX_RAW_TEXT_SIZE) {
+        return false;
+    }
+    appendRaw(m_hasMetadata ? &PAIR_SEPARATOR : &SECTION_SEPARATOR, 1);
+    m_hasMetadata = true;
+    if (key) {
+        appendRaw(key, strlen(key));
+    }
+    // Copied, as taking the address of the class constant would require its definition.
+    const char keyValueSeparator = KEY_VALUE_SEPARATOR;
+    appendRaw(&keyValueSeparator, 1);
+    return true;
+}
+
+void LogEntry::appendRawInteger(long long value) {
+    if (value < 0) {
+        appendRaw("-", 1);
+        // Negate in unsigned arithmetic, which also holds the most negative value.
+        appendRawInteger(0ULL - static_cast<unsigned long long>(value));
+    } else {
+        appendRawInteger(static_cast<unsigned long long>(value));
+    }
+}
+
+void LogEntry::appendRawInteger(unsigned long long value) {
+    char digits[20];
+    auto end = digits + sizeof(digits);
+    auto begin = end;
+    do {
+        *--begin = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    appendRaw(begin, end - begin);
+}
+
 void LogEntry::prefixMessage() {
     if (!m_hasMetadata) {
         m_stream << SECTION_SEPARATOR;
@@ -65,6 +65,10 @@ const char* LogEntryBuffer::c_str() const {
     return m_base;
 }
 
+size_t LogEntryBuffer::size() const {
+    return pptr() - m_base;
+}
+
 }  // namespace logging
 }  // namespace utils
 }  // namespace aisdk
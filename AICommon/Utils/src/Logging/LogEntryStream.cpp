@@ -24,6 +24,10 @@ const char* LogEntryStream::LogEntryStream::c_str() const {
     return LogEntryBuffer::c_str();
 }
 
+size_t LogEntryStream::size() const {
+    return LogEntryBuffer::size();
+}
+
 }  // namespace logging
 }  // namespace utils
 }  // namespace aisdk
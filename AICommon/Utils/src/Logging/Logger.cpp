@@ -31,8 +31,19 @@ Logger::Logger(Level level) : m_level{level} {
 }
 
 void Logger::log(Level level, const LogEntry& entry) {
+    auto now = std::chrono::system_clock::now();
+    if (FlightRecorder::isRecording()) {
+        FlightRecorder::instance().record(level, now, ThreadMoniker::getThisThreadMoniker().c_str(), entry.c_str());
+    }
     if (shouldLog(level)) {
-        emit(level, std::chrono::system_clock::now(), AT_EXIT_THREAD_ID, entry.c_str());	// fix issue log sven
+        emit(level, now, AT_EXIT_THREAD_ID, entry.c_str());	// fix issue log sven
+    }
+}
+
+void Logger::record(Level level, const LogEntry& entry) {
+    if (FlightRecorder::isRecording()) {
+        FlightRecorder::instance().record(
+            level, std::chrono::system_clock::now(), ThreadMoniker::getThisThreadMoniker().c_str(), entry.c_str());
     }
 }
 
@@ -42,7 +53,7 @@ void Logger::setLevel(Level level) {
         m_level = level;
         //notifyObserversOnLogLevelChanged();
     }
-#ifndef AISDK_DEBUG_LOG_ENABLED
+#if !defined(AISDK_DEBUG_LOG_ENABLED) && !defined(AISDK_FLIGHT_RECORDER_DEBUG_LOG_ENABLED)
     if (m_level <= Level::DEBUG0) {
         // Log without AISDK_* macros to avoid recursive invocation of constructor.
         log(Level::WARN,
@@ -12,8 +12,16 @@
 
 #include <atomic>
 #include <iomanip>
+#include <mutex>
 #include <sstream>
 #include <thread>
+
+#ifndef _WIN32
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include "Utils/Logging/ThreadMoniker.h"
 
 namespace aisdk {
@@ -23,12 +31,58 @@ namespace logging {
 /// Counter to generate (small) unique thread monikers.
 static std::atomic<int> g_nextThreadMoniker(1);
 
-ThreadMoniker::ThreadMoniker() {
+/// The threads named with @c setThisThreadName().
+struct NamedThreadRegistry {
+    /// Serializes access to @c threads.
+    std::mutex mutex;
+    /// The named threads, keyed by their OS thread id.
+    std::map<int, ThreadMoniker::NamedThread> threads;
+};
+
+/**
+ * Get the registry of named threads.  It is never destroyed, as threads may exit after static destruction began.
+ *
+ * @return The registry of named threads.
+ */
+static NamedThreadRegistry& getNamedThreadRegistry() {
+    static NamedThreadRegistry* registry = new NamedThreadRegistry;
+    return *registry;
+}
+
+ThreadMoniker::ThreadMoniker() : m_namedThreadId{0} {
     std::ostringstream stream;
     stream << std::setw(3) << std::hex << std::right << g_nextThreadMoniker++;
     m_moniker = stream.str();
 }
 
+ThreadMoniker::~ThreadMoniker() {
+    if (m_namedThreadId) {
+        auto& registry = getNamedThreadRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.threads.erase(m_namedThreadId);
+    }
+}
+
+void ThreadMoniker::setThisThreadName(const std::string& name) {
+#ifndef _WIN32
+    auto& thisThread = getThisThread();
+    thisThread.m_namedThreadId = static_cast<int>(syscall(SYS_gettid));
+    {
+        auto& registry = getNamedThreadRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.threads[thisThread.m_namedThreadId] = NamedThread{thisThread.m_moniker, name};
+    }
+    // The kernel keeps at most 15 characters and truncates longer names itself.
+    prctl(PR_SET_NAME, name.c_str(), 0, 0, 0);
+#endif
+}
+
+std::map<int, ThreadMoniker::NamedThread> ThreadMoniker::getNamedThreads() {
+    auto& registry = getNamedThreadRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.threads;
+}
+
 }  // namespace logging
 }  // namespace utils
 }  // namespace aisdk
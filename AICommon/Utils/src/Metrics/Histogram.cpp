@@ -0,0 +1,124 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include "Utils/Metrics/Histogram.h"
+
+namespace aisdk {
+namespace utils {
+namespace metrics {
+
+// The definition for these static class members.
+constexpr unsigned int Histogram::SUB_BUCKET_BITS;
+constexpr size_t Histogram::NUM_BUCKETS;
+
+/// Number of values below which every value has its own bucket.
+static const uint64_t EXACT_LIMIT = 1u << Histogram::SUB_BUCKET_BITS;
+
+/// Number of buckets each power of two above @c EXACT_LIMIT is split into.
+static const uint64_t BUCKETS_PER_POWER = 1u << (Histogram::SUB_BUCKET_BITS - 1);
+
+/**
+ * Get the position of the most significant set bit of a value.
+ *
+ * @param value The value, which must not be zero.
+ * @return The position of the most significant set bit.
+ */
+static unsigned int mostSignificantBit(uint64_t value) {
+    return 63 - static_cast<unsigned int>(__builtin_clzll(value));
+}
+
+Histogram::Histogram() : m_count{0}, m_sum{0}, m_min{std::numeric_limits<uint64_t>::max()}, m_max{0} {
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t Histogram::bucketIndex(uint64_t value) {
+    if (value < EXACT_LIMIT) {
+        return static_cast<size_t>(value);
+    }
+    auto msb = mostSignificantBit(value);
+    // The top SUB_BUCKET_BITS bits of the value, which always start with a one.
+    auto top = value >> (msb - SUB_BUCKET_BITS + 1);
+    return static_cast<size_t>(
+        EXACT_LIMIT + (msb - SUB_BUCKET_BITS) * BUCKETS_PER_POWER + (top - BUCKETS_PER_POWER));
+}
+
+uint64_t Histogram::bucketUpperBound(size_t index) {
+    if (index < EXACT_LIMIT) {
+        return index;
+    }
+    if (index >= NUM_BUCKETS - 1) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    auto offset = index - EXACT_LIMIT;
+    auto shift = offset / BUCKETS_PER_POWER + 1;
+    auto top = offset % BUCKETS_PER_POWER + BUCKETS_PER_POWER;
+    return ((top + 1) << shift) - 1;
+}
+
+void Histogram::record(uint64_t value) {
+    m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    auto current = m_max.load(std::memory_order_relaxed);
+    while (value > current && !m_max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+    current = m_min.load(std::memory_order_relaxed);
+    while (value < current && !m_min.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot snapshot;
+    snapshot.buckets.reserve(NUM_BUCKETS);
+    uint64_t count = 0;
+    for (const auto& bucket : m_buckets) {
+        auto value = bucket.load(std::memory_order_relaxed);
+        snapshot.buckets.push_back(value);
+        count += value;
+    }
+    // Use the bucket total so percentiles agree with the buckets even while values are being recorded.
+    snapshot.count = count;
+    snapshot.sum = m_sum.load(std::memory_order_relaxed);
+    snapshot.max = m_max.load(std::memory_order_relaxed);
+    auto min = m_min.load(std::memory_order_relaxed);
+    snapshot.min = count ? std::min(min, snapshot.max) : 0;
+    return snapshot;
+}
+
+uint64_t Histogram::Snapshot::percentile(double percentile) const {
+    if (!count) {
+        return 0;
+    }
+    auto rank = static_cast<uint64_t>(percentile / 100.0 * count + 0.5);
+    rank = std::max<uint64_t>(1, std::min(rank, count));
+    uint64_t seen = 0;
+    for (size_t index = 0; index < buckets.size(); ++index) {
+        seen += buckets[index];
+        if (seen >= rank) {
+            return std::min(bucketUpperBound(index), max);
+        }
+    }
+    return max;
+}
+
+double Histogram::Snapshot::mean() const {
+    return count ? static_cast<double>(sum) / count : 0.0;
+}
+
+}  // namespace metrics
+}  // namespace utils
+}  // namespace aisdk
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <atomic>
+#include <memory>
+#include <sstream>
+
+#include "Utils/Metrics/MemoryAccounting.h"
+#include "Utils/Metrics/MetricsRegistry.h"
+
+namespace aisdk {
+namespace utils {
+namespace metrics {
+
+constexpr size_t MemoryAccounting::NUM_SUBSYSTEMS;
+
+namespace {
+
+/// The accounting of one subsystem.
+struct SubsystemState {
+    /// Bytes held now.
+    std::atomic<uint64_t> currentBytes;
+    /// Most bytes held at any time.
+    std::atomic<uint64_t> peakBytes;
+    /// The gauge exporting @c currentBytes.
+    std::shared_ptr<Gauge> currentGauge;
+    /// The gauge exporting @c peakBytes.
+    std::shared_ptr<Gauge> peakGauge;
+};
+
+/**
+ * Get the accounting of a subsystem.  The accounting is never destroyed, so that charges held by static objects can
+ * still be released while the process exits.
+ *
+ * @param subsystem The subsystem.
+ * @return The accounting of the subsystem.
+ */
+SubsystemState& getState(MemoryAccounting::Subsystem subsystem) {
+    static SubsystemState* states = [] {
+        auto result = new SubsystemState[MemoryAccounting::NUM_SUBSYSTEMS];
+        auto& registry = MetricsRegistry::instance();
+        for (size_t index = 0; index < MemoryAccounting::NUM_SUBSYSTEMS; ++index) {
+            std::ostringstream name;
+            name << static_cast<MemoryAccounting::Subsystem>(index);
+            MetricsRegistry::Labels labels{{"subsystem", name.str()}};
+            result[index].currentBytes = 0;
+            result[index].peakBytes = 0;
+            result[index].currentGauge =
+                registry.getGauge("aisdk_memory_bytes", labels, "Bytes held by a subsystem of the SDK.");
+            result[index].peakGauge = registry.getGauge(
+                "aisdk_memory_peak_bytes", labels, "Most bytes held by a subsystem of the SDK at any time.");
+        }
+        return result;
+    }();
+    return states[static_cast<size_t>(subsystem)];
+}
+
+}  // namespace
+
+void MemoryAccounting::allocate(Subsystem subsystem, size_t bytes) {
+    if (!bytes) {
+        return;
+    }
+    auto& state = getState(subsystem);
+    auto current = state.currentBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    auto peak = state.peakBytes.load(std::memory_order_relaxed);
+    while (current > peak && !state.peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+    }
+    if (state.currentGauge) {
+        state.currentGauge->set(static_cast<int64_t>(current));
+    }
+    if (state.peakGauge && current > peak) {
+        state.peakGauge->set(static_cast<int64_t>(current));
+    }
+}
+
+void MemoryAccounting::release(Subsystem subsystem, size_t bytes) {
+    if (!bytes) {
+        return;
+    }
+    auto& state = getState(subsystem);
+    auto current = state.currentBytes.fetch_sub(bytes, std::memory_order_relaxed) - bytes;
+    if (state.currentGauge) {
+        state.currentGauge->set(static_cast<int64_t>(current));
+    }
+}
+
+MemoryAccounting::Usage MemoryAccounting::getUsage(Subsystem subsystem) {
+    auto& state = getState(subsystem);
+    return Usage{state.currentBytes.load(std::memory_order_relaxed), state.peakBytes.load(std::memory_order_relaxed)};
+}
+
+MemoryCharge::MemoryCharge(MemoryAccounting::Subsystem subsystem, size_t bytes) :
+        m_subsystem{subsystem},
+        m_bytes{bytes} {
+    MemoryAccounting::allocate(m_subsystem, m_bytes);
+}
+
+MemoryCharge::MemoryCharge(const MemoryCharge& other) : m_subsystem{other.m_subsystem}, m_bytes{other.m_bytes} {
+    MemoryAccounting::allocate(m_subsystem, m_bytes);
+}
+
+MemoryCharge& MemoryCharge::operator=(const MemoryCharge& other) {
+    if (this != &other) {
+        MemoryAccounting::allocate(other.m_subsystem, other.m_bytes);
+        MemoryAccounting::release(m_subsystem, m_bytes);
+        m_subsystem = other.m_subsystem;
+        m_bytes = other.m_bytes;
+    }
+    return *this;
+}
+
+MemoryCharge::~MemoryCharge() {
+    MemoryAccounting::release(m_subsystem, m_bytes);
+}
+
+void MemoryCharge::resize(size_t bytes) {
+    if (bytes > m_bytes) {
+        MemoryAccounting::allocate(m_subsystem, bytes - m_bytes);
+    } else {
+        MemoryAccounting::release(m_subsystem, m_bytes - bytes);
+    }
+    m_bytes = bytes;
+}
+
+void MemoryCharge::moveTo(MemoryAccounting::Subsystem subsystem) {
+    if (subsystem == m_subsystem) {
+        return;
+    }
+    MemoryAccounting::allocate(subsystem, m_bytes);
+    MemoryAccounting::release(m_subsystem, m_bytes);
+    m_subsystem = subsystem;
+}
+
+std::ostream& operator<<(std::ostream& stream, MemoryAccounting::Subsystem subsystem) {
+    switch (subsystem) {
+        case MemoryAccounting::Subsystem::SHARED_BUFFER:
+            return stream << "sharedBuffer";
+        case MemoryAccounting::Subsystem::ATTACHMENT:
+            return stream << "attachment";
+        case MemoryAccounting::Subsystem::DECODER:
+            return stream << "decoder";
+        case MemoryAccounting::Subsystem::EXECUTOR_QUEUE:
+            return stream << "executorQueue";
+        case MemoryAccounting::Subsystem::LOGGER:
+            return stream << "logger";
+    }
+    return stream << "unknown";
+}
+
+}  // namespace metrics
+}  // namespace utils
+}  // namespace aisdk
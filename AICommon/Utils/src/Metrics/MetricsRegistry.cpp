@@ -0,0 +1,448 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "Utils/Logging/Logger.h"
+#include "Utils/Logging/ThreadMoniker.h"
+#include "Utils/Metrics/MetricsRegistry.h"
+
+namespace aisdk {
+namespace utils {
+namespace metrics {
+
+/// String to identify log entries originating from this file.
+static const std::string TAG("MetricsRegistry");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
+/// The quantiles histograms are exposed with.
+static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+/**
+ * Check a metric or label name against the Prometheus naming rules.
+ *
+ * @param name The name to check.
+ * @param allowColon Whether colons are allowed, as they are in metric names but not in label names.
+ * @return Whether the name is valid.
+ */
+static bool isValidName(const std::string& name, bool allowColon) {
+    if (name.empty()) {
+        return false;
+    }
+    for (size_t index = 0; index < name.size(); ++index) {
+        auto c = name[index];
+        bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || '_' == c || (allowColon && ':' == c) ||
+                     (index > 0 && c >= '0' && c <= '9');
+        if (!valid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Write a string with the escapes of a Prometheus label value or help text.
+ *
+ * @param stream The stream to write to.
+ * @param value The string to write.
+ * @param escapeQuote Whether to escape double quotes, as label values need.
+ */
+static void writePrometheusEscaped(std::ostream& stream, const std::string& value, bool escapeQuote) {
+    for (auto c : value) {
+        if ('\\' == c) {
+            stream << "\\\\";
+        } else if ('\n' == c) {
+            stream << "\\n";
+        } else if (escapeQuote && '"' == c) {
+            stream << "\\\"";
+        } else {
+            stream << c;
+        }
+    }
+}
+
+/**
+ * Write the labels of a metric in the Prometheus format, with an optional extra label.
+ *
+ * @param stream The stream to write to.
+ * @param labels The labels of the metric.
+ * @param extraName The name of an extra label, or @c nullptr.
+ * @param extraValue The value of the extra label.
+ */
+static void writePrometheusLabels(
+    std::ostream& stream,
+    const MetricsRegistry::Labels& labels,
+    const char* extraName = nullptr,
+    const std::string& extraValue = "") {
+    if (labels.empty() && !extraName) {
+        return;
+    }
+    stream << '{';
+    bool first = true;
+    for (const auto& label : labels) {
+        stream << (first ? "" : ",") << label.first << "=\"";
+        writePrometheusEscaped(stream, label.second, true);
+        stream << '"';
+        first = false;
+    }
+    if (extraName) {
+        stream << (first ? "" : ",") << extraName << "=\"" << extraValue << '"';
+    }
+    stream << '}';
+}
+
+/**
+ * Get the Prometheus name of a metric type.
+ *
+ * @param type The type of the metric.
+ * @return The Prometheus name of the type.
+ */
+static const char* prometheusTypeName(MetricsRegistry::Type type) {
+    switch (type) {
+        case MetricsRegistry::Type::COUNTER:
+            return "counter";
+        case MetricsRegistry::Type::GAUGE:
+            return "gauge";
+        case MetricsRegistry::Type::HISTOGRAM:
+            // The buckets are too fine to be worth exporting, so histograms are exposed as summaries.
+            return "summary";
+    }
+    return "untyped";
+}
+
+/**
+ * Write a string as a JSON string literal.
+ *
+ * @param stream The stream to write to.
+ * @param value The string to write.
+ */
+static void writeJsonString(std::ostream& stream, const std::string& value) {
+    stream << '"';
+    for (auto c : value) {
+        if ('"' == c || '\\' == c) {
+            stream << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            stream << escaped;
+        } else {
+            stream << c;
+        }
+    }
+    stream << '"';
+}
+
+/**
+ * Build the key of a metric in @c m_entries.
+ *
+ * @param name The name of the metric.
+ * @param labels The labels of the metric.
+ * @return The key.
+ */
+static std::string buildKey(const std::string& name, const MetricsRegistry::Labels& labels) {
+    // '\x01' sorts before any character allowed in a name, so all metrics of a name stay adjacent.
+    std::string key = name;
+    for (const auto& label : labels) {
+        key += '\x01' + label.first + '\x02' + label.second;
+    }
+    return key;
+}
+
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry singleMetricsRegistry;
+    return singleMetricsRegistry;
+}
+
+MetricsRegistry::MetricsRegistry() :
+        m_exportInterval{0},
+        m_exportFormat{Format::PROMETHEUS},
+        m_isExportStopping{false} {
+}
+
+MetricsRegistry::~MetricsRegistry() {
+    stopFileExport();
+}
+
+std::shared_ptr<Counter> MetricsRegistry::getCounter(
+    const std::string& name,
+    const Labels& labels,
+    const std::string& help) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto entry = getEntry(name, labels, help, Type::COUNTER);
+    if (!entry) {
+        return nullptr;
+    }
+    if (!entry->counter) {
+        entry->counter = std::make_shared<Counter>();
+    }
+    return entry->counter;
+}
+
+std::shared_ptr<Gauge> MetricsRegistry::getGauge(
+    const std::string& name,
+    const Labels& labels,
+    const std::string& help) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto entry = getEntry(name, labels, help, Type::GAUGE);
+    if (!entry) {
+        return nullptr;
+    }
+    if (!entry->gauge) {
+        entry->gauge = std::make_shared<Gauge>();
+    }
+    return entry->gauge;
+}
+
+std::shared_ptr<Histogram> MetricsRegistry::getHistogram(
+    const std::string& name,
+    const Labels& labels,
+    const std::string& help) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto entry = getEntry(name, labels, help, Type::HISTOGRAM);
+    if (!entry) {
+        return nullptr;
+    }
+    if (!entry->histogram) {
+        entry->histogram = std::make_shared<Histogram>();
+    }
+    return entry->histogram;
+}
+
+MetricsRegistry::Entry* MetricsRegistry::getEntry(
+    const std::string& name,
+    const Labels& labels,
+    const std::string& help,
+    Type type) {
+    if (!isValidName(name, true)) {
+        AISDK_ERROR(LX("getMetricFailed").d("reason", "invalidName").d("name", name));
+        return nullptr;
+    }
+    for (const auto& label : labels) {
+        if (!isValidName(label.first, false)) {
+            AISDK_ERROR(
+                LX("getMetricFailed").d("reason", "invalidLabelName").d("name", name).d("label", label.first));
+            return nullptr;
+        }
+    }
+    auto typeIt = m_types.find(name);
+    if (typeIt != m_types.end() && typeIt->second != type) {
+        AISDK_ERROR(LX("getMetricFailed")
+                        .d("reason", "typeMismatch")
+                        .d("name", name)
+                        .d("registeredType", typeIt->second)
+                        .d("requestedType", type));
+        return nullptr;
+    }
+    m_types[name] = type;
+    auto& entry = m_entries[buildKey(name, labels)];
+    if (entry.name.empty()) {
+        entry.name = name;
+        entry.labels = labels;
+        entry.help = help;
+        entry.type = type;
+    }
+    return &entry;
+}
+
+std::vector<MetricsRegistry::MetricSnapshot> MetricsRegistry::snapshot() {
+    std::vector<MetricSnapshot> metrics;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    metrics.reserve(m_entries.size());
+    for (const auto& it : m_entries) {
+        const auto& entry = it.second;
+        MetricSnapshot metric;
+        metric.name = entry.name;
+        metric.labels = entry.labels;
+        metric.help = entry.help;
+        metric.type = entry.type;
+        metric.value = 0;
+        switch (entry.type) {
+            case Type::COUNTER:
+                metric.value = static_cast<int64_t>(entry.counter->value());
+                break;
+            case Type::GAUGE:
+                metric.value = entry.gauge->value();
+                break;
+            case Type::HISTOGRAM:
+                metric.histogram = entry.histogram->snapshot();
+                break;
+        }
+        metrics.push_back(std::move(metric));
+    }
+    return metrics;
+}
+
+std::string MetricsRegistry::dump(Format format) {
+    std::ostringstream stream;
+    render(snapshot(), format, stream);
+    return stream.str();
+}
+
+void MetricsRegistry::render(const std::vector<MetricSnapshot>& metrics, Format format, std::ostream& stream) {
+    if (Format::JSON == format) {
+        stream << '[';
+        bool first = true;
+        for (const auto& metric : metrics) {
+            stream << (first ? "\n" : ",\n") << "{\"name\":";
+            writeJsonString(stream, metric.name);
+            stream << ",\"type\":\"" << metric.type << "\",\"labels\":{";
+            bool firstLabel = true;
+            for (const auto& label : metric.labels) {
+                stream << (firstLabel ? "" : ",");
+                writeJsonString(stream, label.first);
+                stream << ':';
+                writeJsonString(stream, label.second);
+                firstLabel = false;
+            }
+            stream << '}';
+            if (Type::HISTOGRAM == metric.type) {
+                const auto& histogram = metric.histogram;
+                stream << ",\"count\":" << histogram.count << ",\"sum\":" << histogram.sum
+                       << ",\"min\":" << histogram.min << ",\"max\":" << histogram.max
+                       << ",\"mean\":" << histogram.mean() << ",\"p50\":" << histogram.percentile(50)
+                       << ",\"p90\":" << histogram.percentile(90) << ",\"p99\":" << histogram.percentile(99)
+                       << ",\"p999\":" << histogram.percentile(99.9);
+            } else {
+                stream << ",\"value\":" << metric.value;
+            }
+            stream << '}';
+            first = false;
+        }
+        stream << "\n]\n";
+        return;
+    }
+
+    const std::string* previousName = nullptr;
+    for (const auto& metric : metrics) {
+        if (!previousName || *previousName != metric.name) {
+            if (!metric.help.empty()) {
+                stream << "# HELP " << metric.name << ' ';
+                writePrometheusEscaped(stream, metric.help, false);
+                stream << '\n';
+            }
+            stream << "# TYPE " << metric.name << ' ' << prometheusTypeName(metric.type) << '\n';
+            previousName = &metric.name;
+        }
+        if (Type::HISTOGRAM != metric.type) {
+            stream << metric.name;
+            writePrometheusLabels(stream, metric.labels);
+            stream << ' ' << metric.value << '\n';
+            continue;
+        }
+        for (auto quantile : QUANTILES) {
+            std::ostringstream quantileText;
+            quantileText << quantile;
+            stream << metric.name;
+            writePrometheusLabels(stream, metric.labels, "quantile", quantileText.str());
+            stream << ' ' << metric.histogram.percentile(quantile * 100) << '\n';
+        }
+        stream << metric.name << "_sum";
+        writePrometheusLabels(stream, metric.labels);
+        stream << ' ' << metric.histogram.sum << '\n';
+        stream << metric.name << "_count";
+        writePrometheusLabels(stream, metric.labels);
+        stream << ' ' << metric.histogram.count << '\n';
+    }
+}
+
+bool MetricsRegistry::startFileExport(
+    const std::string& filePath,
+    std::chrono::milliseconds interval,
+    Format format) {
+    if (filePath.empty() || interval <= std::chrono::milliseconds::zero()) {
+        AISDK_ERROR(LX("startFileExportFailed")
+                        .d("reason", "invalidArgument")
+                        .d("file", filePath)
+                        .d("intervalMs", interval.count()));
+        return false;
+    }
+    stopFileExport();
+    std::lock_guard<std::mutex> lock(m_exportMutex);
+    m_exportFilePath = filePath;
+    m_exportInterval = interval;
+    m_exportFormat = format;
+    m_isExportStopping = false;
+    m_exportThread = std::thread(&MetricsRegistry::exportLoop, this);
+    AISDK_INFO(LX("startFileExport").d("file", filePath).d("intervalMs", interval.count()));
+    return true;
+}
+
+void MetricsRegistry::stopFileExport() {
+    {
+        std::lock_guard<std::mutex> lock(m_exportMutex);
+        m_isExportStopping = true;
+    }
+    m_exportWakeTrigger.notify_all();
+    if (m_exportThread.joinable()) {
+        m_exportThread.join();
+    }
+}
+
+void MetricsRegistry::exportLoop() {
+    logging::ThreadMoniker::setThisThreadName("MetricsExport");
+    std::unique_lock<std::mutex> lock(m_exportMutex);
+    auto filePath = m_exportFilePath;
+    auto format = m_exportFormat;
+    bool stopping = false;
+    while (!stopping) {
+        stopping = m_exportWakeTrigger.wait_for(lock, m_exportInterval, [this] { return m_isExportStopping; });
+        lock.unlock();
+        writeFile(filePath, format);
+        lock.lock();
+    }
+}
+
+bool MetricsRegistry::writeFile(const std::string& filePath, Format format) {
+    // Write next to the target and rename, so a reader never sees a partially written file.
+    auto temporaryPath = filePath + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::out | std::ios::trunc);
+        if (!file) {
+            AISDK_ERROR(LX("writeFileFailed").d("reason", "openFailed").d("file", temporaryPath));
+            return false;
+        }
+        render(snapshot(), format, file);
+        if (!file.flush()) {
+            AISDK_ERROR(LX("writeFileFailed").d("reason", "writeFailed").d("file", temporaryPath));
+            return false;
+        }
+    }
+    if (std::rename(temporaryPath.c_str(), filePath.c_str()) != 0) {
+        AISDK_ERROR(LX("writeFileFailed").d("reason", "renameFailed").d("file", filePath));
+        return false;
+    }
+    return true;
+}
+
+std::ostream& operator<<(std::ostream& stream, MetricsRegistry::Type type) {
+    switch (type) {
+        case MetricsRegistry::Type::COUNTER:
+            return stream << "counter";
+        case MetricsRegistry::Type::GAUGE:
+            return stream << "gauge";
+        case MetricsRegistry::Type::HISTOGRAM:
+            return stream << "histogram";
+    }
+    return stream << "unknown";
+}
+
+}  // namespace metrics
+}  // namespace utils
+}  // namespace aisdk
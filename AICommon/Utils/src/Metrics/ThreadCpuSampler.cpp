@@ -0,0 +1,286 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include "Utils/Logging/Logger.h"
+#include "Utils/Logging/ThreadMoniker.h"
+#include "Utils/Metrics/MetricsRegistry.h"
+#include "Utils/Metrics/ThreadCpuSampler.h"
+
+namespace aisdk {
+namespace utils {
+namespace metrics {
+
+/// String to identify log entries originating from this file.
+static const std::string TAG("ThreadCpuSampler");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
+/// The directory with one entry per thread of the process.
+static const std::string TASK_DIRECTORY = "/proc/self/task/";
+
+/// Position of the utime field in @c /proc/<pid>/task/<tid>/stat, counting the state field as zero.
+static const size_t STAT_UTIME_INDEX = 11;
+
+/// Position of the stime field, counted like @c STAT_UTIME_INDEX.
+static const size_t STAT_STIME_INDEX = 12;
+
+/**
+ * Read a whole file from @c /proc.
+ *
+ * @param path The path of the file.
+ * @param[out] content The content of the file.
+ * @return Whether the file could be read.
+ */
+static bool readProcFile(const std::string& path, std::string* content) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    *content = stream.str();
+    return true;
+}
+
+/**
+ * Add to a counter, which may be missing if its name was registered with another type.
+ *
+ * @param counter The counter.
+ * @param amount The amount to add.
+ */
+static void addTo(const std::shared_ptr<Counter>& counter, uint64_t amount) {
+    if (counter && amount) {
+        counter->increment(amount);
+    }
+}
+
+/**
+ * Get how much a counter read from @c /proc grew.
+ *
+ * @param current The current value.
+ * @param previous The previous value.
+ * @return The growth, or the current value if the counter went backwards because the thread id was reused.
+ */
+static uint64_t growth(uint64_t current, uint64_t previous) {
+    return current >= previous ? current - previous : current;
+}
+
+ThreadCpuSampler& ThreadCpuSampler::instance() {
+    static ThreadCpuSampler singleThreadCpuSampler;
+    return singleThreadCpuSampler;
+}
+
+ThreadCpuSampler::ThreadCpuSampler() : m_hasPreviousSample{false}, m_interval{0}, m_isStopping{false} {
+}
+
+ThreadCpuSampler::~ThreadCpuSampler() {
+    stop();
+}
+
+bool ThreadCpuSampler::start(std::chrono::milliseconds interval) {
+    if (interval <= std::chrono::milliseconds::zero()) {
+        AISDK_ERROR(LX("startFailed").d("reason", "invalidInterval").d("intervalMs", interval.count()));
+        return false;
+    }
+    stop();
+    std::lock_guard<std::mutex> lock(m_threadMutex);
+    m_interval = interval;
+    m_isStopping = false;
+    m_samplingThread = std::thread(&ThreadCpuSampler::samplingLoop, this);
+    AISDK_INFO(LX("start").d("intervalMs", interval.count()));
+    return true;
+}
+
+void ThreadCpuSampler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_threadMutex);
+        m_isStopping = true;
+    }
+    m_wakeTrigger.notify_all();
+    if (m_samplingThread.joinable()) {
+        m_samplingThread.join();
+    }
+}
+
+void ThreadCpuSampler::sample() {
+    std::lock_guard<std::mutex> lock(m_sampleMutex);
+    auto now = std::chrono::steady_clock::now();
+    auto namedThreads = logging::ThreadMoniker::getNamedThreads();
+
+    std::map<int, ThreadSample> samples;
+    auto directory = opendir(TASK_DIRECTORY.c_str());
+    if (!directory) {
+        AISDK_ERROR(LX("sampleFailed").d("reason", "opendirFailed").d("directory", TASK_DIRECTORY));
+        return;
+    }
+    while (auto entry = readdir(directory)) {
+        char* end = nullptr;
+        auto tid = static_cast<int>(std::strtol(entry->d_name, &end, 10));
+        if (end == entry->d_name || *end != '\0') {
+            continue;
+        }
+        ThreadSample sample;
+        if (!readThread(tid, &sample)) {
+            continue;
+        }
+        auto named = namedThreads.find(tid);
+        if (named != namedThreads.end()) {
+            sample.name = named->second.name;
+        }
+        samples[tid] = sample;
+    }
+    closedir(directory);
+
+    // Add up the change since the previous sample per component.  A thread missing from the previous sample started
+    // since, so all of its counters are new; the last interval of a thread which exited since is lost.
+    std::map<std::string, uint64_t> cpuTicksByComponent;
+    for (const auto& entry : samples) {
+        const auto& current = entry.second;
+        ThreadSample base{current.name, 0, 0, 0, 0};
+        auto previous = m_previousSamples.find(entry.first);
+        if (previous != m_previousSamples.end() && previous->second.name == current.name) {
+            base = previous->second;
+        }
+        auto& metrics = getComponentMetrics(current.name);
+        auto cpuTicks = growth(current.cpuTicks, base.cpuTicks);
+        cpuTicksByComponent[current.name] += cpuTicks;
+        addTo(metrics.cpuTime, cpuTicks * 1000000 / static_cast<uint64_t>(sysconf(_SC_CLK_TCK)));
+        addTo(metrics.voluntarySwitches, growth(current.voluntarySwitches, base.voluntarySwitches));
+        addTo(metrics.involuntarySwitches, growth(current.involuntarySwitches, base.involuntarySwitches));
+        addTo(metrics.runQueueDelay, growth(current.runQueueDelayNs, base.runQueueDelayNs) / 1000);
+    }
+
+    if (m_hasPreviousSample) {
+        auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(now - m_previousSampleTime).count();
+        for (auto& component : m_components) {
+            if (!component.second.cpuUsage || elapsedUs <= 0) {
+                continue;
+            }
+            auto cpuUs = cpuTicksByComponent[component.first] * 1000000 / static_cast<uint64_t>(sysconf(_SC_CLK_TCK));
+            component.second.cpuUsage->set(static_cast<int64_t>(cpuUs * 1000 / static_cast<uint64_t>(elapsedUs)));
+        }
+    }
+
+    m_previousSamples.swap(samples);
+    m_previousSampleTime = now;
+    m_hasPreviousSample = true;
+}
+
+bool ThreadCpuSampler::readThread(int tid, ThreadSample* sample) {
+    auto directory = TASK_DIRECTORY + std::to_string(tid) + "/";
+    std::string content;
+
+    // The name is in parentheses and may itself contain spaces or parentheses, so parse around the last one.
+    if (!readProcFile(directory + "stat", &content)) {
+        return false;
+    }
+    auto nameStart = content.find('(');
+    auto nameEnd = content.rfind(')');
+    if (std::string::npos == nameStart || std::string::npos == nameEnd || nameEnd < nameStart) {
+        return false;
+    }
+    sample->name = content.substr(nameStart + 1, nameEnd - nameStart - 1);
+    std::istringstream fields(content.substr(nameEnd + 1));
+    std::string field;
+    uint64_t utime = 0;
+    uint64_t stime = 0;
+    for (size_t index = 0; index <= STAT_STIME_INDEX && fields >> field; ++index) {
+        if (STAT_UTIME_INDEX == index) {
+            utime = std::strtoull(field.c_str(), nullptr, 10);
+        } else if (STAT_STIME_INDEX == index) {
+            stime = std::strtoull(field.c_str(), nullptr, 10);
+        }
+    }
+    sample->cpuTicks = utime + stime;
+
+    sample->voluntarySwitches = 0;
+    sample->involuntarySwitches = 0;
+    if (readProcFile(directory + "status", &content)) {
+        std::istringstream lines(content);
+        std::string line;
+        while (std::getline(lines, line)) {
+            auto colon = line.find(':');
+            if (std::string::npos == colon) {
+                continue;
+            }
+            auto key = line.substr(0, colon);
+            if ("voluntary_ctxt_switches" == key) {
+                sample->voluntarySwitches = std::strtoull(line.c_str() + colon + 1, nullptr, 10);
+            } else if ("nonvoluntary_ctxt_switches" == key) {
+                sample->involuntarySwitches = std::strtoull(line.c_str() + colon + 1, nullptr, 10);
+            }
+        }
+    }
+
+    // schedstat holds the time on the CPU, the time waiting on a run queue and the number of time slices.
+    sample->runQueueDelayNs = 0;
+    if (readProcFile(directory + "schedstat", &content)) {
+        std::istringstream values(content);
+        uint64_t runTimeNs = 0;
+        values >> runTimeNs >> sample->runQueueDelayNs;
+    }
+    return true;
+}
+
+ThreadCpuSampler::ComponentMetrics& ThreadCpuSampler::getComponentMetrics(const std::string& name) {
+    auto found = m_components.find(name);
+    if (found != m_components.end()) {
+        return found->second;
+    }
+    auto& registry = MetricsRegistry::instance();
+    MetricsRegistry::Labels labels{{"thread", name}};
+    ComponentMetrics metrics;
+    metrics.cpuUsage = registry.getGauge(
+        "aisdk_thread_cpu_usage_permille",
+        labels,
+        "CPU used by the threads of a component over the last sampling interval, in thousandths of a core.");
+    metrics.cpuTime = registry.getCounter(
+        "aisdk_thread_cpu_microseconds_total", labels, "CPU time used by the threads of a component.");
+    metrics.voluntarySwitches = registry.getCounter(
+        "aisdk_thread_voluntary_context_switches_total",
+        labels,
+        "Context switches of the threads of a component which blocked.");
+    metrics.involuntarySwitches = registry.getCounter(
+        "aisdk_thread_involuntary_context_switches_total",
+        labels,
+        "Context switches of the threads of a component which were preempted.");
+    metrics.runQueueDelay = registry.getCounter(
+        "aisdk_thread_runqueue_delay_microseconds_total",
+        labels,
+        "Time the threads of a component were runnable but waiting for a CPU.");
+    return m_components.insert({name, metrics}).first->second;
+}
+
+void ThreadCpuSampler::samplingLoop() {
+    logging::ThreadMoniker::setThisThreadName("ThreadCpuSampler");
+    std::unique_lock<std::mutex> lock(m_threadMutex);
+    while (!m_isStopping) {
+        sample();
+        m_wakeTrigger.wait_for(lock, m_interval, [this] { return m_isStopping; });
+    }
+}
+
+}  // namespace metrics
+}  // namespace utils
+}  // namespace aisdk
@@ -10,10 +10,19 @@
  * permissions and limitations under the License.
  */
  
-#include <iostream>
-
+#include "Utils/Logging/Logger.h"
 #include "Utils/SafeShutdown.h"
 
+/// String to identify log entries originating from this file.
+static const std::string TAG("SafeShutdown");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
 namespace aisdk {
 namespace utils {
 	
@@ -23,10 +32,8 @@ SafeShutdown::SafeShutdown(const std::string& name) : m_name{name}, m_isShutdown
 
 SafeShutdown::~SafeShutdown() {
 	if (!m_isShutdown) {
-		std::cout << "~RequiresShutdownFailed:reason:notShutdown:name: " << m_name << std::endl;
+		AISDK_WARN(LX("~SafeShutdownFailed").d("reason", "notShutdown").d("name", m_name));
 	}
-
-	std::cout << __func__ << " comein..." << std::endl;
 }
 
 const std::string& SafeShutdown::name() const {
@@ -36,7 +43,7 @@ const std::string& SafeShutdown::name() const {
 void SafeShutdown::shutdown() {
 	std::lock_guard<std::mutex> lock(m_mutex);
 	if (m_isShutdown) {
-		std::cout << "shutdownFailed:reason:alreadyShutdown:name: " << m_name << std::endl;
+		AISDK_WARN(LX("shutdownFailed").d("reason", "alreadyShutdown").d("name", m_name));
 		return;
 	}
 	doShutdown();
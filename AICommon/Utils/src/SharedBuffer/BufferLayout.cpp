@@ -29,13 +29,14 @@ namespace aisdk {
 namespace utils {
 namespace sharedbuffer {
 	
-BufferLayout::BufferLayout(std::shared_ptr<Buffer> buffer)
+BufferLayout::BufferLayout(std::shared_ptr<Buffer> buffer, metrics::MemoryAccounting::Subsystem subsystem)
 	:m_buffer{buffer},
 	m_readerEnabledArray{nullptr},
 	m_readerCursorArray{nullptr},
 	m_readerCloseIndexArray{nullptr},
 	m_dataSize{0},
-	m_data{nullptr} {
+	m_data{nullptr},
+	m_memoryCharge{subsystem, buffer ? buffer->size() : 0} {
 
 }
 
@@ -43,6 +44,10 @@ BufferLayout::~BufferLayout() {
     detach();
 }
 
+void BufferLayout::setMemorySubsystem(metrics::MemoryAccounting::Subsystem subsystem) {
+    m_memoryCharge.moveTo(subsystem);
+}
+
 BufferLayout::Header* BufferLayout::getHeader() const {
     return reinterpret_cast<BufferLayout::Header*>(m_buffer->data());
 }
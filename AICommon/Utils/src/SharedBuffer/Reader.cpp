@@ -11,7 +11,9 @@
  */
 #include <cstring> 
 #include <Utils/Logging/Logger.h>
+#include <Utils/Metrics/MetricsRegistry.h>
 #include <Utils/SharedBuffer/Reader.h>
+#include <Utils/Tracing/TraceEventRecorder.h>
 
 /// String to identify log entries originating from this file.
 static const std::string TAG{"SBReader"};
@@ -21,7 +23,31 @@ static const std::string TAG{"SBReader"};
 namespace aisdk {
 namespace utils {
 namespace sharedbuffer {
-	
+
+/**
+ * Count an overrun in the overrun metric shared by all readers.
+ */
+static void countOverrun() {
+    static const auto counter = metrics::MetricsRegistry::instance().getCounter(
+        "aisdk_sharedbuffer_reader_overruns_total", {}, "Reads which failed because the writer overwrote the data.");
+    if (counter) {
+        counter->increment();
+    }
+}
+
+/**
+ * Record how far a reader is behind the writer after a read, in the lag metric shared by all readers.
+ *
+ * @param lagInWords The number of words written but not read yet.
+ */
+static void recordLag(BufferLayout::Index lagInWords) {
+    static const auto histogram = metrics::MetricsRegistry::instance().getHistogram(
+        "aisdk_sharedbuffer_reader_lag_words", {}, "Words written but not read yet, sampled after each read.");
+    if (histogram) {
+        histogram->record(lagInWords);
+    }
+}
+
 Reader::Reader(Policy policy, std::shared_ptr<BufferLayout> bufferLayout, uint8_t id) :
         m_policy{policy},
         m_bufferLayout{bufferLayout},
@@ -48,6 +74,7 @@ Reader::~Reader() {
 }
 
 ssize_t Reader::read(void* buf, size_t nWords, std::chrono::milliseconds timeout) {
+    AISDK_TRACE_SCOPE("sharedBuffer", "Reader::read");
     if (nullptr == buf) {
         AISDK_ERROR(LX("readFailed").d("reason", "nullBuffer"));
         return Error::INVALID;
@@ -68,6 +95,7 @@ ssize_t Reader::read(void* buf, size_t nWords, std::chrono::milliseconds timeout
     auto header = m_bufferLayout->getHeader();
     if ((header->writeEndCursor >= *m_readerCursor) &&
         (header->writeEndCursor - *m_readerCursor) > m_bufferLayout->getDataSize()) {
+        countOverrun();
         return Error::OVERRUN;
     }
 
@@ -138,12 +166,15 @@ ssize_t Reader::read(void* buf, size_t nWords, std::chrono::milliseconds timeout
 
     // Final check for overrun (do this before the updateOldestUnconsumedCursor() call below for improved accuracy).
     // for writer BLOCKING.
-    bool overrun = ((header->writeEndCursor - *m_readerCursor) > m_bufferLayout->getDataSize());
+    auto lag = header->writeEndCursor - *m_readerCursor;
+    bool overrun = (lag > m_bufferLayout->getDataSize());
 
     // Now we can safely error out if there was an overrun.
     if (overrun) {
+        countOverrun();
         return Error::OVERRUN;
     }
+    recordLag(lag);
 
     return nWords;
 }
@@ -9,6 +9,7 @@
  * express or implied. See the License for the specific language governing
  * permissions and limitations under the License.
  */
+#include <Utils/Introspection/IntrospectionServer.h>
 #include <Utils/Logging/Logger.h>
 #include <Utils/SharedBuffer/SharedBuffer.h>
 
@@ -29,7 +30,8 @@ namespace sharedbuffer {
 std::unique_ptr<SharedBuffer> SharedBuffer::create(
 	std::shared_ptr<Buffer> buffer,
 	size_t wordSize,
-	size_t maxReaders) {
+	size_t maxReaders,
+	metrics::MemoryAccounting::Subsystem subsystem) {
 	size_t expectedSize = calculateBufferSize(1, wordSize, maxReaders);
 	if (0 == expectedSize) {
 		// Logged in calcutlateBuffersize().
@@ -45,11 +47,12 @@ std::unique_ptr<SharedBuffer> SharedBuffer::create(
 		return nullptr;
 	}
 
-	std::unique_ptr<SharedBuffer> sds(new SharedBuffer(buffer));
+	std::unique_ptr<SharedBuffer> sds(new SharedBuffer(buffer, subsystem));
 	if (!sds->m_bufferLayout->init(wordSize, maxReaders)) {
 		// Logged in init().
 		return nullptr;
 	}
+	sds->publishState();
 	return sds;
 }
 
@@ -107,15 +110,48 @@ std::unique_ptr<Reader> SharedBuffer::createReader(
     return nullptr;
 }
 
-SharedBuffer::SharedBuffer(std::shared_ptr<Buffer> buffer):
-	m_bufferLayout{std::make_shared<BufferLayout>(buffer)} {
+void SharedBuffer::setMemorySubsystem(metrics::MemoryAccounting::Subsystem subsystem) {
+	m_bufferLayout->setMemorySubsystem(subsystem);
+}
+
+SharedBuffer::SharedBuffer(std::shared_ptr<Buffer> buffer, metrics::MemoryAccounting::Subsystem subsystem):
+	m_bufferLayout{std::make_shared<BufferLayout>(buffer, subsystem)},
+	m_introspectionId{0} {
 }
 
 SharedBuffer::~SharedBuffer() {
 	AISDK_INFO(LX("~SharedBuffer").d("reason", "destory"));
+	introspection::IntrospectionServer::instance().removeSection(m_introspectionId);
 
 }
 
+void SharedBuffer::publishState() {
+	// The cursors are atomics in the header, so they are read without taking any lock of the writer or readers.
+	auto bufferLayout = m_bufferLayout;
+	m_introspectionId = introspection::IntrospectionServer::instance().addSection(
+		"sharedBuffers", "SharedBuffer", [bufferLayout]() {
+			auto header = bufferLayout->getHeader();
+			std::string json = "{\"dataSize\":" + std::to_string(bufferLayout->getDataSize()) +
+				",\"wordSize\":" + std::to_string(header->wordSize) +
+				",\"writerEnabled\":" + (header->isWriterEnabled ? "true" : "false") +
+				",\"writeStartCursor\":" + std::to_string(header->writeStartCursor.load()) +
+				",\"writeEndCursor\":" + std::to_string(header->writeEndCursor.load()) +
+				",\"readers\":[";
+			auto readerEnabled = bufferLayout->getReaderEnabledArray();
+			auto readerCursors = bufferLayout->getReaderCursorArray();
+			bool first = true;
+			for (size_t id = 0; id < header->maxReaders; ++id) {
+				if (!readerEnabled[id]) {
+					continue;
+				}
+				json += std::string(first ? "" : ",") + "{\"id\":" + std::to_string(id) +
+					",\"cursor\":" + std::to_string(readerCursors[id].load()) + "}";
+				first = false;
+			}
+			return json + "]}";
+		});
+}
+
 std::unique_ptr<Reader> SharedBuffer::createReaderLocked(
 	size_t id,
 	Reader::Policy policy,
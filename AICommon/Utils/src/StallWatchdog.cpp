@@ -0,0 +1,219 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <vector>
+
+#include "Utils/Introspection/IntrospectionServer.h"
+#include "Utils/Logging/Logger.h"
+#include "Utils/Logging/ThreadMoniker.h"
+#include "Utils/Metrics/MetricsRegistry.h"
+#include "Utils/Threading/StallWatchdog.h"
+
+namespace aisdk {
+namespace utils {
+namespace threading {
+
+/// String to identify log entries originating from this file.
+static const std::string TAG("StallWatchdog");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
+/// The deadline of the loops until @c StallWatchdog::start() sets one.
+static const std::chrono::milliseconds DEFAULT_DEADLINE{10000};
+
+/**
+ * Convert a @c steady_clock duration in ticks to milliseconds.
+ *
+ * @param ticks The duration in ticks.
+ * @return The duration in milliseconds.
+ */
+static int64_t ticksToMs(std::chrono::steady_clock::rep ticks) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::duration(ticks)).count();
+}
+
+/// A stall or a recovery found by @c StallWatchdog::check(), reported once the heartbeats are unlocked.
+struct StallReport {
+    /// Whether the loop recovered, rather than stalled.
+    bool isRecovery;
+    /// The name of the component running the loop.
+    std::string component;
+    /// The stage the loop stalled in.
+    const char* stage;
+    /// How long the loop has been stalled, in milliseconds.
+    int64_t stalledMs;
+    /// The stall counter of the component.
+    std::shared_ptr<metrics::Counter> counter;
+};
+
+Heartbeat::Heartbeat(const std::string& name, std::chrono::milliseconds deadline) :
+        m_name{name},
+        m_deadline{deadline},
+        m_lastBeat{std::chrono::steady_clock::now().time_since_epoch().count()},
+        m_stage{"start"},
+        m_isIdle{true},
+        m_reportedBeat{0},
+        m_id{0},
+        m_stallCounter{metrics::MetricsRegistry::instance().getCounter(
+            "aisdk_thread_stalls_total",
+            {{"component", name}},
+            "Times a processing loop stayed in one stage past its deadline.")} {
+    StallWatchdog::instance().add(this);
+}
+
+Heartbeat::~Heartbeat() {
+    StallWatchdog::instance().remove(this);
+}
+
+StallWatchdog& StallWatchdog::instance() {
+    static StallWatchdog* singleStallWatchdog = new StallWatchdog;
+    return *singleStallWatchdog;
+}
+
+StallWatchdog::StallWatchdog() :
+        m_nextId{1},
+        m_deadline{std::chrono::duration_cast<std::chrono::steady_clock::duration>(DEFAULT_DEADLINE).count()},
+        m_checkInterval{0},
+        m_isStopping{false} {
+    introspection::IntrospectionServer::instance().addSection("watchdog", "StallWatchdog", [this]() {
+        return renderState();
+    });
+}
+
+bool StallWatchdog::start(std::chrono::milliseconds deadline, std::chrono::milliseconds checkInterval) {
+    if (deadline <= std::chrono::milliseconds::zero() || checkInterval <= std::chrono::milliseconds::zero()) {
+        AISDK_ERROR(LX("startFailed")
+                        .d("reason", "invalidInterval")
+                        .d("deadlineMs", deadline.count())
+                        .d("checkIntervalMs", checkInterval.count()));
+        return false;
+    }
+    stop();
+    m_deadline = std::chrono::duration_cast<std::chrono::steady_clock::duration>(deadline).count();
+    std::lock_guard<std::mutex> lock(m_threadMutex);
+    m_checkInterval = checkInterval;
+    m_isStopping = false;
+    m_watchThread = std::thread(&StallWatchdog::watchLoop, this);
+    AISDK_INFO(LX("start").d("deadlineMs", deadline.count()).d("checkIntervalMs", checkInterval.count()));
+    return true;
+}
+
+void StallWatchdog::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_threadMutex);
+        m_isStopping = true;
+    }
+    m_wakeTrigger.notify_all();
+    if (m_watchThread.joinable()) {
+        m_watchThread.join();
+    }
+}
+
+void StallWatchdog::check() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    std::vector<StallReport> reports;
+    std::unique_lock<std::mutex> lock(m_heartbeatsMutex);
+    for (const auto& entry : m_heartbeats) {
+        auto heartbeat = entry.second;
+        auto isIdle = heartbeat->m_isIdle.load(std::memory_order_acquire);
+        auto lastBeat = heartbeat->m_lastBeat.load(std::memory_order_relaxed);
+
+        if (heartbeat->m_reportedBeat) {
+            if (isIdle || lastBeat != heartbeat->m_reportedBeat) {
+                reports.push_back(
+                    {true, heartbeat->m_name, nullptr, ticksToMs(now - heartbeat->m_reportedBeat), nullptr});
+                heartbeat->m_reportedBeat = 0;
+            }
+            continue;
+        }
+
+        auto deadline = heartbeat->m_deadline > std::chrono::milliseconds::zero()
+                            ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(heartbeat->m_deadline)
+                                  .count()
+                            : m_deadline.load();
+        if (isIdle || now - lastBeat <= deadline) {
+            continue;
+        }
+        reports.push_back({false,
+                           heartbeat->m_name,
+                           heartbeat->m_stage.load(std::memory_order_relaxed),
+                           ticksToMs(now - lastBeat),
+                           heartbeat->m_stallCounter});
+        heartbeat->m_reportedBeat = lastBeat;
+    }
+    // The heartbeats may be destroyed from here on; the reports hold copies of what they need.
+    lock.unlock();
+
+    for (const auto& report : reports) {
+        if (report.isRecovery) {
+            AISDK_WARN(LX("stallRecovered").d("component", report.component).d("stalledMs", report.stalledMs));
+            continue;
+        }
+        AISDK_ERROR(LX("stallDetected")
+                        .d("component", report.component)
+                        .d("stage", report.stage)
+                        .d("stalledMs", report.stalledMs));
+        if (report.counter) {
+            report.counter->increment();
+        }
+    }
+}
+
+void StallWatchdog::add(Heartbeat* heartbeat) {
+    std::lock_guard<std::mutex> lock(m_heartbeatsMutex);
+    heartbeat->m_id = m_nextId++;
+    m_heartbeats[heartbeat->m_id] = heartbeat;
+}
+
+void StallWatchdog::remove(Heartbeat* heartbeat) {
+    std::lock_guard<std::mutex> lock(m_heartbeatsMutex);
+    m_heartbeats.erase(heartbeat->m_id);
+}
+
+std::string StallWatchdog::renderState() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    std::lock_guard<std::mutex> lock(m_heartbeatsMutex);
+    std::string json = "[";
+    bool first = true;
+    for (const auto& entry : m_heartbeats) {
+        auto heartbeat = entry.second;
+        json += (first ? "{" : ",{");
+        json += "\"component\":" + introspection::IntrospectionServer::quote(heartbeat->m_name) +
+                ",\"stage\":" + introspection::IntrospectionServer::quote(heartbeat->m_stage.load()) +
+                ",\"idle\":" + (heartbeat->m_isIdle.load() ? "true" : "false") +
+                ",\"sinceLastBeatMs\":" + std::to_string(ticksToMs(now - heartbeat->m_lastBeat.load())) +
+                ",\"stalled\":" + (heartbeat->m_reportedBeat ? "true" : "false") + "}";
+        first = false;
+    }
+    json += "]";
+    return json;
+}
+
+void StallWatchdog::watchLoop() {
+    logging::ThreadMoniker::setThisThreadName("StallWatchdog");
+    std::unique_lock<std::mutex> lock(m_threadMutex);
+    while (!m_isStopping) {
+        m_wakeTrigger.wait_for(lock, m_checkInterval, [this] { return m_isStopping; });
+        if (!m_isStopping) {
+            check();
+        }
+    }
+}
+
+}  // namespace threading
+}  // namespace utils
+}  // namespace aisdk
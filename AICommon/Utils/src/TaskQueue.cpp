@@ -18,7 +18,7 @@ namespace aisdk {
 namespace utils {
 namespace threading {
 
-TaskQueue::TaskQueue() : m_shutdown{false} {
+TaskQueue::TaskQueue() : m_shutdown{false}, m_size{0} {
 }
 
 std::unique_ptr<std::function<void()>> TaskQueue::pop() {
@@ -34,6 +34,7 @@ std::unique_ptr<std::function<void()>> TaskQueue::pop() {
         auto task = std::move(m_queue.front());
 
         m_queue.pop_front();
+        m_size = m_queue.size();
         return task;
     }
 
@@ -43,6 +44,7 @@ std::unique_ptr<std::function<void()>> TaskQueue::pop() {
 void TaskQueue::shutdown() {
     std::lock_guard<std::mutex> queueLock{m_queueMutex};
     m_queue.clear();
+    m_size = 0;
     m_shutdown = true;
     m_queueChanged.notify_all();
 }
@@ -51,6 +53,10 @@ bool TaskQueue::isShutdown() {
     return m_shutdown;
 }
 
+size_t TaskQueue::size() const {
+    return m_size;
+}
+
 }  // namespace threading
 }  // namespace utils
 }  // namespace aisdk
@@ -11,13 +11,19 @@
  * permissions and limitations under the License.
  */
 
+#include "Utils/Logging/ThreadMoniker.h"
 #include "Utils/Threading/TaskThread.h"
+#include "Utils/Tracing/TraceEventRecorder.h"
 
 namespace aisdk {
 namespace utils {
 namespace threading {
 
-TaskThread::TaskThread(std::shared_ptr<TaskQueue> taskQueue) : m_taskQueue{taskQueue}, m_shutdown{false} {
+TaskThread::TaskThread(std::shared_ptr<TaskQueue> taskQueue, const std::string& name) :
+        m_taskQueue{taskQueue},
+        m_shutdown{false},
+        m_name{name},
+        m_heartbeat{name} {
 }
 
 TaskThread::~TaskThread() {
@@ -37,13 +43,21 @@ bool TaskThread::isShutdown() {
 }
 
 void TaskThread::processTasksLoop() {
+    logging::ThreadMoniker::setThisThreadName(m_name);
+#ifdef AISDK_TRACING_ENABLED
+    auto traceName = tracing::TraceEventRecorder::internName(m_name);
+    tracing::TraceEventRecorder::setThreadName(traceName);
+#endif
     while (!m_shutdown) {
         auto m_actualTaskQueue = m_taskQueue.lock();
 
         if (m_actualTaskQueue && !m_actualTaskQueue->isShutdown()) {
+            m_heartbeat.idle();
             auto task = m_actualTaskQueue->pop();
 
             if (task) {
+                m_heartbeat.beat("runTask");
+                AISDK_TRACE_SCOPE("executor", traceName);
                 task->operator()();
             }
         } else {
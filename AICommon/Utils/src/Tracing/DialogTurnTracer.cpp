@@ -0,0 +1,219 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <algorithm>
+#include <sstream>
+
+#include "Utils/Logging/Logger.h"
+#include "Utils/Metrics/MetricsRegistry.h"
+#include "Utils/Tracing/DialogTurnTracer.h"
+
+namespace aisdk {
+namespace utils {
+namespace tracing {
+
+/// String to identify log entries originating from this file.
+static const std::string TAG("DialogTurnTracer");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
+// The definition for these static class members.
+constexpr size_t DialogTurnTracer::NUM_STAGES;
+constexpr uint32_t DialogTurnTracer::TURN_ACTIVE_BIT;
+
+/**
+ * Get the bit of @c m_markedStages used for a stage.
+ *
+ * @param stage The stage.
+ * @return The bit of the stage.
+ */
+static uint32_t stageBit(DialogTurnTracer::Stage stage) {
+    return 1u << static_cast<uint32_t>(stage);
+}
+
+DialogTurnTracer& DialogTurnTracer::instance() {
+    static DialogTurnTracer singleDialogTurnTracer;
+    return singleDialogTurnTracer;
+}
+
+/// The name of the stage latency metric.
+static const std::string STAGE_LATENCY_METRIC{"aisdk_dialog_turn_stage_milliseconds"};
+
+/**
+ * Get a copy of a stage latency histogram.
+ *
+ * @param histogram The histogram, which may be @c nullptr.
+ * @return The copy, empty if there is no histogram.
+ */
+static metrics::Histogram::Snapshot snapshotOf(const std::shared_ptr<metrics::Histogram>& histogram) {
+    if (histogram) {
+        return histogram->snapshot();
+    }
+    metrics::Histogram::Snapshot empty{0, 0, 0, 0, {}};
+    return empty;
+}
+
+DialogTurnTracer::DialogTurnTracer() : m_markedStages{0} {
+    auto& registry = metrics::MetricsRegistry::instance();
+    for (size_t index = 1; index < NUM_STAGES; ++index) {
+        auto stage = stageToString(static_cast<Stage>(index));
+        m_fromKeyword[index] = registry.getHistogram(
+            STAGE_LATENCY_METRIC,
+            {{"stage", stage}, {"from", "keyword"}},
+            "Time a dialog turn took to reach a stage, from the keyword or from the previous stage reached.");
+        m_fromPreviousStage[index] =
+            registry.getHistogram(STAGE_LATENCY_METRIC, {{"stage", stage}, {"from", "previousStage"}});
+    }
+}
+
+void DialogTurnTracer::beginTurn() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_markedStages.load() & TURN_ACTIVE_BIT) {
+        completeTurnLocked();
+    }
+    m_traceId.clear();
+    m_stageTimes[static_cast<size_t>(Stage::KEYWORD_DETECTED)] = std::chrono::steady_clock::now();
+    m_markedStages = TURN_ACTIVE_BIT | stageBit(Stage::KEYWORD_DETECTED);
+}
+
+void DialogTurnTracer::bindTraceId(const std::string& traceId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_markedStages.load() & TURN_ACTIVE_BIT) {
+        m_traceId = traceId;
+    }
+}
+
+void DialogTurnTracer::mark(Stage stage) {
+    auto marked = m_markedStages.load(std::memory_order_relaxed);
+    if (!(marked & TURN_ACTIVE_BIT) || (marked & stageBit(stage))) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    markLocked(stage);
+}
+
+void DialogTurnTracer::mark(Stage stage, const std::string& traceId) {
+    auto marked = m_markedStages.load(std::memory_order_relaxed);
+    if (!(marked & TURN_ACTIVE_BIT) || (marked & stageBit(stage))) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_traceId.empty() && !traceId.empty() && m_traceId != traceId) {
+        AISDK_DEBUG5(LX("markIgnored").d("stage", stage).d("traceId", traceId).d("currentTraceId", m_traceId));
+        return;
+    }
+    markLocked(stage);
+}
+
+void DialogTurnTracer::markLocked(Stage stage) {
+    // Check again, another thread may have marked the stage or ended the turn while we waited for the lock.
+    auto marked = m_markedStages.load();
+    if (!(marked & TURN_ACTIVE_BIT) || (marked & stageBit(stage))) {
+        return;
+    }
+    m_stageTimes[static_cast<size_t>(stage)] = std::chrono::steady_clock::now();
+    m_markedStages = marked | stageBit(stage);
+    if (Stage::FIRST_AUDIO_OUTPUT == stage) {
+        completeTurnLocked();
+    }
+}
+
+void DialogTurnTracer::completeTurnLocked() {
+    auto marked = m_markedStages.load();
+    auto start = m_stageTimes[static_cast<size_t>(Stage::KEYWORD_DETECTED)];
+    auto previous = start;
+    std::ostringstream stages;
+    for (size_t index = 1; index < NUM_STAGES; ++index) {
+        auto stage = static_cast<Stage>(index);
+        if (!(marked & stageBit(stage))) {
+            continue;
+        }
+        auto time = m_stageTimes[index];
+        auto fromKeyword = std::chrono::duration_cast<std::chrono::milliseconds>(time - start);
+        auto fromPrevious = std::chrono::duration_cast<std::chrono::milliseconds>(time - previous);
+        if (m_fromKeyword[index]) {
+            m_fromKeyword[index]->record(static_cast<uint64_t>(std::max<int64_t>(fromKeyword.count(), 0)));
+        }
+        if (m_fromPreviousStage[index]) {
+            m_fromPreviousStage[index]->record(static_cast<uint64_t>(std::max<int64_t>(fromPrevious.count(), 0)));
+        }
+        previous = time;
+        stages << (stages.tellp() > 0 ? " " : "") << stage << ":" << fromKeyword.count() << "(+"
+               << fromPrevious.count() << ")";
+    }
+    m_markedStages = 0;
+    AISDK_INFO(LX("dialogTurnLatency")
+                   .d("traceId", m_traceId)
+                   .d("complete", static_cast<bool>(marked & stageBit(Stage::FIRST_AUDIO_OUTPUT)))
+                   .d("stagesMs", stages.str()));
+}
+
+metrics::Histogram::Snapshot DialogTurnTracer::getLatencyFromKeyword(Stage stage) {
+    // The histograms are only set by the constructor, and record without locking.
+    return snapshotOf(m_fromKeyword[static_cast<size_t>(stage)]);
+}
+
+metrics::Histogram::Snapshot DialogTurnTracer::getLatencyFromPreviousStage(Stage stage) {
+    return snapshotOf(m_fromPreviousStage[static_cast<size_t>(stage)]);
+}
+
+std::string DialogTurnTracer::getReport() {
+    std::ostringstream report;
+    report << "stage count fromKeyword(p50/p90/max ms) fromPreviousStage(p50/p90/max ms)\n";
+    for (size_t index = 1; index < NUM_STAGES; ++index) {
+        auto fromKeyword = snapshotOf(m_fromKeyword[index]);
+        auto fromPrevious = snapshotOf(m_fromPreviousStage[index]);
+        report << static_cast<Stage>(index) << " " << fromKeyword.count << " " << fromKeyword.percentile(50) << "/"
+               << fromKeyword.percentile(90) << "/" << fromKeyword.max << " " << fromPrevious.percentile(50) << "/"
+               << fromPrevious.percentile(90) << "/" << fromPrevious.max << "\n";
+    }
+    return report.str();
+}
+
+void DialogTurnTracer::reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_markedStages = 0;
+    m_traceId.clear();
+}
+
+std::string DialogTurnTracer::stageToString(Stage stage) {
+    switch (stage) {
+        case Stage::KEYWORD_DETECTED:
+            return "KEYWORD_DETECTED";
+        case Stage::RECOGNIZE_STARTED:
+            return "RECOGNIZE_STARTED";
+        case Stage::FIRST_AUDIO_UPLOADED:
+            return "FIRST_AUDIO_UPLOADED";
+        case Stage::VAD_END:
+            return "VAD_END";
+        case Stage::NLP_RESULT:
+            return "NLP_RESULT";
+        case Stage::FIRST_TTS_CHUNK_WRITTEN:
+            return "FIRST_TTS_CHUNK_WRITTEN";
+        case Stage::FOCUS_ACQUIRED:
+            return "FOCUS_ACQUIRED";
+        case Stage::PLAY_STARTED:
+            return "PLAY_STARTED";
+        case Stage::FIRST_AUDIO_OUTPUT:
+            return "FIRST_AUDIO_OUTPUT";
+    }
+    return "UNKNOWN";
+}
+
+}  // namespace tracing
+}  // namespace utils
+}  // namespace aisdk
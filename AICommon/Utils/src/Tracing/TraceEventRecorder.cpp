@@ -0,0 +1,288 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include <unistd.h>
+
+#include "Utils/Logging/Logger.h"
+#include "Utils/Logging/ThreadMoniker.h"
+#include "Utils/Tracing/TraceEventRecorder.h"
+
+namespace aisdk {
+namespace utils {
+namespace tracing {
+
+/// String to identify log entries originating from this file.
+static const std::string TAG("TraceEventRecorder");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
+// The definition for these static class members.
+constexpr size_t TraceEventRecorder::MAX_EVENTS_PER_THREAD;
+std::atomic<bool> TraceEventRecorder::m_tracing{false};
+
+/// Number of events reserved when a thread records its first event of a session.
+static const size_t INITIAL_EVENTS_PER_THREAD = 1024;
+
+/// One recorded event.
+struct TraceEvent {
+    /// The category of the event.
+    const char* category;
+    /// The name of the event.
+    const char* name;
+    /// Start of the event, in microseconds of @c std::chrono::steady_clock.
+    int64_t timestampUs;
+    /// Duration of the event in microseconds, or -1 for an instant event.
+    int64_t durationUs;
+};
+
+/// The events of one thread.  Owned by the registry so they survive the thread.
+struct TraceThreadBuffer {
+    /// Serializes the owning thread against @c stopTracing().  Never contended while tracing.
+    std::mutex mutex;
+    /// The session @c events belong to.
+    uint64_t session = 0;
+    /// Numeric thread id, parsed from the thread moniker.
+    long threadId = 0;
+    /// The name of the thread in the trace.
+    const char* threadName = nullptr;
+    /// The events recorded in the current session.
+    std::vector<TraceEvent> events;
+    /// Number of events dropped because @c events was full.
+    size_t droppedEvents = 0;
+};
+
+/// State shared by all threads.  Created on first use so it can be used from static initializers.
+struct TraceRegistry {
+    /// Serializes access to the members below.
+    std::mutex mutex;
+    /// The buffers of every thread which recorded an event.
+    std::vector<std::shared_ptr<TraceThreadBuffer>> buffers;
+    /// The file the current session is written to.
+    std::string filePath;
+    /// Start of the current session, in microseconds of @c std::chrono::steady_clock.
+    int64_t startUs = 0;
+    /// Names interned by @c TraceEventRecorder::internName().
+    std::set<std::string> names;
+};
+
+/// The current session, bumped by every @c startTracing() so stale buffers can be recognized.
+static std::atomic<uint64_t> g_session{0};
+
+/**
+ * Get the registry.
+ *
+ * @return The registry.
+ */
+static TraceRegistry& getRegistry() {
+    static TraceRegistry registry;
+    return registry;
+}
+
+/**
+ * Convert a time of @c std::chrono::steady_clock to microseconds.
+ *
+ * @param time The time to convert.
+ * @return The time in microseconds.
+ */
+static int64_t toMicroseconds(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+}
+
+/**
+ * Write a string as a JSON string literal.
+ *
+ * @param stream The stream to write to.
+ * @param value The string to write.
+ */
+static void writeJsonString(std::ostream& stream, const char* value) {
+    stream << '"';
+    for (auto c = value; c && *c; ++c) {
+        switch (*c) {
+            case '"':
+                stream << "\\\"";
+                break;
+            case '\\':
+                stream << "\\\\";
+                break;
+            default:
+                if (static_cast<unsigned char>(*c) < 0x20) {
+                    stream << ' ';
+                } else {
+                    stream << *c;
+                }
+                break;
+        }
+    }
+    stream << '"';
+}
+
+/**
+ * Get the buffer of the calling thread, creating and registering it on first use.
+ *
+ * @return The buffer of the calling thread.
+ */
+static TraceThreadBuffer& getThreadBuffer() {
+    static thread_local std::shared_ptr<TraceThreadBuffer> threadBuffer;
+    if (!threadBuffer) {
+        auto moniker = logging::ThreadMoniker::getThisThreadMoniker();
+        auto buffer = std::make_shared<TraceThreadBuffer>();
+        buffer->threadId = std::strtol(moniker.c_str(), nullptr, 16);
+        auto trimmedMoniker = moniker.substr(moniker.find_first_not_of(' '));
+        buffer->threadName = TraceEventRecorder::internName("thread " + trimmedMoniker);
+        auto& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.buffers.push_back(buffer);
+        threadBuffer = buffer;
+    }
+    return *threadBuffer;
+}
+
+/**
+ * Append an event to the calling thread's buffer.
+ *
+ * @param event The event to append.
+ */
+static void append(const TraceEvent& event) {
+    auto& buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    // Check again under the lock, so no event is added after stopTracing() collected this buffer.
+    if (!TraceEventRecorder::isTracing()) {
+        return;
+    }
+    auto session = g_session.load(std::memory_order_relaxed);
+    if (buffer.session != session) {
+        buffer.session = session;
+        buffer.events.clear();
+        buffer.events.reserve(INITIAL_EVENTS_PER_THREAD);
+        buffer.droppedEvents = 0;
+    }
+    if (buffer.events.size() >= TraceEventRecorder::MAX_EVENTS_PER_THREAD) {
+        ++buffer.droppedEvents;
+        return;
+    }
+    buffer.events.push_back(event);
+}
+
+bool TraceEventRecorder::startTracing(const std::string& filePath) {
+    if (filePath.empty()) {
+        AISDK_ERROR(LX("startTracingFailed").d("reason", "emptyFilePath"));
+        return false;
+    }
+    auto& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.filePath = filePath;
+    registry.startUs = toMicroseconds(std::chrono::steady_clock::now());
+    g_session++;
+    m_tracing = true;
+    AISDK_INFO(LX("startTracing").d("file", filePath));
+    return true;
+}
+
+bool TraceEventRecorder::stopTracing() {
+    auto& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (!m_tracing.exchange(false)) {
+        AISDK_WARN(LX("stopTracingFailed").d("reason", "notTracing"));
+        return false;
+    }
+    std::ofstream file(registry.filePath, std::ios::out | std::ios::trunc);
+    if (!file) {
+        AISDK_ERROR(LX("stopTracingFailed").d("reason", "openFileFailed").d("file", registry.filePath));
+        return false;
+    }
+
+    auto session = g_session.load();
+    auto processId = static_cast<long>(::getpid());
+    size_t eventCount = 0;
+    size_t droppedEvents = 0;
+    bool first = true;
+    file << "{\"traceEvents\":[\n";
+    for (auto& buffer : registry.buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        if (buffer->session != session) {
+            continue;
+        }
+        file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << processId
+             << ",\"tid\":" << buffer->threadId << ",\"args\":{\"name\":";
+        writeJsonString(file, buffer->threadName);
+        file << "}}";
+        first = false;
+        for (const auto& event : buffer->events) {
+            file << ",\n{\"cat\":";
+            writeJsonString(file, event.category);
+            file << ",\"name\":";
+            writeJsonString(file, event.name);
+            file << ",\"pid\":" << processId << ",\"tid\":" << buffer->threadId
+                 << ",\"ts\":" << event.timestampUs - registry.startUs;
+            if (event.durationUs < 0) {
+                file << ",\"ph\":\"i\",\"s\":\"t\"}";
+            } else {
+                file << ",\"ph\":\"X\",\"dur\":" << event.durationUs << "}";
+            }
+        }
+        eventCount += buffer->events.size();
+        droppedEvents += buffer->droppedEvents;
+        // Give the memory back, a session can be large.
+        std::vector<TraceEvent>().swap(buffer->events);
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" << droppedEvents << "}}\n";
+    file.close();
+    if (!file) {
+        AISDK_ERROR(LX("stopTracingFailed").d("reason", "writeFileFailed").d("file", registry.filePath));
+        return false;
+    }
+    AISDK_INFO(LX("stopTracing")
+                   .d("file", registry.filePath)
+                   .d("events", eventCount)
+                   .d("droppedEvents", droppedEvents));
+    return true;
+}
+
+void TraceEventRecorder::setThreadName(const char* name) {
+    auto& buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.threadName = name;
+}
+
+const char* TraceEventRecorder::internName(const std::string& name) {
+    auto& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.names.insert(name).first->c_str();
+}
+
+void TraceEventRecorder::recordComplete(
+    const char* category,
+    const char* name,
+    std::chrono::steady_clock::time_point start) {
+    auto startUs = toMicroseconds(start);
+    append({category, name, startUs, toMicroseconds(std::chrono::steady_clock::now()) - startUs});
+}
+
+void TraceEventRecorder::recordInstant(const char* category, const char* name) {
+    append({category, name, toMicroseconds(std::chrono::steady_clock::now()), -1});
+}
+
+}  // namespace tracing
+}  // namespace utils
+}  // namespace aisdk
@@ -14,6 +14,8 @@
 #include <json/json.h>
 
 #include <Utils/Logging/Logger.h>
+#include <Utils/Tracing/DialogTurnTracer.h>
+#include <Utils/Tracing/TraceEventRecorder.h>
 #include "AIUI/AIUIASRListener.h"
 
 /// String to identify log entries originating from this file.
@@ -38,6 +40,7 @@ bool AIUIASRListener::isVaildVad() {
 }
 
 void AIUIASRListener::onEvent(const aiui::IAIUIEvent& event) const {
+	AISDK_TRACE_SCOPE("aiui", "AIUIASRListener::onEvent");
 	switch (event.getEventType()) {
 	//SDK ״̬ص
 	case aiui::AIUIConstant::EVENT_STATE:
@@ -79,6 +82,7 @@ void AIUIASRListener::onEvent(const aiui::IAIUIEvent& event) const {
 			break;
 		case aiui::AIUIConstant::VAD_EOS:
 			AISDK_INFO(LX("EVENT_VAD").d("state", "VAD_EOS"));
+			utils::tracing::DialogTurnTracer::instance().mark(utils::tracing::DialogTurnTracer::Stage::VAD_END);
 			break;
 		case aiui::AIUIConstant::VAD_VOL:
 			break;
@@ -14,6 +14,9 @@
 // jsoncpp ver.1.8.3
 #include "json/json.h"
 #include <Utils/Logging/Logger.h>
+#include <Utils/Logging/ThreadMoniker.h>
+#include <Utils/Threading/StallWatchdog.h>
+#include <Utils/Tracing/DialogTurnTracer.h>
 // Support read data(TTS) to a attachment.
 #include <Utils/Attachment/InProcessAttachment.h>
 #include "AIUI/AIUIAutomaticSpeechRecognizer.h"
@@ -32,6 +35,7 @@ namespace aiuiEngine {
 	
 using namespace utils::sharedbuffer;
 using ObserverInterface = utils::soundai::SoundAiObserverInterface;
+using TurnStage = utils::tracing::DialogTurnTracer::Stage;
 
 /// The name of the @c AudioTrackManager channel used by the @c SpeechSynthesizer.
 static const std::string CHANNEL_NAME = utils::channel::AudioTrackManagerInterface::DIALOG_CHANNEL_NAME;
@@ -200,6 +204,7 @@ AIUIAutomaticSpeechRecognizer::AIUIAutomaticSpeechRecognizer(
 	const std::string &aiuiConfigFile,
 	const std::string &aiuiDir,
 	const std::string &aiuiLogDir):
+	GenericAutomaticSpeechRecognizer{"aiui"},
 	m_trackManager{trackManager},
 	m_trackState{utils::channel::FocusState::NONE},
 	m_attachmentDocker{attachmentDocker},
@@ -209,7 +214,8 @@ AIUIAutomaticSpeechRecognizer::AIUIAutomaticSpeechRecognizer(
 	m_aiuiDir{aiuiDir}, 
 	m_aiuiLogDir{aiuiLogDir},
 	m_running{false},
-	m_attachmentWriter{nullptr} {
+	m_attachmentWriter{nullptr},
+	m_executor{"AIUIAutomaticSpeechRecognizer"} {
 
 }
 	
@@ -323,6 +329,7 @@ bool AIUIAutomaticSpeechRecognizer::executeRecognize(
 	// Formally update state now.
 	setVaildVad(false);
 	setState(ObserverInterface::State::RECOGNIZING);
+	utils::tracing::DialogTurnTracer::instance().mark(TurnStage::RECOGNIZE_STARTED);
 
 	/**
 	 * It must be ensured that there is a timeout mechanism when there is no response for 
@@ -366,6 +373,9 @@ bool AIUIAutomaticSpeechRecognizer::executeNLPResult(const std::string unparsedI
 
 	m_sessionId = sid;
 	AISDK_INFO(LX("executeNLPResult").d("newSID", sid));
+	utils::tracing::DialogTurnTracer::instance().bindTraceId(sid);
+	utils::tracing::DialogTurnTracer::instance().mark(TurnStage::NLP_RESULT, sid);
+	recordResultLatency();
 
 	setState(ObserverInterface::State::BUSY);
 
@@ -500,7 +510,9 @@ bool AIUIAutomaticSpeechRecognizer::executeTTSResult(const std::string info, con
 		recoder.write((const char*) data.c_str(), data.length());
 	#endif
 		// Start writing tts data to a specail attachment docker.
-		writeDataToAttachment(data.c_str(), data.length());
+		if(TTSDataWriteStatus::OK == writeDataToAttachment(data.c_str(), data.length())) {
+			utils::tracing::DialogTurnTracer::instance().mark(TurnStage::FIRST_TTS_CHUNK_WRITTEN, m_sessionId);
+		}
 	
 		if (2 == dts) {
 			AISDK_INFO(LX("executeTTSResult").d("dts", "Finished2"));
@@ -515,11 +527,14 @@ bool AIUIAutomaticSpeechRecognizer::executeTTSResult(const std::string info, con
 }
 
 void AIUIAutomaticSpeechRecognizer::sendStreamProcessing() {
+	utils::logging::ThreadMoniker::setThisThreadName("AIUIAudioUpload");
+	utils::threading::Heartbeat heartbeat{"AIUIAudioUpload"};
 	std::vector<int16_t> audioDataToPush(640); // 640*2 = 1280 = 80ms
 	ssize_t wordsRead;
 	do {
 		bool didErrorOccur = false;
 		// Start read data.
+		heartbeat.beat("readFromStream");
 		wordsRead = readFromStream(
 				m_reader,
 				audioDataToPush.data(),
@@ -549,8 +564,10 @@ void AIUIAutomaticSpeechRecognizer::sendStreamProcessing() {
 								0,
 								"data_type=audio,sample_rate=16000",
 								buffer);
+			heartbeat.beat("sendMessage");
 			m_aiuiAgent->sendMessage(writeMsg);
 			writeMsg->destroy();
+			utils::tracing::DialogTurnTracer::instance().mark(TurnStage::FIRST_AUDIO_UPLOADED);
 			//usleep(10 * 1000);
 		}
 	} while(!isVaildVad());
@@ -563,6 +580,7 @@ void AIUIAutomaticSpeechRecognizer::sendStreamProcessing() {
 								"data_type=audio,sample_rate=16000");
 	
 
+	heartbeat.beat("stopWrite");
 	m_aiuiAgent->sendMessage(stopWrite);
 	stopWrite->destroy();
 
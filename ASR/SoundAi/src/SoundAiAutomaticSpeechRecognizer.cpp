@@ -11,11 +11,11 @@
  * permissions and limitations under the License.
  */
 
-#include <iostream>
 #include <fstream>
 #include <string>
 
 #include <Utils/Logging/Logger.h>
+#include <Utils/Tracing/DialogTurnTracer.h>
 
 #include "SoundAi/SoundAiAutomaticSpeechRecognizer.h"
 #include "SoundAi/NetEventTypes.h"
@@ -134,14 +134,16 @@ SoundAiAutomaticSpeechRecognizer::SoundAiAutomaticSpeechRecognizer(
 	std::shared_ptr<dmInterface::MessageConsumerInterface> messageConsumer,
 	const std::string &configPath,
 	double threshold)
-	:m_deviceInfo{deviceInfo}
+	:GenericAutomaticSpeechRecognizer{"soundai"}
+	,m_deviceInfo{deviceInfo}
 	,m_trackManager{trackManager}
 	,m_trackState{utils::channel::FocusState::NONE}
 	,m_messageConsumer{messageConsumer}
 	,m_config{configPath}
 	,m_threshold{threshold}
 	,m_voipMode{0}
-	,m_logLevel{SAI_LOGGER_DEBUG} {
+	,m_logLevel{SAI_LOGGER_DEBUG}
+	,m_executor{"SoundAiAutomaticSpeechRecognizer"} {
 	m_soundAiEngine = this;
 
 }
@@ -174,8 +176,7 @@ bool SoundAiAutomaticSpeechRecognizer::init(){
 }
 
 void SoundAiAutomaticSpeechRecognizer::asrDataCallback(void * usr_data_asr, const char * id, const char *buffer, size_t size){
-	std::cout << __func__ << " :Entry" << std::endl;
-	std::cout << "buffer: " << buffer << std::endl;
+	AISDK_DEBUG5(LX("asrDataCallback").d("id", id).d("size", size));
 }
 
 void SoundAiAutomaticSpeechRecognizer::notifyKeyWordObservers( 
@@ -219,6 +220,8 @@ int SoundAiAutomaticSpeechRecognizer::wakeupCallback(void * usr_data_wk, const c
 	/// Comein capture stream state 
 	engine->setState(SoundAiObserver::State::RECOGNIZING);
 #endif
+	/// The engine detects the keyword itself, so the dialog turn starts here.
+	utils::tracing::DialogTurnTracer::instance().beginTurn();
 
 	engine->m_executor.submit([usr_data_wk, dialogID, keyword, angle]() {
 	    SoundAiAutomaticSpeechRecognizer* engine = static_cast<SoundAiAutomaticSpeechRecognizer*>(usr_data_wk);
@@ -232,18 +235,16 @@ int SoundAiAutomaticSpeechRecognizer::wakeupCallback(void * usr_data_wk, const c
 }
 
 void SoundAiAutomaticSpeechRecognizer::ivwDataCallback(const char * id, const char *buffer, size_t size){
-	std::cout << __func__ << " :Entry" << std::endl;	
-	std::cout << "buffer: " << buffer << std::endl;
+	AISDK_DEBUG5(LX("ivwDataCallback").d("id", id).d("size", size));
 }
 
 void SoundAiAutomaticSpeechRecognizer::voipDataCallback(void * usr_data_voip, const char* id, const char *buffer, size_t size){
-	std::cout << __func__ << " :Entry" << std::endl;
-	std::cout << "buffer: " << buffer << std::endl;
+	AISDK_DEBUG5(LX("voipDataCallback").d("id", id).d("size", size));
 	// default no-op
 }
 
 void SoundAiAutomaticSpeechRecognizer::oneshotCallback(int event_type){
-	std::cout << __func__ << " :Entry" << ": event_type: " << event_type << std::endl;
+	AISDK_DEBUG0(LX("oneshotCallback").d("eventType", event_type));
 	// default no-op
 }
 
@@ -262,6 +263,7 @@ void SoundAiAutomaticSpeechRecognizer::netEventCallback(const char * id, int typ
 	if(type == SOUNDAI_VAD) {
 		if(error_code == EVENT_VAD_END || error_code == EVENT_VAD_BEGIN_TIMEOUT) {
 			set_unwakeup_status();
+			utils::tracing::DialogTurnTracer::instance().mark(utils::tracing::DialogTurnTracer::Stage::VAD_END);
 
 			/// Comein think state
 			m_soundAiEngine->setState(SoundAiObserver::State::BUSY);
@@ -274,6 +276,9 @@ void SoundAiAutomaticSpeechRecognizer::netEventCallback(const char * id, int typ
 		// ...
 		// ...
 		// ...
+		utils::tracing::DialogTurnTracer::instance().bindTraceId(id);
+		utils::tracing::DialogTurnTracer::instance().mark(utils::tracing::DialogTurnTracer::Stage::NLP_RESULT, id);
+		m_soundAiEngine->recordResultLatency();
 		m_soundAiEngine->m_messageConsumer->consumeMessage(id, msg);
 		m_soundAiEngine->setState(SoundAiObserver::State::IDLE);
 	}
@@ -324,6 +329,7 @@ bool SoundAiAutomaticSpeechRecognizer::executeRecognize(
 #endif	
 	// Formally update state now.
 	setState(SoundAiObserver::State::RECOGNIZING);
+	utils::tracing::DialogTurnTracer::instance().mark(utils::tracing::DialogTurnTracer::Stage::RECOGNIZE_STARTED);
 
 	/**
 	 * It must be ensured that there is a timeout mechanism when there is no response for 
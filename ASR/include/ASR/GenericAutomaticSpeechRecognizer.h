@@ -13,6 +13,7 @@
 #ifndef __GENERIC_AUTOMATIC_SPEECH_RECOGNIZER_H_
 #define __GENERIC_AUTOMATIC_SPEECH_RECOGNIZER_H_
 
+#include <chrono>
 #include <mutex>
 #include <future>
 #include <unordered_set>
@@ -21,6 +22,7 @@
 #include <Utils/SharedBuffer/SharedBuffer.h>
 #include <Utils/Attachment/AttachmentManagerInterface.h>
 #include <Utils/SoundAi/SoundAiObserverInterface.h>
+#include <Utils/Metrics/Histogram.h>
 
 namespace aisdk {
 namespace asr {
@@ -92,9 +94,11 @@ protected:
     /**
      * Constructor.
      *
+     * @param engine The name of the engine, used as the @c engine label of the ASR result latency metric.
      * @param asrObservers The observers to notify of ASR.
      */
     GenericAutomaticSpeechRecognizer(
+        const std::string& engine,
         std::unordered_set<std::shared_ptr<utils::soundai::SoundAiObserverInterface>> asrObservers =
             std::unordered_set<std::shared_ptr<utils::soundai::SoundAiObserverInterface>>());
 #if 0
@@ -141,6 +145,12 @@ protected:
 	 */
 	utils::soundai::SoundAiObserverInterface::State getState() const;
 
+	/**
+	 * Record the time from the last change to the @c RECOGNIZING state until now in the ASR result latency metric.
+	 * Subclasses call this when the recognition result arrives; only the first call per recognition is recorded.
+	 */
+	void recordResultLatency();
+
 	/// @name SafeShutdown method:
 	/// @{
 	void doShutdown() override;
@@ -164,6 +174,15 @@ private:
     /// Lock to protect m_asrObservers when users wish to add or remove observers
     mutable std::mutex m_asrObserversMutex;
 
+	/// The time of the last change to the @c RECOGNIZING state.
+	std::chrono::steady_clock::time_point m_recognizeStartTime;
+
+	/// Whether a recognition started and its result latency has not been recorded yet.
+	bool m_isAwaitingResult;
+
+	/// The ASR result latency metric of the engine.
+	std::shared_ptr<utils::metrics::Histogram> m_resultLatencyHistogram;
+
 };
 
 }  // namespace asr
@@ -10,6 +10,7 @@
  * permissions and limitations under the License.
  */
 #include <Utils/Logging/Logger.h>
+#include <Utils/Metrics/MetricsRegistry.h>
 #include "ASR/GenericAutomaticSpeechRecognizer.h"
 
 namespace aisdk {
@@ -40,10 +41,16 @@ void GenericAutomaticSpeechRecognizer::removeASRObserver(
 }
 
 GenericAutomaticSpeechRecognizer::GenericAutomaticSpeechRecognizer(
+    const std::string& engine,
     std::unordered_set<std::shared_ptr<utils::soundai::SoundAiObserverInterface>> asrObservers):
     SafeShutdown{"GenericAutomaticSpeechRecognizer"},
     m_asrObservers{asrObservers},
-	m_state{utils::soundai::SoundAiObserverInterface::State::IDLE} {
+	m_state{utils::soundai::SoundAiObserverInterface::State::IDLE},
+	m_isAwaitingResult{false},
+	m_resultLatencyHistogram{utils::metrics::MetricsRegistry::instance().getHistogram(
+		"aisdk_asr_result_latency_milliseconds",
+		{{"engine", engine}},
+		"Time from the start of recognition to the recognition result.")} {
 
 }
 
@@ -103,6 +110,10 @@ void GenericAutomaticSpeechRecognizer::setState(
 
     AISDK_DEBUG(LX("setState").d("from", m_state).d("to", state));
     m_state = state;
+    if (utils::soundai::SoundAiObserverInterface::State::RECOGNIZING == state) {
+        m_recognizeStartTime = std::chrono::steady_clock::now();
+        m_isAwaitingResult = true;
+    }
     for (auto observer : m_asrObservers) {
         observer->onStateChanged(m_state);
     }
@@ -112,6 +123,21 @@ utils::soundai::SoundAiObserverInterface::State GenericAutomaticSpeechRecognizer
 	return m_state;
 }
 
+void GenericAutomaticSpeechRecognizer::recordResultLatency() {
+	std::unique_lock<std::mutex> lock(m_asrObserversMutex);
+	if (!m_isAwaitingResult) {
+		return;
+	}
+	m_isAwaitingResult = false;
+	auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - m_recognizeStartTime);
+	lock.unlock();
+
+	if (m_resultLatencyHistogram) {
+		m_resultLatencyHistogram->record(static_cast<uint64_t>(latency.count()));
+	}
+}
+
 void GenericAutomaticSpeechRecognizer::doShutdown() {
 	m_asrObservers.clear();
 	terminate();
@@ -13,6 +13,8 @@
 #ifndef _AUDIO_TRACE_MANAGER_H_
 #define _AUDIO_TRACE_MANAGER_H_
 
+#include <chrono>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <unordered_map>
@@ -21,6 +23,7 @@
 
 #include <Utils/Channel/ChannelObserverInterface.h>
 #include <Utils/Channel/AudioTrackManagerInterface.h>
+#include <Utils/Metrics/Histogram.h>
 
 #include "AudioTrackManager/Channel.h"
 #include "Utils/Threading/Executor.h"
@@ -78,6 +81,9 @@ public:
             {MEDIA_CHANNEL_NAME, MEDIA_CHANNEL_PRIORITY}
         });
 
+    /// Destructor.
+    ~AudioTrackManager();
+
 	/// name AudioTrackManagerInterface method:
 	/// @{
     bool acquireChannel(
@@ -135,6 +141,14 @@ private:
         std::shared_ptr<utils::channel::ChannelObserverInterface> channelObserver,
         const std::string &interface);
 
+    /**
+     * Record the focus change latency of an acquired Channel in its metric.
+     *
+     * @param channelName The name of the Channel acquired.
+     * @param requestTime The time the Channel was requested.
+     */
+    void recordFocusChangeLatency(const std::string& channelName, std::chrono::steady_clock::time_point requestTime);
+
     /**
      * Releases the Channel specified and updates other Channels as needed. This function provides the full
      * implementation which the public method will call.
@@ -208,6 +222,18 @@ private:
      */
     void foregroundHighestPriorityActiveChannel();
 
+    /**
+     * Renders the active Channels for the @c IntrospectionServer, from the last snapshot published by a focus change.
+     *
+     * @return A JSON array of the active Channels, the foregrounded one first.
+     */
+    std::string renderActiveChannels();
+
+    /**
+     * Publishes a snapshot of the active Channels for @c renderActiveChannels().  @c m_mutex must be held.
+     */
+    void publishActiveChannelsLocked();
+
     /// Map of channel names to shared_ptrs of Channel objects and contains every channel.
     std::unordered_map<std::string, std::shared_ptr<Channel>> m_allChannels;
 
@@ -220,6 +246,18 @@ private:
     /// Mutex used to lock m_activeChannels, m_observers and Channels' interface name.
     std::mutex m_mutex;
 
+    /**
+     * The JSON rendering of @c m_activeChannels, replaced on each change of the active Channels.  Only accessed with
+     * @c std::atomic_load and @c std::atomic_store, so that rendering never takes @c m_mutex.
+     */
+    std::shared_ptr<const std::string> m_activeChannelsSnapshot;
+
+    /// The id of the section published to the @c IntrospectionServer.
+    size_t m_introspectionId;
+
+    /// The focus change latency metric of each channel, by channel name.  Only written by the constructor.
+    std::unordered_map<std::string, std::shared_ptr<utils::metrics::Histogram>> m_focusChangeLatencyHistograms;
+
 	/// An internal thread pool.
     utils::threading::Executor m_executor;
 };
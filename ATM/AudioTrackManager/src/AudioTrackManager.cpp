@@ -11,43 +11,72 @@
  * permissions and limitations under the License.
  */
  
-#include <iostream>
+#include <Utils/Introspection/IntrospectionServer.h>
+#include <Utils/Logging/Logger.h>
+#include <Utils/Metrics/MetricsRegistry.h>
 #include "AudioTrackManager/AudioTrackManager.h"
 
+/// String to identify log entries originating from this file.
+static const std::string TAG("AudioTrackManager");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
 namespace aisdk {
 namespace atm {
 
 using namespace utils::channel;
 
-AudioTrackManager::AudioTrackManager(const std::vector<ChannelConfiguration> channelConfigurations){
+AudioTrackManager::AudioTrackManager(const std::vector<ChannelConfiguration> channelConfigurations) :
+        m_executor{"AudioTrackManager"} {
     for (auto config : channelConfigurations) {
         if (doesChannelNameExist(config.name)) {
-			std::cout << "createChannelFailed:reason:channel already exists: config: " << config.toString() << std::endl;
+			AISDK_ERROR(LX("createChannelFailed").d("reason", "channelNameExists").d("config", config.toString()));
             continue;
         }
         if (doesChannelPriorityExist(config.priority)) {
-			std::cout << "createChannelFailed:reason:priority already exist: config: " << config.toString() << std::endl;
+			AISDK_ERROR(LX("createChannelFailed").d("reason", "channelPriorityExists").d("config", config.toString()));
             continue;
         }
 
         auto channel = std::make_shared<Channel>(config.name, config.priority);
         m_allChannels.insert({config.name, channel});
+        m_focusChangeLatencyHistograms.insert({config.name,
+                                              utils::metrics::MetricsRegistry::instance().getHistogram(
+                                                  "aisdk_atm_focus_change_latency_microseconds",
+                                                  {{"channel", config.name}},
+                                                  "Time from a channel being requested until its observers were "
+                                                  "told of the new focus.")});
     }
+
+    std::atomic_store(&m_activeChannelsSnapshot, std::make_shared<const std::string>("[]"));
+    m_introspectionId = utils::introspection::IntrospectionServer::instance().addSection(
+        "audioTrackManager", "AudioTrackManager", [this]() { return renderActiveChannels(); });
+}
+
+AudioTrackManager::~AudioTrackManager() {
+    utils::introspection::IntrospectionServer::instance().removeSection(m_introspectionId);
 }
 
 bool AudioTrackManager::acquireChannel(
     const std::string& channelName,
     std::shared_ptr<ChannelObserverInterface> channelObserver,
     const std::string &interface) {
-	std::cout << "acquireChannel:channel:" << channelName << std::endl;
+	AISDK_DEBUG1(LX("acquireChannel").d("channel", channelName).d("interface", interface));
     std::shared_ptr<Channel> channelToAcquire = getChannel(channelName);
     if (!channelToAcquire) {
-		std::cout << "acquireChannelFailed:reason:channelNotFound:channel: " << channelName << std::endl;
+		AISDK_ERROR(LX("acquireChannelFailed").d("reason", "channelNotFound").d("channel", channelName));
         return false;
     }
 
-    m_executor.submit([this, channelToAcquire, channelObserver, interface]() {
+    auto requestTime = std::chrono::steady_clock::now();
+    m_executor.submit([this, channelToAcquire, channelObserver, interface, requestTime]() {
         acquireChannelHelper(channelToAcquire, channelObserver, interface);
+        recordFocusChangeLatency(channelToAcquire->getName(), requestTime);
     });
 	
     return true;
@@ -56,13 +85,13 @@ bool AudioTrackManager::acquireChannel(
 std::future<bool> AudioTrackManager::releaseChannel(
     const std::string& channelName,
     std::shared_ptr<ChannelObserverInterface> channelObserver) {
-	std::cout << "releaseChannel:channel: " << channelName << std::endl;
+	AISDK_DEBUG1(LX("releaseChannel").d("channel", channelName));
     // Using a shared_ptr here so that the promise stays in scope by the time the Executor picks up the task.
     auto releaseChannelSuccess = std::make_shared<std::promise<bool>>();
     std::future<bool> returnValue = releaseChannelSuccess->get_future();
     std::shared_ptr<Channel> channelToRelease = getChannel(channelName);
     if (!channelToRelease) {
-		std::cout << "releaseChannelFailed:reason:channelNotFound:channel: " << channelName << std::endl;	
+		AISDK_ERROR(LX("releaseChannelFailed").d("reason", "channelNotFound").d("channel", channelName));
         releaseChannelSuccess->set_value(false);
         return returnValue;
     }
@@ -79,7 +108,7 @@ void AudioTrackManager::stopForegroundActivity() {
     std::unique_lock<std::mutex> lock(m_mutex);
     std::shared_ptr<Channel> foregroundChannel = getHighestPriorityActiveChannelLocked();
     if (!foregroundChannel) {
-		std::cout << "stopForegroundActivityFailed:reason:noForegroundActivity" << std::endl;
+		AISDK_DEBUG0(LX("stopForegroundActivityFailed").d("reason", "noForegroundActivity"));
         return;
     }
 
@@ -91,6 +120,17 @@ void AudioTrackManager::stopForegroundActivity() {
     });
 }
 
+void AudioTrackManager::recordFocusChangeLatency(
+    const std::string& channelName,
+    std::chrono::steady_clock::time_point requestTime) {
+    auto it = m_focusChangeLatencyHistograms.find(channelName);
+    if (it != m_focusChangeLatencyHistograms.end() && it->second) {
+        it->second->record(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - requestTime)
+                .count());
+    }
+}
+
 void AudioTrackManager::addObserver(const std::shared_ptr<AudioTrackManagerObserverInterface>& observer) {
     std::lock_guard<std::mutex> lock(m_mutex);
     m_observers.insert(observer);
@@ -125,6 +165,7 @@ void AudioTrackManager::acquireChannelHelper(
     std::shared_ptr<Channel> foregroundChannel = getHighestPriorityActiveChannelLocked();
 	channelToAcquire->setInterface(interface);
     m_activeChannels.insert(channelToAcquire);
+    publishActiveChannelsLocked();
     lock.unlock();
 
     // Set the new observer.
@@ -148,7 +189,7 @@ void AudioTrackManager::releaseChannelHelper(
     std::shared_ptr<std::promise<bool>> releaseChannelSuccess,
     const std::string& name) {
     if (!channelToRelease->doesObserverOwnChannel(channelObserver)) {
-		std::cout << "releaseChannelHelperFailed:reason:observerDoNotOwnChannel:channel: " << name << std::endl;
+		AISDK_ERROR(LX("releaseChannelHelperFailed").d("reason", "observerDoesNotOwnChannel").d("channel", name));
         releaseChannelSuccess->set_value(false);
         return;
     }
@@ -158,6 +199,7 @@ void AudioTrackManager::releaseChannelHelper(
     std::unique_lock<std::mutex> lock(m_mutex);
     bool wasForegrounded = isChannelForegroundedLocked(channelToRelease);
     m_activeChannels.erase(channelToRelease);
+    publishActiveChannelsLocked();
     lock.unlock();
 
     setChannelTrack(channelToRelease, FocusState::NONE);
@@ -180,6 +222,7 @@ void AudioTrackManager::stopForegroundActivityHelper(
     // Lock here to update internal state which stopForegroundActivity may concurrently access.
     std::unique_lock<std::mutex> lock(m_mutex);
     m_activeChannels.erase(foregroundChannel);
+    publishActiveChannelsLocked();
     lock.unlock();
     foregroundHighestPriorityActiveChannel();
 }
@@ -203,6 +246,22 @@ bool AudioTrackManager::isChannelForegroundedLocked(const std::shared_ptr<Channe
     return getHighestPriorityActiveChannelLocked() == channel;
 }
 
+std::string AudioTrackManager::renderActiveChannels() {
+    return *std::atomic_load(&m_activeChannelsSnapshot);
+}
+
+void AudioTrackManager::publishActiveChannelsLocked() {
+    using utils::introspection::IntrospectionServer;
+    std::string json = "[";
+    for (auto& channel : m_activeChannels) {
+        json += (json.size() > 1 ? ",{\"name\":" : "{\"name\":") + IntrospectionServer::quote(channel->getName()) +
+                ",\"priority\":" + std::to_string(channel->getPriority()) +
+                ",\"interface\":" + IntrospectionServer::quote(channel->getInterface()) +
+                ",\"foreground\":" + (isChannelForegroundedLocked(channel) ? "true" : "false") + "}";
+    }
+    std::atomic_store(&m_activeChannelsSnapshot, std::make_shared<const std::string>(json + "]"));
+}
+
 bool AudioTrackManager::doesChannelNameExist(const std::string& name) const {
     return m_allChannels.find(name) != m_allChannels.end();
 }
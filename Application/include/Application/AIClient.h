@@ -63,6 +63,14 @@ public:
 	 * Stop service to allow the client to initiate disconnect sai sdk.
 	 */
 	void disconnect();
+
+	/**
+	 * Add an observer of the focus changes of the audio channels, such as the one ducking a shared output.
+	 *
+	 * @param observer The observer to add.
+	 */
+	void addAudioTrackManagerObserver(
+		std::shared_ptr<utils::channel::AudioTrackManagerObserverInterface> observer);
 	
     /**
      * Destructor.
@@ -15,6 +15,11 @@
 
 #include <memory>
 #include <AudioMediaPlayer/AOWrapper.h>
+#include <AudioMediaPlayer/AudioMixer.h>
+#include <AudioMediaPlayer/FocusDuckingObserver.h>
+#include <AudioMediaPlayer/DecoderContextPool.h>
+#include <AudioMediaPlayer/PcmCache.h>
+#include <AudioMediaPlayer/UrlCache.h>
 #include <KWD/GenericKeywordDetector.h>
 
 #include "Application/AIClient.h"
@@ -44,6 +49,17 @@ public:
 private:
 	bool initialize();
 
+	/**
+	 * Create the chat, stream and alarm players on the inputs of an @c AudioMixer writing to one output device.
+	 *
+	 * @param soundOptions The options of the chat and alarm players.
+	 * @param streamOptions The options of the stream player.
+	 * @return Whether the players were created.
+	 */
+	bool createSharedOutputPlayers(
+		const mediaPlayer::ffmpeg::AOWrapper::Options& soundOptions,
+		const mediaPlayer::ffmpeg::AOWrapper::Options& streamOptions);
+
 	// The used to create libao objects.
 	std::shared_ptr<mediaPlayer::ffmpeg::AOEngine> m_aoEngine;
 
@@ -56,6 +72,21 @@ private:
 	// The @c MediaPlayer used by @c MediaStream.
 	std::shared_ptr<mediaPlayer::ffmpeg::AOWrapper> m_alarmMediaPlayer;
 
+	/// The mixer of the players when they share one output device, or @c nullptr.
+	std::shared_ptr<mediaPlayer::ffmpeg::AudioMixer> m_audioMixer;
+
+	/// Ducks the players of the shared output whose channel is in background, or @c nullptr.
+	std::shared_ptr<mediaPlayer::ffmpeg::FocusDuckingObserver> m_duckingObserver;
+
+	/// The cache the stream player reads http urls through, or @c nullptr.
+	std::shared_ptr<mediaPlayer::ffmpeg::UrlCache> m_urlCache;
+
+	/// The cache the chat and alarm players keep the decoded audio of their sounds in, or @c nullptr.
+	std::shared_ptr<mediaPlayer::ffmpeg::PcmCache> m_pcmCache;
+
+	/// The codec contexts and resamplers the decoders of the players share, or @c nullptr.
+	std::shared_ptr<mediaPlayer::ffmpeg::DecoderContextPool> m_decoderContextPool;
+
 	/// The default ai sdk client instance.
 	std::shared_ptr<AIClient> m_aiClient;
 
@@ -231,6 +231,11 @@ void AIClient::disconnect() {
 #endif	
 }
 
+void AIClient::addAudioTrackManagerObserver(
+	std::shared_ptr<utils::channel::AudioTrackManagerObserverInterface> observer) {
+	m_audioTrackManager->addObserver(observer);
+}
+
 AIClient::~AIClient() {
 	if(m_domainSequencer) {
 		AISDK_DEBUG5(LX("DomainSequencerShutdown"));
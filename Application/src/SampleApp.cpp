@@ -10,9 +10,20 @@
  * permissions and limitations under the License.
  */
 
+#include <cstdlib>
+
+#include <Utils/Introspection/IntrospectionServer.h>
+#include <Utils/Logging/FlightRecorder.h>
 #include <Utils/Logging/Logger.h>
+#include <Utils/Metrics/MetricsRegistry.h>
+#include <Utils/Metrics/ThreadCpuSampler.h>
+#include <Utils/Threading/StallWatchdog.h>
+#include <Utils/Tracing/TraceEventRecorder.h>
 #include <Utils/DeviceInfo.h>
 #include <KWD/KeywordDetectorRegister.h>
+#include <AudioMediaPlayer/AOAudioOutput.h>
+#include <AudioMediaPlayer/Endian.h>
+#include <AudioMediaPlayer/FocusDuckingObserver.h>
 
 #include "Application/PortAudioMicrophoneWrapper.h"
 #include "Application/AIClient.h"  //tmp
@@ -25,6 +36,53 @@ static const std::string TAG{"SampleApp"};
 namespace aisdk {
 namespace application {
 
+#ifdef AISDK_TRACING_ENABLED
+/// Environment variable naming the file a trace-event capture is written to when the app exits.
+static const char* TRACE_FILE_ENVIRONMENT_VARIABLE = "AISDK_TRACE_FILE";
+#endif
+
+/// Environment variable naming the file the flight recorder dumps the recent logs to, after an error or a crash.
+static const char* FLIGHT_RECORDER_FILE_ENVIRONMENT_VARIABLE = "AISDK_FLIGHT_RECORDER_FILE";
+
+/// Environment variable naming the file the metrics are periodically written to.
+static const char* METRICS_FILE_ENVIRONMENT_VARIABLE = "AISDK_METRICS_FILE";
+
+/// The interval between two writes of the metrics file.
+static const std::chrono::seconds METRICS_FILE_INTERVAL{10};
+
+/// The interval between two samples of the CPU use of the SDK threads, exported with the metrics.
+static const std::chrono::seconds THREAD_CPU_SAMPLING_INTERVAL{5};
+
+/// Environment variable naming the Unix domain socket the introspection server listens on.
+static const char* INTROSPECTION_SOCKET_ENVIRONMENT_VARIABLE = "AISDK_INTROSPECTION_SOCKET";
+
+/// Environment variable overriding how long, in milliseconds, a processing loop may stay in one stage.
+static const char* STALL_DEADLINE_ENVIRONMENT_VARIABLE = "AISDK_STALL_DEADLINE_MS";
+
+/// How long a processing loop may stay in one stage before it is reported as stalled.
+static const std::chrono::milliseconds DEFAULT_STALL_DEADLINE{10000};
+
+/// The interval between two checks of the processing loops.
+static const std::chrono::milliseconds STALL_CHECK_INTERVAL{1000};
+
+/// Environment variable which, when set, mixes the chat, stream and alarm players into one shared output device.
+static const char* SHARED_OUTPUT_ENVIRONMENT_VARIABLE = "AISDK_SHARED_OUTPUT";
+
+/// Environment variable naming the directory the stream player caches the content of http urls in.
+static const char* URL_CACHE_DIRECTORY_ENVIRONMENT_VARIABLE = "AISDK_URL_CACHE_DIR";
+
+/// The most content of urls kept in the cache directory.
+static const uint64_t URL_CACHE_MAX_BYTES = 256 * 1024 * 1024;
+
+/// Environment variable naming the directory the chat and alarm players keep the decoded audio of their sounds in.
+static const char* PCM_CACHE_DIRECTORY_ENVIRONMENT_VARIABLE = "AISDK_PCM_CACHE_DIR";
+
+/// The most decoded audio kept in the cache directory.
+static const uint64_t PCM_CACHE_MAX_BYTES = 32 * 1024 * 1024;
+
+/// The most decoded audio kept mapped between plays.
+static const uint64_t PCM_CACHE_MAX_MEMORY_BYTES = 8 * 1024 * 1024;
+
 /// The sample rate of microphone audio data.
 static const unsigned int SAMPLE_RATE_HZ = 16000;
 
@@ -64,6 +122,11 @@ void SampleApp::run() {
 }
 
 SampleApp::~SampleApp() {
+	utils::threading::StallWatchdog::instance().stop();
+	utils::introspection::IntrospectionServer::instance().stop();
+	if(utils::tracing::TraceEventRecorder::isTracing()) {
+		utils::tracing::TraceEventRecorder::stopTracing();
+	}
 //	m_aiClient.reset();
 	if(m_chatMediaPlayer) {
 		m_chatMediaPlayer->shutdown();
@@ -74,37 +137,144 @@ SampleApp::~SampleApp() {
 	if(m_alarmMediaPlayer) {
 		m_alarmMediaPlayer->shutdown();
 	}
+	if(m_audioMixer) {
+		m_audioMixer->shutdown();
+	}
 }
 
 bool SampleApp::initialize() {
+	// Keep the most recent logs of every level in memory so they can be dumped after an error or a crash.
+	auto flightRecorderFile = std::getenv(FLIGHT_RECORDER_FILE_ENVIRONMENT_VARIABLE);
+	if(flightRecorderFile) {
+		auto& flightRecorder = utils::logging::FlightRecorder::instance();
+		if(!flightRecorder.setDumpFilePath(flightRecorderFile) || !flightRecorder.enable() ||
+			!flightRecorder.installFatalSignalHandlers()) {
+			AISDK_WARN(LX("initialize").d("reason", "flight recorder unavailable").d("file", flightRecorderFile));
+		}
+	}
+
 	AISDK_INFO(LX("initialize").d("reason", "Entry"));
 
+	auto metricsFile = std::getenv(METRICS_FILE_ENVIRONMENT_VARIABLE);
+	if(metricsFile) {
+		utils::metrics::MetricsRegistry::instance().startFileExport(
+			metricsFile, METRICS_FILE_INTERVAL, utils::metrics::MetricsRegistry::Format::PROMETHEUS);
+		utils::metrics::ThreadCpuSampler::instance().start(THREAD_CPU_SAMPLING_INTERVAL);
+	}
+
+	auto stallDeadline = DEFAULT_STALL_DEADLINE;
+	auto stallDeadlineMs = std::getenv(STALL_DEADLINE_ENVIRONMENT_VARIABLE);
+	if(stallDeadlineMs) {
+		char* end = nullptr;
+		auto value = std::strtol(stallDeadlineMs, &end, 10);
+		if(end != stallDeadlineMs && '\0' == *end && value > 0) {
+			stallDeadline = std::chrono::milliseconds(value);
+		} else {
+			AISDK_WARN(LX("initialize").d("reason", "invalid stall deadline, using the default")
+				.d("value", stallDeadlineMs).d("defaultMs", DEFAULT_STALL_DEADLINE.count()));
+		}
+	}
+	utils::threading::StallWatchdog::instance().start(stallDeadline, STALL_CHECK_INTERVAL);
+
+	auto introspectionSocket = std::getenv(INTROSPECTION_SOCKET_ENVIRONMENT_VARIABLE);
+	if(introspectionSocket) {
+		utils::introspection::IntrospectionServer::instance().start(introspectionSocket);
+	}
+
+#ifdef AISDK_TRACING_ENABLED
+	auto traceFile = std::getenv(TRACE_FILE_ENVIRONMENT_VARIABLE);
+	if(traceFile) {
+		utils::tracing::TraceEventRecorder::startTracing(traceFile);
+	}
+#endif
+
 	// Create a libao engine object.
-	auto m_aoEngine = mediaPlayer::ffmpeg::AOEngine::create();
+	m_aoEngine = mediaPlayer::ffmpeg::AOEngine::create();
 	if(!m_aoEngine) {
 		AISDK_ERROR(LX("Failed to create media player engine!"));
 		return false;
 	}
 	
-	// Create a chatMediaPlayer of @c Pawrapper.
-	m_chatMediaPlayer = mediaPlayer::ffmpeg::AOWrapper::create(m_aoEngine);
-	if(!m_chatMediaPlayer) {
-		AISDK_ERROR(LX("Failed to create media player for chat speech!"));
-		return false;
+	auto urlCacheDirectory = std::getenv(URL_CACHE_DIRECTORY_ENVIRONMENT_VARIABLE);
+	if(urlCacheDirectory) {
+		// Replays and backward seeks of the stream player are read from disk; without a cache they are fetched again.
+		m_urlCache = mediaPlayer::ffmpeg::UrlCache::create(urlCacheDirectory, URL_CACHE_MAX_BYTES);
+		if(!m_urlCache) {
+			AISDK_WARN(LX("Failed to create the url cache, urls are read from the network!"));
+		}
 	}
 
-	m_streamMediaPlayer = mediaPlayer::ffmpeg::AOWrapper::create(m_aoEngine);
-	if(!m_streamMediaPlayer) {
-		AISDK_ERROR(LX("Failed to create media player for stream!"));
-		return false;
+	auto pcmCacheDirectory = std::getenv(PCM_CACHE_DIRECTORY_ENVIRONMENT_VARIABLE);
+	if(pcmCacheDirectory) {
+		// Prompts, earcons and alarm tones played again are copied from their decoded audio instead of decoded.
+		// The url cache validates the http ones, which are decoded again once they change on the server.
+		m_pcmCache = mediaPlayer::ffmpeg::PcmCache::create(
+			pcmCacheDirectory,
+			PCM_CACHE_MAX_BYTES,
+			PCM_CACHE_MAX_MEMORY_BYTES,
+			mediaPlayer::ffmpeg::PcmCache::DEFAULT_MAX_CLIP_BYTES,
+			m_urlCache);
+		if(!m_pcmCache) {
+			AISDK_WARN(LX("Failed to create the decoded audio cache, every play is decoded!"));
+		}
 	}
 
-	m_alarmMediaPlayer = mediaPlayer::ffmpeg::AOWrapper::create(m_aoEngine);
-	if(!m_alarmMediaPlayer) {
-		AISDK_ERROR(LX("Failed to create media player for alarm!"));
-		return false;
+	// Every dialog turn decodes its speech with a new decoder, which takes the codec context of the previous turn.
+	m_decoderContextPool = mediaPlayer::ffmpeg::DecoderContextPool::create();
+	if(!m_decoderContextPool) {
+		AISDK_WARN(LX("Failed to create the decoder context pool, each decoder sets up its own!"));
 	}
-	
+
+	// The chat and alarm players play short sounds again and again, the stream player reads http urls.
+	mediaPlayer::ffmpeg::AOWrapper::Options soundOptions;
+	soundOptions.pcmCache = m_pcmCache;
+	soundOptions.contextPool = m_decoderContextPool;
+	mediaPlayer::ffmpeg::AOWrapper::Options streamOptions;
+	streamOptions.urlCache = m_urlCache;
+	streamOptions.contextPool = m_decoderContextPool;
+
+	if(std::getenv(SHARED_OUTPUT_ENVIRONMENT_VARIABLE)) {
+		// Mix all the players into one device, at its default format, and duck a channel while it is in background.
+		if(!createSharedOutputPlayers(soundOptions, streamOptions)) {
+			return false;
+		}
+	} else {
+		// Create a chatMediaPlayer of @c Pawrapper, at the 16kHz mono format of the speech so that it is played without FFmpeg.
+		m_chatMediaPlayer = mediaPlayer::ffmpeg::AOWrapper::create(
+			m_aoEngine,
+			mediaPlayer::ffmpeg::PlaybackConfiguration(
+				mediaPlayer::ffmpeg::littleEndianMachine(),
+				16000,
+				mediaPlayer::ffmpeg::PlaybackConfiguration::ChannelLayout::LAYOUT_MONO,
+				mediaPlayer::ffmpeg::PlaybackConfiguration::SampleFormat::SIGNED_16),
+			"chat",
+			soundOptions);
+		if(!m_chatMediaPlayer) {
+			AISDK_ERROR(LX("Failed to create media player for chat speech!"));
+			return false;
+		}
+
+		m_streamMediaPlayer = mediaPlayer::ffmpeg::AOWrapper::create(
+			m_aoEngine,
+			mediaPlayer::ffmpeg::PlaybackConfiguration(),
+			"stream",
+			streamOptions);
+		if(!m_streamMediaPlayer) {
+			AISDK_ERROR(LX("Failed to create media player for stream!"));
+			return false;
+		}
+
+		m_alarmMediaPlayer = mediaPlayer::ffmpeg::AOWrapper::create(
+			m_aoEngine,
+			mediaPlayer::ffmpeg::PlaybackConfiguration(),
+			"alarm",
+			soundOptions);
+		if(!m_alarmMediaPlayer) {
+			AISDK_ERROR(LX("Failed to create media player for alarm!"));
+			return false;
+		}
+	}
+
 	// To-Do Sven
 	// To create other mediaplayer
 	// ...
@@ -131,6 +301,9 @@ bool SampleApp::initialize() {
         AISDK_ERROR(LX("Failed to create AI SDK client!"));
         return false;
     }
+	if(m_duckingObserver) {
+		m_aiClient->addAudioTrackManagerObserver(m_duckingObserver);
+	}
 	
 #if defined(KWD_IFLYTEK)
 	// Step1.
@@ -179,6 +352,45 @@ bool SampleApp::initialize() {
 	return true;
 }
 
+bool SampleApp::createSharedOutputPlayers(
+	const mediaPlayer::ffmpeg::AOWrapper::Options& soundOptions,
+	const mediaPlayer::ffmpeg::AOWrapper::Options& streamOptions) {
+	std::shared_ptr<mediaPlayer::ffmpeg::AudioOutputInterface> output =
+		mediaPlayer::ffmpeg::AOAudioOutput::create(m_aoEngine, mediaPlayer::ffmpeg::PlaybackConfiguration());
+	if(!output) {
+		AISDK_ERROR(LX("Failed to open the shared audio output!"));
+		return false;
+	}
+
+	m_audioMixer = mediaPlayer::ffmpeg::AudioMixer::create(output);
+	if(!m_audioMixer) {
+		AISDK_ERROR(LX("Failed to create the audio mixer!"));
+		return false;
+	}
+
+	auto chatInput = m_audioMixer->createInput("chat");
+	auto streamInput = m_audioMixer->createInput("stream");
+	auto alarmInput = m_audioMixer->createInput("alarm");
+	if(!chatInput || !streamInput || !alarmInput) {
+		AISDK_ERROR(LX("Failed to create the audio mixer inputs!"));
+		return false;
+	}
+
+	m_chatMediaPlayer = mediaPlayer::ffmpeg::AOWrapper::create(chatInput, "chat", soundOptions);
+	m_streamMediaPlayer = mediaPlayer::ffmpeg::AOWrapper::create(streamInput, "stream", streamOptions);
+	m_alarmMediaPlayer = mediaPlayer::ffmpeg::AOWrapper::create(alarmInput, "alarm", soundOptions);
+	if(!m_chatMediaPlayer || !m_streamMediaPlayer || !m_alarmMediaPlayer) {
+		AISDK_ERROR(LX("Failed to create the media players of the shared output!"));
+		return false;
+	}
+
+	m_duckingObserver = std::make_shared<mediaPlayer::ffmpeg::FocusDuckingObserver>(
+		std::unordered_map<std::string, std::shared_ptr<mediaPlayer::ffmpeg::AudioMixerInput>>{
+			{std::string(utils::channel::AudioTrackManagerInterface::DIALOG_CHANNEL_NAME), chatInput},
+			{std::string(utils::channel::AudioTrackManagerInterface::MEDIA_CHANNEL_NAME), streamInput},
+			{std::string(utils::channel::AudioTrackManagerInterface::ALARMS_CHANNEL_NAME), alarmInput}});
+	return true;
+}
 
 }  // namespace application
 }  // namespace aisdk
@@ -14,6 +14,7 @@
 // jsoncpp ver-1.8.3
 #include <json/json.h>
 #include <Utils/Logging/Logger.h>
+#include <Utils/Tracing/DialogTurnTracer.h>
 
 #include "SpeechSynthesizer/SpeechSynthesizer.h"
 
@@ -118,6 +119,10 @@ void SpeechSynthesizer::onTrackChanged(FocusState newTrace) {
     }
 
 	auto messageId = (m_currentInfo && m_currentInfo->directive) ? m_currentInfo->directive->getMessageId() : "";
+	if (FocusState::FOREGROUND == newTrace) {
+		utils::tracing::DialogTurnTracer::instance().mark(
+			utils::tracing::DialogTurnTracer::Stage::FOCUS_ACQUIRED, messageId);
+	}
     m_executor.submit([this]() { executeStateChange(); });
 
 	// Block until we achieve the desired state.
@@ -250,7 +255,8 @@ SpeechSynthesizer::SpeechSynthesizer(
 	m_currentState{SpeechSynthesizerObserverInterface::SpeechSynthesizerState::FINISHED},
 	m_desiredState{SpeechSynthesizerObserverInterface::SpeechSynthesizerState::FINISHED},
 	m_currentFocus{FocusState::NONE},
-	m_isAlreadyStopping{false} {
+	m_isAlreadyStopping{false},
+	m_executor{SPEECHNAME} {
 }
 
 void SpeechSynthesizer::init() {
@@ -1,4 +1,3 @@
-#include <iostream>
 #include <vector>
 #include <fstream>
 #include <cstring>
@@ -10,6 +9,8 @@
 #include <msp_errors.h>
 
 #include <Utils/Logging/Logger.h>
+#include <Utils/Logging/ThreadMoniker.h>
+#include <Utils/Threading/StallWatchdog.h>
 #include "IflyTekKeywordDetector.h"
 
 /// String to identify log entries originating from this file.
@@ -148,6 +149,8 @@ int IflyTekKeywordDetector::keyWordDetectedCallback(
 }
 
 void IflyTekKeywordDetector::detectionLoop() {
+	utils::logging::ThreadMoniker::setThisThreadName("IflyTekKeywordDetector");
+	utils::threading::Heartbeat heartbeat{"IflyTekKeywordDetector"};
 	std::vector<int16_t> audioDataToPush(m_maxSamplesPerPush); //160*2 = 320 = 20ms 
 	int errCode = MSP_SUCCESS;
 	int audioStatus = MSP_AUDIO_SAMPLE_FIRST;
@@ -158,6 +161,7 @@ void IflyTekKeywordDetector::detectionLoop() {
 
 		bool didErrorOccur = false;
 		// Start read data.
+		heartbeat.beat("readFromStream");
 		wordsRead = readFromStream(
 				m_streamReader,
 				m_stream,
@@ -175,14 +179,14 @@ void IflyTekKeywordDetector::detectionLoop() {
 			void *pbuf8 = audioDataToPush.data();
 			output.write(static_cast<char *>(pbuf8), wordsRead*sizeof(*audioDataToPush.data()));
 
+			heartbeat.beat("QIVWAudioWrite");
 			errCode = QIVWAudioWrite(
 				m_sessionId.c_str(),
 				audioDataToPush.data(),
 				wordsRead*sizeof(*audioDataToPush.data()),
 				audioStatus);
 			if (MSP_SUCCESS != errCode){
-				std::cout << __FILE__ << ":" << __LINE__ << " QIVWAudioWrite failed! error code: " << errCode << std::endl;
-				
+				AISDK_ERROR(LX("detectionLoopFailed").d("reason", "QIVWAudioWriteFailed").d("errorCode", errCode));
 			}
 
 			audioStatus = MSP_AUDIO_SAMPLE_CONTINUE;
@@ -10,11 +10,22 @@
  * express or implied. See the License for the specific language governing
  * permissions and limitations under the License.
  */
-#include <iostream>
+#include <Utils/Logging/Logger.h>
+#include <Utils/Logging/ThreadMoniker.h>
 #include "SoundAi/sai_sdk.h"
 
 #include "KeywordDetector/KeywordDetector.h"
 
+/// String to identify log entries originating from this file.
+static const std::string TAG("KeywordDetector");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
 namespace aisdk {
 namespace kwd {
 
@@ -32,11 +43,13 @@ void KeywordDetector::stop() {
 
     if (std::this_thread::get_id() != m_detectionThread.get_id() && m_detectionThread.joinable()) {
         m_detectionThread.join();
-		std::cout << "stop task..." << std::endl;  //tmp debug
+		AISDK_DEBUG0(LX("stop").d("reason", "detectionThreadJoined"));
     }
 }
 
 void KeywordDetector::detectionHandler(){
+	utils::logging::ThreadMoniker::setThisThreadName("SoundAiKeywordDetector");
+
     // Timepoint to measure delay/period against.
     auto now = std::chrono::steady_clock::now();
 
@@ -45,7 +58,7 @@ void KeywordDetector::detectionHandler(){
 	// ...
 	// ...
 	
-	std::cout << "detectionHandler entry...." << std::endl;
+	AISDK_DEBUG0(LX("detectionHandler").d("reason", "Entry"));
 	std::unique_lock<std::mutex> lock(m_detectionWaitMutex);
     // Wait for stop() or a delay/period to elapse.
     if (m_detectionWaitCondition.wait_until(lock, now + timeoutForListeningToIdle, [this]() { return m_stopping; })) {
@@ -53,7 +66,7 @@ void KeywordDetector::detectionHandler(){
         m_running = false;
         return;
     }else{
-		std::cout << "wakeup handler timeout:reason: don't check vad event or network unreachable." << std::endl;
+		AISDK_WARN(LX("detectionHandlerTimeout").d("reason", "noVadEventOrNetworkUnreachable"));
 		// To-Do release channel player
 		// ...
 		// ...
@@ -69,19 +82,15 @@ void KeywordDetector::onKeyWordDetected(
 	 std::string dialogId,
 	 std::string keyword,
 	 float angle){
-	std::cout << __func__ << ": dialogid: " << dialogId << ", word: " << keyword << ", angle: " << angle << std::endl;
-#if 0
-	if(keyword == "xiaokangxiaokang")
-		std::cout << "This isn't our expectation keyword" << std::endl;
-#endif
+	AISDK_INFO(LX("onKeyWordDetected").d("dialogId", dialogId).d("keyword", keyword).d("angle", angle));
 
 	if(m_detectionThread.joinable()){
-		std::cout << "detection stop old task...." << std::endl;
+		AISDK_DEBUG0(LX("onKeyWordDetected").d("reason", "joiningPreviousDetectionThread"));
 		m_detectionThread.join();
 	}
 	
 	if(m_running.exchange(true)){
-		std::cout << "detectHandler already actived..." << std::endl;
+		AISDK_DEBUG0(LX("onKeyWordDetectedIgnored").d("reason", "detectionHandlerAlreadyActive"));
 		return;
 	}
 	
@@ -90,7 +99,7 @@ void KeywordDetector::onKeyWordDetected(
 }
 
 void KeywordDetector::onStateChanged(utils::soundai::SoundAiObserverInterface::State state){
-	std::cout << "====>" << __func__ << ", state change" << std::endl;
+	AISDK_DEBUG0(LX("onStateChanged").d("state", state));
 
 	if(utils::soundai::SoundAiObserverInterface::State::BUSY == state){
 		stop();
@@ -11,6 +11,7 @@
  */
 
 #include <Utils/Logging/Logger.h>
+#include <Utils/Tracing/DialogTurnTracer.h>
 
 #include "KWD/GenericKeywordDetector.h"
 
@@ -51,6 +52,7 @@ void GenericKeywordDetector::notifyKeyWordObservers(
     std::string keyword,
     SharedBuffer::Index beginIndex,
     SharedBuffer::Index endIndex) const {
+    utils::tracing::DialogTurnTracer::instance().beginTurn();
     std::lock_guard<std::mutex> lock(m_keyWordObserversMutex);
     for (auto keyWordObserver : m_keyWordObservers) {
         keyWordObserver->onKeyWordDetected(stream, keyword);
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __AO_AUDIO_OUTPUT_H_
+#define __AO_AUDIO_OUTPUT_H_
+
+#include <memory>
+
+#include <ao/ao.h>
+
+#include "AOEngine.h"
+#include "AudioOutputInterface.h"
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/**
+ * An output which plays the audio on the default libao driver.
+ */
+class AOAudioOutput : public AudioOutputInterface {
+public:
+    /**
+     * Open the default libao device.
+     *
+     * @param aoEngine The libao engine, which is kept alive as long as the device is open.
+     * @param config The format of the audio to play.
+     * @return The new output, or @c nullptr if the engine is @c nullptr or the device could not be opened.
+     */
+    static std::unique_ptr<AOAudioOutput> create(
+        std::shared_ptr<AOEngine> aoEngine,
+        const PlaybackConfiguration& config);
+
+    /// @name AudioOutputInterface method overrides.
+    /// @{
+    bool write(const uint8_t* data, size_t size) override;
+    PlaybackConfiguration getConfiguration() const override;
+    /// @}
+
+private:
+    /**
+     * Constructor.
+     *
+     * @param aoEngine The libao engine.
+     * @param config The format of the audio to play.
+     * @param device The open device.
+     */
+    AOAudioOutput(
+        std::shared_ptr<AOEngine> aoEngine,
+        const PlaybackConfiguration& config,
+        std::shared_ptr<ao_device> device);
+
+    /// Keep the libao engine alive until the device is closed.
+    std::shared_ptr<AOEngine> m_engine;
+
+    /// The format of the audio to play.
+    const PlaybackConfiguration m_config;
+
+    /// The libao device.
+    std::shared_ptr<ao_device> m_device;
+};
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __AO_AUDIO_OUTPUT_H_
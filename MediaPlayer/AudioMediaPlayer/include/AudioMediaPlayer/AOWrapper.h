@@ -12,15 +12,35 @@
 #ifndef __AOWRAPPER__H_
 #define __AOWRAPPER__H_
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 #include <stdbool.h>
 
-#include <ao/ao.h>
 #include <Utils/MediaPlayer/MediaPlayerInterface.h>
+#include <Utils/Metrics/Counter.h>
+#include <Utils/Metrics/Gauge.h>
+#include <Utils/Metrics/Histogram.h>
+#include <Utils/PlaylistParser/IterativePlaylistParserInterface.h>
 #include <Utils/SafeShutdown.h>
+#include <Utils/Threading/StallWatchdog.h>
 #include "FFmpegInputControllerInterface.h"
+#include "AudioMediaPlayer/AudioOutputInterface.h"
+#include "AudioMediaPlayer/DecoderInterface.h"
 #include "AudioMediaPlayer/FFmpegDecoder.h"
+#include "AudioMediaPlayer/DecoderContextPool.h"
+#include "AudioMediaPlayer/PcmCache.h"
+#include "AudioMediaPlayer/PcmKernels.h"
+#include "AudioMediaPlayer/PcmRingBuffer.h"
+#include "AudioMediaPlayer/ProbeConfiguration.h"
+#include "AudioMediaPlayer/UrlCache.h"
 #include "AOEngine.h"
 
 namespace aisdk {
@@ -30,7 +50,32 @@ namespace ffmpeg{
 /**
  * This class implements an media player.
  *
- * The implementation uses Libao APIs to play the audio and FFmpeg to decode and resample the media input.
+ * The implementation uses Libao APIs to play the audio and FFmpeg to decode and resample the media input.  Instead
+ * of a libao device, the audio can go to any @c AudioOutputInterface, such as a file or a null output, so that the
+ * player also runs without a sound card.
+ *
+ * Each source is played by two threads: a decoder thread fills a @c PcmRingBuffer with decoded audio, from the time
+ * the source is set, and an output thread feeds the ring to the device in short periods.  The output thread starts,
+ * and restarts after an underrun, once the ring holds the prebuffer target, so that decoding hiccups such as network
+ * stalls are absorbed by the ring instead of reaching the speaker.
+ *
+ * A source set with @c prepareNext() follows the current one in the same ring: it is opened and starts decoding on a
+ * prepare thread while the current source plays, and the decoder thread moves on to it when the current source ends,
+ * so that the output plays one after the other without a gap.
+ *
+ * Each source has a volume, applied by the output thread to the decoded audio, so that changing it does not touch the
+ * decoder.  Pausing and stopping fade the audio out over a few milliseconds, and resuming fades it back in, instead of
+ * cutting the output mid-wave.
+ *
+ * A url of an m3u or pls playlist is played entry after entry when the player is given a playlist parser factory: the
+ * url input controller parses the playlist with a new parser and opens the next entry near the end of the current one.
+ *
+ * With a @c PcmCache, a url played from its start again in the same format, like an earcon or a prompt, is recorded
+ * on its second play, and its following plays are played from the recorded audio instead of being opened and decoded
+ * again.
+ *
+ * With a @c DecoderContextPool, the decoders of the sources take the opened codec contexts and resamplers of the
+ * previous ones instead of setting up their own, which most dialog turns can since their speech is in the same format.
  */	
 class AOWrapper 
 		: public utils::mediaPlayer::MediaPlayerInterface
@@ -39,6 +84,38 @@ public:
     /// Represents one byte of data.
     using Byte = uint8_t;		// add Sven
     
+	/// The audio buffered before the output starts or restarts after an underrun, unless given to @c create().
+	static constexpr std::chrono::milliseconds DEFAULT_PREBUFFER_TARGET{200};
+
+	/// Creates the parser of a playlist url; each playlist is iterated by its own parser.
+	using PlaylistParserFactory =
+		std::function<std::shared_ptr<utils::playlistParser::IterativePlaylistParserInterface>()>;
+
+	/// The optional settings of a player, given to @c create().
+	struct Options {
+		/// Constructor, with the defaults of a player which reads and decodes every source itself.
+		Options() : prebufferTarget{DEFAULT_PREBUFFER_TARGET} {
+		}
+
+		/// The audio buffered before the output starts or restarts after an underrun.
+		std::chrono::milliseconds prebufferTarget;
+
+		/// How much of a source FFmpeg may read to find its format before the first frame.
+		ProbeConfiguration probeConfig;
+
+		/// The cache http urls are read through, or @c nullptr to read them from the network.
+		std::shared_ptr<UrlCache> urlCache;
+
+		/// Creates the parsers of playlist urls, or an empty function to give them to FFmpeg.
+		PlaylistParserFactory playlistParserFactory;
+
+		/// The cache of the decoded audio of urls, or @c nullptr to decode every play.
+		std::shared_ptr<PcmCache> pcmCache;
+
+		/// The pool of codec contexts and resamplers of the decoders, or @c nullptr to set them up for each source.
+		std::shared_ptr<DecoderContextPool> contextPool;
+	};
+
 	enum class AOPlayerState {
 		/// AOEngine already be initialized but no resources have been requested yet.
 		IDLE,
@@ -57,11 +134,28 @@ public:
      *
      * @param preSampleBits A pointer to the sampleformat type. It shall include at @PaSampleFormat.
      * @param channelsCount represents the stream whether is stereo or mono.
+     * @param name The name of the player in the metrics and the @c IntrospectionServer.
+     * @param options The optional settings of the player.
      * @return A pointer to the @c PaWrapper if succeed; @c nullptr otherwise.
      */
 	static std::unique_ptr<AOWrapper> create(	
 	std::shared_ptr<AOEngine> aoEngine,
-	const PlaybackConfiguration& config = PlaybackConfiguration());
+	const PlaybackConfiguration& config = PlaybackConfiguration(),
+	const std::string& name = "AOWrapper",
+	const Options& options = Options());
+
+	/**
+	 * Creates a player which plays to the given output, in the format of the output.
+	 *
+	 * @param output The output to play to, which only this player writes to.
+	 * @param name The name of the player in the metrics and the @c IntrospectionServer.
+	 * @param options The optional settings of the player.
+	 * @return A pointer to the @c AOWrapper if succeed; @c nullptr otherwise.
+	 */
+	static std::unique_ptr<AOWrapper> create(
+	std::shared_ptr<AudioOutputInterface> output,
+	const std::string& name = "AOWrapper",
+	const Options& options = Options());
 
     /// @name MediaPlayerInterface methods.
     ///@{
@@ -77,6 +171,53 @@ public:
 	void setObserver(
 		std::shared_ptr<utils::mediaPlayer::MediaPlayerObserverInterface> playerObserver) override;
 	///@}
+
+	/**
+	 * Set an @c url source to play right after the current source, without a gap.  The source is opened and its
+	 * first audio decoded in the background while the current source plays.  When the current source ends, the
+	 * player moves on to it without stopping the output, reporting @c onPlaybackFinished() for the current source and
+	 * @c onPlaybackStarted() for the next one; the next source does not need a @c play() call.
+	 *
+	 * Only one source is prepared at a time, so preparing another one discards it, as do @c setSource(), stopping the
+	 * current source and @c stop() with the id of the prepared source.  If no source is playing, the source is set and
+	 * played right away.
+	 *
+	 * @param url The url to set as the next source.
+	 * @param offset The offset to start playing the next source from.
+	 * @return The @c SourceId of the next source, or @c ERROR if it could not be set.
+	 */
+	SourceId prepareNext(const std::string& url, std::chrono::milliseconds offset = std::chrono::milliseconds::zero());
+
+	/**
+	 * Set an @c istream source to play right after the current source, without a gap, as the @c url variant does.
+	 *
+	 * @param stream Object from which to read an incoming audio stream.
+	 * @param repeat Whether the audio stream should be played in a loop until stopped.
+	 * @return The @c SourceId of the next source, or @c ERROR if it could not be set.
+	 */
+	SourceId prepareNext(std::shared_ptr<std::istream> stream, bool repeat);
+
+	/**
+	 * Set an attachment source to play right after the current source, without a gap, as the @c url variant does.
+	 *
+	 * @param attachmentReader The attachment to read the audio from.
+	 * @param format The format of raw audio in the attachment, or @c nullptr if FFmpeg should detect it.
+	 * @return The @c SourceId of the next source, or @c ERROR if it could not be set.
+	 */
+	SourceId prepareNext(
+		std::shared_ptr<utils::attachment::AttachmentReader> attachmentReader,
+		const utils::AudioFormat* format = nullptr);
+
+	/**
+	 * Set the volume of a source, the current one or one set by @c prepareNext().  The change ramps over one output
+	 * period rather than restarting anything, and a source starts at full volume.  The volume only applies to 16 and
+	 * 32 bit outputs.
+	 *
+	 * @param id The id of the source.
+	 * @param volume The volume, from 0 for silence to 1 for the audio as decoded, and up to 8 to amplify it.
+	 * @return Whether the volume was set.
+	 */
+	bool setVolume(SourceId id, float volume);
 	
 
 	/// Destructor
@@ -90,54 +231,199 @@ private:
 	/**
      * Constructor
      */	
-    AOWrapper(
-    std::shared_ptr<AOEngine> aoEngine,
-    const PlaybackConfiguration& config);
-		
-	/// initialize Portaudio
-	bool initialize();
+    AOWrapper(std::shared_ptr<AudioOutputInterface> output, const std::string& name, const Options& options);
+
+	/// A source set by @c prepareNext(), which follows the current source in the ring.
+	struct PreparedSource {
+		/// The id of the source.
+		SourceId id;
+		/// The decoder of the source.
+		std::shared_ptr<DecoderInterface> decoder;
+		/// The offset to start playing from.
+		std::chrono::milliseconds offset;
+		/// The volume of the source.
+		float volume;
+		/// Whether playing this source reports stages to the @c DialogTurnTracer.
+		bool traceDialogTurn;
+		/// The first audio of the source, decoded by the prepare thread.
+		std::vector<Byte> head;
+		/// The status of the read of @c head.
+		DecoderInterface::Status headStatus;
+		/// Whether the prepare thread is done with @c head and the decoder, so that the decoder thread may take them.
+		std::atomic<bool> isReady;
+	};
+
+	/// The point in the ring where the audio of a prepared source starts.
+	struct TrackSwitch {
+		/// The source starting.
+		std::shared_ptr<PreparedSource> source;
+		/// The number of bytes written to the ring in the playback session before the audio of @c source.
+		uint64_t startByte;
+	};
+
+	/**
+	 * Create the decoder of an @c url source, which plays the recording of the url when the @c PcmCache has one.  A
+	 * local file which is not a playlist is read with @c pread at the position of the decoder, rather than through
+	 * the file protocol.
+	 *
+	 * @param url The url of the source.
+	 * @param offset The offset to start playing from.
+	 * @return The decoder, or @c nullptr on failure.
+	 */
+	std::shared_ptr<DecoderInterface> createDecoder(const std::string& url, std::chrono::milliseconds offset);
+
+	/**
+	 * Create the decoder of an @c istream source.
+	 *
+	 * @param stream The stream to read the audio from.
+	 * @param repeat Whether the audio stream should be played in a loop until stopped.
+	 * @return The decoder, or @c nullptr on failure.
+	 */
+	std::shared_ptr<DecoderInterface> createDecoder(std::shared_ptr<std::istream> stream, bool repeat);
+
+	/**
+	 * Create the decoder of an attachment source: a @c PcmDecoder for raw PCM at the output rate, and a
+	 * @c FFmpegDecoder otherwise.
+	 *
+	 * @param attachmentReader The attachment to read the audio from.
+	 * @param format The format of raw audio in the attachment, or @c nullptr.
+	 * @return The decoder, or @c nullptr on failure.
+	 */
+	std::shared_ptr<DecoderInterface> createDecoder(
+		std::shared_ptr<utils::attachment::AttachmentReader> attachmentReader,
+		const utils::AudioFormat* format);
 
 	/**
      * Internal method used to create a new media queue and increment the request id.
+     *
+     * @param decoder The decoder of the new source.
+     * @param offset The offset to start playing from.
+     * @param traceDialogTurn Whether playing this source reports stages to the @c DialogTurnTracer.
      */
 	int configureNewRequest(
-			std::unique_ptr<FFmpegInputControllerInterface> inputController,
-			std::chrono::milliseconds offset = std::chrono::milliseconds(0));
+			std::shared_ptr<DecoderInterface> decoder,
+			std::chrono::milliseconds offset = std::chrono::milliseconds(0),
+			bool traceDialogTurn = false);
+
+	/**
+	 * Internal method used to set the source which follows the current one, and start preparing it.
+	 *
+	 * @param decoder The decoder of the next source.
+	 * @param offset The offset to start playing from.
+	 * @param traceDialogTurn Whether playing this source reports stages to the @c DialogTurnTracer.
+	 * @return The id of the next source, or @c ERROR on failure.
+	 */
+	SourceId configureNextRequest(
+			std::shared_ptr<DecoderInterface> decoder,
+			std::chrono::milliseconds offset,
+			bool traceDialogTurn);
 
 	/// Internal method implements the stop media player logic. This method should be called after acquring @c m_mutex
     bool stopLocked();
 
-	/// Thread audio play handler method.
-    void doPlayAudioLoop();
+	/// Abort and discard the prepared source, if any.  This method should be called after acquring @c m_mutex.
+	void discardNextSourceLocked();
 
-	/* Processing the stream for decoding and playback.
-	 * @note This method must only be called by threads @c doPlayAudioLoop() that have acquired @c m_operationMutex.
-     *
-     * @param lock A @c unique_lock on m_operationMutex, allowing this method to release the lock around callbacks
-     * that need to be invoked.
-     */
-	void doPlayAudioLocked(std::unique_lock<std::mutex> &lock);
+	/// Wait for the decoder and output threads of the previous source to exit.  Must be called without the lock.
+	void joinPlaybackThreads();
+
+	/**
+	 * Loop of the decoder thread: decode the source, and the prepared sources following it, into @c m_ring until
+	 * the last one ends, fails or they are replaced.
+	 *
+	 * @param sessionId The id of the source which started the playback session.
+	 */
+    void doDecodeLoop(SourceId sessionId);
+
+	/**
+	 * Called by the decoder thread when its source ended: wait until a prepared source is ready to follow it, and make
+	 * it the source the thread decodes.
+	 *
+	 * @param sessionId The id of the source which started the playback session.
+	 * @param bytesWritten The number of bytes written to the ring in the session, where the next source starts.
+	 * @return The next source, or @c nullptr if the session ended first.
+	 */
+	std::shared_ptr<PreparedSource> takeNextSource(SourceId sessionId, uint64_t bytesWritten);
+
+	/**
+	 * Loop of the prepare thread: open the source and decode its first audio, while the current source plays.
+	 *
+	 * @param source The source to prepare.
+	 */
+	void doPrepareLoop(std::shared_ptr<PreparedSource> source);
+
+	/**
+	 * Loop of the output thread: play @c m_ring to the device while the source is playing, move on to the prepared
+	 * sources at their @c TrackSwitch, and report the end of the last source once the decoder finished and the ring
+	 * is empty.
+	 *
+	 * @param id The id of the source the thread plays.
+	 */
+    void doPlayAudioLoop(SourceId id);
+
+	/// Record the gap since the last audio of the previous source, when called for the first audio of a source.
+	void recordTrackGap();
+
+	/**
+	 * Apply a gain which moves from one value to another to whole frames in the output format.
+	 *
+	 * @param data The frames.
+	 * @param bytes The size of the frames in bytes.
+	 * @param fromGain The gain at the start of the frames.
+	 * @param toGain The gain at the end of the frames.
+	 * @param curve The shape of the gain change.
+	 */
+	void applyGainRamp(Byte* data, size_t bytes, float fromGain, float toGain, FadeCurve curve);
+
+	/**
+	 * Called by the output thread to fade out the audio which follows what it played, when the playback pauses or
+	 * stops, so that the output does not stop mid-wave.
+	 *
+	 * @param buffer The buffer to read the audio into, of at least @c m_fadeBytes.
+	 * @param fromGain The gain the audio played so far ended at.
+	 * @param maxBytes The most bytes the fade may take from the ring.
+	 * @return The number of bytes of the ring played.
+	 */
+	size_t fadeOut(Byte* buffer, float fromGain, uint64_t maxBytes);
+
+	/**
+	 * Renders the state of the player for the @c IntrospectionServer from the atomic members only, so that it never
+	 * waits for @c m_operationMutex.
+	 *
+	 * @return A JSON object with the source id, the player state, the decoder state and the ring fill.
+	 */
+	std::string renderState() const;
 	
     /// The current source id.
-    SourceId m_sourceId;
-	
-    /// Keep a pointer to the libao(initialize) engine to guarantee that it doesn't 
-    /// get destroyed before other libao objects.
-    std::shared_ptr<AOEngine> m_engine;
+    std::atomic<SourceId> m_sourceId;
+
+	/// The id of the source set by the last @c setSource(), which started the threads of the playback session.
+	std::atomic<SourceId> m_sessionId;
 
-	/// A decoder object @c FFmpegDecoder.
-	std::shared_ptr<FFmpegDecoder> m_decoder;
+	/// The last id given to a source, by @c setSource() or @c prepareNext().
+	SourceId m_lastSourceId;
 
-	/// A specific objects @c ao_device from libao library.
-	std::shared_ptr<ao_device> m_device;
+	/// The decoder of the current source, a @c FFmpegDecoder, for raw PCM attachments a @c PcmDecoder, or a decoder of
+	/// the @c PcmCache.
+	std::shared_ptr<DecoderInterface> m_decoder;
+
+	/// The output the audio is played to, a libao device unless another output was given to @c create().
+	std::shared_ptr<AudioOutputInterface> m_output;
 		
     /// Save the initial media offset to compute total offset.
     std::chrono::milliseconds m_initialOffset;
 
-	/// A type used to set audio playback parameters.
-	//ao_sample_format m_aoSampleformat;
-	
-	AOPlayerState m_state;
+	/// Whether the current source reports playback stages to the @c DialogTurnTracer.
+	bool m_traceDialogTurn;
+
+	/// The volume of the current source, applied by the output thread.
+	std::atomic<float> m_volume;
+
+	std::atomic<AOPlayerState> m_state;
+
+	/// A copy of the state of @c m_decoder, updated by the decoder thread after each read.  The other decoders have no
+	/// state of their own, so their state is derived from the status of their reads.
+	std::atomic<FFmpegDecoder::DecodingState> m_decoderState;
 
 	/// /// Flags whether or not processor task is shutdown.
 	bool m_isShuttingDown;
@@ -148,16 +434,94 @@ private:
     // The android media player configuration.
     PlaybackConfiguration m_config;
 
-	/// Internal thread that process the specify stream to play audio data.
+	/// The name of the player in the metrics and the @c IntrospectionServer.
+	const std::string m_name;
+
+	/// How much of a source FFmpeg may read to find its format before the first frame.
+	const ProbeConfiguration m_probeConfig;
+
+	/// The cache http urls are read through, or @c nullptr.
+	const std::shared_ptr<UrlCache> m_urlCache;
+
+	/// Creates the parsers of playlist urls, or an empty function.
+	const PlaylistParserFactory m_playlistParserFactory;
+
+	/// The cache of the decoded audio of urls, or @c nullptr.
+	const std::shared_ptr<PcmCache> m_pcmCache;
+
+	/// The pool of codec contexts and resamplers of the decoders, or @c nullptr.
+	const std::shared_ptr<DecoderContextPool> m_contextPool;
+
+	/// The size in bytes of one sample of every channel; the ring is only read in whole frames.
+	const size_t m_frameBytes;
+
+	/// The number of bytes the output thread hands to the device at once.
+	const size_t m_periodBytes;
+
+	/// The number of bytes buffered before the output starts or restarts after an underrun.
+	const size_t m_prebufferBytes;
+
+	/// The number of bytes faded out when the playback pauses or stops.
+	const size_t m_fadeBytes;
+
+	/// The decoded audio of the current source, from the decoder thread to the output thread.
+	PcmRingBuffer m_ring;
+
+	/// Whether the decoder thread of the current source has written its last audio to @c m_ring.
+	std::atomic<bool> m_isDecodeFinished;
+
+	/// Number of times the output found the ring empty while playing.
+	std::atomic<uint64_t> m_underrunCount;
+
+	/// The counter of underruns of this player.
+	std::shared_ptr<utils::metrics::Counter> m_underrunCounter;
+
+	/// The fill level of the ring of this player, in thousandths of its capacity.
+	std::shared_ptr<utils::metrics::Gauge> m_bufferFillGauge;
+
+	/// Internal thread that feeds the decoded audio of the current source to the device.
 	std::thread m_playerThread;
+
+	/// Internal thread that decodes the current source.
+	std::thread m_decodeThread;
+
+	/// Internal thread that prepares the source set by @c prepareNext().  Only moved under @c m_operationMutex.
+	std::thread m_prepareThread;
+
+	/// The source set by @c prepareNext() which the decoder thread has not taken yet.
+	std::shared_ptr<PreparedSource> m_nextSource;
+
+	/// The prepared sources taken by the decoder thread which the output thread has not reached yet, in order.
+	std::deque<TrackSwitch> m_trackSwitches;
+
+	/// The @c startByte of the first of @c m_trackSwitches, read by the output thread without the lock.
+	std::atomic<uint64_t> m_nextSwitchByte;
+
+	/// When the last audio of a source which ended by itself went to the device, in @c steady_clock ticks, or zero.
+	std::atomic<int64_t> m_trackEndTime;
+
+	/// The time between the last audio of a source and the first audio of the source after it, in microseconds.
+	std::shared_ptr<utils::metrics::Histogram> m_trackGapHistogram;
 	
 	std::shared_ptr<utils::mediaPlayer::MediaPlayerObserverInterface> m_observer;
 
 	/// The condition variable used to wait @c libao operater.
     std::condition_variable m_playerWaitCondition;
+
+	/// The condition variable the decoder thread waits on for room in the ring.
+    std::condition_variable m_decodeWaitCondition;
 		
     /// Mutex used to synchronize media player operations.
     std::mutex m_operationMutex;
+
+	/// The id of the section published to the @c IntrospectionServer.
+	size_t m_introspectionId;
+
+	/// The heartbeat of @c doPlayAudioLoop(), watched by the @c StallWatchdog.
+	utils::threading::Heartbeat m_heartbeat;
+
+	/// The heartbeat of @c doDecodeLoop(), watched by the @c StallWatchdog.
+	utils::threading::Heartbeat m_decodeHeartbeat;
 	
 	/// Mutex used to synchronize @c request creation.
 	//std::mutex m_requestMutex;
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __AUDIO_MIXER_H_
+#define __AUDIO_MIXER_H_
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Utils/Metrics/Gauge.h>
+#include <Utils/Threading/StallWatchdog.h>
+
+#include "AudioMixerInput.h"
+#include "AudioOutputInterface.h"
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/**
+ * Mixes the audio of several players into one output, so that they share one device and one output thread instead
+ * of each opening its own.
+ *
+ * Each player plays to an @c AudioMixerInput, with its own gain.  The mixer thread adds a period of every input which
+ * holds audio, scaled by its gain and saturated, and writes it to the output, which paces the mix and through the
+ * inputs the players.  The mixer only writes to the output while some input holds audio.
+ *
+ * The inputs and the output are 16 bit samples in native endianness, at the format of the output.
+ */
+class AudioMixer : public std::enable_shared_from_this<AudioMixer> {
+public:
+    /**
+     * Create a mixer.
+     *
+     * @param output The output the mix is played to.
+     * @param name The name of the mixer in the metrics.
+     * @return The new mixer, or @c nullptr if the output is @c nullptr or not in a format the mixer handles.
+     */
+    static std::shared_ptr<AudioMixer> create(
+        std::shared_ptr<AudioOutputInterface> output,
+        const std::string& name = "AudioMixer");
+
+    /**
+     * Add an input to the mix.
+     *
+     * @param name The name of the input.
+     * @param gain The initial gain of the input, from 0 to 1.
+     * @return The new input, or @c nullptr if the mixer is shut down.
+     */
+    std::shared_ptr<AudioMixerInput> createInput(const std::string& name, float gain = 1.0f);
+
+    /**
+     * Stop mixing: the mixer thread ends, and writes to the inputs fail from now on.
+     */
+    void shutdown();
+
+    /// Destructor.
+    ~AudioMixer();
+
+private:
+    /// Inputs wake the mixer when audio is written to them.
+    friend class AudioMixerInput;
+
+    /**
+     * Constructor.
+     *
+     * @param output The output the mix is played to.
+     * @param name The name of the mixer in the metrics.
+     */
+    AudioMixer(std::shared_ptr<AudioOutputInterface> output, const std::string& name);
+
+    /// Wake the mixer thread if it waits for audio.
+    void notifyAudioWritten();
+
+    /// The loop of the mixer thread.
+    void doMixLoop();
+
+    /// The output the mix is played to.
+    std::shared_ptr<AudioOutputInterface> m_output;
+
+    /// The format of the output.
+    const PlaybackConfiguration m_config;
+
+    /// The frames of one period of the mix.
+    const size_t m_periodFrames;
+
+    /// Serializes the list of inputs and the wait for audio.
+    std::mutex m_mutex;
+
+    /// Wakes the mixer thread when audio is written or the mixer is shut down.
+    std::condition_variable m_wakeCondition;
+
+    /// The inputs.
+    std::vector<std::shared_ptr<AudioMixerInput>> m_inputs;
+
+    /// Whether @c shutdown() was called.
+    bool m_isShuttingDown;
+
+    /// The number of inputs mixed in the last period.
+    std::shared_ptr<utils::metrics::Gauge> m_activeInputsGauge;
+
+    /// The heartbeat of @c doMixLoop(), watched by the @c StallWatchdog.
+    utils::threading::Heartbeat m_heartbeat;
+
+    /// The mixer thread.
+    std::thread m_mixThread;
+};
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __AUDIO_MIXER_H_
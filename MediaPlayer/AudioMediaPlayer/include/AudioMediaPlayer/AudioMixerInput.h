@@ -0,0 +1,183 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __AUDIO_MIXER_INPUT_H_
+#define __AUDIO_MIXER_INPUT_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "AudioOutputInterface.h"
+#include "PcmRingBuffer.h"
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+class AudioMixer;
+
+/**
+ * One input of an @c AudioMixer, which a player writes to as to its own output.
+ *
+ * Each input has a gain, and can be ducked: its gain then ramps down to a fraction of itself, and back up when it is
+ * unducked, so that another input can be heard over it without it being paused.  Gain changes ramp as well, so that
+ * they do not click.
+ *
+ * Created by @c AudioMixer::createInput().
+ */
+class AudioMixerInput : public AudioOutputInterface {
+public:
+    /**
+     * Set the gain of the input.
+     *
+     * @param gain The gain, from 0 for silence to 1 for the input as it is.
+     * @param ramp How long the gain takes to change.
+     */
+    void setGain(float gain, std::chrono::milliseconds ramp = std::chrono::milliseconds(20));
+
+    /**
+     * Lower the gain of the input, relatively to the gain set with @c setGain().
+     *
+     * @param level The fraction of the gain the input is lowered to.
+     * @param ramp How long the gain takes to go down.
+     */
+    void duck(float level, std::chrono::milliseconds ramp);
+
+    /**
+     * Bring the gain of a ducked input back up.
+     *
+     * @param ramp How long the gain takes to go up.
+     */
+    void unduck(std::chrono::milliseconds ramp);
+
+    /**
+     * Check whether the input is ducked.
+     *
+     * @return Whether the gain is lowered by @c duck(), and was not brought back up by @c unduck() since.
+     */
+    bool isDucked();
+
+    /**
+     * Get the name of the input.
+     *
+     * @return The name given to @c AudioMixer::createInput().
+     */
+    std::string getName() const;
+
+    /// @name AudioOutputInterface method overrides.
+    /// @{
+    bool write(const uint8_t* data, size_t size) override;
+    PlaybackConfiguration getConfiguration() const override;
+    /// @}
+
+private:
+    /// The mixer creates the inputs and reads them.
+    friend class AudioMixer;
+
+    /**
+     * Constructor.
+     *
+     * @param mixer The mixer of the input, woken when audio is written.
+     * @param name The name of the input.
+     * @param config The format of the mixer.
+     * @param capacity The bytes of audio the input holds before @c write() blocks.
+     * @param gain The initial gain.
+     */
+    AudioMixerInput(
+        std::weak_ptr<AudioMixer> mixer,
+        const std::string& name,
+        const PlaybackConfiguration& config,
+        size_t capacity,
+        float gain);
+
+    /**
+     * Move the gain towards its target.
+     *
+     * @param ramp How long the gain takes to reach its target.
+     */
+    void rampToTargetLocked(std::chrono::milliseconds ramp);
+
+    /**
+     * Get whether the input holds audio to mix.  Mixer thread only.
+     *
+     * @return Whether the input holds at least one frame.
+     */
+    bool hasAudio() const;
+
+    /**
+     * Scale the audio of the input by its gain and add it to a period of the mix.  Mixer thread only.
+     *
+     * @param period The period of the mix.
+     * @param frames The number of frames of the period.
+     * @return Whether the input had audio for the period.
+     */
+    bool mixInto(int16_t* period, size_t frames);
+
+    /// Make @c write() fail from now on, when the mixer is shut down.
+    void close();
+
+    /// The mixer of the input.
+    std::weak_ptr<AudioMixer> m_mixer;
+
+    /// The name of the input.
+    const std::string m_name;
+
+    /// The format of the mixer.
+    const PlaybackConfiguration m_config;
+
+    /// The samples of one frame.
+    const size_t m_channels;
+
+    /// The audio written and not mixed yet.
+    PcmRingBuffer m_ring;
+
+    /// The samples read from @c m_ring for one period.
+    std::vector<int16_t> m_period;
+
+    /// Serializes the writes waiting for room with @c close().
+    std::mutex m_writeMutex;
+
+    /// Wakes a write waiting for room when audio is mixed or the input is closed.
+    std::condition_variable m_spaceCondition;
+
+    /// Whether the mixer was shut down.
+    bool m_isClosed;
+
+    /// Serializes the gain changes with the mixer thread.
+    std::mutex m_gainMutex;
+
+    /// The gain set with @c setGain().
+    float m_gain;
+
+    /// The fraction of @c m_gain the input is ducked to, or 1 if it is not ducked.
+    float m_duckLevel;
+
+    /// The gain applied to the audio now.
+    float m_currentGain;
+
+    /// The gain the current gain moves to.
+    float m_targetGain;
+
+    /// How much the current gain moves per frame.
+    float m_gainStep;
+};
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __AUDIO_MIXER_INPUT_H_
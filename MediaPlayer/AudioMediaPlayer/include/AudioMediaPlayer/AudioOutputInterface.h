@@ -0,0 +1,57 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __AUDIO_OUTPUT_INTERFACE_H_
+#define __AUDIO_OUTPUT_INTERFACE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "PlaybackConfiguration.h"
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/**
+ * Where @c AOWrapper hands the decoded audio to: a libao device, a file or nothing at all.
+ *
+ * An output plays audio in the single format it was created for, and is written to by one thread at a time.  Like a
+ * sound card, @c write() blocks until the output can take more audio, which is what paces the player.
+ */
+class AudioOutputInterface {
+public:
+    /**
+     * Play audio.
+     *
+     * @param data The audio, in whole frames of the output format.
+     * @param size The number of bytes of audio.
+     * @return Whether the audio was played.
+     */
+    virtual bool write(const uint8_t* data, size_t size) = 0;
+
+    /**
+     * Get the format of the audio the output plays.
+     *
+     * @return The output format.
+     */
+    virtual PlaybackConfiguration getConfiguration() const = 0;
+
+    /// Destructor.
+    virtual ~AudioOutputInterface() = default;
+};
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __AUDIO_OUTPUT_INTERFACE_H_
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __DECODER_CONTEXT_POOL_H_
+#define __DECODER_CONTEXT_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+extern "C" {
+#include <libavutil/samplefmt.h>
+}
+
+#include <Utils/Metrics/Counter.h>
+
+struct AVCodec;
+struct AVCodecContext;
+struct AVCodecParameters;
+struct SwrContext;
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/**
+ * A pool of opened codec contexts and initialized resamplers, shared by the decoders of the players.  Every dialog
+ * turn decodes its speech with a new @c FFmpegDecoder, yet always with the same codec and formats, so instead of
+ * opening a codec and building a resampler for each turn, a decoder takes the ones a previous decoder gave back.
+ *
+ * A codec context is kept under its codec and stream parameters, and a resampler under its input and output formats.
+ * A context given back is flushed, so that nothing of the previous stream is decoded or resampled into the next one,
+ * and the pool keeps at most @c maxContexts of each kind, freeing the least recently given back ones.
+ *
+ * The format contexts are not pooled: FFmpeg cannot open another input with a context once it was closed.
+ */
+class DecoderContextPool : public std::enable_shared_from_this<DecoderContextPool> {
+public:
+    /// The contexts of each kind kept, unless given to @c create().
+    static constexpr size_t DEFAULT_MAX_CONTEXTS = 4;
+
+    /**
+     * Create a pool.
+     *
+     * @param maxContexts The most codec contexts, and the most resamplers, kept between decoders.
+     * @return The new pool, or @c nullptr if @c maxContexts is 0.
+     */
+    static std::shared_ptr<DecoderContextPool> create(size_t maxContexts = DEFAULT_MAX_CONTEXTS);
+
+    /**
+     * Destructor, which frees the contexts kept.  The contexts in use are freed when they are released.
+     */
+    ~DecoderContextPool();
+
+    /**
+     * Get an opened codec context for a stream, from the pool or opened for it.
+     *
+     * @param parameters The parameters of the stream.
+     * @param codec The decoder of the stream.
+     * @param[out] isReused Whether the context came from the pool.
+     * @return The context, which goes back to the pool when released, or @c nullptr if it cannot be opened.
+     */
+    std::shared_ptr<AVCodecContext> acquireCodecContext(
+        const AVCodecParameters& parameters,
+        const AVCodec* codec,
+        bool* isReused);
+
+    /**
+     * Get an initialized resampler for a conversion, from the pool or built for it.
+     *
+     * @param outputLayout The output channel layout.
+     * @param outputFormat The output sample format.
+     * @param outputRate The output sample rate.
+     * @param inputLayout The input channel layout.
+     * @param inputFormat The input sample format.
+     * @param inputRate The input sample rate.
+     * @param[out] isReused Whether the resampler came from the pool.
+     * @return The resampler, which goes back to the pool when released, or @c nullptr if it cannot be built.
+     */
+    std::shared_ptr<SwrContext> acquireResampler(
+        int64_t outputLayout,
+        AVSampleFormat outputFormat,
+        int outputRate,
+        int64_t inputLayout,
+        AVSampleFormat inputFormat,
+        int inputRate,
+        bool* isReused);
+
+    /**
+     * Get the number of contexts kept, which are not in use.
+     *
+     * @return The number of codec contexts and resamplers in the pool.
+     */
+    size_t getIdleCount();
+
+private:
+    /// The idle contexts of a kind, from the least recently given back, with their keys.
+    template <typename Context>
+    using IdleList = std::list<std::pair<std::string, Context*>>;
+
+    /**
+     * Constructor.
+     *
+     * @param maxContexts The most codec contexts, and the most resamplers, kept between decoders.
+     */
+    explicit DecoderContextPool(size_t maxContexts);
+
+    /**
+     * Take the most recently given back idle context of a key.  @c m_mutex must be held.
+     *
+     * @param idle The idle contexts of the kind.
+     * @param key The key.
+     * @return The context, or @c nullptr if there is none.
+     */
+    template <typename Context>
+    static Context* takeLocked(IdleList<Context>& idle, const std::string& key);
+
+    /**
+     * Give back a codec context, once flushed, or free it when the pool is gone.
+     *
+     * @param pool The pool the context was taken from.
+     * @param key The key of the context.
+     * @param context The context.
+     */
+    static void releaseCodecContext(
+        std::weak_ptr<DecoderContextPool> pool,
+        const std::string& key,
+        AVCodecContext* context);
+
+    /**
+     * Give back a resampler, once reset, or free it when the pool is gone.
+     *
+     * @param pool The pool the resampler was taken from.
+     * @param key The key of the resampler.
+     * @param context The resampler.
+     */
+    static void releaseResampler(std::weak_ptr<DecoderContextPool> pool, const std::string& key, SwrContext* context);
+
+    /// The most contexts of each kind kept.
+    const size_t m_maxContexts;
+
+    /// Serializes the members below.
+    std::mutex m_mutex;
+
+    /// The idle codec contexts.
+    IdleList<AVCodecContext> m_codecContexts;
+
+    /// The idle resamplers.
+    IdleList<SwrContext> m_resamplers;
+
+    /// Codec contexts taken from the pool.
+    std::shared_ptr<utils::metrics::Counter> m_codecHitCounter;
+
+    /// Codec contexts opened because the pool had none for the stream.
+    std::shared_ptr<utils::metrics::Counter> m_codecMissCounter;
+
+    /// Resamplers taken from the pool.
+    std::shared_ptr<utils::metrics::Counter> m_resamplerHitCounter;
+
+    /// Resamplers built because the pool had none for the conversion.
+    std::shared_ptr<utils::metrics::Counter> m_resamplerMissCounter;
+};
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __DECODER_CONTEXT_POOL_H_
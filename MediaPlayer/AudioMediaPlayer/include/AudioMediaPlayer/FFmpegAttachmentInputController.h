@@ -51,6 +51,8 @@ public:
     bool next() override;
 	AVFormatContext* createNewFormatContext() override;
     std::tuple<Result, std::shared_ptr<AVFormatContext>, std::chrono::milliseconds> getCurrentFormatContextOpen() override;
+    bool hasKnownCodecParameters() const override;
+    std::string getInputType() const override;
     /// @}
 
     /**
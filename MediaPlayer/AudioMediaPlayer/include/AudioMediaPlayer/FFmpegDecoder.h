@@ -25,9 +25,13 @@ extern "C" {
 #include <libavutil/samplefmt.h>
 }
 
+#include <Utils/Metrics/MemoryAccounting.h>
+
+#include "DecoderContextPool.h"
 #include "DecoderInterface.h"
 #include "FFmpegInputControllerInterface.h"
 #include "PlaybackConfiguration.h"
+#include "ProbeConfiguration.h"
 
 struct AVCodec;
 struct AVCodecContext;
@@ -57,16 +61,54 @@ using LayoutMask = int64_t;		// add Sven
  */
 class FFmpegDecoder : public DecoderInterface {
 public:
+    /**
+     * This enumeration represents the states that the decoder can be in. The possible transitions are:
+     *
+     * INITIALIZING -> {DECODING, INVALID}
+     * DECODING -> {INITIALIZING, FLUSHING_DECODER, INVALID}
+     * FLUSHING_DECODER -> {FLUSHING_RESAMPLER, INVALID}
+     * FLUSHING_RESAMPLER -> {FINISHED, INVALID}
+     *
+     * The transition from DECODING to INITIALIZING happens when input controller has next track.
+     *
+     * @note: The order of states matter since we use less than comparisons.
+     */
+    enum class DecodingState {
+        /// The input provided still has data that needs to be decoded.
+        DECODING,
+        /// The input has been read completely, but decoding hasn't finished yet.
+        FLUSHING_DECODER,
+        /// The decoding has finished but the re-sampling might still have unread data.
+        FLUSHING_RESAMPLER,
+        /// Decoder is initializing.
+        INITIALIZING,
+        /// There is no more data to be decoded / re-sampled. Calls to @c read will return 0 bytes.
+        FINISHED,
+        /// The decoder has found an error and it is in an invalid state. Calls to @c read will return 0 bytes.
+        INVALID
+    };
+
+    /// Friend relationship to allow accessing State to convert it to a string for logging.
+    friend std::ostream& operator<<(std::ostream& stream, const DecodingState state);
+
     /**
      * Creates a new decoder buffer queue that reads input data using the given controller.
      *
      * @param inputController The controller used to retrieve input data.
      * @param outputConfig The decoder output configuration.
+     * @param allowResamplerBypass Whether input already in the output format is passed through without a resampler.
+     * It is only turned off to measure what the bypass saves.
+     * @param probeConfig How much of the input may be read to find its format and stream parameters.
+     * @param contextPool The pool the codec context and the resampler are taken from, or @c nullptr to set them up
+     * for this decoder only.
      * @return The new decoder buffer queue if create succeeds, @c nullptr otherwise.
      */
     static std::unique_ptr<FFmpegDecoder> create(	
         std::unique_ptr<FFmpegInputControllerInterface> inputController,
-        const PlaybackConfiguration& outputConfig);	 // add last param
+        const PlaybackConfiguration& outputConfig,	 // add last param
+        bool allowResamplerBypass = true,
+        const ProbeConfiguration& probeConfig = ProbeConfiguration(),
+        std::shared_ptr<DecoderContextPool> contextPool = nullptr);
 
     /// @name DecoderInterface method overrides.
     /// @{
@@ -88,6 +130,13 @@ public:
      * @return @c true if FFmpeg should be interrupted; false otherwise.
      */
     bool shouldInterruptFFmpeg();	
+
+    /**
+     * Get the current decoding state.  Unlike the rest of this class, this method may be called from any thread.
+     *
+     * @return The current decoding state.
+     */
+    DecodingState getState() const;
 private:
     /**
      * Constructor.
@@ -96,42 +145,18 @@ private:
      * @param format The output sample format.
      * @param layout The output channels layout.
      * @param sampleRate The output sample rate in Hz.
+     * @param allowResamplerBypass Whether input already in the output format is passed through without a resampler.
+     * @param probeConfig How much of the input may be read to find its format and stream parameters.
+     * @param contextPool The pool the codec context and the resampler are taken from, or @c nullptr.
      */
     FFmpegDecoder(
         std::unique_ptr<FFmpegInputControllerInterface> inputController,
         AVSampleFormat format,		// add Sven
         LayoutMask layout,			// add
-        int sampleRate);			// add
-
-    /**
-     * This enumeration represents the states that the decoder can be in. The possible transitions are:
-     *
-     * INITIALIZING -> {DECODING, INVALID}
-     * DECODING -> {INITIALIZING, FLUSHING_DECODER, INVALID}
-     * FLUSHING_DECODER -> {FLUSHING_RESAMPLER, INVALID}
-     * FLUSHING_RESAMPLER -> {FINISHED, INVALID}
-     *
-     * The transition from DECODING to INITIALIZING happens when input controller has next track.
-     *
-     * @note: The order of states matter since we use less than comparisons.
-     */
-    enum class DecodingState {
-        /// The input provided still has data that needs to be decoded.
-        DECODING,
-        /// The input has been read completely, but decoding hasn't finished yet.
-        FLUSHING_DECODER,
-        /// The decoding has finished but the re-sampling might still have unread data.
-        FLUSHING_RESAMPLER,
-        /// Decoder is initializing.
-        INITIALIZING,
-        /// There is no more data to be decoded / re-sampled. Calls to @c read will return 0 bytes.
-        FINISHED,
-        /// The decoder has found an error and it is in an invalid state. Calls to @c read will return 0 bytes.
-        INVALID
-    };
-
-    /// Friend relationship to allow accessing State to convert it to a string for logging.
-    friend std::ostream& operator<<(std::ostream& stream, const DecodingState state);
+        int sampleRate,				// add
+        bool allowResamplerBypass,
+        const ProbeConfiguration& probeConfig,
+        std::shared_ptr<DecoderContextPool> contextPool);
 
     /**
      * Sets the @c m_state variable to the value given if and only if the transition is valid.
@@ -169,11 +194,14 @@ private:
         int getOffset() const;
 
         /**
-         * Resize the buffer if current capacity is less than the required minimum.
+         * Resize the buffer if current capacity is less than the required minimum.  The capacity at least doubles
+         * when it grows, so that a stream whose frames vary in size quickly stops reallocating.  The buffer is
+         * allocated here at the whole capacity, which the frame then offers to @c swr_convert_frame().
          *
          * @param minimumCapacity The minimum capacity required.
+         * @return Whether the buffer holds at least @c minimumCapacity samples.
          */
-        void resize(size_t minimumCapacity);
+        bool resize(size_t minimumCapacity);
 
         /**
          * Return whether there is any data that hasn't been unread yet.
@@ -189,8 +217,16 @@ private:
          */
         void setOffset(int offset);
 
+        /**
+         * Make a decoded frame the unread data, without copying it.  Used when the decoded frame is already in the
+         * output format.
+         *
+         * @param frame The frame, which is left empty.
+         */
+        void takeFrame(AVFrame& frame);
+
     private:
-        /// The resampleFrame buffer size. This is used to know when we need to resize the frame buffer.
+        /// The samples allocated in the frame buffer, or 0 if the frame has no buffer of its own.
         size_t m_capacity;
 
         /// The current offset of the unread data inside the frame.
@@ -201,13 +237,14 @@ private:
     };
 
     /**
-     * Read the data that has been decoded.
+     * Read the data that has been decoded. As many whole samples as fit are copied, and the rest of the frame is left
+     * in @c m_unreadData for the next read.
      *
      * @param buffer The buffer where the data will be written to.
      * @param size The buffer size in bytes.
      * @param bytesRead The number of bytes that has been read already. This is used to calculate the write offset and
      * the amount of data that can still be written to the buffer.
-     * @return The number of bytes copied to @c buffer.
+     * @return The number of bytes copied to @c buffer, 0 if not even one sample fits.
      */
     size_t readData(Byte* buffer, size_t size, size_t bytesRead);
 
@@ -218,6 +255,26 @@ private:
      */
     void resample(std::shared_ptr<AVFrame> inputFrame);
 
+    /**
+     * Call the resampler for the given input frame, writing the resampled data straight to the caller's buffer, if
+     * it has room for all of it.
+     *
+     * @param inputFrame The frame with the media data that has to be resampled.
+     * @param buffer The buffer where the data will be written to.
+     * @param size The room left in @c buffer, in bytes.
+     * @param[out] bytesWritten Set to the number of bytes written to @c buffer.
+     * @return @c false if the resampled frame might not fit in @c buffer, in which case nothing was done.
+     */
+    bool resampleTo(std::shared_ptr<AVFrame> inputFrame, Byte* buffer, size_t size, size_t* bytesWritten);
+
+    /**
+     * Get the upper bound of the number of samples the resampler outputs for the given input frame.
+     *
+     * @param inputFrame The frame with the media data that has to be resampled.
+     * @return The maximum number of output samples.
+     */
+    int maxResampledSamples(const AVFrame& inputFrame);
+
     /// Call the decoder to start processing more input data.
     void decode();
 
@@ -241,6 +298,21 @@ private:
      */
     void initialize();
 
+    /// Record the time from the start of the initialization of the current track to its first decoded frame.
+    void recordTimeToFirstFrame();
+
+    /// Tell the input controller how far the packet just read is in the current input, when its duration is known.
+    void reportProgress();
+
+    /**
+     * Set up the codec context and the resampler of the current track, from @c m_contextPool when there is one.
+     *
+     * @param streamIndex The index of the audio stream in @c m_formatContext.
+     * @param codec The decoder of the stream.
+     * @return Whether the decoder is ready to decode the track; otherwise its state was set.
+     */
+    bool setUpContexts(int streamIndex, AVCodec* codec);
+
     /**
      * Parse the status returned by an FFmpeg function.
      *
@@ -253,7 +325,7 @@ private:
      * @param functionName The name of the function that was called. This is used for logging purpose.
      * @return @c true if status indicates that the operation succeeded or EOF was found; @c false, otherwise.
      */
-    bool transitionStateUsingStatus(int status, DecodingState nextState, const std::string& functionName);
+    bool transitionStateUsingStatus(int status, DecodingState nextState, const char* functionName);
 
     /// The decoder state.
     std::atomic<DecodingState> m_state;
@@ -270,6 +342,27 @@ private:
     /// The output sample rate.
     const int m_outputRate;						// add Sven
 
+    /// The bytes of one output sample over all channels.
+    const size_t m_outputFrameBytes;
+
+    /// Whether input already in the output format may skip the resampler.
+    const bool m_allowResamplerBypass;
+
+    /// Whether the current input is in the output format, so that there is no @c m_swrContext.
+    bool m_isBypassingResampler;
+
+    /// How much of the input may be read to find its format and stream parameters.
+    const ProbeConfiguration m_probeConfig;
+
+    /// The pool the codec context and the resampler are taken from, or @c nullptr.
+    const std::shared_ptr<DecoderContextPool> m_contextPool;
+
+    /// Whether the current track is initializing or initialized, but no frame of it has been decoded yet.
+    bool m_isAwaitingFirstFrame;
+
+    /// Time when the initialization of the current track started, including its retries.
+    std::chrono::steady_clock::time_point m_trackStartTime;
+
     /// Input format context object.
     std::shared_ptr<AVFormatContext> m_formatContext;
 
@@ -282,6 +375,15 @@ private:
     /// Object that keeps the unread data leftover from the last @c read.
     UnreadData m_unreadData;
 
+    /// The packet demuxed by @c decode(), reused for every packet.
+    std::shared_ptr<AVPacket> m_packet;
+
+    /// The frame received from the codec by @c readDecodedFrame(), reused for every frame.
+    std::shared_ptr<AVFrame> m_decodedFrame;
+
+    /// The bytes of the frames held between two calls to @c resample(), accounted to the @c DECODER subsystem.
+    utils::metrics::MemoryCharge m_frameMemory;
+
     /// Retry counter used to count the times where data was not available.
     size_t m_retryCount;
 
@@ -15,6 +15,7 @@
 
 #include <chrono>
 #include <ostream>
+#include <string>
 #include <tuple>
 
 struct AVFormatContext;
@@ -68,6 +69,30 @@ public:
     virtual std::tuple<Result, std::shared_ptr<AVFormatContext>, std::chrono::milliseconds>
     getCurrentFormatContextOpen() = 0;
 
+    /**
+     * Check whether the codec parameters of the input are complete as soon as it is opened, such as for raw PCM of a
+     * given format, so that the decoder can skip analyzing the stream before decoding it.
+     *
+     * @return @c true if the stream does not need to be analyzed; false, otherwise.
+     */
+    virtual bool hasKnownCodecParameters() const { return false; }
+
+    /**
+     * Get the kind of input, which labels the time-to-first-frame metric of the decoder.
+     *
+     * @return A short name of the input type.
+     */
+    virtual std::string getInputType() const { return "unknown"; }
+
+    /**
+     * Tell the controller how far the decoder has read the current input, so that it may get the next one ready
+     * before the decoder gets to it.
+     *
+     * @param position The position of the packet the decoder just read.
+     * @param duration The duration of the current input.
+     */
+    virtual void onDecodeProgress(std::chrono::milliseconds /*position*/, std::chrono::milliseconds /*duration*/) {}
+
     /**
      * Destructor
      */
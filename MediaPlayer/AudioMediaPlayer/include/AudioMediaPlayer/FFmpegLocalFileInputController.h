@@ -0,0 +1,166 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __FFMPEGLOCALFILEINPUTCONTROLLER_H_
+#define __FFMPEGLOCALFILEINPUTCONTROLLER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "FFmpegInputControllerInterface.h"
+
+struct AVIOContext;
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/**
+ * This class provides the FFmpegDecoder input access to the content of a local file, which is read with @c pread, or
+ * mapped to memory when the SDK owns it.
+ *
+ * The reads of the decoder are served without a stream, and from a mapping without a system call per read.  Its seeks
+ * only move the read position, so that the container may be seeked in and its duration found.
+ *
+ * A mapped file must not be truncated while it is played: reading the pages past its new end raises SIGBUS, which
+ * kills the process.  Only the files the SDK owns, which no other process changes, are mapped; the other ones are
+ * read with @c pread at the read position, which reports a file truncated under the decoder as its end.
+ *
+ * This class support repeat functionality implemented by returning @c true to @c hasNext and moving the read
+ * position back to the start of the file when @c next is called.
+ */
+class FFmpegLocalFileInputController : public FFmpegInputControllerInterface {
+public:
+    /**
+     * Creates a controller of a local file.
+     *
+     * @param path The path of the file.
+     * @param offset The offset the file is played from.
+     * @param repeat Whether to play the file in a loop.
+     * @param isOwned Whether the SDK owns the file, which nothing truncates while it is played, so that it is mapped.
+     * @return A pointer to the @c FFmpegLocalFileInputController if succeed; @c nullptr otherwise.
+     */
+    static std::unique_ptr<FFmpegLocalFileInputController> create(
+        const std::string& path,
+        std::chrono::milliseconds offset = std::chrono::milliseconds::zero(),
+        bool repeat = false,
+        bool isOwned = false);
+
+    /**
+     * Get the path of the local file a url names, which is a path or a file:// url.
+     *
+     * @param url The url.
+     * @param[out] path The path of the file, if the url names a local file.
+     * @return Whether the url names a local file.
+     */
+    static bool getLocalPath(const std::string& url, std::string* path);
+
+    /// @name FFmpegInputControllerInterface methods
+    /// @{
+    bool hasNext() const override;
+    bool next() override;
+    AVFormatContext* createNewFormatContext() override;
+    std::tuple<Result, std::shared_ptr<AVFormatContext>, std::chrono::milliseconds> getCurrentFormatContextOpen() override;
+    std::string getInputType() const override;
+    /// @}
+
+    /**
+     * Destructor.
+     */
+    ~FFmpegLocalFileInputController();
+
+private:
+    /**
+     * Constructor
+     *
+     * @param mapping The content of the file, which is unmapped when released, or @c nullptr to read @c fd.
+     * @param fd The file, which the controller closes, or -1 if it is mapped.
+     * @param size The size of the file.
+     * @param offset The offset the file is played from.
+     * @param repeat Whether to play the file in a loop.
+     */
+    FFmpegLocalFileInputController(
+        std::shared_ptr<const uint8_t> mapping,
+        int fd,
+        int64_t size,
+        std::chrono::milliseconds offset,
+        bool repeat);
+
+    /**
+     * Function used to provide input data to the decoder.
+     *
+     * @param buffer Buffer to copy the data to.
+     * @param bufferSize The buffer size in bytes.
+     * @return The size read if the @c read call succeeded or the AVError code.
+     */
+    int read(uint8_t* buffer, int bufferSize);
+
+    /**
+     * Function used to move the read position of the decoder.
+     *
+     * @param offset The position, relative to @c whence.
+     * @param whence @c SEEK_SET, @c SEEK_CUR or @c SEEK_END, or @c AVSEEK_SIZE to get the size of the file.
+     * @return The new position, the size of the file for @c AVSEEK_SIZE, or the AVError code.
+     */
+    int64_t seek(int64_t offset, int whence);
+
+    /**
+     * Feed AvioBuffer with some data from the input controller.
+     *
+     * @param userData A pointer to the input controller instance used to read the encoded input.
+     * @param buffer Buffer to copy the data to.
+     * @param bufferSize The buffer size in bytes.
+     * @return The size read if the @c read call succeeded or the AVError code.
+     */
+    static int feedBuffer(void* userData, uint8_t* buffer, int bufferSize);
+
+    /**
+     * Move the read position of the input controller.
+     *
+     * @param userData A pointer to the input controller instance.
+     * @param offset The position, relative to @c whence.
+     * @param whence @c SEEK_SET, @c SEEK_CUR or @c SEEK_END, or @c AVSEEK_SIZE to get the size of the file.
+     * @return The new position, the size of the file for @c AVSEEK_SIZE, or the AVError code.
+     */
+    static int64_t seekBuffer(void* userData, int64_t offset, int whence);
+
+    /// The content of the file, shared with the format contexts reading it, or @c nullptr if it is not mapped.
+    const std::shared_ptr<const uint8_t> m_mapping;
+
+    /// The file read with @c pread, or -1 if it is mapped.
+    const int m_fd;
+
+    /// The size of the file.
+    const int64_t m_size;
+
+    /// The read position in the file.
+    int64_t m_position;
+
+    /// The offset the next format context is played from, which is zero once the file was played.
+    std::chrono::milliseconds m_offset;
+
+    /// Keep a pointer to the avioContext to avoid memory leaks.
+    std::shared_ptr<AVIOContext> m_ioContext;
+
+    /// Flag that indicates whether repeat is on or not.
+    const bool m_repeat;
+
+    /// The current format context original point @c AVFormatContext.
+    AVFormatContext* m_avFormatContext;
+};
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __FFMPEGLOCALFILEINPUTCONTROLLER_H_
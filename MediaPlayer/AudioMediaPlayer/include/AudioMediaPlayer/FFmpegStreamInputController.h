@@ -48,6 +48,7 @@ public:
     bool next() override;
 	AVFormatContext* createNewFormatContext() override;
     std::tuple<Result, std::shared_ptr<AVFormatContext>, std::chrono::milliseconds> getCurrentFormatContextOpen() override;
+    std::string getInputType() const override;
     /// @}
 
     /**
@@ -14,11 +14,19 @@
 #ifndef __FFMPEGURLINPUTCONTROLLER_H_
 #define __FFMPEGURLINPUTCONTROLLER_H_
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <memory>
 #include <queue>
+#include <thread>
+
+#include <Utils/PlaylistParser/IterativePlaylistParserInterface.h>
 
 #include "FFmpegInputControllerInterface.h"
+#include "UrlCache.h"
+
+struct AVInputFormat;
 
 namespace aisdk {
 namespace mediaPlayer {
@@ -26,6 +34,12 @@ namespace ffmpeg {
 
 /**
  * This class provides the FFmpegDecoder input access to the content of a url (playlist or single media file).
+ *
+ * A playlist is iterated with a playlist parser: @c next() moves to the following entry.  Once the decoder gets near
+ * the end of an entry, a prefetch thread parses the following entry and opens it, so that the decoder moves to it
+ * without waiting for the network.  Opening it any earlier would leave its connection idle for the whole entry, for
+ * the server to close, and would take bandwidth from the entry playing.  The entry after one whose duration is unknown
+ * is opened when the decoder gets to it, and so is an entry whose context opened in advance is no longer usable.
  */
 class FFmpegUrlInputController : public FFmpegInputControllerInterface {
 public:
@@ -34,11 +48,15 @@ public:
      *
      * @param url The playlist / media url that we would like to decode.
      * @param offset The audio input should start from the given offset.
+     * @param urlCache The cache http media is read through, or @c nullptr to always read it from the network.
+     * @param playlistParser The parser iterating the entries of @c url, or @c nullptr to play @c url as one media.
      * @return A pointer to the @c FFmpegUrlInputReader if succeed; otherwise, @c nullptr.
      */
     static std::unique_ptr<FFmpegUrlInputController> create(
         const std::string& url,
-        const std::chrono::milliseconds& offset);
+        const std::chrono::milliseconds& offset,
+        std::shared_ptr<UrlCache> urlCache = nullptr,
+        std::shared_ptr<utils::playlistParser::IterativePlaylistParserInterface> playlistParser = nullptr);
 
 	/// @name FFmpegInputControllerInterface methods
     /// @{
@@ -46,6 +64,8 @@ public:
     std::tuple<Result, std::shared_ptr<AVFormatContext>, std::chrono::milliseconds> getCurrentFormatContextOpen() override;
     bool hasNext() const override;
     bool next() override;
+    std::string getInputType() const override;
+    void onDecodeProgress(std::chrono::milliseconds position, std::chrono::milliseconds duration) override;
     /// @}
 
     /**
@@ -57,12 +77,42 @@ private:
     /**
      * Constructor
      *
-     * @param parser Pointer to a valid playlist parser used to parse the target URL.
+     * @param url The playlist / media url that we would like to decode.
      * @param offset The audio input should start from the given offset.
+     * @param urlCache The cache http media is read through, or @c nullptr.
+     * @param playlistParser The parser iterating the entries of @c url, or @c nullptr.
      */
     FFmpegUrlInputController(
 		const std::string& url,
-        const std::chrono::milliseconds& offset);
+        const std::chrono::milliseconds& offset,
+        std::shared_ptr<UrlCache> urlCache,
+        std::shared_ptr<utils::playlistParser::IterativePlaylistParserInterface> playlistParser);
+
+    /**
+     * Open a media url, from the cache if it can be cached.
+     *
+     * @param avFormatContext The context to open, which is freed on failure.
+     * @param url The media url.
+     * @return The result, the opened context and the offset, like @c getCurrentFormatContextOpen().
+     */
+    std::tuple<Result, std::shared_ptr<AVFormatContext>, std::chrono::milliseconds> openUrl(
+        AVFormatContext* avFormatContext,
+        const std::string& url);
+
+    /**
+     * Open a media url from the cache.
+     *
+     * @param avFormatContext The context to open, which is freed on failure.
+     * @param url The media url.
+     * @param reader The reader of the cached content.
+     * @param inputFormat The demuxer guessed from the url, or @c nullptr to probe the format.
+     * @return The result, the opened context and the offset, like @c getCurrentFormatContextOpen().
+     */
+    std::tuple<Result, std::shared_ptr<AVFormatContext>, std::chrono::milliseconds> openCachedInput(
+        AVFormatContext* avFormatContext,
+        const std::string& url,
+        std::shared_ptr<UrlCache::Reader> reader,
+        AVInputFormat* inputFormat);
 
     /**
      * Finds the first playlist entry. This is unique to the first audio track because of the initial offset logic.
@@ -71,6 +121,33 @@ private:
      */
     bool findFirstEntry();
 
+    /**
+     * Start the prefetch thread on the entry after the current one, if there is one.
+     */
+    void startPrefetch();
+
+    /**
+     * The prefetch thread: parse the entry after the current one and open it.
+     */
+    void prefetchNextEntry();
+
+    /**
+     * Check whether the context opened by the prefetch thread can still be read: its connection may have failed, or
+     * been left idle long enough for the server to close it, such as while the playback was paused.
+     *
+     * @return Whether @c m_prefetchedContext can be given to the decoder.
+     */
+    bool isPrefetchedContextUsable() const;
+
+    /**
+     * The FFmpeg interrupt callback of the contexts opened by the prefetch thread.  It gives up when the controller is
+     * destroyed, and once the decoder reads the context, when the decoder would.
+     *
+     * @param controller This controller.
+     * @return Non-zero if FFmpeg should give up.
+     */
+    static int shouldInterruptPrefetch(void* controller);
+
     /// The current url that we are parsing.
     std::string m_currentUrl;
 
@@ -82,6 +159,45 @@ private:
 
 	/// The current format context original point @c AVFormatContext.
 	AVFormatContext* m_avFormatContext;
+
+    /// The cache http media is read through, or @c nullptr.
+    std::shared_ptr<UrlCache> m_urlCache;
+
+    /// The parser iterating the playlist entries, or @c nullptr if the url is played as one media.
+    std::shared_ptr<utils::playlistParser::IterativePlaylistParserInterface> m_playlistParser;
+
+    /// The interrupt callback the decoder gave the last opened context.
+    int (*m_decoderInterruptCallback)(void*);
+
+    /// The argument of @c m_decoderInterruptCallback.
+    void* m_decoderInterruptOpaque;
+
+    /// The probe size the decoder gave the last opened context.
+    int64_t m_probeSize;
+
+    /// The analyze duration the decoder gave the last opened context.
+    int64_t m_maxAnalyzeDuration;
+
+    /// Whether the entry after the current one is to be prefetched once the decoder gets near the end of this one.
+    bool m_isPrefetchPending;
+
+    /// Parses and opens the entry after the current one.  The members below are only used while it is not running.
+    std::thread m_prefetchThread;
+
+    /// Whether @c m_prefetchedEntry was parsed by the prefetch thread.
+    bool m_hasPrefetchedEntry;
+
+    /// The entry after the current one.
+    utils::playlistParser::IterativePlaylistParserInterface::PlaylistEntry m_prefetchedEntry;
+
+    /// The opened context of @c m_prefetchedEntry, or @c nullptr if it was not opened in advance.
+    std::shared_ptr<AVFormatContext> m_prefetchedContext;
+
+    /// When @c m_prefetchedContext was opened.
+    std::chrono::steady_clock::time_point m_prefetchedTime;
+
+    /// Tells the prefetch thread and the contexts it opened to give up.
+    std::atomic<bool> m_isShuttingDown;
 };
 
 }  // namespace ffmpeg
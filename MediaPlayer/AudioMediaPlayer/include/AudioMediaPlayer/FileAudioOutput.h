@@ -0,0 +1,105 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __FILE_AUDIO_OUTPUT_H_
+#define __FILE_AUDIO_OUTPUT_H_
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "AudioOutputInterface.h"
+#include "OutputPacer.h"
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/**
+ * An output which writes the audio to a file, to check what a player plays without a sound card.
+ *
+ * A WAV file gets its header when it is opened and the sizes in the header are completed when the output is
+ * destroyed; a raw file only holds the samples.
+ */
+class FileAudioOutput : public AudioOutputInterface {
+public:
+    /// The format of the file.
+    enum class FileFormat {
+        /// A RIFF WAVE file.
+        WAV,
+        /// The samples only.
+        RAW
+    };
+
+    /**
+     * Create a file output.
+     *
+     * @param filename The file to write, which is replaced if it exists.
+     * @param config The format of the audio written to the output.
+     * @param fileFormat The format of the file.
+     * @param clock How the output is paced.
+     * @return The new output, or @c nullptr if the file could not be opened or a WAV file cannot hold the audio.
+     */
+    static std::unique_ptr<FileAudioOutput> create(
+        const std::string& filename,
+        const PlaybackConfiguration& config,
+        FileFormat fileFormat = FileFormat::WAV,
+        OutputPacer::Clock clock = OutputPacer::Clock::UNTHROTTLED);
+
+    /// Destructor, which completes the WAV header.
+    ~FileAudioOutput();
+
+    /// @name AudioOutputInterface method overrides.
+    /// @{
+    bool write(const uint8_t* data, size_t size) override;
+    PlaybackConfiguration getConfiguration() const override;
+    /// @}
+
+private:
+    /**
+     * Constructor.
+     *
+     * @param config The format of the audio written to the output.
+     * @param fileFormat The format of the file.
+     * @param clock How the output is paced.
+     */
+    FileAudioOutput(const PlaybackConfiguration& config, FileFormat fileFormat, OutputPacer::Clock clock);
+
+    /**
+     * Write the WAV header at the current position of the file.
+     *
+     * @return Whether the header was written.
+     */
+    bool writeWavHeader();
+
+    /// The format of the audio written to the output.
+    const PlaybackConfiguration m_config;
+
+    /// The format of the file.
+    const FileFormat m_fileFormat;
+
+    /// Paces the writes.
+    OutputPacer m_pacer;
+
+    /// The file.
+    std::ofstream m_file;
+
+    /// The number of bytes of audio written.
+    uint64_t m_bytesWritten;
+};
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __FILE_AUDIO_OUTPUT_H_
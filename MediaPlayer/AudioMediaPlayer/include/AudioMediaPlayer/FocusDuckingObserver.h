@@ -0,0 +1,87 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __FOCUS_DUCKING_OBSERVER_H_
+#define __FOCUS_DUCKING_OBSERVER_H_
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <Utils/Channel/AudioTrackManagerObserverInterface.h>
+
+#include "AudioMixerInput.h"
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/**
+ * Ducks the mixer input of a channel while another channel is in the foreground, or while the channel itself is in
+ * the background, so that the foreground channel is heard over it.  The input is brought back up once neither holds.
+ *
+ * Ducking on another channel being in the foreground covers the players which play without acquiring their channel:
+ * an answer acquiring the dialog channel then ducks the stream and the alarm inputs all the same.
+ *
+ * Register it with @c AudioTrackManagerInterface::addObserver().
+ */
+class FocusDuckingObserver : public utils::channel::AudioTrackManagerObserverInterface {
+public:
+    /**
+     * Constructor.
+     *
+     * @param inputs The mixer input of the player of each channel, by channel name.
+     * @param duckLevel The fraction of its gain a channel in the background is lowered to.
+     * @param duckRamp How long the gain takes to go down.
+     * @param restoreRamp How long the gain takes to come back up.
+     */
+    FocusDuckingObserver(
+        const std::unordered_map<std::string, std::shared_ptr<AudioMixerInput>>& inputs,
+        float duckLevel = 0.25f,
+        std::chrono::milliseconds duckRamp = std::chrono::milliseconds(100),
+        std::chrono::milliseconds restoreRamp = std::chrono::milliseconds(300));
+
+    /// @name AudioTrackManagerObserverInterface method overrides.
+    /// @{
+    void onTrackChanged(const std::string& channelName, utils::channel::FocusState newTrace) override;
+    /// @}
+
+private:
+    /// The mixer input of the player of each channel.
+    const std::unordered_map<std::string, std::shared_ptr<AudioMixerInput>> m_inputs;
+
+    /// Serializes the members below.
+    std::mutex m_mutex;
+
+    /// The last focus of each channel reported, by channel name.
+    std::unordered_map<std::string, utils::channel::FocusState> m_focus;
+
+    /// The channels whose input is ducked.
+    std::unordered_map<std::string, bool> m_isDucked;
+
+    /// The fraction of its gain a channel in the background is lowered to.
+    const float m_duckLevel;
+
+    /// How long the gain takes to go down.
+    const std::chrono::milliseconds m_duckRamp;
+
+    /// How long the gain takes to come back up.
+    const std::chrono::milliseconds m_restoreRamp;
+};
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __FOCUS_DUCKING_OBSERVER_H_
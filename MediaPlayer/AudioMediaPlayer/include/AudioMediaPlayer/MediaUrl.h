@@ -0,0 +1,58 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __MEDIA_URL_H_
+#define __MEDIA_URL_H_
+
+#include <string>
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/// The FFmpeg option key of the HTTP User-Agent.
+extern const char* const USER_AGENT_OPTION;
+
+/// The User-Agent of the http requests of the players.
+extern const char* const USER_AGENT;
+
+/**
+ * Find the file extension of a url, without its query and fragment.
+ *
+ * @param url The url.
+ * @return The extension in lower case, or an empty string if the url has none.
+ */
+std::string findUrlExtension(const std::string& url);
+
+/**
+ * Check whether a url is a playlist, which has to be played with a playlist parser, from its file extension.
+ *
+ * HLS playlists (m3u8) are not, since FFmpeg plays them itself.
+ *
+ * @param url The url.
+ * @return Whether the url is an m3u or a pls playlist.
+ */
+bool isPlaylistUrl(const std::string& url);
+
+/**
+ * Check whether a url is an HLS playlist, which FFmpeg plays segment after segment, from its file extension.
+ *
+ * @param url The url.
+ * @return Whether the url is an m3u8 playlist.
+ */
+bool isHlsUrl(const std::string& url);
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __MEDIA_URL_H_
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __NULL_AUDIO_OUTPUT_H_
+#define __NULL_AUDIO_OUTPUT_H_
+
+#include <atomic>
+#include <memory>
+
+#include "AudioOutputInterface.h"
+#include "OutputPacer.h"
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/**
+ * An output which drops the audio, to run players without a sound card: in real time for latency tests, or
+ * unthrottled to measure how fast the audio is decoded.
+ */
+class NullAudioOutput : public AudioOutputInterface {
+public:
+    /**
+     * Create a null output.
+     *
+     * @param config The format of the audio written to the output.
+     * @param clock How the output is paced.
+     * @return The new output.
+     */
+    static std::unique_ptr<NullAudioOutput> create(
+        const PlaybackConfiguration& config,
+        OutputPacer::Clock clock = OutputPacer::Clock::REAL_TIME);
+
+    /**
+     * Get the number of bytes written to the output.
+     *
+     * @return The number of bytes written.
+     */
+    uint64_t getBytesWritten() const;
+
+    /// @name AudioOutputInterface method overrides.
+    /// @{
+    bool write(const uint8_t* data, size_t size) override;
+    PlaybackConfiguration getConfiguration() const override;
+    /// @}
+
+private:
+    /**
+     * Constructor.
+     *
+     * @param config The format of the audio written to the output.
+     * @param clock How the output is paced.
+     */
+    NullAudioOutput(const PlaybackConfiguration& config, OutputPacer::Clock clock);
+
+    /// The format of the audio written to the output.
+    const PlaybackConfiguration m_config;
+
+    /// Paces the writes.
+    OutputPacer m_pacer;
+
+    /// The number of bytes written.
+    std::atomic<uint64_t> m_bytesWritten;
+};
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __NULL_AUDIO_OUTPUT_H_
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __OUTPUT_PACER_H_
+#define __OUTPUT_PACER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "PlaybackConfiguration.h"
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/**
+ * Makes an output without a device take audio at the speed a device would, or as fast as it is written.
+ *
+ * In real time, @c pace() sleeps until the audio written before would have been played since the first write.  A
+ * write which comes after that, because the player was paused, stopped or starved, starts the clock again like a
+ * device which ran dry, so that the audio after it is not played faster to catch up.
+ */
+class OutputPacer {
+public:
+    /// How an output without a device is paced.
+    enum class Clock {
+        /// The audio is taken at the speed it plays, as by a sound card.
+        REAL_TIME,
+        /// The audio is taken as soon as it is written.
+        UNTHROTTLED
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param config The format of the audio, which sets how long bytes of it play.
+     * @param clock How the output is paced.
+     */
+    OutputPacer(const PlaybackConfiguration& config, Clock clock);
+
+    /**
+     * Wait until the output can take more audio.
+     *
+     * @param size The number of bytes just written.
+     */
+    void pace(size_t size);
+
+private:
+    /**
+     * Get when the audio written since the clock started will have played.
+     *
+     * @return The time the audio ends.
+     */
+    std::chrono::steady_clock::time_point playedUntil() const;
+
+    /// How the output is paced.
+    const Clock m_clock;
+
+    /// The bytes of one second of audio.
+    const uint64_t m_bytesPerSecond;
+
+    /// When the clock started.
+    std::chrono::steady_clock::time_point m_startTime;
+
+    /// The bytes written since the clock started.
+    uint64_t m_bytes;
+};
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __OUTPUT_PACER_H_
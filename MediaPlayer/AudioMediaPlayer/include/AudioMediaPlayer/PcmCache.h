@@ -0,0 +1,321 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __PCM_CACHE_H_
+#define __PCM_CACHE_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <Utils/Metrics/Counter.h>
+#include <Utils/Metrics/Gauge.h>
+#include <Utils/Metrics/Histogram.h>
+
+#include "DecoderInterface.h"
+#include "PlaybackConfiguration.h"
+#include "UrlCache.h"
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/**
+ * A bounded cache of decoded audio, for the short sounds which are played again and again: earcons, prompts and alarm
+ * tones.  The first play of a url decodes it with FFmpeg as usual, and records the audio handed to the player, which
+ * is already in the output format.  The following plays of the url in the same format skip opening, probing, decoding
+ * and resampling: their decoder copies the recorded audio.
+ *
+ * A recording is a file holding a header with the key it was recorded for and then the audio, so that it is mapped to
+ * memory and read in place.  The most recently played recordings stay mapped, within @c maxMemoryBytes, and the
+ * files are kept within @c maxBytes by evicting the least recently played ones.  The key of a url is the url and the
+ * output format, and for a local file its size and modification time too, so that a changed file is decoded again.
+ * An http url has a key only while the @c UrlCache holds its content with fresh validators, its size and content
+ * type, which are part of the key: the url is decoded again once its content changed on the server.
+ *
+ * Only whole plays from the start are recorded, and only of a url played recently before, so that the one-off urls of
+ * the speech of a dialog turn are not written to the disk, nor evict the sounds played again.  A recording is dropped
+ * when it is aborted, fails or grows past @c maxClipBytes, like a song or a live stream would.
+ */
+class PcmCache : public std::enable_shared_from_this<PcmCache> {
+public:
+    /// The largest recording, unless given to @c create(): about 20 seconds of 48kHz 16 bit stereo.
+    static constexpr uint64_t DEFAULT_MAX_CLIP_BYTES = 4 * 1024 * 1024;
+
+    /// The urls whose last play is remembered, so that their next play is recorded.
+    static constexpr size_t MAX_PLAYED_URLS = 256;
+
+    /**
+     * Create a cache, and load the recordings left in the directory by a previous run.
+     *
+     * @param directory The directory the recordings are stored in, which is created if it does not exist.
+     * @param maxBytes The most recorded audio the cache keeps on disk.
+     * @param maxMemoryBytes The most recorded audio the cache keeps mapped between plays.
+     * @param maxClipBytes The largest recording.
+     * @param urlCache The cache giving the validators of http urls, or @c nullptr to only record local files.
+     * @return The new cache, or @c nullptr if the directory cannot be used or @c maxBytes or @c maxClipBytes is 0.
+     */
+    static std::shared_ptr<PcmCache> create(
+        const std::string& directory,
+        uint64_t maxBytes,
+        uint64_t maxMemoryBytes,
+        uint64_t maxClipBytes = DEFAULT_MAX_CLIP_BYTES,
+        std::shared_ptr<UrlCache> urlCache = nullptr);
+
+    /**
+     * Check whether the play of a url can be served from or recorded to the cache, which is the case of whole plays
+     * of urls which are not playlists.
+     *
+     * @param url The url.
+     * @param offset The offset the url is played from.
+     * @return Whether the play may use the cache.
+     */
+    static bool isCacheable(const std::string& url, std::chrono::milliseconds offset);
+
+    /**
+     * Create a decoder which plays the recording of a url, if there is one.
+     *
+     * @param url The url.
+     * @param config The output format of the decoder.
+     * @return The decoder, or @c nullptr if the url was not recorded in this format.
+     */
+    std::shared_ptr<DecoderInterface> createDecoder(const std::string& url, const PlaybackConfiguration& config);
+
+    /**
+     * Record the audio of a decoder of a url, which is stored when the decoder reaches the end of the url.  The first
+     * play of a url is not recorded, only remembered.
+     *
+     * @param url The url.
+     * @param config The output format of the decoder.
+     * @param decoder The decoder, which decodes the url from its start.
+     * @return A decoder which reads @c decoder and records its audio, or @c decoder if the url is not recorded.
+     */
+    std::shared_ptr<DecoderInterface> record(
+        const std::string& url,
+        const PlaybackConfiguration& config,
+        std::shared_ptr<DecoderInterface> decoder);
+
+    /**
+     * Get the size of the recordings on disk.
+     *
+     * @return The number of bytes of the recording files.
+     */
+    uint64_t getSizeBytes();
+
+    /**
+     * Get the size of the recordings kept mapped between plays.
+     *
+     * @return The number of bytes of recorded audio mapped.
+     */
+    uint64_t getMemoryBytes();
+
+private:
+    /// A recording mapped to memory, defined in the implementation.
+    struct Clip;
+
+    /// The decoder of a recording, defined in the implementation.
+    class ClipDecoder;
+
+    /// The decoder which records the audio of another decoder, defined in the implementation.
+    class RecordingDecoder;
+
+    /// A recording file.
+    struct FileEntry {
+        /// The size of the file.
+        uint64_t bytes;
+        /// Orders the files from the least recently played.
+        uint64_t lastUse;
+    };
+
+    /// The recordings kept mapped, from the most recently played, with their file names.
+    using ClipList = std::list<std::pair<std::string, std::shared_ptr<Clip>>>;
+
+    /// The hashes of the urls played, from the most recently played.
+    using PlayedUrlList = std::list<size_t>;
+
+    /**
+     * Constructor.
+     *
+     * @param directory The directory the recordings are stored in.
+     * @param maxBytes The most recorded audio the cache keeps on disk.
+     * @param maxMemoryBytes The most recorded audio the cache keeps mapped between plays.
+     * @param maxClipBytes The largest recording.
+     * @param urlCache The cache giving the validators of http urls, or @c nullptr.
+     */
+    PcmCache(
+        const std::string& directory,
+        uint64_t maxBytes,
+        uint64_t maxMemoryBytes,
+        uint64_t maxClipBytes,
+        std::shared_ptr<UrlCache> urlCache);
+
+    /**
+     * Get the key of the play of a url in an output format, which identifies its decoded audio.
+     *
+     * @param url The url.
+     * @param config The output format.
+     * @param[out] key The key.
+     * @return Whether the url has a key: a local file which cannot be found has none, nor an http url whose content
+     * is not in @c m_urlCache with fresh validators.
+     */
+    bool keyOf(const std::string& url, const PlaybackConfiguration& config, std::string* key) const;
+
+    /**
+     * Remember the play of a url, and check whether it was played before.  @c m_mutex must be held.
+     *
+     * @param url The url.
+     * @return Whether the url is among the last @c MAX_PLAYED_URLS played before.
+     */
+    bool markPlayedLocked(const std::string& url);
+
+    /**
+     * Map a recording file.
+     *
+     * @param path The file.
+     * @param key The key the recording must have been recorded for.
+     * @return The recording, or @c nullptr if the file cannot be mapped or was recorded for another key.
+     */
+    static std::shared_ptr<Clip> mapClip(const std::string& path, const std::string& key);
+
+    /**
+     * Load the recordings in the directory, and remove the ones left incomplete.
+     *
+     * @return Whether the directory could be read.
+     */
+    bool load();
+
+    /**
+     * Find the recording of a key, mapped from the memory or from its file.
+     *
+     * @param key The key.
+     * @param name The file name of the key.
+     * @return The recording, or @c nullptr if the key was not recorded.
+     */
+    std::shared_ptr<Clip> findClip(const std::string& key, const std::string& name);
+
+    /**
+     * Store a completed recording under its file name, replacing any previous one.
+     *
+     * @param name The file name of the recording.
+     * @param temporaryPath The file the recording was written to, with its header.
+     * @param fileBytes The size of the file.
+     * @return Whether the recording was stored.
+     */
+    bool commit(const std::string& name, const std::string& temporaryPath, uint64_t fileBytes);
+
+    /**
+     * Evict the least recently played recordings until the files fit their budget.  @c m_mutex must be held.
+     */
+    void evictLocked();
+
+    /**
+     * Unmap the least recently played recordings until the mapped ones fit their budget.  @c m_mutex must be held.
+     */
+    void trimMemoryLocked();
+
+    /**
+     * Forget the mapping of a recording.  @c m_mutex must be held.
+     *
+     * @param name The file name of the recording.
+     */
+    void unmapLocked(const std::string& name);
+
+    /**
+     * Get the path of a file of the cache.
+     *
+     * @param name The name of the file, without its extension.
+     * @param extension The extension of the file.
+     * @return The path.
+     */
+    std::string pathOf(const std::string& name, const std::string& extension) const;
+
+    /// The directory the recordings are stored in.
+    const std::string m_directory;
+
+    /// The most recorded audio the cache keeps on disk.
+    const uint64_t m_maxBytes;
+
+    /// The most recorded audio the cache keeps mapped between plays.
+    const uint64_t m_maxMemoryBytes;
+
+    /// The largest recording.
+    const uint64_t m_maxClipBytes;
+
+    /// The cache giving the validators of http urls, or @c nullptr.
+    const std::shared_ptr<UrlCache> m_urlCache;
+
+    /// Serializes the members below.
+    std::mutex m_mutex;
+
+    /// The recording files by name.
+    std::unordered_map<std::string, FileEntry> m_files;
+
+    /// The recordings kept mapped, from the most recently played.
+    ClipList m_clips;
+
+    /// The entries of @c m_clips by file name.
+    std::unordered_map<std::string, ClipList::iterator> m_clipIndex;
+
+    /// The urls played, from the most recently played.
+    PlayedUrlList m_playedUrls;
+
+    /// The entries of @c m_playedUrls by hash.
+    std::unordered_map<size_t, PlayedUrlList::iterator> m_playedUrlIndex;
+
+    /// The bytes of the recording files.
+    uint64_t m_sizeBytes;
+
+    /// The bytes of recorded audio kept mapped.
+    uint64_t m_memoryBytes;
+
+    /// The last value given to @c FileEntry::lastUse.
+    uint64_t m_useCount;
+
+    /// The number of recordings started, which names their temporary files.
+    uint64_t m_recordingCount;
+
+    /// Plays served from a recording which was mapped.
+    std::shared_ptr<utils::metrics::Counter> m_memoryHitCounter;
+
+    /// Plays served from a recording which was mapped from its file.
+    std::shared_ptr<utils::metrics::Counter> m_diskHitCounter;
+
+    /// Plays which found no recording.
+    std::shared_ptr<utils::metrics::Counter> m_missCounter;
+
+    /// Plays not recorded because their url was not played before.
+    std::shared_ptr<utils::metrics::Counter> m_firstPlayCounter;
+
+    /// The time from the creation of the decoder of a recorded play to its first audio, in microseconds.
+    std::shared_ptr<utils::metrics::Histogram> m_hitFirstSampleHistogram;
+
+    /// The time from the creation of the decoder of a decoded play to its first audio, in microseconds.
+    std::shared_ptr<utils::metrics::Histogram> m_missFirstSampleHistogram;
+
+    /// The bytes of the recording files.
+    std::shared_ptr<utils::metrics::Gauge> m_sizeGauge;
+
+    /// The bytes of recorded audio kept mapped.
+    std::shared_ptr<utils::metrics::Gauge> m_memoryGauge;
+};
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __PCM_CACHE_H_
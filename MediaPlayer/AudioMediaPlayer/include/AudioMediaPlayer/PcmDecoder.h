@@ -0,0 +1,138 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __PCM_DECODER_H_
+#define __PCM_DECODER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <Utils/Attachment/AttachmentReader.h>
+#include <Utils/AudioFormat.h>
+#include <Utils/Metrics/MemoryAccounting.h>
+
+#include "DecoderInterface.h"
+#include "PlaybackConfiguration.h"
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/**
+ * A decoder for raw LPCM attachments of a known @c AudioFormat, such as TTS, which reads the attachment directly and
+ * only converts the sample format, endianness and channels to the output, without FFmpeg.  Compared to
+ * @c FFmpegDecoder it skips probing the input and the codec and resampler setup, and copies the samples once.
+ *
+ * The input must already be at the output sample rate; use @c isSupported() to choose between this decoder and
+ * @c FFmpegDecoder.
+ */
+class PcmDecoder : public DecoderInterface {
+public:
+    /**
+     * Check whether audio in the given format can be decoded to the given output by this decoder.
+     *
+     * @param format The format of the input.
+     * @param outputConfig The decoder output configuration.
+     * @return Whether the input is interleaved LPCM at the output rate, with a supported sample size and channels.
+     */
+    static bool isSupported(const utils::AudioFormat& format, const PlaybackConfiguration& outputConfig);
+
+    /**
+     * Create a decoder.
+     *
+     * @param reader The attachment to read the audio from.
+     * @param format The format of the audio in the attachment.
+     * @param outputConfig The decoder output configuration.
+     * @return The new decoder, or @c nullptr if the reader is @c nullptr or the format is not supported.
+     */
+    static std::unique_ptr<PcmDecoder> create(
+        std::shared_ptr<utils::attachment::AttachmentReader> reader,
+        const utils::AudioFormat& format,
+        const PlaybackConfiguration& outputConfig);
+
+    /// @name DecoderInterface method overrides.
+    /// @{
+    std::pair<Status, size_t> read(Byte* buffer, size_t size) override;
+    void abort() override;
+    /// @}
+
+private:
+    /**
+     * Constructor.
+     *
+     * @param reader The attachment to read the audio from.
+     * @param format The format of the audio in the attachment.
+     * @param outputConfig The decoder output configuration.
+     */
+    PcmDecoder(
+        std::shared_ptr<utils::attachment::AttachmentReader> reader,
+        const utils::AudioFormat& format,
+        const PlaybackConfiguration& outputConfig);
+
+    /**
+     * Convert whole input frames from @c m_input to the output format.
+     *
+     * @param buffer The buffer where the output will be written to.
+     * @param frames The number of frames to convert.
+     */
+    void convert(Byte* buffer, size_t frames);
+
+    /// The attachment to read the audio from.
+    std::shared_ptr<utils::attachment::AttachmentReader> m_reader;
+
+    /// The bytes of one input sample.
+    const size_t m_inputSampleBytes;
+
+    /// Whether the input samples are big endian.
+    const bool m_isInputBigEndian;
+
+    /// The number of input channels.
+    const size_t m_inputChannels;
+
+    /// The bytes of one output sample.
+    const size_t m_outputSampleBytes;
+
+    /// The number of output channels.
+    const size_t m_outputChannels;
+
+    /// The input read from the attachment and not converted yet, which is less than one frame between reads.
+    std::vector<Byte> m_input;
+
+    /// The number of bytes at the start of @c m_input.
+    size_t m_inputBytes;
+
+    /// The bytes of @c m_input, accounted to the @c DECODER subsystem.
+    utils::metrics::MemoryCharge m_inputMemory;
+
+    /// Whether the attachment was closed by its writer.
+    bool m_isFinished;
+
+    /// Whether @c abort() was called.
+    std::atomic<bool> m_isAborted;
+
+    /// Serializes the waits for data with @c abort().
+    std::mutex m_abortMutex;
+
+    /// Wakes a wait for data when the decoder is aborted.
+    std::condition_variable m_abortCondition;
+};
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __PCM_DECODER_H_
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __PCM_KERNELS_H_
+#define __PCM_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/*
+ * Sample processing kernels of the playback path, in SSE2 or NEON when the target has it and in plain C++ otherwise.
+ * The buffers need no particular alignment.
+ */
+
+/// The gain of a signal left as it is, in Q15.
+static constexpr int32_t UNITY_GAIN_Q15 = 1 << 15;
+
+/// The highest gain @c applyGain16() takes, in Q15.
+static constexpr int32_t MAX_GAIN_Q15 = 8 * UNITY_GAIN_Q15;
+
+/// The shape of a fade from one gain to another.
+enum class FadeCurve {
+    /// The gain moves by the same amount in each step.
+    LINEAR,
+    /// The gain moves by the same number of decibels in each step, which sounds even to the ear.  Silence is taken
+    /// as -60dB, and is only reached at the very end of a fade out.
+    EXPONENTIAL
+};
+
+/**
+ * Add 16 bit samples to others, saturating at the limits of the format instead of wrapping around.
+ *
+ * @param destination The samples to add to, which receive the sums.
+ * @param source The samples to add.
+ * @param samples The number of samples.
+ */
+void mixSaturating16(int16_t* destination, const int16_t* source, size_t samples);
+
+/**
+ * Scale 16 bit samples by a gain and add them to others, saturating at the limits of the format.
+ *
+ * @param destination The samples to add to, which receive the sums.
+ * @param source The samples to scale and add.
+ * @param samples The number of samples.
+ * @param gainQ15 The gain in Q15, from 0 to @c UNITY_GAIN_Q15.
+ */
+void mixScaledSaturating16(int16_t* destination, const int16_t* source, size_t samples, int32_t gainQ15);
+
+/**
+ * Scale 16 bit samples by a gain in place, clipping at the limits of the format.
+ *
+ * @param samples The samples.
+ * @param count The number of samples.
+ * @param gainQ15 The gain in Q15, from 0 to @c MAX_GAIN_Q15.  Above unity the gain loses its lowest bits.
+ */
+void applyGain16(int16_t* samples, size_t count, int32_t gainQ15);
+
+/**
+ * Scale 32 bit samples by a gain in place, clipping at the limits of the format.  The samples are scaled in single
+ * precision, which keeps 24 bits of them.
+ *
+ * @param samples The samples.
+ * @param count The number of samples.
+ * @param gain The gain, from 0.
+ */
+void applyGain32(int32_t* samples, size_t count, float gain);
+
+/**
+ * Scale float samples by a gain in place, clipping to [-1, 1].
+ *
+ * @param samples The samples.
+ * @param count The number of samples.
+ * @param gain The gain, from 0.
+ */
+void applyGainF32(float* samples, size_t count, float gain);
+
+/**
+ * Get the gain at some point of a fade.
+ *
+ * @param fromGain The gain at the start of the fade.
+ * @param toGain The gain at the end of the fade.
+ * @param position Where in the fade, from 0 at the start to 1 at the end.
+ * @param curve The shape of the fade.
+ * @return The gain.
+ */
+float fadeGain(float fromGain, float toGain, float position, FadeCurve curve);
+
+/**
+ * Fade interleaved 16 bit frames in place from one gain to another.  The gain changes every few frames, and reaches
+ * @c toGain on the last frames.
+ *
+ * @param samples The frames.
+ * @param frames The number of frames.
+ * @param channels The number of channels of a frame.
+ * @param fromGain The gain at the start of the fade, from 0 to 8.
+ * @param toGain The gain at the end of the fade, from 0 to 8.
+ * @param curve The shape of the fade.
+ */
+void applyFade16(int16_t* samples, size_t frames, size_t channels, float fromGain, float toGain, FadeCurve curve);
+
+/**
+ * Fade interleaved 32 bit frames in place from one gain to another, as @c applyFade16() does.
+ *
+ * @param samples The frames.
+ * @param frames The number of frames.
+ * @param channels The number of channels of a frame.
+ * @param fromGain The gain at the start of the fade.
+ * @param toGain The gain at the end of the fade.
+ * @param curve The shape of the fade.
+ */
+void applyFade32(int32_t* samples, size_t frames, size_t channels, float fromGain, float toGain, FadeCurve curve);
+
+/**
+ * Convert 16 bit samples to 32 bit samples, keeping the most significant bits.
+ *
+ * @param input The 16 bit samples.
+ * @param output The 32 bit samples.
+ * @param count The number of samples.
+ */
+void convertS16ToS32(const int16_t* input, int32_t* output, size_t count);
+
+/**
+ * Convert 32 bit samples to 16 bit samples, keeping the most significant bits.
+ *
+ * @param input The 32 bit samples.
+ * @param output The 16 bit samples.
+ * @param count The number of samples.
+ */
+void convertS32ToS16(const int32_t* input, int16_t* output, size_t count);
+
+/**
+ * Convert 16 bit samples to float samples in [-1, 1).
+ *
+ * @param input The 16 bit samples.
+ * @param output The float samples.
+ * @param count The number of samples.
+ */
+void convertS16ToF32(const int16_t* input, float* output, size_t count);
+
+/**
+ * Convert float samples to 16 bit samples, rounding to the nearest and clipping outside [-1, 1).
+ *
+ * @param input The float samples.
+ * @param output The 16 bit samples.
+ * @param count The number of samples.
+ */
+void convertF32ToS16(const float* input, int16_t* output, size_t count);
+
+/**
+ * Convert 32 bit samples to float samples in [-1, 1).
+ *
+ * @param input The 32 bit samples.
+ * @param output The float samples.
+ * @param count The number of samples.
+ */
+void convertS32ToF32(const int32_t* input, float* output, size_t count);
+
+/**
+ * Convert float samples to 32 bit samples, rounding to the nearest and clipping outside [-1, 1).
+ *
+ * @param input The float samples.
+ * @param output The 32 bit samples.
+ * @param count The number of samples.
+ */
+void convertF32ToS32(const float* input, int32_t* output, size_t count);
+
+/**
+ * Duplicate mono 16 bit samples to interleaved stereo.
+ *
+ * @param input The mono samples.
+ * @param output The stereo samples, twice the size of @c input.
+ * @param frames The number of mono samples.
+ */
+void monoToStereo16(const int16_t* input, int16_t* output, size_t frames);
+
+/**
+ * Average interleaved stereo 16 bit samples to mono, rounding down.
+ *
+ * @param input The stereo samples.
+ * @param output The mono samples, half the size of @c input.
+ * @param frames The number of stereo frames.
+ */
+void stereoToMono16(const int16_t* input, int16_t* output, size_t frames);
+
+/**
+ * Swap the bytes of 16 bit samples, to convert them to the other endianness.
+ *
+ * @param input The samples.
+ * @param output The swapped samples.
+ * @param count The number of samples.
+ */
+void byteSwap16(const uint8_t* input, uint8_t* output, size_t count);
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __PCM_KERNELS_H_
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __PCM_RING_BUFFER_H_
+#define __PCM_RING_BUFFER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/**
+ * A lock-free ring of decoded PCM bytes between one producer thread and one consumer thread.
+ *
+ * @c write() must only be called by the producer and @c read() only by the consumer; @c size() and @c freeSpace()
+ * may be called by any thread.  Neither side ever blocks: they move as many bytes as fit or are available.
+ */
+class PcmRingBuffer {
+public:
+    /**
+     * Constructor.
+     *
+     * @param capacity The number of bytes the ring can hold.
+     */
+    explicit PcmRingBuffer(size_t capacity);
+
+    /**
+     * Append bytes to the ring.  Producer only.
+     *
+     * @param data The bytes to append.
+     * @param size The number of bytes to append.
+     * @return The number of bytes appended, less than @c size if the ring is full.
+     */
+    size_t write(const uint8_t* data, size_t size);
+
+    /**
+     * Get the free space after the last written byte which is contiguous in memory, so that the producer can write
+     * into the ring in place and then @c commit() what it wrote.  Producer only.
+     *
+     * @param[out] size Set to the number of bytes which can be written at the returned address.
+     * @return The address to write at.
+     */
+    uint8_t* reserve(size_t* size);
+
+    /**
+     * Make bytes written in place after @c reserve() available to the consumer.  Producer only.
+     *
+     * @param size The number of bytes written, at most the size returned by @c reserve().
+     */
+    void commit(size_t size);
+
+    /**
+     * Take bytes out of the ring.  Consumer only.
+     *
+     * @param data The buffer to copy the bytes to.
+     * @param size The number of bytes wanted.
+     * @return The number of bytes copied, less than @c size if the ring holds fewer.
+     */
+    size_t read(uint8_t* data, size_t size);
+
+    /**
+     * Get the number of bytes which can be read.
+     *
+     * @return The number of bytes which can be read.
+     */
+    size_t size() const;
+
+    /**
+     * Get the number of bytes which can be written.
+     *
+     * @return The number of bytes which can be written.
+     */
+    size_t freeSpace() const;
+
+    /**
+     * Get the number of bytes the ring can hold.
+     *
+     * @return The capacity of the ring.
+     */
+    size_t capacity() const;
+
+    /// Empty the ring.  Must only be called while neither the producer nor the consumer is using it.
+    void clear();
+
+private:
+    /// The storage of the ring.
+    std::vector<uint8_t> m_buffer;
+
+    /// The total number of bytes written, only modified by the producer.
+    std::atomic<uint64_t> m_writeIndex;
+
+    /// Keeps the indexes on separate cache lines, so that the producer and the consumer do not contend.
+    char m_padding[64 - sizeof(std::atomic<uint64_t>)];
+
+    /// The total number of bytes read, only modified by the consumer.
+    std::atomic<uint64_t> m_readIndex;
+};
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __PCM_RING_BUFFER_H_
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __PROBE_CONFIGURATION_H_
+#define __PROBE_CONFIGURATION_H_
+
+#include <chrono>
+#include <cstdint>
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/**
+ * How much of an input @c FFmpegDecoder lets FFmpeg read to detect the format and the stream parameters before the
+ * first frame is decoded.
+ *
+ * By default the decoder starts fast: FFmpeg probes at most 16KB and analyzes at most 200ms of the input, and the
+ * stream analysis is skipped altogether when the codec parameters are already known once the input is opened, as for
+ * raw PCM.  Without fast start FFmpeg uses its own limits, which are meant for files with many streams and cost
+ * hundreds of milliseconds on a network stream.
+ */
+class ProbeConfiguration {
+public:
+    /**
+     * Constructor.
+     *
+     * @param fastStart Whether the probing is limited to @c probeSize and @c analyzeDuration.
+     * @param probeSize The maximum number of bytes probed in fast start.
+     * @param analyzeDuration The maximum duration of input analyzed in fast start.
+     */
+    ProbeConfiguration(
+        bool fastStart = true,
+        int64_t probeSize = 16384,
+        std::chrono::milliseconds analyzeDuration = std::chrono::milliseconds(200)) :
+            m_isFastStart{fastStart},
+            m_probeSize{probeSize},
+            m_analyzeDuration{analyzeDuration} {
+    }
+
+    /**
+     * Get whether the probing is limited.
+     *
+     * @return @c true in fast start; @c false if FFmpeg uses its own limits.
+     */
+    bool isFastStart() const {
+        return m_isFastStart;
+    }
+
+    /**
+     * Get the maximum number of bytes probed in fast start.
+     *
+     * @return The probe size in bytes.
+     */
+    int64_t probeSize() const {
+        return m_probeSize;
+    }
+
+    /**
+     * Get the maximum duration of input analyzed in fast start.
+     *
+     * @return The analyze duration.
+     */
+    std::chrono::milliseconds analyzeDuration() const {
+        return m_analyzeDuration;
+    }
+
+private:
+    /// Whether the probing is limited.
+    bool m_isFastStart;
+
+    /// The maximum number of bytes probed in fast start.
+    int64_t m_probeSize;
+
+    /// The maximum duration of input analyzed in fast start.
+    std::chrono::milliseconds m_analyzeDuration;
+};
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __PROBE_CONFIGURATION_H_
@@ -0,0 +1,347 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef __URL_CACHE_H_
+#define __URL_CACHE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <Utils/Metrics/Counter.h>
+#include <Utils/Metrics/Gauge.h>
+#include <Utils/Metrics/Histogram.h>
+
+struct AVIOContext;
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/**
+ * A bounded on-disk cache of the content of http urls, which @c FFmpegUrlInputController reads through so that
+ * replays and backward seeks of a song or a prompt are served from disk instead of the network.
+ *
+ * The content of a url is fetched in order by a background fetcher, which stays at most @c maxPrefetchBytes ahead of
+ * the furthest read and stops when the url has no reader left; a later read resumes the fetch where it stopped.  A read
+ * far past the fetched content, like the demuxer looking for tags at the end of the file when it opens it, does not
+ * wait for the fetcher to get there: the reader gets it from the network with a range request of its own, which is
+ * not cached.
+ * Each url is stored as a data file holding the fetched part of the content and a meta file holding the url, its
+ * validators and how much of it was fetched, so the cache survives a restart.  Content older than @c maxAge is
+ * validated again before it is read: FFmpeg's http protocol gives no entity tag, so the size and the content type of
+ * the response are the validators, and a change drops the stored content.  When the cache is over its budget the
+ * least recently opened urls which are not read or fetched are evicted.
+ *
+ * Content whose size the server does not give, like a live stream, is not cached: @c open() returns @c nullptr and
+ * the url is played from the network as before.
+ */
+class UrlCache : public std::enable_shared_from_this<UrlCache> {
+public:
+    class Reader;
+
+    /// The bytes a fetcher reads ahead of the furthest reader of a url, unless given to @c create().
+    static constexpr uint64_t DEFAULT_MAX_PREFETCH_BYTES = 8 * 1024 * 1024;
+
+    /// How long cached content is used before it is validated again, unless given to @c create().
+    static constexpr std::chrono::seconds DEFAULT_MAX_AGE{24 * 60 * 60};
+
+    /**
+     * Create a cache, and load the content cached in the directory by a previous run.
+     *
+     * @param directory The directory the content is stored in, which is created if it does not exist.
+     * @param maxBytes The most content the cache keeps on disk.
+     * @param maxPrefetchBytes The bytes fetched ahead of the furthest reader of a url.
+     * @param maxAge How long cached content is used before it is validated again.
+     * @return The new cache, or @c nullptr if the directory cannot be used or a size is 0.
+     */
+    static std::shared_ptr<UrlCache> create(
+        const std::string& directory,
+        uint64_t maxBytes,
+        uint64_t maxPrefetchBytes = DEFAULT_MAX_PREFETCH_BYTES,
+        std::chrono::seconds maxAge = DEFAULT_MAX_AGE);
+
+    /**
+     * Check whether the content of a url can be cached, which is the case of http and https urls which are not
+     * playlists.
+     *
+     * @param url The url.
+     * @return Whether @c open() may cache the url.
+     */
+    static bool isCacheable(const std::string& url);
+
+    /**
+     * Open the content of a url, from the disk if it is cached and fresh, and start fetching what is missing.
+     *
+     * The call blocks until the fetcher has opened the url when its content has to be validated first.
+     *
+     * @param url The url.
+     * @param shouldInterrupt Tells a blocked call or read of the reader to give up, or an empty function.
+     * @return A reader at the start of the content, or @c nullptr if the url is not cached and has to be read from
+     * the network directly: it is not cacheable, the server did not give its size, it cannot be opened, or the call
+     * was interrupted.
+     */
+    std::shared_ptr<Reader> open(const std::string& url, std::function<bool()> shouldInterrupt);
+
+    /**
+     * Get the validators of the content of a url, as last checked with the server, without contacting it.
+     *
+     * @param url The url.
+     * @param[out] totalBytes The size of the content.
+     * @param[out] mimeType The content type of the content.
+     * @return Whether the url is cached and its validators were checked within the max age.
+     */
+    bool getValidators(const std::string& url, int64_t* totalBytes, std::string* mimeType);
+
+    /**
+     * Get the size of the content on disk.
+     *
+     * @return The number of bytes cached.
+     */
+    uint64_t getSizeBytes();
+
+    /**
+     * Stop the fetchers.  Readers can still read what was fetched, and @c open() returns @c nullptr from now on.
+     */
+    void shutdown();
+
+    /// Destructor.
+    ~UrlCache();
+
+private:
+    /// The cached content of one url, defined in the implementation.
+    struct Entry;
+
+    /**
+     * Constructor.
+     *
+     * @param directory The directory the content is stored in.
+     * @param maxBytes The most content the cache keeps on disk.
+     * @param maxPrefetchBytes The bytes fetched ahead of the furthest reader of a url.
+     * @param maxAge How long cached content is used before it is validated again.
+     */
+    UrlCache(
+        const std::string& directory,
+        uint64_t maxBytes,
+        uint64_t maxPrefetchBytes,
+        std::chrono::seconds maxAge);
+
+    /**
+     * Load the entries of the meta files in the directory.
+     *
+     * @return Whether the directory could be read.
+     */
+    bool load();
+
+    /**
+     * Start the fetcher of an entry, unless it is running.  @c Entry::mutex must be held.
+     *
+     * @param entry The entry.
+     */
+    void startFetcherLocked(std::shared_ptr<Entry> entry);
+
+    /**
+     * The loop of the fetcher of an entry: validate the content of the url and fetch it to the data file.
+     *
+     * @param entry The entry.
+     */
+    void fetchLoop(std::shared_ptr<Entry> entry);
+
+    /**
+     * Forget an entry whose content cannot be cached, and remove its files.
+     *
+     * @param entry The entry.
+     */
+    void dropUncacheable(std::shared_ptr<Entry> entry);
+
+    /**
+     * Forget an entry whose url could not be opened, of which nothing is cached, so that the next open of the url
+     * tries again with a new entry.
+     *
+     * @param entry The entry.
+     */
+    void dropFailed(std::shared_ptr<Entry> entry);
+
+    /**
+     * Account bytes added to or removed from the disk, and evict entries if the cache is over its budget.
+     *
+     * @param delta The bytes added, or removed if negative.
+     */
+    void addSizeBytes(int64_t delta);
+
+    /**
+     * Evict the least recently opened entries which are not in use until the cache fits its budget.  @c m_mutex must
+     * be held.
+     */
+    void evictLocked();
+
+    /**
+     * Get the path of a file of an entry.
+     *
+     * @param key The key of the entry.
+     * @param extension The extension of the file.
+     * @return The path.
+     */
+    std::string pathOf(const std::string& key, const std::string& extension) const;
+
+    /// The directory the content is stored in.
+    const std::string m_directory;
+
+    /// The most content the cache keeps on disk.
+    const uint64_t m_maxBytes;
+
+    /// The bytes fetched ahead of the furthest reader of a url.
+    const uint64_t m_maxPrefetchBytes;
+
+    /// How long cached content is used before it is validated again.
+    const std::chrono::seconds m_maxAge;
+
+    /// Serializes the members below.  Taken before the mutex of an entry when both are held.
+    std::mutex m_mutex;
+
+    /// The entries by key.
+    std::unordered_map<std::string, std::shared_ptr<Entry>> m_entries;
+
+    /// The urls whose content was found not to be cacheable in this run.
+    std::unordered_set<std::string> m_uncacheableUrls;
+
+    /// The bytes on disk.
+    uint64_t m_sizeBytes;
+
+    /// The last value given to @c Entry::lastUse, which orders the entries from the least recently opened.
+    uint64_t m_useCount;
+
+    /// Whether @c shutdown() was called.
+    std::atomic<bool> m_isShutdown;
+
+    /// Opens which found the content cached and fresh.
+    std::shared_ptr<utils::metrics::Counter> m_hitCounter;
+
+    /// Opens which found a part of the content cached, or the content to be validated again.
+    std::shared_ptr<utils::metrics::Counter> m_partialCounter;
+
+    /// Opens which found nothing cached.
+    std::shared_ptr<utils::metrics::Counter> m_missCounter;
+
+    /// Opens of urls which cannot be cached.
+    std::shared_ptr<utils::metrics::Counter> m_uncacheableCounter;
+
+    /// Reads served from disk without waiting.
+    std::shared_ptr<utils::metrics::Counter> m_readyReadCounter;
+
+    /// Reads which waited for the fetcher.
+    std::shared_ptr<utils::metrics::Counter> m_waitedReadCounter;
+
+    /// Reads served by a range request, far past the fetched content.
+    std::shared_ptr<utils::metrics::Counter> m_rangeReadCounter;
+
+    /// The content fetched ahead of the reader after each read, in kilobytes.
+    std::shared_ptr<utils::metrics::Histogram> m_prefetchDepthHistogram;
+
+    /// The bytes on disk.
+    std::shared_ptr<utils::metrics::Gauge> m_sizeGauge;
+};
+
+/**
+ * Reads the content of one url from a @c UrlCache, waiting for the fetcher when the content is not on disk yet, or
+ * reading it from the network when it is far past what was fetched.  The functions follow the FFmpeg AVIO callbacks,
+ * so that they can back an @c AVIOContext.
+ */
+class UrlCache::Reader {
+public:
+    /**
+     * Read the content at the position of the reader.
+     *
+     * @param buffer The buffer the content is copied to.
+     * @param size The size of the buffer.
+     * @return The number of bytes read, @c AVERROR_EOF at the end of the content, @c AVERROR_EXIT if interrupted, or
+     * another negative FFmpeg error.
+     */
+    int read(uint8_t* buffer, int size);
+
+    /**
+     * Move the position of the reader.
+     *
+     * @param offset The offset.
+     * @param whence @c SEEK_SET, @c SEEK_CUR or @c SEEK_END, or @c AVSEEK_SIZE to get the size of the content.
+     * @return The new position, the size for @c AVSEEK_SIZE, or a negative FFmpeg error.
+     */
+    int64_t seek(int64_t offset, int whence);
+
+    /// Destructor.  The fetcher stops when the url has no reader left.
+    ~Reader();
+
+private:
+    friend class UrlCache;
+
+    /**
+     * Constructor.
+     *
+     * @param cache The cache.
+     * @param entry The entry to read.
+     * @param shouldInterrupt Tells a blocked read to give up.
+     */
+    Reader(std::shared_ptr<UrlCache> cache, std::shared_ptr<Entry> entry, std::function<bool()> shouldInterrupt);
+
+    /**
+     * Check whether a blocked read should give up.
+     *
+     * @return Whether the reader was interrupted.
+     */
+    bool isInterrupted() const;
+
+    /**
+     * Read the content at the position of the reader from the network, opening the url at the position with a range
+     * request if it is not open there yet.
+     *
+     * @param buffer The buffer the content is copied to.
+     * @param size The size of the buffer.
+     * @return The number of bytes read, or a negative FFmpeg error.
+     */
+    int readRange(uint8_t* buffer, int size);
+
+    /// Close the url opened by @c readRange(), if any.
+    void closeRange();
+
+    /// The cache.
+    std::shared_ptr<UrlCache> m_cache;
+
+    /// The entry to read.
+    std::shared_ptr<Entry> m_entry;
+
+    /// Tells a blocked read to give up.
+    std::function<bool()> m_shouldInterrupt;
+
+    /// The data file of the entry, opened for reading, or -1.
+    int m_fd;
+
+    /// The position of the reader in the content.
+    int64_t m_position;
+
+    /// The url opened by @c readRange(), or @c nullptr.
+    AVIOContext* m_rangeContext;
+
+    /// The position of @c m_rangeContext in the content.
+    int64_t m_rangePosition;
+};
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
+
+#endif  // __URL_CACHE_H_
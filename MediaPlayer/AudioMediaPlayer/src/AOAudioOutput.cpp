@@ -0,0 +1,98 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <cstring>
+
+#include <Utils/Logging/Logger.h>
+
+#include "AudioMediaPlayer/AOAudioOutput.h"
+#include "AudioMediaPlayer/AudioOutputDeleter.h"
+
+/// String to identify log entries originating from this file.
+static const std::string TAG("AOAudioOutput");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/**
+ * Describes the format of audio samples @c ao_sample_format.
+ * It will convert the appropriate bits and channels according to config @c PlaybackConfiguration.
+*/
+static int convertBitsPreSample(PlaybackConfiguration::SampleFormat format) {
+	switch (format) {
+		case PlaybackConfiguration::SampleFormat::UNSIGNED_8:
+			return 8;
+		case PlaybackConfiguration::SampleFormat::SIGNED_16:
+			return 16;
+		case PlaybackConfiguration::SampleFormat::SIGNED_32:
+			return 32;
+	}
+
+	AISDK_WARN(LX("invalidFormat").d("format", static_cast<int>(format)));
+	return 16;
+}
+
+std::unique_ptr<AOAudioOutput> AOAudioOutput::create(
+    std::shared_ptr<AOEngine> aoEngine,
+    const PlaybackConfiguration& config) {
+    if (!aoEngine) {
+        AISDK_ERROR(LX("createFailed").d("reason", "aoEngineIsNullptr"));
+        return nullptr;
+    }
+
+    ao_sample_format format;
+    // Bzero the structs @c ao_sample_format.
+    std::memset(&format, 0, sizeof format);
+    format.bits = convertBitsPreSample(config.sampleFormat());
+    format.channels = config.numberChannels();
+    format.rate = config.sampleRate();
+    format.byte_format = (config.isLittleEndian() ? AO_FMT_LITTLE : AO_FMT_BIG);
+
+    auto device = ao_open_live(aoEngine->getDefaultDriver(), &format, NULL);
+    if (device == NULL) {
+        AISDK_ERROR(LX("createFailed").d("reason", "ErrorOpeningDevice"));
+        return nullptr;
+    }
+
+    return std::unique_ptr<AOAudioOutput>(
+        new AOAudioOutput(aoEngine, config, std::shared_ptr<ao_device>(device, AOOpenLiveDeleter())));
+}
+
+AOAudioOutput::AOAudioOutput(
+    std::shared_ptr<AOEngine> aoEngine,
+    const PlaybackConfiguration& config,
+    std::shared_ptr<ao_device> device) :
+        m_engine{aoEngine},
+        m_config{config},
+        m_device{device} {
+}
+
+bool AOAudioOutput::write(const uint8_t* data, size_t size) {
+    // libao takes a non-const buffer, though it does not write to it.
+    return ao_play(m_device.get(), reinterpret_cast<char*>(const_cast<uint8_t*>(data)), size) != 0;
+}
+
+PlaybackConfiguration AOAudioOutput::getConfiguration() const {
+    return m_config;
+}
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
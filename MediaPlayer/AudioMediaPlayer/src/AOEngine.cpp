@@ -10,10 +10,20 @@
  * express or implied. See the License for the specific language governing
  * permissions and limitations under the License.
  */
-#include <iostream>
 #include <ao/ao.h> 
+#include <Utils/Logging/Logger.h>
 #include "AudioMediaPlayer/AOEngine.h"
 
+/// String to identify log entries originating from this file.
+static const std::string TAG("AOEngine");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
 
 namespace aisdk {
 namespace mediaPlayer {
@@ -30,7 +40,7 @@ std::shared_ptr<AOEngine> AOEngine::create() {
 		// Setup for default driver.
 		int default_driver = ao_default_driver_id();
 		if(default_driver < 0) {
-			std::cout << "createFailed:reason=setupForDefaultDriverFailed." << std::endl;
+			AISDK_ERROR(LX("createFailed").d("reason", "setupForDefaultDriverFailed"));
 			return nullptr;
 		}
 		
@@ -9,21 +9,31 @@
  * express or implied. See the License for the specific language governing
  * permissions and limitations under the License.
  */
-// memset references
-#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <vector>
 
 extern "C" {
 #include <libavformat/avformat.h>
 }
 
+#include <Utils/Introspection/IntrospectionServer.h>
 #include <Utils/Logging/Logger.h>
+#include <Utils/Logging/ThreadMoniker.h>
 #include <Utils/MediaPlayer/MediaPlayerObserverInterface.h>
+#include <Utils/Metrics/MetricsRegistry.h>
+#include <Utils/Tracing/DialogTurnTracer.h>
+#include <Utils/Tracing/TraceEventRecorder.h>
 #include "AudioMediaPlayer/FFmpegUrlInputController.h"
+#include "AudioMediaPlayer/FFmpegLocalFileInputController.h"
 #include "AudioMediaPlayer/FFmpegStreamInputController.h"
 #include "AudioMediaPlayer/FFmpegAttachmentInputController.h"
+#include "AudioMediaPlayer/MediaUrl.h"
 //#include "AudioMediaPlayer/FFmpegDecoder.h"
+#include "AudioMediaPlayer/AOAudioOutput.h"
 #include "AudioMediaPlayer/AOWrapper.h"
-#include "AudioMediaPlayer/AudioOutputDeleter.h"
+#include "AudioMediaPlayer/PcmDecoder.h"
 
 /// String to identify log entries originating from this file.
 static const std::string TAG{"AOWrapper"};
@@ -36,45 +46,141 @@ static constexpr size_t BUFFER_SIZE{16384u};	// 32768
 namespace aisdk {
 namespace mediaPlayer {
 namespace ffmpeg {
+
+constexpr std::chrono::milliseconds AOWrapper::DEFAULT_PREBUFFER_TARGET;
+
+/// The audio handed to the device at once, which bounds the latency of pause and stop.
+static const std::chrono::milliseconds OUTPUT_PERIOD{20};
+
+/// The audio faded out when the playback pauses or stops, which is not played again on resume.
+static const std::chrono::milliseconds FADE_DURATION{10};
+
+/// The highest volume of a source.
+static constexpr float MAX_VOLUME = 8.0f;
+
+/// The audio the ring holds, on top of the prebuffer target.
+static const std::chrono::milliseconds RING_BUFFER_DURATION{1000};
+
+/// How long a thread waiting on the ring sleeps before looking at it again, in case the other side did not wake it.
+static const std::chrono::milliseconds RING_WAIT_INTERVAL{10};
+
+/// The longest silence between two sources which is still measured as a gap between tracks.
+static const std::chrono::seconds MAX_TRACK_GAP{5};
+
+/// The value of @c m_nextSwitchByte when no prepared source follows the current one in the ring.
+static const uint64_t NO_TRACK_SWITCH = std::numeric_limits<uint64_t>::max();
+
 /**
- * Describes the format of audio samples @c ao_sample_format.
- * It will convert the appropriate bits and channels according to config @c PlaybackConfiguration.
-*/
-static int convertBitsPreSample(PlaybackConfiguration::SampleFormat format) {
-	switch (format) {
-		case PlaybackConfiguration::SampleFormat::UNSIGNED_8:
-			return 8;
-		case PlaybackConfiguration::SampleFormat::SIGNED_16:
-			return 16;
-		case PlaybackConfiguration::SampleFormat::SIGNED_32:
-			return 32;
-	}
+ * Convert a duration of audio to a number of bytes in the output format.
+ *
+ * @param config The output format.
+ * @param duration The duration.
+ * @return The number of bytes of @c duration of audio, in whole frames.
+ */
+static size_t durationToBytes(const PlaybackConfiguration& config, std::chrono::milliseconds duration) {
+	auto frames = config.sampleRate() * static_cast<size_t>(duration.count()) / 1000;
+	return frames * config.sampleSizeBytes() * config.numberChannels();
+}
 
-	AISDK_WARN(LX("invalidFormat").d("format", static_cast<int>(format)));
-	return 16;
+/// Convert an @c AOPlayerState to the name of the state.
+static const char* playerStateToString(AOWrapper::AOPlayerState state) {
+	switch (state) {
+		case AOWrapper::AOPlayerState::IDLE:
+			return "IDLE";
+		case AOWrapper::AOPlayerState::OPENED:
+			return "OPENED";
+		case AOWrapper::AOPlayerState::PLAYING:
+			return "PLAYING";
+		case AOWrapper::AOPlayerState::PAUSED:
+			return "PAUSED";
+		case AOWrapper::AOPlayerState::FINISHED:
+			return "FINISHED";
+	}
+	return "UNKNOWN";
 }
 
 std::unique_ptr<AOWrapper> AOWrapper::create(
 	std::shared_ptr<AOEngine> aoEngine,
-	const PlaybackConfiguration& config){
+	const PlaybackConfiguration& config,
+	const std::string& name,
+	const Options& options){
 	if(!aoEngine) {
 		AISDK_ERROR(LX("createFailed").d("reason", "aoEngineIsNullptr"));
 		return nullptr;
 	}
-	
-	auto player = std::unique_ptr<AOWrapper>(
-			new AOWrapper(aoEngine, config));
-	if(!player->initialize()){
-		AISDK_ERROR(LX("createFailed").d("reason", "initializeFailedAOWrapper"));
+
+	std::shared_ptr<AudioOutputInterface> output = AOAudioOutput::create(aoEngine, config);
+	if(!output) {
+		AISDK_ERROR(LX("createFailed").d("reason", "openDeviceFailed"));
+		return nullptr;
+	}
+
+	return create(output, name, options);
+}
+
+std::unique_ptr<AOWrapper> AOWrapper::create(
+	std::shared_ptr<AudioOutputInterface> output,
+	const std::string& name,
+	const Options& options){
+	if(!output) {
+		AISDK_ERROR(LX("createFailed").d("reason", "outputIsNullptr"));
+		return nullptr;
+	}
+	if(options.prebufferTarget < std::chrono::milliseconds::zero()) {
+		AISDK_ERROR(LX("createFailed").d("reason", "negativePrebufferTarget")
+			.d("prebufferMs", options.prebufferTarget.count()));
 		return nullptr;
 	}
 
-	return player;
+	return std::unique_ptr<AOWrapper>(new AOWrapper(output, name, options));
+}
+
+std::shared_ptr<DecoderInterface> AOWrapper::createDecoder(const std::string& url, std::chrono::milliseconds offset) {
+	bool isCacheable = m_pcmCache && PcmCache::isCacheable(url, offset);
+	if(isCacheable) {
+		// A sound played before is copied from its recording, without opening, probing and decoding it again.
+		auto decoder = m_pcmCache->createDecoder(url, m_config);
+		if(decoder) {
+			return decoder;
+		}
+	}
+
+	std::unique_ptr<FFmpegInputControllerInterface> input;
+	std::string path;
+	if(FFmpegLocalFileInputController::getLocalPath(url, &path) && !isPlaylistUrl(url)) {
+		// A local file is read by its own controller rather than through the file protocol; on failure it is opened as
+		// a url.  The files played are not the SDK's: another process may truncate them, so they are not mapped.
+		input = FFmpegLocalFileInputController::create(path, offset);
+	}
+	if(!input) {
+		std::shared_ptr<utils::playlistParser::IterativePlaylistParserInterface> playlistParser;
+		if(m_playlistParserFactory && isPlaylistUrl(url)) {
+			playlistParser = m_playlistParserFactory();
+		}
+		input = FFmpegUrlInputController::create(url, offset, m_urlCache, playlistParser);
+	}
+	std::shared_ptr<DecoderInterface> decoder = FFmpegDecoder::create(std::move(input), m_config, true, m_probeConfig, m_contextPool);
+	return isCacheable ? m_pcmCache->record(url, m_config, decoder) : decoder;
+}
+
+std::shared_ptr<DecoderInterface> AOWrapper::createDecoder(std::shared_ptr<std::istream> stream, bool repeat) {
+	auto input = FFmpegStreamInputController::create(stream, repeat);
+	return FFmpegDecoder::create(std::move(input), m_config, true, m_probeConfig, m_contextPool);
+}
+
+std::shared_ptr<DecoderInterface> AOWrapper::createDecoder(
+	std::shared_ptr<utils::attachment::AttachmentReader> attachmentReader,
+	const utils::AudioFormat* format) {
+	if(format && PcmDecoder::isSupported(*format, m_config)) {
+		// Raw PCM which only needs its samples converted is played without probing and decoding it with FFmpeg.
+		return PcmDecoder::create(attachmentReader, *format, m_config);
+	}
+	auto input = FFmpegAttachmentInputController::create(attachmentReader, format);
+	return FFmpegDecoder::create(std::move(input), m_config, true, m_probeConfig, m_contextPool);
 }
 
 AOWrapper::SourceId AOWrapper::setSource(const std::string& url, std::chrono::milliseconds offset){
-	auto input = FFmpegUrlInputController::create(url, offset);
-	auto newID = configureNewRequest(std::move(input), offset);
+	auto newID = configureNewRequest(createDecoder(url, offset), offset);
 	if(utils::mediaPlayer::MediaPlayerInterface::ERROR == newID){
 		AISDK_DEBUG5(LX("setSourceFailed").d("type", "url").d("offset(ms)", offset.count()));
 	}
@@ -83,8 +189,7 @@ AOWrapper::SourceId AOWrapper::setSource(const std::string& url, std::chrono::mi
 }
 
 AOWrapper::SourceId AOWrapper::setSource(std::shared_ptr<std::istream> stream, bool repeat){	
-	auto input = FFmpegStreamInputController::create(stream, repeat);
-	auto newID = configureNewRequest(std::move(input));
+	auto newID = configureNewRequest(createDecoder(stream, repeat));
 	if(utils::mediaPlayer::MediaPlayerInterface::ERROR == newID){
 		AISDK_DEBUG5(LX("setSourceFailed").d("type", "istream").d("repeat", repeat));
 	}
@@ -95,8 +200,8 @@ AOWrapper::SourceId AOWrapper::setSource(std::shared_ptr<std::istream> stream, b
 AOWrapper::SourceId AOWrapper::setSource(
     std::shared_ptr<utils::attachment::AttachmentReader> attachmentReader,
     const utils::AudioFormat* format) {
-	auto input = FFmpegAttachmentInputController::create(attachmentReader, format);
-	auto newID = configureNewRequest(std::move(input));
+	// Attachments carry the TTS answer, so their playback ends the current dialog turn.
+	auto newID = configureNewRequest(createDecoder(attachmentReader, format), std::chrono::milliseconds(0), true);
 	if(utils::mediaPlayer::MediaPlayerInterface::ERROR == newID){
 		AISDK_DEBUG5(LX("setSourceFailed").d("type", "attachment").d("format", format));
 	}
@@ -104,6 +209,35 @@ AOWrapper::SourceId AOWrapper::setSource(
 	return newID;
 }
 
+AOWrapper::SourceId AOWrapper::prepareNext(const std::string& url, std::chrono::milliseconds offset) {
+	auto newID = configureNextRequest(createDecoder(url, offset), offset, false);
+	if(utils::mediaPlayer::MediaPlayerInterface::ERROR == newID){
+		AISDK_DEBUG5(LX("prepareNextFailed").d("type", "url").d("offset(ms)", offset.count()));
+	}
+
+	return newID;
+}
+
+AOWrapper::SourceId AOWrapper::prepareNext(std::shared_ptr<std::istream> stream, bool repeat) {
+	auto newID = configureNextRequest(createDecoder(stream, repeat), std::chrono::milliseconds(0), false);
+	if(utils::mediaPlayer::MediaPlayerInterface::ERROR == newID){
+		AISDK_DEBUG5(LX("prepareNextFailed").d("type", "istream").d("repeat", repeat));
+	}
+
+	return newID;
+}
+
+AOWrapper::SourceId AOWrapper::prepareNext(
+	std::shared_ptr<utils::attachment::AttachmentReader> attachmentReader,
+	const utils::AudioFormat* format) {
+	auto newID = configureNextRequest(createDecoder(attachmentReader, format), std::chrono::milliseconds(0), true);
+	if(utils::mediaPlayer::MediaPlayerInterface::ERROR == newID){
+		AISDK_DEBUG5(LX("prepareNextFailed").d("type", "attachment").d("format", format));
+	}
+
+	return newID;
+}
+
 bool AOWrapper::play(SourceId id)
 {
 	AISDK_DEBUG2(LX(__func__).d("requestId", id));
@@ -116,6 +250,9 @@ bool AOWrapper::play(SourceId id)
 		m_state = AOPlayerState::PLAYING;
 		AISDK_DEBUG2(LX("PLAY").d("reason", "startPlaySuccess"));
 		m_playerWaitCondition.notify_one();
+		if(m_traceDialogTurn) {
+			utils::tracing::DialogTurnTracer::instance().mark(utils::tracing::DialogTurnTracer::Stage::PLAY_STARTED);
+		}
 
 		if (m_observer) {
             m_observer->onPlaybackStarted(m_sourceId);
@@ -131,6 +268,15 @@ bool AOWrapper::play(SourceId id)
 
 bool AOWrapper::stopLocked(){
 
+	// A stopped source is not followed by anything, and cutting it short is not a track change.  A source which played
+	// to its end keeps its end time, so that the gap before a source set after it is measured as well.
+	discardNextSourceLocked();
+	m_trackSwitches.clear();
+	m_nextSwitchByte = NO_TRACK_SWITCH;
+	if(AOPlayerState::FINISHED != m_state && AOPlayerState::IDLE != m_state) {
+		m_trackEndTime = 0;
+	}
+
 	if(m_state != AOWrapper::AOPlayerState::IDLE) {
 		m_state = AOWrapper::AOPlayerState::FINISHED;
 		if(m_decoder)
@@ -138,6 +284,7 @@ bool AOWrapper::stopLocked(){
 		m_decoder.reset();
 		AISDK_DEBUG2(LX("stopLocked").d("reason", "startStopSuccess"));
 		m_playerWaitCondition.notify_one();
+		m_decodeWaitCondition.notify_one();
 		
 		if (m_observer) {
             m_observer->onPlaybackStopped(m_sourceId);
@@ -151,6 +298,39 @@ bool AOWrapper::stopLocked(){
 	return false;
 }
 
+bool AOWrapper::setVolume(SourceId id, float volume)
+{
+	AISDK_DEBUG2(LX(__func__).d("requestId", id).d("volume", volume));
+	if(!(volume >= 0.0f && volume <= MAX_VOLUME)) {
+		AISDK_ERROR(LX("setVolumeFailed").d("reason", "volumeOutOfRange").d("volume", volume));
+		return false;
+	}
+	if(PlaybackConfiguration::SampleFormat::UNSIGNED_8 == m_config.sampleFormat()) {
+		AISDK_ERROR(LX("setVolumeFailed").d("reason", "unsupportedSampleFormat"));
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock{m_operationMutex};
+	if(id == m_sourceId) {
+		m_volume = volume;
+		return true;
+	}
+	if(m_nextSource && id == m_nextSource->id) {
+		m_nextSource->volume = volume;
+		return true;
+	}
+	// A prepared source may already be in the ring, behind the current one.
+	for(auto& trackSwitch : m_trackSwitches) {
+		if(id == trackSwitch.source->id) {
+			trackSwitch.source->volume = volume;
+			return true;
+		}
+	}
+
+	AISDK_ERROR(LX("setVolumeFailed").d("reason", "Invalid Id").d("RequestId", id).d("currentId", m_sourceId.load()));
+	return false;
+}
+
 bool AOWrapper::stop(SourceId id)
 {
 	AISDK_DEBUG2(LX(__func__).d("requestId", id));
@@ -158,7 +338,15 @@ bool AOWrapper::stop(SourceId id)
 	if (id == m_sourceId)
 		return stopLocked();
 
-	AISDK_ERROR(LX("stopFailed").d("reason", "Invalid Id").d("RequestId", id).d("currentId", m_sourceId));
+	if (m_nextSource && id == m_nextSource->id) {
+		discardNextSourceLocked();
+		if (m_observer) {
+			m_observer->onPlaybackStopped(id);
+		}
+		return true;
+	}
+
+	AISDK_ERROR(LX("stopFailed").d("reason", "Invalid Id").d("RequestId", id).d("currentId", m_sourceId.load()));
 		
 	return false;
 }
@@ -215,10 +403,11 @@ void AOWrapper::setObserver(std::shared_ptr<utils::mediaPlayer::MediaPlayerObser
 }
 
 int AOWrapper::configureNewRequest(
-	std::unique_ptr<FFmpegInputControllerInterface> inputController,
-	std::chrono::milliseconds offset){
-	if(!inputController) {
-		AISDK_ERROR(LX("configureNewRequestFailed").d("reason", "inputControllerIsNullptr"));
+	std::shared_ptr<DecoderInterface> decoder,
+	std::chrono::milliseconds offset,
+	bool traceDialogTurn){
+	if(!decoder) {
+		AISDK_ERROR(LX("configureNewRequestFailed").d("reason", "decoderIsNullptr"));
 		return utils::mediaPlayer::MediaPlayerInterface::ERROR;
 	}
 
@@ -226,16 +415,16 @@ int AOWrapper::configureNewRequest(
 		// Use global lock to stop player and set new source id.
         std::lock_guard<std::mutex> lock{m_operationMutex};
         stopLocked();
-        m_sourceId++;
+        m_sourceId = ++m_lastSourceId;
+        m_sessionId = m_sourceId.load();
         m_initialOffset = offset;
+		m_traceDialogTurn = traceDialogTurn;
+		m_volume = 1.0f;
 		m_state = AOPlayerState::OPENED;
 	}
 
 	// Make sure current thread be destroyed.
-	if(m_playerThread.joinable()) {
-		m_playerWaitCondition.notify_one();	//
-		m_playerThread.join();
-	}
+	joinPlaybackThreads();
 
 	// Delete old decoder before configuring new one.
 #if 0
@@ -244,35 +433,101 @@ int AOWrapper::configureNewRequest(
 #endif		
 	m_decoder.reset();
 	
-	m_decoder = FFmpegDecoder::create(std::move(inputController), m_config);
+	m_decoder = decoder;
+	auto ffmpegDecoder = std::dynamic_pointer_cast<FFmpegDecoder>(m_decoder);
+	m_decoderState = ffmpegDecoder ? ffmpegDecoder->getState() : FFmpegDecoder::DecodingState::DECODING;
+
+	// Both threads of the previous source have exited, so the ring can be emptied.
+	m_ring.clear();
+	m_isDecodeFinished = false;
+	if(m_bufferFillGauge) {
+		m_bufferFillGauge->set(0);
+	}
 
-	m_playerThread = std::thread(&AOWrapper::doPlayAudioLoop, this);
+	SourceId id = m_sourceId;
+	m_decodeThread = std::thread(&AOWrapper::doDecodeLoop, this, id);
+	m_playerThread = std::thread(&AOWrapper::doPlayAudioLoop, this, id);
 
-	return m_sourceId;
+	return id;
 }
 
-bool AOWrapper::initialize(){
+AOWrapper::SourceId AOWrapper::configureNextRequest(
+	std::shared_ptr<DecoderInterface> decoder,
+	std::chrono::milliseconds offset,
+	bool traceDialogTurn) {
+	if(!decoder) {
+		AISDK_ERROR(LX("configureNextRequestFailed").d("reason", "decoderIsNullptr"));
+		return utils::mediaPlayer::MediaPlayerInterface::ERROR;
+	}
+
+	std::thread previousPrepareThread;
+	SourceId id = utils::mediaPlayer::MediaPlayerInterface::ERROR;
+	{
+		std::lock_guard<std::mutex> lock{m_operationMutex};
+		// The output thread holds on to the session while it plays, pauses or waits to play; otherwise there is
+		// nothing to follow.
+		bool isPlaybackActive = !m_isShuttingDown && (AOPlayerState::OPENED == m_state ||
+			AOPlayerState::PLAYING == m_state || AOPlayerState::PAUSED == m_state);
+		if(isPlaybackActive) {
+			discardNextSourceLocked();
+			auto source = std::make_shared<PreparedSource>();
+			source->id = ++m_lastSourceId;
+			source->decoder = decoder;
+			source->offset = offset;
+			source->volume = 1.0f;
+			source->traceDialogTurn = traceDialogTurn;
+			source->head.resize(BUFFER_SIZE / m_frameBytes * m_frameBytes);
+			source->headStatus = DecoderInterface::Status::OK;
+			source->isReady = false;
+			m_nextSource = source;
+			id = source->id;
+
+			// The discarded source was aborted, so its prepare thread exits soon; join it without the lock.
+			previousPrepareThread = std::move(m_prepareThread);
+			m_prepareThread = std::thread(&AOWrapper::doPrepareLoop, this, source);
+		}
+	}
+	if(previousPrepareThread.joinable()) {
+		previousPrepareThread.join();
+	}
+
+	if(utils::mediaPlayer::MediaPlayerInterface::ERROR == id) {
+		AISDK_DEBUG2(LX("configureNextRequest").d("reason", "nothingPlaying"));
+		id = configureNewRequest(decoder, offset, traceDialogTurn);
+		if(utils::mediaPlayer::MediaPlayerInterface::ERROR != id) {
+			play(id);
+		}
+	}
 
-	ao_sample_format format;
-	// Bzero the structs @c ao_sample_format.
-	std::memset(&format, 0, sizeof format);
-	format.bits = convertBitsPreSample(m_config.sampleFormat());
-	format.channels = m_config.numberChannels();
-	format.rate = m_config.sampleRate();
-	format.byte_format = (m_config.isLittleEndian()?AO_FMT_LITTLE: AO_FMT_BIG);
+	return id;
+}
 
-	auto defaultDriver = m_engine->getDefaultDriver();
-	
-	/// Open liao driver.
-	auto device = ao_open_live(defaultDriver, &format, NULL);
-	if (device == NULL) {
-		AISDK_DEBUG2(LX("initializeFailed").d("reason", "ErrorOpeningDevice"));
-		return false;
+void AOWrapper::discardNextSourceLocked() {
+	if(m_nextSource) {
+		AISDK_DEBUG2(LX("discardNextSource").d("id", m_nextSource->id));
+		m_nextSource->decoder->abort();
+		m_nextSource.reset();
 	}
+}
 
-	m_device = std::shared_ptr<ao_device>(device, AOOpenLiveDeleter());
-	
-	return true;
+void AOWrapper::joinPlaybackThreads() {
+	m_decodeWaitCondition.notify_all();
+	m_playerWaitCondition.notify_all();
+	if(m_decodeThread.joinable()) {
+		m_decodeThread.join();
+	}
+	if(m_playerThread.joinable()) {
+		m_playerThread.join();
+	}
+	// prepareNext() replaces the prepare thread under the lock, so take it out under the lock and join it without.
+	std::thread prepareThread;
+	{
+		std::lock_guard<std::mutex> lock{m_operationMutex};
+		prepareThread = std::move(m_prepareThread);
+	}
+	if(prepareThread.joinable()) {
+		prepareThread.join();
+	}
 }
 
 void AOWrapper::doShutdown()
@@ -287,95 +542,421 @@ void AOWrapper::doShutdown()
 			m_decoder->abort();
 #endif
 	    m_sourceId = ERROR;
+	    m_sessionId = ERROR;
 	}
 	// Make sure current thread be destroyed.
-	if(m_playerThread.joinable()) {		
-		m_playerWaitCondition.notify_one();	//
-		m_playerThread.join();
-	}
+	joinPlaybackThreads();
 
-	if(m_device) {
-		m_device.reset();
+	if(m_output) {
+		m_output.reset();
 	}
 }
 
-/* The instance callback, where we have access to every method/variable in object of class Sine */
-void AOWrapper::doPlayAudioLoop() {
-	auto task = [this](){
-		return (m_state == AOPlayerState::PLAYING) || (m_state == AOPlayerState::FINISHED) || m_isShuttingDown;
-	};
+void AOWrapper::doDecodeLoop(SourceId sessionId) {
+	utils::logging::ThreadMoniker::setThisThreadName("AOWrapperDecoder");
+
+	std::shared_ptr<DecoderInterface> decoder;
+	{
+		std::lock_guard<std::mutex> lock(m_operationMutex);
+		// Keep the decoder of this source alive even if @c stopLocked() releases @c m_decoder meanwhile.
+		decoder = m_decoder;
+	}
+	auto ffmpegDecoder = std::dynamic_pointer_cast<FFmpegDecoder>(decoder);
+	// The prepared source whose first audio still has to be copied to the ring.
+	std::shared_ptr<PreparedSource> preparedSource;
+	// The bytes written to the ring in this session, which tell the output thread where each source starts.
+	uint64_t bytesWritten = 0;
+
+	while(decoder) {
+		// Only take the lock to wait for room in the ring or to notice that the source ended.
+		if(m_ring.freeSpace() < BUFFER_SIZE || sessionId != m_sessionId || AOPlayerState::FINISHED == m_state) {
+			std::unique_lock<std::mutex> lock(m_operationMutex);
+			if(m_isShuttingDown || sessionId != m_sessionId || AOPlayerState::FINISHED == m_state) {
+				return;
+			}
+			if(m_ring.freeSpace() < BUFFER_SIZE) {
+				m_decodeHeartbeat.idle();
+				m_decodeWaitCondition.wait_for(lock, RING_WAIT_INTERVAL, [this, sessionId]() {
+					return m_isShuttingDown || sessionId != m_sessionId || AOPlayerState::FINISHED == m_state ||
+						m_ring.freeSpace() >= BUFFER_SIZE;
+				});
+				continue;
+			}
+		}
+
+		size_t wordsRead;
+		DecoderInterface::Status status;
+		if(preparedSource) {
+			// The first audio of a prepared source was decoded ahead, and is never more than BUFFER_SIZE.
+			wordsRead = m_ring.write(preparedSource->head.data(), preparedSource->head.size());
+			status = preparedSource->headStatus;
+			preparedSource.reset();
+		} else {
+			// Decode straight into the ring. The ring holds whole frames, so its free space never ends mid-frame.
+			size_t reserved;
+			auto region = m_ring.reserve(&reserved);
+			/// Start to read and decode a new frame
+			m_decodeHeartbeat.beat("decode");
+			std::tie(status, wordsRead) = decoder->read(region, std::min(reserved, BUFFER_SIZE));
+			if(DecoderInterface::Status::ERROR == status) {
+				wordsRead = 0;
+			}
+			m_ring.commit(wordsRead);
+		}
+		if(ffmpegDecoder) {
+			m_decoderState = ffmpegDecoder->getState();
+		} else if(DecoderInterface::Status::OK != status) {
+			m_decoderState = DecoderInterface::Status::DONE == status ?
+				FFmpegDecoder::DecodingState::FINISHED : FFmpegDecoder::DecodingState::INVALID;
+		}
+		bytesWritten += wordsRead;
+		m_playerWaitCondition.notify_one();
+
+		if(DecoderInterface::Status::OK != status) {
+			if(DecoderInterface::Status::ERROR == status) {
+				AISDK_ERROR(LX("doDecodeLoopFailed").d("reason", "decodingFailed"));
+			} else {
+				AISDK_DEBUG2(LX("doDecodeLoopDone").d("reason", "decodingFinished"));
+			}
+			// What was decoded of this source still plays, and a prepared source may follow it.
+			preparedSource = takeNextSource(sessionId, bytesWritten);
+			if(!preparedSource) {
+				break;
+			}
+			decoder = preparedSource->decoder;
+			ffmpegDecoder = std::dynamic_pointer_cast<FFmpegDecoder>(decoder);
+		}
+	}
+
+	m_isDecodeFinished = true;
+	m_playerWaitCondition.notify_one();
+}
 
+std::shared_ptr<AOWrapper::PreparedSource> AOWrapper::takeNextSource(SourceId sessionId, uint64_t bytesWritten) {
 	std::unique_lock<std::mutex> lock(m_operationMutex);
-	while(true) {
-		m_playerWaitCondition.wait(lock, task);
-		if(m_isShuttingDown || m_state == AOPlayerState::FINISHED) {
-			m_state = AOPlayerState::IDLE;
-			break;
+	// Let the output thread play the rest of the ring and finish, unless a source is prepared meanwhile.
+	m_isDecodeFinished = true;
+	m_playerWaitCondition.notify_one();
+	while(!m_nextSource || !m_nextSource->isReady) {
+		if(m_isShuttingDown || sessionId != m_sessionId || AOPlayerState::FINISHED == m_state) {
+			return nullptr;
 		}
-		
-		doPlayAudioLocked(lock);
+		m_decodeHeartbeat.idle();
+		m_decodeWaitCondition.wait_for(lock, RING_WAIT_INTERVAL);
+	}
+
+	auto source = m_nextSource;
+	m_nextSource.reset();
+	// Make the decoder of the next source the one @c stopLocked() aborts.
+	m_decoder = source->decoder;
+	m_trackSwitches.push_back({source, bytesWritten});
+	if(1 == m_trackSwitches.size()) {
+		m_nextSwitchByte = bytesWritten;
 	}
+	m_isDecodeFinished = false;
+	AISDK_DEBUG2(LX("takeNextSource").d("id", source->id).d("startByte", bytesWritten));
+	return source;
 }
 
-void AOWrapper::doPlayAudioLocked(std::unique_lock<std::mutex> &lock) {
-	bool unexpected = false;
+void AOWrapper::doPrepareLoop(std::shared_ptr<PreparedSource> source) {
+	utils::logging::ThreadMoniker::setThisThreadName("AOWrapperPrepare");
 
-	// We need to release the lock @c m_operationMutex when the @c FFMpegDecoder enters the decoding stage and play decode data.
-	lock.unlock();
+	// Opening the source, probing it and decoding its first frames happen here, while the current source plays.
+	size_t bytes;
+	std::tie(source->headStatus, bytes) = source->decoder->read(source->head.data(), source->head.size());
+	if(DecoderInterface::Status::ERROR == source->headStatus) {
+		bytes = 0;
+	}
+	source->head.resize(bytes);
 
-	do {
-	
-		size_t wordsRead;
-		DecoderInterface::Status status;
-		Byte buffer[BUFFER_SIZE];
-		/// Start to read and decode a new frame
-		std::tie(status, wordsRead) = m_decoder->read(buffer, sizeof buffer);
-		if(DecoderInterface::Status::ERROR == status) {
-			AISDK_ERROR(LX("doPlayAudioLockedFailed").d("reason", "decodingFailed"));
-			unexpected = true;
-			break;
+	{
+		std::lock_guard<std::mutex> lock(m_operationMutex);
+		// A source replaced or stopped while it was prepared fails with its aborted decoder; that is not an error.
+		if(DecoderInterface::Status::ERROR == source->headStatus && m_nextSource == source) {
+			AISDK_ERROR(LX("doPrepareLoopFailed").d("reason", "decodingFailed").d("id", source->id));
 		}
+		source->isReady = true;
+	}
+	m_decodeWaitCondition.notify_all();
+}
 
-		if(DecoderInterface::Status::DONE == status) {
-			AISDK_DEBUG2(LX("doPlayAudioLockedDone").d("reason", "decodingFinished"));
-			unexpected = true;
-			break;
+void AOWrapper::doPlayAudioLoop(SourceId id) {
+	utils::logging::ThreadMoniker::setThisThreadName("AOWrapperPlayer");
+
+	bool traceDialogTurn;
+	{
+		std::lock_guard<std::mutex> lock(m_operationMutex);
+		traceDialogTurn = m_traceDialogTurn;
+	}
+
+	std::vector<Byte> period(m_periodBytes);
+	bool isPrebuffering = true;
+	// The bytes played in this session, compared with where the prepared sources start.
+	uint64_t bytesPlayed = 0;
+	// Whether the current source has not played anything yet, to measure the gap after the previous one.
+	bool isTrackStart = true;
+	// The gain the audio played so far ended at, which the next audio ramps from.
+	float gain = m_volume;
+	// Whether the output was faded out for a pause, so that the audio fades back in when it resumes.
+	bool isFadedOut = false;
+	// When the last period was handed to the device.
+	auto lastOutputTime = std::chrono::steady_clock::now();
+	while(true) {
+		auto bufferedBytes = m_ring.size();
+		uint64_t switchByte = m_nextSwitchByte;
+		bool canPlay = AOPlayerState::PLAYING == m_state && id == m_sourceId && bytesPlayed != switchByte &&
+			(isPrebuffering ? (bufferedBytes >= m_prebufferBytes || m_isDecodeFinished) : bufferedBytes >= m_frameBytes);
+
+		// Only take the lock when the audio cannot flow: paused, prebuffering, ended, replaced or at a track switch.
+		if(!canPlay) {
+			std::unique_lock<std::mutex> lock(m_operationMutex);
+			if(m_isShuttingDown || id != m_sourceId || AOPlayerState::FINISHED == m_state) {
+				if(id == m_sourceId) {
+					m_state = AOPlayerState::IDLE;
+				}
+				// A source stopped while it is heard fades out; the next source waits for this thread to exit.
+				uint64_t fadeLimit = m_nextSwitchByte - bytesPlayed;
+				lock.unlock();
+				if(!isFadedOut && !isPrebuffering) {
+					fadeOut(period.data(), gain, fadeLimit);
+				}
+				break;
+			}
+
+			AOPlayerState state = m_state;
+			if(AOPlayerState::PAUSED == state && !isFadedOut && !isPrebuffering) {
+				uint64_t fadeLimit = m_nextSwitchByte - bytesPlayed;
+				lock.unlock();
+				bytesPlayed += fadeOut(period.data(), gain, fadeLimit);
+				lastOutputTime = std::chrono::steady_clock::now();
+				isFadedOut = true;
+				continue;
+			}
+			if(AOPlayerState::PLAYING != state) {
+				m_heartbeat.idle();
+				m_playerWaitCondition.wait(lock, [this, id, state]() {
+					return m_isShuttingDown || id != m_sourceId || m_state != state;
+				});
+				continue;
+			}
+
+			if(!m_trackSwitches.empty() && bytesPlayed == m_trackSwitches.front().startByte) {
+				// The audio of the current source is all played: carry on with the prepared source after it.
+				auto source = m_trackSwitches.front().source;
+				m_trackSwitches.pop_front();
+				m_nextSwitchByte = m_trackSwitches.empty() ? NO_TRACK_SWITCH : m_trackSwitches.front().startByte;
+				m_trackEndTime = lastOutputTime.time_since_epoch().count();
+				isTrackStart = true;
+				auto previousId = id;
+				id = source->id;
+				m_sourceId = id;
+				m_initialOffset = source->offset;
+				m_traceDialogTurn = source->traceDialogTurn;
+				m_volume = source->volume;
+				traceDialogTurn = source->traceDialogTurn;
+				AISDK_DEBUG2(LX("doPlayAudioLoop").d("reason", "trackSwitch").d("from", previousId).d("to", id));
+				if (m_observer) {
+					m_observer->onPlaybackFinished(previousId);
+					m_observer->onPlaybackStarted(id);
+				}
+				if(traceDialogTurn) {
+					utils::tracing::DialogTurnTracer::instance().mark(utils::tracing::DialogTurnTracer::Stage::PLAY_STARTED);
+				}
+				continue;
+			}
+
+			// A prepared source which the decoder thread has not taken yet still follows the current one.
+			if(m_isDecodeFinished && m_ring.size() < m_frameBytes && !m_nextSource) {
+				m_state = AOWrapper::AOPlayerState::FINISHED;
+				if(!isTrackStart) {
+					m_trackEndTime = lastOutputTime.time_since_epoch().count();
+				}
+				if (m_observer) {
+					m_observer->onPlaybackFinished(m_sourceId);
+				}
+				continue;
+			}
+
+			if(!isPrebuffering && m_ring.size() < m_frameBytes && !m_isDecodeFinished) {
+				// The decoder fell behind: count it, and buffer up to the target again rather than play in bits.
+				++m_underrunCount;
+				if(m_underrunCounter) {
+					m_underrunCounter->increment();
+				}
+				AISDK_DEBUG0(LX("doPlayAudioLoop").d("reason", "underrun").d("count", m_underrunCount.load()));
+				isPrebuffering = true;
+			}
+
+			m_heartbeat.idle();
+			m_playerWaitCondition.wait_for(lock, RING_WAIT_INTERVAL, [this, id, isPrebuffering, bytesPlayed]() {
+				return m_isShuttingDown || id != m_sourceId || AOPlayerState::PLAYING != m_state ||
+					bytesPlayed == m_nextSwitchByte || (m_isDecodeFinished && !m_nextSource) ||
+					m_ring.size() >= (isPrebuffering ? m_prebufferBytes : m_frameBytes);
+			});
+			continue;
 		}
-		
-	//	 std::cout << "decodec size: " << wordsRead << std::endl;
 
-		if(ao_play(m_device.get(), (char *)buffer, wordsRead) == 0) {
-			AISDK_ERROR(LX("doPlayAudioLockedDone").d("reason", "ao_play failed"));
+		isPrebuffering = false;
+		// Never play past the start of the next source, so that its start is reported when it is heard.
+		auto wanted = std::min<uint64_t>(std::min(bufferedBytes, m_periodBytes), switchByte - bytesPlayed);
+		auto bytes = m_ring.read(period.data(), static_cast<size_t>(wanted) / m_frameBytes * m_frameBytes);
+		bytesPlayed += bytes;
+		m_decodeWaitCondition.notify_one();
+		if(m_bufferFillGauge) {
+			m_bufferFillGauge->set(static_cast<int64_t>((bufferedBytes - bytes) * 1000 / m_ring.capacity()));
+		}
+
+		if(isTrackStart && bytes > 0) {
+			isTrackStart = false;
+			recordTrackGap();
+		}
+
+		// Ramp to the volume of the source, from silence after a pause; the audio at full volume is left as it is.
+		if(isFadedOut) {
+			isFadedOut = false;
+			gain = 0.0f;
+		}
+		float volume = m_volume;
+		if(gain != volume || 1.0f != volume) {
+			applyGainRamp(period.data(), bytes, gain, volume, FadeCurve::EXPONENTIAL);
+			gain = volume;
+		}
+
+		bool played;
+		m_heartbeat.beat("output_write");
+		{
+			AISDK_TRACE_SCOPE("output", "output_write");
+			played = m_output->write(period.data(), bytes);
+		}
+		lastOutputTime = std::chrono::steady_clock::now();
+		if(!played) {
+			AISDK_ERROR(LX("doPlayAudioLoopFailed").d("reason", "outputWriteFailed"));
+		} else if(traceDialogTurn) {
+			utils::tracing::DialogTurnTracer::instance().mark(utils::tracing::DialogTurnTracer::Stage::FIRST_AUDIO_OUTPUT);
 		}
-	}while(0);
-	
-	lock.lock();
-	if(unexpected) {
-		m_state = AOWrapper::AOPlayerState::FINISHED;
-		if (m_observer) {
-            m_observer->onPlaybackFinished(m_sourceId);
-        }
 	}
-	
+}
+
+void AOWrapper::recordTrackGap() {
+	auto trackEndTime = m_trackEndTime.exchange(0);
+	if(!trackEndTime) {
+		return;
+	}
+	auto gap = std::chrono::steady_clock::now() -
+		std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(trackEndTime));
+	if(gap > MAX_TRACK_GAP) {
+		// The player was idle between the two sources rather than playing one after the other.
+		return;
+	}
+	auto gapMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(gap).count();
+	AISDK_DEBUG2(LX("recordTrackGap").d("gap(us)", gapMicroseconds));
+	if(m_trackGapHistogram) {
+		m_trackGapHistogram->record(static_cast<uint64_t>(std::max<int64_t>(gapMicroseconds, 0)));
+	}
+}
+
+void AOWrapper::applyGainRamp(Byte* data, size_t bytes, float fromGain, float toGain, FadeCurve curve) {
+	auto frames = bytes / m_frameBytes;
+	switch(m_config.sampleFormat()) {
+		case PlaybackConfiguration::SampleFormat::SIGNED_16:
+			applyFade16(reinterpret_cast<int16_t*>(data), frames, m_config.numberChannels(), fromGain, toGain, curve);
+			break;
+		case PlaybackConfiguration::SampleFormat::SIGNED_32:
+			applyFade32(reinterpret_cast<int32_t*>(data), frames, m_config.numberChannels(), fromGain, toGain, curve);
+			break;
+		case PlaybackConfiguration::SampleFormat::UNSIGNED_8:
+			// @c setVolume() refuses 8 bit outputs, and the fades leave them as they are.
+			break;
+	}
+}
+
+size_t AOWrapper::fadeOut(Byte* buffer, float fromGain, uint64_t maxBytes) {
+	auto wanted = std::min<uint64_t>(std::min(m_ring.size(), m_fadeBytes), maxBytes);
+	auto bytes = m_ring.read(buffer, static_cast<size_t>(wanted) / m_frameBytes * m_frameBytes);
+	m_decodeWaitCondition.notify_one();
+	if(0 == bytes) {
+		return 0;
+	}
+
+	applyGainRamp(buffer, bytes, fromGain, 0.0f, FadeCurve::LINEAR);
+	AISDK_DEBUG2(LX("fadeOut").d("bytes", bytes));
+	m_heartbeat.beat("output_write");
+	{
+		AISDK_TRACE_SCOPE("output", "output_fade_out");
+		if(!m_output->write(buffer, bytes)) {
+			AISDK_ERROR(LX("fadeOutFailed").d("reason", "outputWriteFailed"));
+		}
+	}
+	return bytes;
+}
+
+std::string AOWrapper::renderState() const {
+	std::ostringstream decoderState;
+	decoderState << m_decoderState.load();
+	return "{\"sourceId\":" + std::to_string(m_sourceId.load()) +
+		",\"state\":\"" + playerStateToString(m_state) +
+		"\",\"decoderState\":\"" + decoderState.str() +
+		"\",\"bufferedBytes\":" + std::to_string(m_ring.size()) +
+		",\"capacityBytes\":" + std::to_string(m_ring.capacity()) +
+		",\"prebufferBytes\":" + std::to_string(m_prebufferBytes) +
+		",\"underruns\":" + std::to_string(m_underrunCount.load()) +
+		",\"volume\":" + std::to_string(m_volume.load()) + "}";
 }
 
 AOWrapper::AOWrapper(
-	std::shared_ptr<AOEngine> aoEngine,
-	const PlaybackConfiguration& config) :
+	std::shared_ptr<AudioOutputInterface> output,
+	const std::string& name,
+	const Options& options) :
 	SafeShutdown{"AOWrapper"},
 	m_sourceId{utils::mediaPlayer::MediaPlayerInterface::ERROR},
-	m_engine{aoEngine},
+	m_sessionId{utils::mediaPlayer::MediaPlayerInterface::ERROR},
+	m_lastSourceId{utils::mediaPlayer::MediaPlayerInterface::ERROR},
 	m_decoder{nullptr},
-	m_device{nullptr},
+	m_output{output},
 	m_initialOffset{0},
+	m_traceDialogTurn{false},
+	m_volume{1.0f},
 	m_state{AOPlayerState::IDLE},
+	m_decoderState{FFmpegDecoder::DecodingState::INVALID},
 	m_isShuttingDown{false},
-	m_config{config} {
-	
+	m_config{output->getConfiguration()},
+	m_name{name},
+	m_probeConfig{options.probeConfig},
+	m_urlCache{options.urlCache},
+	m_playlistParserFactory{options.playlistParserFactory},
+	m_pcmCache{options.pcmCache},
+	m_contextPool{options.contextPool},
+	m_frameBytes{m_config.sampleSizeBytes() * m_config.numberChannels()},
+	m_periodBytes{std::max(durationToBytes(m_config, OUTPUT_PERIOD), m_frameBytes)},
+	m_prebufferBytes{durationToBytes(m_config, options.prebufferTarget)},
+	m_fadeBytes{std::min(std::max(durationToBytes(m_config, FADE_DURATION), m_frameBytes), m_periodBytes)},
+	m_ring{(std::max(durationToBytes(m_config, RING_BUFFER_DURATION), m_prebufferBytes) + BUFFER_SIZE + m_frameBytes - 1) /
+		m_frameBytes * m_frameBytes},
+	m_isDecodeFinished{false},
+	m_underrunCount{0},
+	m_underrunCounter{utils::metrics::MetricsRegistry::instance().getCounter(
+		"aisdk_player_underruns_total",
+		{{"player", name}},
+		"Times a player ran out of decoded audio while playing.")},
+	m_bufferFillGauge{utils::metrics::MetricsRegistry::instance().getGauge(
+		"aisdk_player_buffer_fill_permille",
+		{{"player", name}},
+		"Fill level of the decoded audio ring of a player, in thousandths of its capacity.")},
+	m_nextSwitchByte{NO_TRACK_SWITCH},
+	m_trackEndTime{0},
+	m_trackGapHistogram{utils::metrics::MetricsRegistry::instance().getHistogram(
+		"aisdk_player_track_gap_microseconds",
+		{{"player", name}},
+		"Time between the last audio of a source and the first audio of the source played after it.")},
+	m_heartbeat{"AOWrapperPlayer:" + name},
+	m_decodeHeartbeat{"AOWrapperDecoder:" + name} {
+	m_introspectionId = utils::introspection::IntrospectionServer::instance().addSection(
+		"mediaPlayers", m_name, [this]() { return renderState(); });
 }
 
 AOWrapper::~AOWrapper() {
 	AISDK_DEBUG5(LX("AOWrapper").d("reason", "Destructor"));
+	utils::introspection::IntrospectionServer::instance().removeSection(m_introspectionId);
 	m_decoder.reset();
 	doShutdown();
 }
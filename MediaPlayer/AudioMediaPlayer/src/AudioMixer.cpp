@@ -0,0 +1,177 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <algorithm>
+
+#include <Utils/Logging/Logger.h>
+#include <Utils/Logging/ThreadMoniker.h>
+#include <Utils/Metrics/MetricsRegistry.h>
+#include <Utils/Tracing/TraceEventRecorder.h>
+
+#include "AudioMediaPlayer/AudioMixer.h"
+#include "AudioMediaPlayer/Endian.h"
+
+/// String to identify log entries originating from this file.
+static const std::string TAG("AudioMixer");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/// The audio mixed and handed to the output at once, the same as the period of an @c AOWrapper.
+static const std::chrono::milliseconds MIX_PERIOD{20};
+
+/// The audio an input holds before a write to it blocks.
+static const std::chrono::milliseconds INPUT_BUFFER_DURATION{40};
+
+std::shared_ptr<AudioMixer> AudioMixer::create(std::shared_ptr<AudioOutputInterface> output, const std::string& name) {
+    if (!output) {
+        AISDK_ERROR(LX("createFailed").d("reason", "outputIsNullptr"));
+        return nullptr;
+    }
+    auto config = output->getConfiguration();
+    if (PlaybackConfiguration::SampleFormat::SIGNED_16 != config.sampleFormat() ||
+        littleEndianMachine() != config.isLittleEndian()) {
+        AISDK_ERROR(LX("createFailed").d("reason", "unsupportedFormat").d("format", config.sampleFormat()));
+        return nullptr;
+    }
+
+    auto mixer = std::shared_ptr<AudioMixer>(new AudioMixer(output, name));
+    mixer->m_mixThread = std::thread(&AudioMixer::doMixLoop, mixer.get());
+    return mixer;
+}
+
+AudioMixer::AudioMixer(std::shared_ptr<AudioOutputInterface> output, const std::string& name) :
+        m_output{output},
+        m_config{output->getConfiguration()},
+        m_periodFrames{std::max<size_t>(m_config.sampleRate() * MIX_PERIOD.count() / 1000, 1)},
+        m_isShuttingDown{false},
+        m_activeInputsGauge{utils::metrics::MetricsRegistry::instance().getGauge(
+            "aisdk_mixer_active_inputs",
+            {{"mixer", name}},
+            "Number of inputs which had audio in the last period of a mixer.")},
+        m_heartbeat{"AudioMixer"} {
+}
+
+AudioMixer::~AudioMixer() {
+    shutdown();
+}
+
+std::shared_ptr<AudioMixerInput> AudioMixer::createInput(const std::string& name, float gain) {
+    auto frameBytes = m_config.numberChannels() * sizeof(int16_t);
+    auto capacity =
+        std::max<size_t>(m_config.sampleRate() * INPUT_BUFFER_DURATION.count() / 1000, m_periodFrames) * frameBytes;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_isShuttingDown) {
+        AISDK_ERROR(LX("createInputFailed").d("reason", "isShuttingDown").d("name", name));
+        return nullptr;
+    }
+    auto input = std::shared_ptr<AudioMixerInput>(
+        new AudioMixerInput(shared_from_this(), name, m_config, capacity, gain));
+    m_inputs.push_back(input);
+    AISDK_DEBUG5(LX("createInput").d("name", name).d("gain", gain));
+    return input;
+}
+
+void AudioMixer::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isShuttingDown = true;
+        for (auto& input : m_inputs) {
+            input->close();
+        }
+    }
+    m_wakeCondition.notify_all();
+    if (m_mixThread.joinable()) {
+        m_mixThread.join();
+    }
+}
+
+void AudioMixer::notifyAudioWritten() {
+    {
+        // Taken so that the mixer thread cannot miss the audio between checking the inputs and waiting.
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_wakeCondition.notify_one();
+}
+
+void AudioMixer::doMixLoop() {
+    utils::logging::ThreadMoniker::setThisThreadName("AudioMixer");
+
+    auto channels = m_config.numberChannels();
+    std::vector<int16_t> period(m_periodFrames * channels);
+    // A copy of the inputs, updated when some are added, so that they are mixed without holding the lock.
+    std::vector<std::shared_ptr<AudioMixerInput>> inputs;
+    int64_t activeInputs = -1;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            auto hasAudio = [this]() {
+                return std::any_of(m_inputs.begin(), m_inputs.end(), [](const std::shared_ptr<AudioMixerInput>& input) {
+                    return input->hasAudio();
+                });
+            };
+            if (!m_isShuttingDown && !hasAudio()) {
+                // Nothing to play: the output is not written to until an input gets audio, like a stopped player.
+                m_heartbeat.idle();
+                m_wakeCondition.wait(lock, [this, &hasAudio]() { return m_isShuttingDown || hasAudio(); });
+            }
+            if (m_isShuttingDown) {
+                break;
+            }
+            if (inputs.size() != m_inputs.size()) {
+                inputs = m_inputs;
+            }
+        }
+
+        m_heartbeat.beat("mix");
+        std::fill(period.begin(), period.end(), 0);
+        int64_t mixed = 0;
+        {
+            AISDK_TRACE_SCOPE("mixer", "mix");
+            for (auto& input : inputs) {
+                if (input->mixInto(period.data(), m_periodFrames)) {
+                    mixed++;
+                }
+            }
+        }
+        if (mixed != activeInputs) {
+            activeInputs = mixed;
+            if (m_activeInputsGauge) {
+                m_activeInputsGauge->set(activeInputs);
+            }
+        }
+
+        m_heartbeat.beat("output_write");
+        bool played;
+        {
+            AISDK_TRACE_SCOPE("output", "output_write");
+            played = m_output->write(reinterpret_cast<const uint8_t*>(period.data()), period.size() * sizeof(int16_t));
+        }
+        if (!played) {
+            AISDK_ERROR(LX("doMixLoopFailed").d("reason", "outputWriteFailed"));
+        }
+    }
+    m_heartbeat.idle();
+}
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
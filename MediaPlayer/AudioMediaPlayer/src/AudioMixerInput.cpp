@@ -0,0 +1,158 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "AudioMediaPlayer/AudioMixer.h"
+#include "AudioMediaPlayer/AudioMixerInput.h"
+#include "AudioMediaPlayer/PcmKernels.h"
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/// How long a write waiting for room sleeps before looking at the input again, in case the mixer did not wake it.
+static const std::chrono::milliseconds WRITE_WAIT_INTERVAL{10};
+
+/// The frames mixed with the same gain while the gain ramps, short enough for the steps not to be heard.
+static const size_t GAIN_BLOCK_FRAMES = 32;
+
+/**
+ * Clamp a gain to the range of the mixer.
+ *
+ * @param gain The gain.
+ * @return The gain, from 0 to 1.
+ */
+static float clampGain(float gain) {
+    return std::min(std::max(gain, 0.0f), 1.0f);
+}
+
+AudioMixerInput::AudioMixerInput(
+    std::weak_ptr<AudioMixer> mixer,
+    const std::string& name,
+    const PlaybackConfiguration& config,
+    size_t capacity,
+    float gain) :
+        m_mixer{mixer},
+        m_name{name},
+        m_config{config},
+        m_channels{config.numberChannels()},
+        m_ring{capacity},
+        m_period(capacity / sizeof(int16_t)),
+        m_isClosed{false},
+        m_gain{clampGain(gain)},
+        m_duckLevel{1.0f},
+        m_currentGain{m_gain},
+        m_targetGain{m_gain},
+        m_gainStep{0} {
+}
+
+void AudioMixerInput::setGain(float gain, std::chrono::milliseconds ramp) {
+    std::lock_guard<std::mutex> lock(m_gainMutex);
+    m_gain = clampGain(gain);
+    rampToTargetLocked(ramp);
+}
+
+void AudioMixerInput::duck(float level, std::chrono::milliseconds ramp) {
+    std::lock_guard<std::mutex> lock(m_gainMutex);
+    m_duckLevel = clampGain(level);
+    rampToTargetLocked(ramp);
+}
+
+void AudioMixerInput::unduck(std::chrono::milliseconds ramp) {
+    std::lock_guard<std::mutex> lock(m_gainMutex);
+    m_duckLevel = 1.0f;
+    rampToTargetLocked(ramp);
+}
+
+bool AudioMixerInput::isDucked() {
+    std::lock_guard<std::mutex> lock(m_gainMutex);
+    return m_duckLevel < 1.0f;
+}
+
+void AudioMixerInput::rampToTargetLocked(std::chrono::milliseconds ramp) {
+    m_targetGain = m_gain * m_duckLevel;
+    auto rampFrames = static_cast<float>(m_config.sampleRate()) * ramp.count() / 1000;
+    m_gainStep = rampFrames >= 1 ? std::fabs(m_targetGain - m_currentGain) / rampFrames : 1.0f;
+}
+
+std::string AudioMixerInput::getName() const {
+    return m_name;
+}
+
+bool AudioMixerInput::write(const uint8_t* data, size_t size) {
+    size_t written = 0;
+    while (true) {
+        written += m_ring.write(data + written, size - written);
+        if (auto mixer = m_mixer.lock()) {
+            mixer->notifyAudioWritten();
+        }
+
+        std::unique_lock<std::mutex> lock(m_writeMutex);
+        if (m_isClosed) {
+            return false;
+        }
+        if (written == size) {
+            return true;
+        }
+        // Like a device with a full buffer, wait until the mixer took some audio.
+        m_spaceCondition.wait_for(
+            lock, WRITE_WAIT_INTERVAL, [this]() { return m_isClosed || m_ring.freeSpace() > 0; });
+    }
+}
+
+PlaybackConfiguration AudioMixerInput::getConfiguration() const {
+    return m_config;
+}
+
+bool AudioMixerInput::hasAudio() const {
+    return m_ring.size() >= m_channels * sizeof(int16_t);
+}
+
+bool AudioMixerInput::mixInto(int16_t* period, size_t frames) {
+    auto frameBytes = m_channels * sizeof(int16_t);
+    frames = std::min(std::min(frames, m_ring.size() / frameBytes), m_period.size() / m_channels);
+    if (!frames) {
+        return false;
+    }
+    m_ring.read(reinterpret_cast<uint8_t*>(m_period.data()), frames * frameBytes);
+    m_spaceCondition.notify_one();
+
+    std::lock_guard<std::mutex> lock(m_gainMutex);
+    for (size_t offset = 0; offset < frames; offset += GAIN_BLOCK_FRAMES) {
+        auto blockFrames = std::min(GAIN_BLOCK_FRAMES, frames - offset);
+        if (m_currentGain < m_targetGain) {
+            m_currentGain = std::min(m_targetGain, m_currentGain + m_gainStep * blockFrames);
+        } else if (m_currentGain > m_targetGain) {
+            m_currentGain = std::max(m_targetGain, m_currentGain - m_gainStep * blockFrames);
+        }
+        mixScaledSaturating16(
+            period + offset * m_channels,
+            m_period.data() + offset * m_channels,
+            blockFrames * m_channels,
+            static_cast<int32_t>(std::lround(m_currentGain * UNITY_GAIN_Q15)));
+    }
+    return true;
+}
+
+void AudioMixerInput::close() {
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        m_isClosed = true;
+    }
+    m_spaceCondition.notify_all();
+}
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
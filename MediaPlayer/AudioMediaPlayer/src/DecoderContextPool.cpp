@@ -0,0 +1,262 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <iterator>
+#include <sstream>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libswresample/swresample.h>
+}
+
+#include <Utils/Logging/Logger.h>
+#include <Utils/Metrics/MetricsRegistry.h>
+#include "AudioMediaPlayer/DecoderContextPool.h"
+
+/// String to identify log entries originating from this file.
+static const std::string TAG("DecoderContextPool");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+constexpr size_t DecoderContextPool::DEFAULT_MAX_CONTEXTS;
+
+/**
+ * Get the key of the codec contexts which decode a stream: a context opened for other parameters may have set up
+ * the codec differently.
+ *
+ * @param parameters The parameters of the stream.
+ * @return The key.
+ */
+static std::string codecKeyOf(const AVCodecParameters& parameters) {
+    std::ostringstream stream;
+    stream << parameters.codec_id << ' ' << parameters.format << ' ' << parameters.sample_rate << ' '
+           << parameters.channel_layout << ' ' << parameters.channels << ' ' << parameters.block_align << ' '
+           << parameters.bits_per_coded_sample << ' ' << parameters.bits_per_raw_sample << ' '
+           << parameters.frame_size << ' ';
+    if (parameters.extradata && parameters.extradata_size > 0) {
+        stream.write(reinterpret_cast<const char*>(parameters.extradata), parameters.extradata_size);
+    }
+    return stream.str();
+}
+
+/**
+ * Get the key of the resamplers of a conversion.
+ *
+ * @return The key.
+ */
+static std::string resamplerKeyOf(
+    int64_t outputLayout,
+    AVSampleFormat outputFormat,
+    int outputRate,
+    int64_t inputLayout,
+    AVSampleFormat inputFormat,
+    int inputRate) {
+    std::ostringstream stream;
+    stream << outputLayout << ' ' << outputFormat << ' ' << outputRate << ' ' << inputLayout << ' ' << inputFormat
+           << ' ' << inputRate;
+    return stream.str();
+}
+
+std::shared_ptr<DecoderContextPool> DecoderContextPool::create(size_t maxContexts) {
+    if (0 == maxContexts) {
+        AISDK_ERROR(LX("createFailed").d("reason", "zeroMaxContexts"));
+        return nullptr;
+    }
+    return std::shared_ptr<DecoderContextPool>(new DecoderContextPool(maxContexts));
+}
+
+DecoderContextPool::DecoderContextPool(size_t maxContexts) :
+        m_maxContexts{maxContexts},
+        m_codecHitCounter{utils::metrics::MetricsRegistry::instance().getCounter(
+            "aisdk_decoder_context_pool_lookups_total",
+            {{"context", "codec"}, {"result", "hit"}},
+            "Codec contexts and resamplers asked of the decoder context pool, by whether the pool had one.")},
+        m_codecMissCounter{utils::metrics::MetricsRegistry::instance().getCounter(
+            "aisdk_decoder_context_pool_lookups_total", {{"context", "codec"}, {"result", "miss"}})},
+        m_resamplerHitCounter{utils::metrics::MetricsRegistry::instance().getCounter(
+            "aisdk_decoder_context_pool_lookups_total", {{"context", "resampler"}, {"result", "hit"}})},
+        m_resamplerMissCounter{utils::metrics::MetricsRegistry::instance().getCounter(
+            "aisdk_decoder_context_pool_lookups_total", {{"context", "resampler"}, {"result", "miss"}})} {
+}
+
+DecoderContextPool::~DecoderContextPool() {
+    for (auto& entry : m_codecContexts) {
+        avcodec_free_context(&entry.second);
+    }
+    for (auto& entry : m_resamplers) {
+        swr_free(&entry.second);
+    }
+}
+
+template <typename Context>
+Context* DecoderContextPool::takeLocked(IdleList<Context>& idle, const std::string& key) {
+    for (auto it = idle.rbegin(); it != idle.rend(); ++it) {
+        if (it->first == key) {
+            auto context = it->second;
+            idle.erase(std::next(it).base());
+            return context;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<AVCodecContext> DecoderContextPool::acquireCodecContext(
+    const AVCodecParameters& parameters,
+    const AVCodec* codec,
+    bool* isReused) {
+    auto key = codecKeyOf(parameters);
+    AVCodecContext* context = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        context = takeLocked(m_codecContexts, key);
+    }
+    *isReused = context != nullptr;
+    if (context) {
+        if (m_codecHitCounter) {
+            m_codecHitCounter->increment();
+        }
+    } else {
+        if (m_codecMissCounter) {
+            m_codecMissCounter->increment();
+        }
+        context = avcodec_alloc_context3(codec);
+        if (!context) {
+            AISDK_ERROR(LX("acquireCodecContextFailed").d("reason", "allocFailed"));
+            return nullptr;
+        }
+        auto status = avcodec_parameters_to_context(context, &parameters);
+        if (status >= 0) {
+            status = avcodec_open2(context, codec, nullptr);
+        }
+        if (status < 0) {
+            AISDK_ERROR(LX("acquireCodecContextFailed").d("reason", "openFailed").d("error", status));
+            avcodec_free_context(&context);
+            return nullptr;
+        }
+    }
+
+    std::weak_ptr<DecoderContextPool> pool = shared_from_this();
+    return std::shared_ptr<AVCodecContext>(
+        context, [pool, key](AVCodecContext* released) { releaseCodecContext(pool, key, released); });
+}
+
+std::shared_ptr<SwrContext> DecoderContextPool::acquireResampler(
+    int64_t outputLayout,
+    AVSampleFormat outputFormat,
+    int outputRate,
+    int64_t inputLayout,
+    AVSampleFormat inputFormat,
+    int inputRate,
+    bool* isReused) {
+    auto key = resamplerKeyOf(outputLayout, outputFormat, outputRate, inputLayout, inputFormat, inputRate);
+    SwrContext* context = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        context = takeLocked(m_resamplers, key);
+    }
+    *isReused = context != nullptr;
+    if (context) {
+        if (m_resamplerHitCounter) {
+            m_resamplerHitCounter->increment();
+        }
+    } else {
+        if (m_resamplerMissCounter) {
+            m_resamplerMissCounter->increment();
+        }
+        context = swr_alloc_set_opts(
+            nullptr, outputLayout, outputFormat, outputRate, inputLayout, inputFormat, inputRate, 0, nullptr);
+        if (!context) {
+            AISDK_ERROR(LX("acquireResamplerFailed").d("reason", "allocFailed"));
+            return nullptr;
+        }
+        auto status = swr_init(context);
+        if (status < 0) {
+            AISDK_ERROR(LX("acquireResamplerFailed").d("reason", "initFailed").d("error", status));
+            swr_free(&context);
+            return nullptr;
+        }
+    }
+
+    std::weak_ptr<DecoderContextPool> pool = shared_from_this();
+    return std::shared_ptr<SwrContext>(
+        context, [pool, key](SwrContext* released) { releaseResampler(pool, key, released); });
+}
+
+size_t DecoderContextPool::getIdleCount() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_codecContexts.size() + m_resamplers.size();
+}
+
+void DecoderContextPool::releaseCodecContext(
+    std::weak_ptr<DecoderContextPool> pool,
+    const std::string& key,
+    AVCodecContext* context) {
+    auto owner = pool.lock();
+    if (!owner) {
+        avcodec_free_context(&context);
+        return;
+    }
+
+    // Drop the frames and the draining state of the previous stream.
+    avcodec_flush_buffers(context);
+    AVCodecContext* evicted = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(owner->m_mutex);
+        owner->m_codecContexts.emplace_back(key, context);
+        if (owner->m_codecContexts.size() > owner->m_maxContexts) {
+            evicted = owner->m_codecContexts.front().second;
+            owner->m_codecContexts.pop_front();
+        }
+    }
+    if (evicted) {
+        avcodec_free_context(&evicted);
+    }
+}
+
+void DecoderContextPool::releaseResampler(
+    std::weak_ptr<DecoderContextPool> pool,
+    const std::string& key,
+    SwrContext* context) {
+    auto owner = pool.lock();
+    // Initializing again drops the samples buffered from the previous stream, and keeps the filter already built
+    // for the same conversion.
+    if (!owner || swr_init(context) < 0) {
+        swr_free(&context);
+        return;
+    }
+
+    SwrContext* evicted = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(owner->m_mutex);
+        owner->m_resamplers.emplace_back(key, context);
+        if (owner->m_resamplers.size() > owner->m_maxContexts) {
+            evicted = owner->m_resamplers.front().second;
+            owner->m_resamplers.pop_front();
+        }
+    }
+    if (evicted) {
+        swr_free(&evicted);
+    }
+}
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
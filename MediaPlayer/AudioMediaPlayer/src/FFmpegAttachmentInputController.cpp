@@ -134,6 +134,15 @@ bool FFmpegAttachmentInputController::next() {
     return false;
 }
 
+bool FFmpegAttachmentInputController::hasKnownCodecParameters() const {
+    // The raw PCM demuxer takes the sample format from its name and the rate and channels from the options.
+    return m_inputFormat && m_inputOptions;
+}
+
+std::string FFmpegAttachmentInputController::getInputType() const {
+    return m_inputFormat ? "attachment_pcm" : "attachment";
+}
+
 FFmpegAttachmentInputController::FFmpegAttachmentInputController(
     std::shared_ptr<AttachmentReader> reader,
     std::shared_ptr<AVInputFormat> inputFormat,
@@ -11,6 +11,7 @@
  * permissions and limitations under the License.
  */
 
+#include <algorithm>
 #include <atomic>
 #include <fstream>
 #include <thread>
@@ -22,6 +23,8 @@ extern "C" {
 }
 
 #include <Utils/Logging/Logger.h>
+#include <Utils/Metrics/MetricsRegistry.h>
+#include <Utils/Tracing/TraceEventRecorder.h>
 #include "AudioMediaPlayer/RetryTimer.h"
 #include "AudioMediaPlayer/FFmpegDecoder.h"
 #include "AudioMediaPlayer/FFmpegDeleter.h"
@@ -86,9 +89,60 @@ static LayoutMask convertLayout(PlaybackConfiguration::ChannelLayout layout) {
     return AV_CH_LAYOUT_STEREO;
 }
 
+/**
+ * Record the time taken to produce one decoded and resampled frame.
+ *
+ * @param duration The time taken.
+ */
+static void recordFrameDecodeTime(std::chrono::steady_clock::duration duration) {
+    static const auto histogram = utils::metrics::MetricsRegistry::instance().getHistogram(
+        "aisdk_decoder_frame_decode_microseconds", {}, "Time to demux, decode and resample one audio frame.");
+    if (histogram) {
+        histogram->record(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    }
+}
+
+/**
+ * Check whether the demuxer already found everything the codec and the resampler need to know about an audio stream,
+ * so that the stream does not need to be analyzed.
+ *
+ * @param context The opened format context.
+ * @return @c true if an audio stream has its codec, sample format, sample rate and channels.
+ */
+static bool hasCodecParameters(const AVFormatContext& context) {
+    for (unsigned int i = 0; i < context.nb_streams; ++i) {
+        auto parameters = context.streams[i]->codecpar;
+        if (AVMEDIA_TYPE_AUDIO == parameters->codec_type && AV_CODEC_ID_NONE != parameters->codec_id &&
+            parameters->format >= 0 && parameters->sample_rate > 0 && parameters->channels > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Get the bytes of the data buffers referenced by a frame.
+ *
+ * @param frame The frame.
+ * @return The bytes of the data buffers of @c frame.
+ */
+static size_t frameBufferBytes(const AVFrame& frame) {
+    size_t bytes = 0;
+    for (int i = 0; i < AV_NUM_DATA_POINTERS && frame.buf[i]; ++i) {
+        bytes += static_cast<size_t>(frame.buf[i]->size);
+    }
+    for (int i = 0; i < frame.nb_extended_buf; ++i) {
+        bytes += static_cast<size_t>(frame.extended_buf[i]->size);
+    }
+    return bytes;
+}
+
 std::unique_ptr<FFmpegDecoder> FFmpegDecoder::create(
     std::unique_ptr<FFmpegInputControllerInterface> inputController,
-    const PlaybackConfiguration& outputConfig) {
+    const PlaybackConfiguration& outputConfig,
+    bool allowResamplerBypass,
+    const ProbeConfiguration& probeConfig,
+    std::shared_ptr<DecoderContextPool> contextPool) {
     if (!inputController) {
 		AISDK_ERROR(LX("createFailed").d("reason", "nullInputController"));
         return nullptr;
@@ -98,23 +152,38 @@ std::unique_ptr<FFmpegDecoder> FFmpegDecoder::create(
     auto layout = convertLayout(outputConfig.channelLayout());
     int sampleRate = outputConfig.sampleRate();
 
-    return std::unique_ptr<FFmpegDecoder>(new FFmpegDecoder(std::move(inputController), format, layout, sampleRate));
+    return std::unique_ptr<FFmpegDecoder>(new FFmpegDecoder(
+        std::move(inputController), format, layout, sampleRate, allowResamplerBypass, probeConfig, contextPool));
 }
 
 FFmpegDecoder::FFmpegDecoder(
     std::unique_ptr<FFmpegInputControllerInterface> input,
     AVSampleFormat format,
     LayoutMask layout,
-    int sampleRate) :
+    int sampleRate,
+    bool allowResamplerBypass,
+    const ProbeConfiguration& probeConfig,
+    std::shared_ptr<DecoderContextPool> contextPool) :
         m_state{DecodingState::INITIALIZING},
         m_inputController{std::move(input)},
         m_outputFormat{format},   //add 
         m_outputLayout{layout},		//add 
         m_outputRate{sampleRate}, 	//add
-        m_unreadData{format, layout, sampleRate} {	//add
+        m_outputFrameBytes{static_cast<size_t>(
+            av_get_bytes_per_sample(format) * av_get_channel_layout_nb_channels(layout))},
+        m_allowResamplerBypass{allowResamplerBypass},
+        m_isBypassingResampler{false},
+        m_probeConfig{probeConfig},
+        m_contextPool{contextPool},
+        m_isAwaitingFirstFrame{false},
+        m_unreadData{format, layout, sampleRate},	//add
+        m_packet{av_packet_alloc(), AVPacketDeleter()},
+        m_decodedFrame{av_frame_alloc(), AVFrameDeleter()},
+        m_frameMemory{utils::metrics::MemoryAccounting::Subsystem::DECODER} {
 }
 
 std::pair<FFmpegDecoder::Status, size_t> FFmpegDecoder::read(Byte* buffer, size_t size) {
+    AISDK_TRACE_SCOPE("decoder", "FFmpegDecoder::read");
     if (!buffer || size == 0) {
 		AISDK_ERROR(LX("readFailed").d("reason", "invalidInput").d("buffer", buffer).d("size", size));
         return {Status::ERROR, 0};
@@ -132,8 +201,7 @@ std::pair<FFmpegDecoder::Status, size_t> FFmpegDecoder::read(Byte* buffer, size_
 
     m_retryCount = 0;
     size_t bytesRead = 0;
-    auto decodedFrame = std::shared_ptr<AVFrame>(av_frame_alloc(), AVFrameDeleter());
-    while (m_state != DecodingState::FINISHED && m_state != DecodingState::INVALID) {
+    while (m_state != DecodingState::FINISHED && m_state != DecodingState::INVALID && bytesRead < size) {
         if (!m_unreadData.isEmpty()) {
             auto lastReadSize = readData(buffer, size, bytesRead);
             if (lastReadSize == 0) {
@@ -145,6 +213,7 @@ std::pair<FFmpegDecoder::Status, size_t> FFmpegDecoder::read(Byte* buffer, size_
             }
             bytesRead += lastReadSize;
         } else {
+            auto decodeStart = std::chrono::steady_clock::now();
             if (m_state == DecodingState::INITIALIZING) {
                 initialize();
             }
@@ -158,11 +227,21 @@ std::pair<FFmpegDecoder::Status, size_t> FFmpegDecoder::read(Byte* buffer, size_
             }
 
             if (m_state <= DecodingState::FLUSHING_DECODER) {
-                readDecodedFrame(decodedFrame);
+                readDecodedFrame(m_decodedFrame);
             }
 
-            if (m_state < DecodingState::FLUSHING_RESAMPLER && (decodedFrame->nb_samples > 0)) {
-                resample(decodedFrame);
+            if (m_state < DecodingState::FLUSHING_RESAMPLER && (m_decodedFrame->nb_samples > 0)) {
+                // Resample straight to the caller when the frame fits, and through m_unreadData otherwise.
+                size_t bytesWritten = 0;
+                if (resampleTo(m_decodedFrame, buffer + bytesRead, size - bytesRead, &bytesWritten)) {
+                    bytesRead += bytesWritten;
+                } else {
+                    resample(m_decodedFrame);
+                }
+                recordFrameDecodeTime(std::chrono::steady_clock::now() - decodeStart);
+                if (m_isAwaitingFirstFrame) {
+                    recordTimeToFirstFrame();
+                }
             }
         }
     }
@@ -199,6 +278,11 @@ bool FFmpegDecoder::shouldInterruptFFmpeg() {
 }
 
 void FFmpegDecoder::initialize() {
+    if (!m_isAwaitingFirstFrame) {
+        m_isAwaitingFirstFrame = true;
+        m_trackStartTime = std::chrono::steady_clock::now();
+    }
+
     FFmpegInputControllerInterface::Result result;
     std::chrono::milliseconds initialPosition;
 	auto avformatContext = m_inputController->createNewFormatContext();
@@ -208,6 +292,13 @@ void FFmpegDecoder::initialize() {
         return;
 	}
 
+    if (m_probeConfig.isFastStart()) {
+        // FFmpeg's own limits read seconds of a network stream before the first frame.
+        avformatContext->probesize = m_probeConfig.probeSize();
+        avformatContext->max_analyze_duration =
+            std::chrono::duration_cast<std::chrono::microseconds>(m_probeConfig.analyzeDuration()).count();
+    }
+
 	/// Set interrupt callback logic.
 #if 1
 	avformatContext->interrupt_callback.callback = shouldInterrupt;
@@ -231,9 +322,17 @@ void FFmpegDecoder::initialize() {
     m_formatContext->interrupt_callback.opaque = this;
 	m_initializeStartTime = std::chrono::steady_clock::now();
 #endif
-    auto status = avformat_find_stream_info(m_formatContext.get(), nullptr);
-    if (!transitionStateUsingStatus(status, DecodingState::INVALID, "initialize::findStreamInfo")) {
-        return;
+    // Analyzing the stream reads and decodes packets until the codec parameters are found, so skip it when they are
+    // known already.
+    int status = NO_ERROR;
+    if (m_probeConfig.isFastStart() &&
+        (m_inputController->hasKnownCodecParameters() || hasCodecParameters(*m_formatContext))) {
+        AISDK_DEBUG(LX("initialize").d("reason", "streamInfoSkipped").d("input", m_inputController->getInputType()));
+    } else {
+        status = avformat_find_stream_info(m_formatContext.get(), nullptr);
+        if (!transitionStateUsingStatus(status, DecodingState::INVALID, "initialize::findStreamInfo")) {
+            return;
+        }
     }
 
     AVCodec* codec = nullptr;  // We don't own the codec.
@@ -255,13 +354,37 @@ void FFmpegDecoder::initialize() {
     }
 
 AISDK_DEBUG5(LX("initialDurations").d("durations(ms)", m_formatContext->duration));
-    m_codecContext = std::shared_ptr<AVCodecContext>(avcodec_alloc_context3(codec), AVContextDeleter());
-    avcodec_parameters_to_context(m_codecContext.get(), m_formatContext->streams[streamIndex]->codecpar);
-    status = avcodec_open2(m_codecContext.get(), codec, nullptr);
-    if (!transitionStateUsingStatus(status, m_state, "initialize::openCodec")) {
+    if (!setUpContexts(streamIndex, codec)) {
         return;
     }
 
+    setState(DecodingState::DECODING);
+}
+
+bool FFmpegDecoder::setUpContexts(int streamIndex, AVCodec* codec) {
+    auto setupStart = std::chrono::steady_clock::now();
+    // The contexts of a previous track go back to the pool first, where this track may take them again.
+    m_codecContext.reset();
+    m_swrContext.reset();
+
+    bool isCodecReused = false;
+    if (m_contextPool) {
+        m_codecContext =
+            m_contextPool->acquireCodecContext(*m_formatContext->streams[streamIndex]->codecpar, codec, &isCodecReused);
+        if (!m_codecContext) {
+            AISDK_ERROR(LX("initializedFailed").d("reason", "acquireCodecContextFailed"));
+            setState(DecodingState::INVALID);
+            return false;
+        }
+    } else {
+        m_codecContext = std::shared_ptr<AVCodecContext>(avcodec_alloc_context3(codec), AVContextDeleter());
+        avcodec_parameters_to_context(m_codecContext.get(), m_formatContext->streams[streamIndex]->codecpar);
+        auto status = avcodec_open2(m_codecContext.get(), codec, nullptr);
+        if (!transitionStateUsingStatus(status, m_state, "initialize::openCodec")) {
+            return false;
+        }
+    }
+
     if (0 == m_codecContext->channel_layout) {
         // Some codecs do not fill up this property, so use default layout.
         m_codecContext->channel_layout = av_get_default_channel_layout(m_codecContext->channels);
@@ -270,62 +393,114 @@ AISDK_DEBUG5(LX("initialDurations").d("durations(ms)", m_formatContext->duration
 				.d("channels", m_codecContext->channels)
 				.d("sample_rate", m_codecContext->sample_rate)
 				.d("out_sample_rate", m_outputRate)
-				.d("out_layout_channel", m_outputLayout));
-
-    m_swrContext = std::shared_ptr<SwrContext>(
-        swr_alloc_set_opts(
-            nullptr,
-            m_outputLayout,                  // output channels
-            m_outputFormat,                  // output format (signed 16 bits)
-            m_outputRate,                    // output sample rate
-            m_codecContext->channel_layout,  // input channel layout
-            m_codecContext->sample_fmt,      // input sample format
-            m_codecContext->sample_rate,     // input sample rate
-            0,                               // logging
-            NULL),
-        SwrContextDeleter());
-    if (!m_swrContext) {
-		AISDK_ERROR(LX("initializedFailed").d("reason", "allocResamplerFailed"));
-        setState(DecodingState::INVALID);
-        return;
-    }
+				.d("out_layout_channel", m_outputLayout)
+				.d("codecReused", isCodecReused));
+
+    // Input already in the output format, like most TTS, only needs to be copied out of the decoded frames.
+    m_isBypassingResampler = m_allowResamplerBypass && m_codecContext->sample_fmt == m_outputFormat &&
+                             m_codecContext->sample_rate == m_outputRate &&
+                             static_cast<LayoutMask>(m_codecContext->channel_layout) == m_outputLayout;
+    if (m_isBypassingResampler) {
+        AISDK_INFO(LX("initialized").d("reason", "resamplerBypassed"));
+    } else if (m_contextPool) {
+        bool isResamplerReused = false;
+        m_swrContext = m_contextPool->acquireResampler(
+            m_outputLayout,
+            m_outputFormat,
+            m_outputRate,
+            m_codecContext->channel_layout,
+            m_codecContext->sample_fmt,
+            m_codecContext->sample_rate,
+            &isResamplerReused);
+        if (!m_swrContext) {
+            AISDK_ERROR(LX("initializedFailed").d("reason", "acquireResamplerFailed"));
+            setState(DecodingState::INVALID);
+            return false;
+        }
+    } else {
+        m_swrContext = std::shared_ptr<SwrContext>(
+            swr_alloc_set_opts(
+                nullptr,
+                m_outputLayout,                  // output channels
+                m_outputFormat,                  // output format (signed 16 bits)
+                m_outputRate,                    // output sample rate
+                m_codecContext->channel_layout,  // input channel layout
+                m_codecContext->sample_fmt,      // input sample format
+                m_codecContext->sample_rate,     // input sample rate
+                0,                               // logging
+                NULL),
+            SwrContextDeleter());
+        if (!m_swrContext) {
+            AISDK_ERROR(LX("initializedFailed").d("reason", "allocResamplerFailed"));
+            setState(DecodingState::INVALID);
+            return false;
+        }
 
-    status = swr_init(m_swrContext.get());
-    if (!transitionStateUsingStatus(status, DecodingState::INVALID, "initialize::initContext")) {
-        return;
+        auto status = swr_init(m_swrContext.get());
+        if (!transitionStateUsingStatus(status, DecodingState::INVALID, "initialize::initContext")) {
+            return false;
+        }
     }
 
-    setState(DecodingState::DECODING);
+    // The time of each turn spent in opening the codec and building the resampler, which the pool saves.
+    auto elapsed =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - setupStart);
+    auto histogram = utils::metrics::MetricsRegistry::instance().getHistogram(
+        "aisdk_decoder_context_setup_microseconds",
+        {{"pool", m_contextPool ? (isCodecReused ? "hit" : "miss") : "off"}},
+        "Time to set up the codec context and the resampler of a track, by whether a pooled codec context was used.");
+    if (histogram) {
+        histogram->record(static_cast<uint64_t>(elapsed.count()));
+    }
+    return true;
 }
 
-size_t FFmpegDecoder::readData(Byte* buffer, size_t size, size_t bytesRead) {
-    // Use av_samples_copy to partially copy the frame and avoid buffer too small issue.
-    auto& frame = m_unreadData.getFrame();
-
-    size_t sampleSizeBytes = av_samples_get_buffer_size(
-       nullptr, frame.channels, frame.nb_samples, (AVSampleFormat)frame.format, NO_ALIGNMENT);
-		/// Debug pre sample frame size
-		//std::cout << "sampleSize: " << sampleSizeBytes << std::endl;
-		//AISDK_DEBUG5(LX("readData").d("sampleSize", sampleSizeBytes));
-    if ((sampleSizeBytes % (sizeof(buffer[0]) * frame.channels)) != 0) {
-        // Sample size should be format size * number of channels. This may cause glitches in the audio.
-        AISDK_WARN(LX("readDataTruncated")
-                       .d("reason", "Unexpected sample size")
-                       .d("sampleSize", sampleSizeBytes)
-                       .d("wordSize", sizeof(buffer[0]))
-                       .d("channels", frame.channels));
-
+void FFmpegDecoder::recordTimeToFirstFrame() {
+    m_isAwaitingFirstFrame = false;
+    auto elapsed =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_trackStartTime);
+    auto input = m_inputController->getInputType();
+    AISDK_INFO(LX("firstFrame").d("input", input).d("elapsed(ms)", elapsed.count()));
+
+    auto histogram = utils::metrics::MetricsRegistry::instance().getHistogram(
+        "aisdk_decoder_first_frame_milliseconds",
+        {{"input", input}},
+        "Time from the start of the decoder initialization to the first decoded frame.");
+    if (histogram) {
+        histogram->record(static_cast<uint64_t>(elapsed.count()));
     }
+}
 
-    if (size >= bytesRead + sampleSizeBytes) {
-        // Have enough space. Read the entire frame.
-        size_t writeOffset = bytesRead;
-        memcpy(buffer + writeOffset, frame.data[0], sampleSizeBytes);
-        m_unreadData.setOffset(frame.nb_samples);
-        return sampleSizeBytes;
+void FFmpegDecoder::reportProgress() {
+    auto duration = m_formatContext->duration;
+    if (AV_NOPTS_VALUE == duration || duration <= 0 || AV_NOPTS_VALUE == m_packet->pts ||
+        m_packet->stream_index < 0 || static_cast<unsigned>(m_packet->stream_index) >= m_formatContext->nb_streams) {
+        return;
     }
+    auto stream = m_formatContext->streams[m_packet->stream_index];
+    auto pts = m_packet->pts - (AV_NOPTS_VALUE == stream->start_time ? 0 : stream->start_time);
+    m_inputController->onDecodeProgress(
+        std::chrono::milliseconds(av_rescale_q(pts, stream->time_base, AVRational{1, 1000})),
+        std::chrono::milliseconds(duration / (AV_TIME_BASE / 1000)));
+}
+
+size_t FFmpegDecoder::readData(Byte* buffer, size_t size, size_t bytesRead) {
+    // The output format is packed, so the unread samples of all channels follow each other in data[0].
+    auto& frame = m_unreadData.getFrame();
+    auto offset = m_unreadData.getOffset();
+    auto samples = std::min(static_cast<size_t>(frame.nb_samples - offset), (size - bytesRead) / m_outputFrameBytes);
+    auto bytes = samples * m_outputFrameBytes;
+    memcpy(buffer + bytesRead, frame.data[0] + offset * m_outputFrameBytes, bytes);
+    m_unreadData.setOffset(offset + static_cast<int>(samples));
+    return bytes;
+}
 
-    return 0;
+int FFmpegDecoder::maxResampledSamples(const AVFrame& inputFrame) {
+    return av_rescale_rnd(
+        swr_get_delay(m_swrContext.get(), m_codecContext->sample_rate) + inputFrame.nb_samples,
+        m_outputRate,
+        m_codecContext->sample_rate,
+        AV_ROUND_UP);
 }
 
 void FFmpegDecoder::resample(std::shared_ptr<AVFrame> inputFrame) {
@@ -336,20 +511,59 @@ void FFmpegDecoder::resample(std::shared_ptr<AVFrame> inputFrame) {
 				.d("codec_sample_rate", m_codecContext->sample_rate)
 				.d("m_outputRate", m_outputRate));
 #endif	
-    int outSamples = av_rescale_rnd(
-        swr_get_delay(m_swrContext.get(), m_codecContext->sample_rate) + inputFrame->nb_samples,
-        m_outputRate,
-        m_codecContext->sample_rate,
-        AV_ROUND_UP);
-    m_unreadData.resize(outSamples);
+    if (m_isBypassingResampler) {
+        m_unreadData.takeFrame(*inputFrame);
+        m_frameMemory.resize(frameBufferBytes(m_unreadData.getFrame()));
+        return;
+    }
+    if (!m_unreadData.resize(maxResampledSamples(*inputFrame))) {
+        av_frame_unref(inputFrame.get());
+        setState(DecodingState::INVALID);
+        return;
+    }
     auto error = swr_convert_frame(m_swrContext.get(), &m_unreadData.getFrame(), inputFrame.get());
     transitionStateUsingStatus(error, DecodingState::INVALID, __func__);
+    // Hand the decoded buffers back to the codec pool right away; the frame itself is reused for the next one.
+    av_frame_unref(inputFrame.get());
+    m_frameMemory.resize(frameBufferBytes(m_unreadData.getFrame()));
+}
+
+bool FFmpegDecoder::resampleTo(std::shared_ptr<AVFrame> inputFrame, Byte* buffer, size_t size, size_t* bytesWritten) {
+    if (m_isBypassingResampler) {
+        auto bytes = static_cast<size_t>(inputFrame->nb_samples) * m_outputFrameBytes;
+        if (bytes > size) {
+            return false;
+        }
+        memcpy(buffer, inputFrame->data[0], bytes);
+        *bytesWritten = bytes;
+        av_frame_unref(inputFrame.get());
+        return true;
+    }
+
+    auto maxSamples = maxResampledSamples(*inputFrame);
+    if (static_cast<size_t>(maxSamples) * m_outputFrameBytes > size) {
+        return false;
+    }
+    uint8_t* output[] = {buffer};
+    auto samples = swr_convert(
+        m_swrContext.get(),
+        output,
+        maxSamples,
+        const_cast<const uint8_t**>(inputFrame->extended_data),
+        inputFrame->nb_samples);
+    if (transitionStateUsingStatus(samples, DecodingState::INVALID, __func__)) {
+        *bytesWritten = static_cast<size_t>(samples) * m_outputFrameBytes;
+    }
+    av_frame_unref(inputFrame.get());
+    return true;
 }
 
 void FFmpegDecoder::decode() {
-    auto packet = std::shared_ptr<AVPacket>(av_packet_alloc(), AVPacketDeleter());
-    auto status = av_read_frame(m_formatContext.get(), packet.get());
+    auto status = av_read_frame(m_formatContext.get(), m_packet.get());
     if (transitionStateUsingStatus(status, m_state, "decode::readFrame")) {
+        if (status >= 0) {
+            reportProgress();
+        }
         if (AVERROR_EOF == status) {
             if (!m_inputController->hasNext()) {
                 setState(DecodingState::FLUSHING_DECODER);
@@ -359,9 +573,11 @@ void FFmpegDecoder::decode() {
         }
 
         // Note: We still need to send empty packet when we find an EOF.
-        status = avcodec_send_packet(m_codecContext.get(), packet.get());
+        status = avcodec_send_packet(m_codecContext.get(), m_packet.get());
         transitionStateUsingStatus(status, m_state, "decode::sendPacket");
     }
+    // The codec holds its own reference to the data, so the packet can be emptied for the next one.
+    av_packet_unref(m_packet.get());
 
 }
 
@@ -430,11 +646,11 @@ void FFmpegDecoder::setState(FFmpegDecoder::DecodingState nextState) {
 bool FFmpegDecoder::transitionStateUsingStatus(
     int status,
     FFmpegDecoder::DecodingState nextState,
-    const std::string& functionName) {
+    const char* functionName) {
     if (status < 0) {
         // We'll try to keep decoding if error was due to buffer under run or corrupted data.
         if (-EAGAIN == status || AVERROR_INVALIDDATA == status) {
-            AISDK_ERROR(LX(functionName + "Failed").d("error", "tryAgain"));
+            AISDK_ERROR(LX(std::string(functionName) + "Failed").d("error", "tryAgain"));
             // Manually reset these variables since aviobuf::fill_buffer() set eof_reached even for EAGAIN error, which
             // invalidate future read operations.
             m_formatContext->pb->eof_reached = 0;
@@ -444,8 +660,8 @@ bool FFmpegDecoder::transitionStateUsingStatus(
         }
 
         if (status != AVERROR_EOF) {
-            //AISDK_ERROR(LX(functionName + "Failed").d("error", av_err2str(status)));
-			AISDK_ERROR(LX(functionName + "Failed"));
+            //AISDK_ERROR(LX(std::string(functionName) + "Failed").d("error", av_err2str(status)));
+			AISDK_ERROR(LX(std::string(functionName) + "Failed"));
             setState(DecodingState::INVALID);
             return false;
         }
@@ -474,16 +690,39 @@ int FFmpegDecoder::UnreadData::getOffset() const {
     return m_offset;
 }
 
-void FFmpegDecoder::UnreadData::resize(size_t minimumCapacity) {
+bool FFmpegDecoder::UnreadData::resize(size_t minimumCapacity) {
+    m_offset = 0;
     if (m_capacity < minimumCapacity) {
-        auto oldFrame = m_frame;
-        m_frame = std::shared_ptr<AVFrame>(av_frame_alloc(), AVFrameDeleter());
-        m_frame->format = oldFrame->format;
-        m_frame->sample_rate = oldFrame->sample_rate;
-        m_frame->channel_layout = oldFrame->channel_layout;
-        m_capacity = minimumCapacity;
-    }
-    m_frame->nb_samples = m_capacity;
+        // Keep the frame and only replace its buffers, allocated here for the whole capacity: a frame without buffers
+        // would be allocated by @c swr_convert_frame() for the current frame only.
+        auto format = m_frame->format;
+        auto sampleRate = m_frame->sample_rate;
+        auto channelLayout = m_frame->channel_layout;
+        auto capacity = std::max(minimumCapacity, m_capacity * 2);
+        av_frame_unref(m_frame.get());
+        m_capacity = 0;
+        m_frame->format = format;
+        m_frame->sample_rate = sampleRate;
+        m_frame->channel_layout = channelLayout;
+        m_frame->nb_samples = static_cast<int>(capacity);
+        auto error = av_frame_get_buffer(m_frame.get(), 0);
+        if (error < 0) {
+            AISDK_ERROR(LX("resizeFailed").d("reason", "getBufferFailed").d("samples", capacity).d("error", error));
+            m_frame->nb_samples = 0;
+            return false;
+        }
+        m_capacity = capacity;
+    }
+    // The converter writes at most this many samples, and sets the number it wrote.
+    m_frame->nb_samples = static_cast<int>(m_capacity);
+    return true;
+}
+
+void FFmpegDecoder::UnreadData::takeFrame(AVFrame& frame) {
+    av_frame_unref(m_frame.get());
+    av_frame_move_ref(m_frame.get(), &frame);
+    // The buffers now come from the codec pool, so the next resize() has to allocate buffers of its own.
+    m_capacity = 0;
     m_offset = 0;
 }
 
@@ -495,6 +734,10 @@ void FFmpegDecoder::UnreadData::setOffset(int offset) {
     m_offset = offset;
 }
 
+FFmpegDecoder::DecodingState FFmpegDecoder::getState() const {
+    return m_state;
+}
+
 #define STATE_TO_STREAM(name, stream)        \
     case FFmpegDecoder::DecodingState::name: \
         return stream << #name;
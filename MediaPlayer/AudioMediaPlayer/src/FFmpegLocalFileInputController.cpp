@@ -0,0 +1,298 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavformat/avio.h>
+#include <libavutil/common.h>
+#include <libavutil/error.h>
+}
+
+#include <Utils/Logging/Logger.h>
+#include "AudioMediaPlayer/FFmpegDeleter.h"
+#include "AudioMediaPlayer/FFmpegLocalFileInputController.h"
+
+/// String to identify log entries originating from this file.
+static const std::string TAG("FFmpegLocalFileInputController");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/// The reads are plain copies from the mapping or single @c pread calls, so a larger buffer only means fewer calls.
+static constexpr int BUFFER_SIZE{32768};
+
+/// The prefix of the urls of local files.
+static const std::string FILE_SCHEME{"file://"};
+
+std::unique_ptr<FFmpegLocalFileInputController> FFmpegLocalFileInputController::create(
+    const std::string& path,
+    std::chrono::milliseconds offset,
+    bool repeat,
+    bool isOwned) {
+    if (offset < std::chrono::milliseconds::zero()) {
+        AISDK_ERROR(LX("createFailed").d("reason", "negativeOffset").d("offset", offset.count()));
+        return nullptr;
+    }
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        AISDK_ERROR(LX("createFailed").d("reason", "openFailed").d("path", path).d("errno", errno));
+        return nullptr;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode) || fileStat.st_size <= 0) {
+        AISDK_ERROR(LX("createFailed").d("reason", "notARegularFile").d("path", path));
+        close(fd);
+        return nullptr;
+    }
+
+    if (!isOwned) {
+        // Another process may truncate the file while it is played, which would raise SIGBUS on a read of the mapping.
+        return std::unique_ptr<FFmpegLocalFileInputController>(
+            new FFmpegLocalFileInputController(nullptr, fd, fileStat.st_size, offset, repeat));
+    }
+
+    auto size = static_cast<size_t>(fileStat.st_size);
+    auto mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping holds its own reference to the file.
+    close(fd);
+    if (MAP_FAILED == mapping) {
+        AISDK_ERROR(LX("createFailed").d("reason", "mmapFailed").d("path", path).d("errno", errno));
+        return nullptr;
+    }
+    // The decoder reads the file from its start to its end, except for a few seeks to find the duration.
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    std::shared_ptr<const uint8_t> content(
+        static_cast<const uint8_t*>(mapping), [size](const uint8_t* data) { munmap(const_cast<uint8_t*>(data), size); });
+    return std::unique_ptr<FFmpegLocalFileInputController>(
+        new FFmpegLocalFileInputController(content, -1, fileStat.st_size, offset, repeat));
+}
+
+bool FFmpegLocalFileInputController::getLocalPath(const std::string& url, std::string* path) {
+    if (url.compare(0, FILE_SCHEME.size(), FILE_SCHEME) == 0) {
+        *path = url.substr(FILE_SCHEME.size());
+        return !path->empty();
+    }
+    if (url.empty() || url.find("://") != std::string::npos) {
+        return false;
+    }
+    *path = url;
+    return true;
+}
+
+int FFmpegLocalFileInputController::read(uint8_t* buffer, int bufferSize) {
+    if (m_position >= m_size) {
+        return AVERROR_EOF;
+    }
+    auto bytesToRead = static_cast<int>(std::min<int64_t>(bufferSize, m_size - m_position));
+    if (m_mapping) {
+        memcpy(buffer, m_mapping.get() + m_position, bytesToRead);
+        m_position += bytesToRead;
+        return bytesToRead;
+    }
+
+    ssize_t bytesRead;
+    do {
+        bytesRead = pread(m_fd, buffer, bytesToRead, m_position);
+    } while (bytesRead < 0 && EINTR == errno);
+    if (bytesRead < 0) {
+        AISDK_ERROR(LX("readFailed").d("reason", "preadFailed").d("position", m_position).d("errno", errno));
+        return AVERROR(errno);
+    }
+    if (0 == bytesRead) {
+        // The file was truncated while it was played.
+        return AVERROR_EOF;
+    }
+    m_position += bytesRead;
+    return static_cast<int>(bytesRead);
+}
+
+int64_t FFmpegLocalFileInputController::seek(int64_t offset, int whence) {
+    int64_t position;
+    switch (whence & ~AVSEEK_FORCE) {
+        case AVSEEK_SIZE:
+            return m_size;
+        case SEEK_SET:
+            position = offset;
+            break;
+        case SEEK_CUR:
+            position = m_position + offset;
+            break;
+        case SEEK_END:
+            position = m_size + offset;
+            break;
+        default:
+            AISDK_ERROR(LX("seekFailed").d("reason", "unsupportedWhence").d("whence", whence));
+            return AVERROR(EINVAL);
+    }
+    if (position < 0) {
+        AISDK_ERROR(LX("seekFailed").d("reason", "negativePosition").d("position", position));
+        return AVERROR(EINVAL);
+    }
+    // A position past the end is kept, and the next read reports the end of the file.
+    m_position = position;
+    return m_position;
+}
+
+bool FFmpegLocalFileInputController::hasNext() const {
+    return m_repeat;
+}
+
+bool FFmpegLocalFileInputController::next() {
+    if (!m_repeat) {
+        AISDK_ERROR(LX("nextFailed").d("reason", "repeatIsOff"));
+        return false;
+    }
+
+    // The file is still mapped or open: rewinding is only moving the read position.
+    m_position = 0;
+    m_offset = std::chrono::milliseconds::zero();
+    return true;
+}
+
+std::string FFmpegLocalFileInputController::getInputType() const {
+    return m_mapping ? "mappedFile" : "file";
+}
+
+FFmpegLocalFileInputController::FFmpegLocalFileInputController(
+    std::shared_ptr<const uint8_t> mapping,
+    int fd,
+    int64_t size,
+    std::chrono::milliseconds offset,
+    bool repeat) :
+        m_mapping{mapping},
+        m_fd{fd},
+        m_size{size},
+        m_position{0},
+        m_offset{offset},
+        m_repeat{repeat},
+        m_avFormatContext{nullptr} {
+}
+
+AVFormatContext* FFmpegLocalFileInputController::createNewFormatContext() {
+    m_avFormatContext = avformat_alloc_context();
+    if (!m_avFormatContext) {
+        AISDK_ERROR(LX("createNewContextFailed").d("reason", "avFormatAllocFailed"));
+        return nullptr;
+    }
+
+    return m_avFormatContext;
+}
+
+std::tuple<FFmpegInputControllerInterface::Result, std::shared_ptr<AVFormatContext>, std::chrono::milliseconds>
+FFmpegLocalFileInputController::getCurrentFormatContextOpen() {
+    if (!m_avFormatContext) {
+        AISDK_ERROR(LX("getContextFailed").d("reason", "avFormatIsnullptr"));
+        return std::make_tuple(Result::ERROR, nullptr, std::chrono::milliseconds::zero());
+    }
+
+    // Open the context given to the decoder, which carries its interrupt callback and probing limits.
+    auto avFormatContext = m_avFormatContext;
+    // Clear the original pointer to prepare for the next creation.
+    m_avFormatContext = nullptr;
+
+    if (m_ioContext) {
+        // Invalidate possible references to this object.
+        m_ioContext->opaque = nullptr;
+    }
+
+    unsigned char* buffer =
+        static_cast<unsigned char*>(av_malloc(BUFFER_SIZE + AVPROBE_PADDING_SIZE));  // Owned by m_ioContext
+    if (!buffer) {
+        AISDK_ERROR(LX("getContextFailed").d("reason", "avMallocFailed"));
+        avformat_free_context(avFormatContext);
+        return std::make_tuple(Result::ERROR, nullptr, std::chrono::milliseconds::zero());
+    }
+
+    auto ioContext = avio_alloc_context(buffer, BUFFER_SIZE, false, this, feedBuffer, nullptr, seekBuffer);
+    if (!ioContext) {
+        AISDK_ERROR(LX("getContextFailed").d("reason", "avioAllocFailed"));
+        av_free(buffer);
+        avformat_free_context(avFormatContext);
+        return std::make_tuple(Result::ERROR, nullptr, std::chrono::milliseconds::zero());
+    }
+    m_ioContext = std::shared_ptr<AVIOContext>(ioContext, AVIOContextDeleter());
+
+    avFormatContext->pb = m_ioContext.get();
+
+    auto error = avformat_open_input(&avFormatContext, "", nullptr, nullptr);
+    if (error != 0) {
+        // The avFormatContext will be freed on failure.
+        AISDK_ERROR(LX("getContextFailed").d("reason", "openInputFailed").d("error", error));
+        return std::make_tuple(Result::ERROR, nullptr, std::chrono::milliseconds::zero());
+    }
+
+    // The offset only applies to the first play; the following ones start over.
+    auto offset = m_offset;
+    m_offset = std::chrono::milliseconds::zero();
+
+    // The context keeps the mapping it reads from, should it outlive this controller.
+    auto ioContextOwner = m_ioContext;
+    auto mapping = m_mapping;
+    return std::make_tuple(
+        Result::OK,
+        std::shared_ptr<AVFormatContext>(
+            avFormatContext, [ioContextOwner, mapping](AVFormatContext* context) { AVFormatContextDeleter()(context); }),
+        offset);
+}
+
+int FFmpegLocalFileInputController::feedBuffer(void* userData, uint8_t* buffer, int bufferSize) {
+    auto inputController = reinterpret_cast<FFmpegLocalFileInputController*>(userData);
+    if (!inputController) {
+        AISDK_ERROR(LX("feedBufferFailed").d("reason", "nullInputController"));
+        return AVERROR_EXTERNAL;
+    }
+    return inputController->read(buffer, bufferSize);
+}
+
+int64_t FFmpegLocalFileInputController::seekBuffer(void* userData, int64_t offset, int whence) {
+    auto inputController = reinterpret_cast<FFmpegLocalFileInputController*>(userData);
+    if (!inputController) {
+        AISDK_ERROR(LX("seekBufferFailed").d("reason", "nullInputController"));
+        return AVERROR_EXTERNAL;
+    }
+    return inputController->seek(offset, whence);
+}
+
+FFmpegLocalFileInputController::~FFmpegLocalFileInputController() {
+    if (m_ioContext) {
+        m_ioContext->opaque = nullptr;
+    }
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
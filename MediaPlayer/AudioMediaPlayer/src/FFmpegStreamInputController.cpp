@@ -79,9 +79,14 @@ bool FFmpegStreamInputController::next() {
     return m_stream->good();
 }
 
+std::string FFmpegStreamInputController::getInputType() const {
+    return "stream";
+}
+
 FFmpegStreamInputController::FFmpegStreamInputController(std::shared_ptr<std::istream> stream, bool repeat) :
         m_stream{stream},
-        m_repeat{repeat} {
+        m_repeat{repeat},
+        m_avFormatContext{nullptr} {
 }
 
 
@@ -98,6 +103,16 @@ AVFormatContext* FFmpegStreamInputController::createNewFormatContext() {
 
 std::tuple<FFmpegInputControllerInterface::Result, std::shared_ptr<AVFormatContext>, std::chrono::milliseconds>
 FFmpegStreamInputController::getCurrentFormatContextOpen() {
+	if(!m_avFormatContext) {
+		AISDK_ERROR(LX("getContextFailed").d("reason", "avFormatIsnullptr"));
+        return std::make_tuple(Result::ERROR, nullptr, std::chrono::milliseconds::zero());
+	}
+
+	// Open the context given to the decoder, which carries its interrupt callback and probing limits.
+	auto avFormatContext = m_avFormatContext;
+	// Clear the original pointer to prepare for the next creation.
+	m_avFormatContext = nullptr;
+
     if (m_ioContext) {
         // Invalidate possible references to this object.
         m_ioContext->opaque = nullptr;
@@ -116,6 +131,7 @@ FFmpegStreamInputController::getCurrentFormatContextOpen() {
 		 * }
 		 * so we need to use make_tuple to make a correction
 		 */
+        avformat_free_context(avFormatContext);
         return std::make_tuple(Result::ERROR, nullptr, std::chrono::milliseconds::zero());
     }
 
@@ -123,13 +139,7 @@ FFmpegStreamInputController::getCurrentFormatContextOpen() {
         avio_alloc_context(buffer, BUFFER_SIZE, false, this, feedBuffer, nullptr, nullptr), AVIOContextDeleter());
     if (!m_ioContext) {
 		AISDK_ERROR(LX("getContextFailed").d("reason", "avioAllocFailed"));
-        return std::make_tuple(Result::ERROR, nullptr, std::chrono::milliseconds::zero());
-    }
-
-    // Allocate the AVFormatContext:
-    auto avFormatContext = avformat_alloc_context();
-    if (!avFormatContext) {
-		AISDK_ERROR(LX("getContextFailed").d("reason", "avFormatAllocFailed"));
+        avformat_free_context(avFormatContext);
         return std::make_tuple(Result::ERROR, nullptr, std::chrono::milliseconds::zero());
     }
 
@@ -10,15 +10,21 @@
  * permissions and limitations under the License.
  */
 
+#include <map>
+#include <string>
+
 extern "C" {
 #include <libavformat/avformat.h>
+#include <libavformat/avio.h>
 #include <libavutil/common.h>
 #include <libavutil/error.h>
 }
 
 #include <Utils/Logging/Logger.h>
+#include <Utils/Logging/ThreadMoniker.h>
 #include "AudioMediaPlayer/FFmpegDeleter.h"
 #include "AudioMediaPlayer/FFmpegUrlInputController.h"
+#include "AudioMediaPlayer/MediaUrl.h"
 
 /// String to identify log entries originating from this file.
 static const std::string TAG("FFmpegUrlInputController");
@@ -29,21 +35,107 @@ namespace aisdk {
 namespace mediaPlayer {
 namespace ffmpeg {
 
-/// This string represents the FFmpeg HTTP User-Agent option key.
-static const char* USER_AGENT_OPTION{"user_agent"};
+/// The size of the buffer FFmpeg reads cached content into, the default of FFmpeg.
+static constexpr int CACHE_BUFFER_SIZE{32768};
+
+/// The FFmpeg demuxers of the file extensions which are opened without probing their format.
+static const std::map<std::string, std::string> EXTENSION_INPUT_FORMATS = {
+    {"mp3", "mp3"}, {"aac", "aac"}, {"wav", "wav"}, {"flac", "flac"}, {"ogg", "ogg"}, {"opus", "ogg"}, {"m4a", "mov"}};
+
+/// How long before the end of an entry the next one is opened, which covers the time the network takes to open it.
+static const std::chrono::seconds PREFETCH_LEAD_TIME{10};
+
+/// How long a context opened in advance may wait for the decoder, before its connection is not trusted anymore.
+static const std::chrono::seconds MAX_PREFETCH_IDLE_TIME{30};
+
+/**
+ * Find the demuxer of a media url from its file extension, so that FFmpeg does not need to probe the format.
+ *
+ * @param url The media url.
+ * @return The demuxer, or @c nullptr if the extension is unknown and the format has to be probed.
+ */
+static AVInputFormat* findInputFormatHint(const std::string& url) {
+    auto it = EXTENSION_INPUT_FORMATS.find(findUrlExtension(url));
+    return EXTENSION_INPUT_FORMATS.end() == it ? nullptr : av_find_input_format(it->second.c_str());
+}
+
+/**
+ * The FFmpeg read callback of cached content.
+ *
+ * @param opaque The @c UrlCache::Reader.
+ * @param buffer The buffer to read to.
+ * @param bufferSize The size of the buffer.
+ * @return The number of bytes read, or a negative FFmpeg error.
+ */
+static int readCache(void* opaque, uint8_t* buffer, int bufferSize) {
+    return static_cast<UrlCache::Reader*>(opaque)->read(buffer, bufferSize);
+}
+
+/**
+ * The FFmpeg seek callback of cached content.
+ *
+ * @param opaque The @c UrlCache::Reader.
+ * @param offset The offset.
+ * @param whence Where the offset is from, or @c AVSEEK_SIZE.
+ * @return The new position or the size, or a negative FFmpeg error.
+ */
+static int64_t seekCache(void* opaque, int64_t offset, int whence) {
+    return static_cast<UrlCache::Reader*>(opaque)->seek(offset, whence);
+}
+
+/**
+ * Open a format context which reads cached content.
+ *
+ * @param avFormatContext The context to open, which is freed on failure.
+ * @param url The url of the content, for the logs of FFmpeg.
+ * @param reader The reader of the cached content.
+ * @param inputFormat The demuxer, or @c nullptr to probe the format.
+ * @param[out] ioContext The I/O context of the opened context, which has to live as long as it.
+ * @return 0 on success, or a negative FFmpeg error.
+ */
+static int openWithReader(
+    AVFormatContext** avFormatContext,
+    const std::string& url,
+    std::shared_ptr<UrlCache::Reader> reader,
+    AVInputFormat* inputFormat,
+    std::shared_ptr<AVIOContext>* ioContext) {
+    unsigned char* buffer =
+        static_cast<unsigned char*>(av_malloc(CACHE_BUFFER_SIZE + AVPROBE_PADDING_SIZE));  // Owned by ioContext
+    if (!buffer) {
+        avformat_free_context(*avFormatContext);
+        return AVERROR(ENOMEM);
+    }
+    *ioContext = std::shared_ptr<AVIOContext>(
+        avio_alloc_context(buffer, CACHE_BUFFER_SIZE, 0, reader.get(), readCache, nullptr, seekCache),
+        AVIOContextDeleter());
+    if (!*ioContext) {
+        av_free(buffer);
+        avformat_free_context(*avFormatContext);
+        return AVERROR(ENOMEM);
+    }
+    (*avFormatContext)->pb = ioContext->get();
+    return avformat_open_input(avFormatContext, url.c_str(), inputFormat, nullptr);
+}
 
 std::unique_ptr<FFmpegUrlInputController> FFmpegUrlInputController::create(
     const std::string& url,
-    const std::chrono::milliseconds& offset) {
+    const std::chrono::milliseconds& offset,
+    std::shared_ptr<UrlCache> urlCache,
+    std::shared_ptr<utils::playlistParser::IterativePlaylistParserInterface> playlistParser) {
 	std::ostringstream oss;
     if (url.empty()) {
 		AISDK_ERROR(LX("createFailed").d("reason", "emptyOriginalUrl"));
         return nullptr;
     }
+    if (playlistParser && !playlistParser->initializeParsing(url)) {
+		AISDK_ERROR(LX("createFailed").d("reason", "initializeParsingFailed").d("url", url));
+        return nullptr;
+    }
+
+	AISDK_DEBUG5(LX("created").d("url", url).d("offset(ms)", offset.count()).d("isPlaylist", playlistParser != nullptr));
 
-	AISDK_DEBUG5(LX("created").d("url", url).d("offset(ms)", offset.count()));
-	
-    auto controller = std::unique_ptr<FFmpegUrlInputController>(new FFmpegUrlInputController(url, offset));
+    auto controller = std::unique_ptr<FFmpegUrlInputController>(
+        new FFmpegUrlInputController(url, offset, urlCache, playlistParser));
     if (!controller->findFirstEntry()) {
 		AISDK_ERROR(LX("createFailed").d("reason", "emptyPlayList"));
         return nullptr;
@@ -62,33 +154,101 @@ bool FFmpegUrlInputController::next() {
         return false;
     }
 
-	/*To-Do*/
+    // The entry was not prefetched if the decoder did not know how long it was.
+    m_isPrefetchPending = false;
+    if (m_prefetchThread.joinable()) {
+        m_prefetchThread.join();
+    }
+    utils::playlistParser::IterativePlaylistParserInterface::PlaylistEntry entry;
+    if (m_hasPrefetchedEntry) {
+        entry = m_prefetchedEntry;
+        m_hasPrefetchedEntry = false;
+    } else {
+        entry = m_playlistParser->next();
+    }
+    if (utils::playlistParser::PlaylistParseResult::ERROR == entry.parseResult) {
+		AISDK_ERROR(LX("nextFailed").d("reason", "parseError"));
+        m_prefetchedContext.reset();
+        return false;
+    }
+
+    m_done = utils::playlistParser::PlaylistParseResult::FINISHED == entry.parseResult;
+    m_currentUrl = entry.url;
+    m_offset = std::chrono::milliseconds::zero();
+	AISDK_DEBUG5(LX("next").d("url", m_currentUrl).d("isPrefetched", m_prefetchedContext != nullptr));
     return true;
 }
 
+std::string FFmpegUrlInputController::getInputType() const {
+    return "url";
+}
+
+void FFmpegUrlInputController::onDecodeProgress(
+    std::chrono::milliseconds position,
+    std::chrono::milliseconds duration) {
+    if (m_isPrefetchPending && duration - position <= PREFETCH_LEAD_TIME) {
+        m_isPrefetchPending = false;
+        startPrefetch();
+    }
+}
+
 bool FFmpegUrlInputController::findFirstEntry() {
-    //auto offset = m_offset;
-    //while (!m_done) {
+    if (!m_playlistParser) {
+        // A media url is the only entry.
+        m_done = true;
+        return true;
+    }
 
-    //}
+    // Skip the entries which end before the offset, when their duration is known.
+    auto offset = m_offset;
+    while (!m_done) {
+        auto entry = m_playlistParser->next();
+        if (utils::playlistParser::PlaylistParseResult::ERROR == entry.parseResult) {
+			AISDK_ERROR(LX("findFirstEntryFailed").d("reason", "parseError"));
+            return false;
+        }
 
-	/* To-Do fix me: to prase playlist or m3u*/
-	// we'd better to implatement how to prase speical mutex.
-	m_done = true;
+        m_done = utils::playlistParser::PlaylistParseResult::FINISHED == entry.parseResult;
+        if (entry.duration < std::chrono::milliseconds::zero() || offset < entry.duration) {
+            m_currentUrl = entry.url;
+            m_offset = offset;
+            return true;
+        }
+        offset -= entry.duration;
+    }
 
-    return true;
+	AISDK_ERROR(LX("findFirstEntryFailed").d("reason", "offsetPastEnd").d("offset(ms)", m_offset.count()));
+    return false;
 }
 
 FFmpegUrlInputController::~FFmpegUrlInputController() {
+    m_isShuttingDown = true;
+    if (m_playlistParser) {
+        m_playlistParser->abort();
+    }
+    if (m_prefetchThread.joinable()) {
+        m_prefetchThread.join();
+    }
 }
 
 FFmpegUrlInputController::FFmpegUrlInputController(
 	const std::string& url,
-    const std::chrono::milliseconds& offset) :
+    const std::chrono::milliseconds& offset,
+    std::shared_ptr<UrlCache> urlCache,
+    std::shared_ptr<utils::playlistParser::IterativePlaylistParserInterface> playlistParser) :
     	m_currentUrl{url},
         m_offset{offset},
         m_done{false},
-        m_avFormatContext{nullptr} {
+        m_avFormatContext{nullptr},
+        m_urlCache{urlCache},
+        m_playlistParser{playlistParser},
+        m_decoderInterruptCallback{nullptr},
+        m_decoderInterruptOpaque{nullptr},
+        m_probeSize{0},
+        m_maxAnalyzeDuration{0},
+        m_isPrefetchPending{false},
+        m_hasPrefetchedEntry{false},
+        m_isShuttingDown{false} {
 }
 
 AVFormatContext* FFmpegUrlInputController::createNewFormatContext() {
@@ -117,9 +277,75 @@ FFmpegUrlInputController::getCurrentFormatContextOpen() {
 	// Clear the original pointer to prepare for the next creation.
 	m_avFormatContext = nullptr;
 
+    if (m_prefetchThread.joinable()) {
+        m_prefetchThread.join();
+    }
+    // The decoder settings, for the context of the next entry opened in advance.
+    m_decoderInterruptCallback = avFormatContext->interrupt_callback.callback;
+    m_decoderInterruptOpaque = avFormatContext->interrupt_callback.opaque;
+    m_probeSize = avFormatContext->probesize;
+    m_maxAnalyzeDuration = avFormatContext->max_analyze_duration;
+
+    if (m_prefetchedContext && !isPrefetchedContextUsable()) {
+		AISDK_WARN(LX(__func__).d("issue", "prefetchedContextUnusable").d("url", m_currentUrl));
+        m_prefetchedContext.reset();
+    }
+
+    std::tuple<Result, std::shared_ptr<AVFormatContext>, std::chrono::milliseconds> result;
+    if (m_prefetchedContext) {
+        // The entry was opened while the previous one played; the decoder reads it with the settings it gave.
+        std::get<0>(result) = Result::OK;
+        std::get<1>(result) = m_prefetchedContext;
+        std::get<2>(result) = m_offset;
+        m_prefetchedContext.reset();
+        std::get<1>(result)->interrupt_callback = avFormatContext->interrupt_callback;
+        std::get<1>(result)->probesize = m_probeSize;
+        std::get<1>(result)->max_analyze_duration = m_maxAnalyzeDuration;
+        avformat_free_context(avFormatContext);
+    } else {
+        result = openUrl(avFormatContext, m_currentUrl);
+    }
+
+    // The next entry is opened once the decoder gets near the end of this one.
+    m_isPrefetchPending = Result::OK == std::get<0>(result) && !m_done && m_playlistParser;
+    return result;
+}
+
+std::tuple<FFmpegInputControllerInterface::Result, std::shared_ptr<AVFormatContext>, std::chrono::milliseconds>
+FFmpegUrlInputController::openUrl(AVFormatContext* avFormatContext, const std::string& url) {
+    // The decoder settings of the context, to open it again if the format hint is wrong.
+    auto interruptCallback = avFormatContext->interrupt_callback;
+    auto probeSize = avFormatContext->probesize;
+    auto maxAnalyzeDuration = avFormatContext->max_analyze_duration;
+
+    auto inputFormat = findInputFormatHint(url);
+    if (m_urlCache && UrlCache::isCacheable(url)) {
+        // Media whose content cannot be cached, like a live stream, is read from the network below.
+        auto reader = m_urlCache->open(url, [interruptCallback]() {
+            return interruptCallback.callback && interruptCallback.callback(interruptCallback.opaque) != 0;
+        });
+        if (reader) {
+            return openCachedInput(avFormatContext, url, reader, inputFormat);
+        }
+    }
+
     AVDictionary* options = nullptr;
-    av_dict_set(&options, USER_AGENT_OPTION, "AiSdkv1.0.1", 0);
-    auto error = avformat_open_input(&avFormatContext, m_currentUrl.c_str(), nullptr, &options);
+    av_dict_set(&options, USER_AGENT_OPTION, USER_AGENT, 0);
+    auto error = avformat_open_input(&avFormatContext, url.c_str(), inputFormat, &options);
+    if (error != 0 && -EAGAIN != error && inputFormat) {
+		AISDK_WARN(LX(__func__).d("issue", "formatHintFailed").d("format", inputFormat->name).d("url", url));
+        av_dict_free(&options);
+        avFormatContext = avformat_alloc_context();
+        if (!avFormatContext) {
+			AISDK_ERROR(LX("getContextFailed").d("reason", "avFormatAllocFailed"));
+            return std::make_tuple(Result::ERROR, nullptr, std::chrono::milliseconds::zero());
+        }
+        avFormatContext->interrupt_callback = interruptCallback;
+        avFormatContext->probesize = probeSize;
+        avFormatContext->max_analyze_duration = maxAnalyzeDuration;
+        av_dict_set(&options, USER_AGENT_OPTION, USER_AGENT, 0);
+        error = avformat_open_input(&avFormatContext, url.c_str(), nullptr, &options);
+    }
     auto optionsPtr = std::unique_ptr<AVDictionary, AVDictionaryDeleter>(options);
 
     if (!optionsPtr) {
@@ -140,14 +366,112 @@ FFmpegUrlInputController::getCurrentFormatContextOpen() {
         //auto errorStr = av_err2str(error);
 		AISDK_ERROR(LX("getContextFailed")
 					.d("reason", "openInputFailed")
-					.d("url", m_currentUrl));
-		
+					.d("url", url));
+
         return std::make_tuple(Result::ERROR, nullptr, std::chrono::milliseconds::zero());
     }
 
     return std::make_tuple(Result::OK, std::shared_ptr<AVFormatContext>(avFormatContext, AVFormatContextDeleter()), m_offset);
 }
 
+std::tuple<FFmpegInputControllerInterface::Result, std::shared_ptr<AVFormatContext>, std::chrono::milliseconds>
+FFmpegUrlInputController::openCachedInput(
+    AVFormatContext* avFormatContext,
+    const std::string& url,
+    std::shared_ptr<UrlCache::Reader> reader,
+    AVInputFormat* inputFormat) {
+    auto interruptCallback = avFormatContext->interrupt_callback;
+    auto probeSize = avFormatContext->probesize;
+    auto maxAnalyzeDuration = avFormatContext->max_analyze_duration;
+
+    std::shared_ptr<AVIOContext> ioContext;
+    auto error = openWithReader(&avFormatContext, url, reader, inputFormat, &ioContext);
+    if (error != 0 && -EAGAIN != error && AVERROR_EXIT != error && inputFormat) {
+		AISDK_WARN(LX(__func__).d("issue", "formatHintFailed").d("format", inputFormat->name).d("url", url));
+        avFormatContext = avformat_alloc_context();
+        if (!avFormatContext) {
+			AISDK_ERROR(LX("getContextFailed").d("reason", "avFormatAllocFailed"));
+            return std::make_tuple(Result::ERROR, nullptr, std::chrono::milliseconds::zero());
+        }
+        avFormatContext->interrupt_callback = interruptCallback;
+        avFormatContext->probesize = probeSize;
+        avFormatContext->max_analyze_duration = maxAnalyzeDuration;
+        reader->seek(0, SEEK_SET);
+        error = openWithReader(&avFormatContext, url, reader, nullptr, &ioContext);
+    }
+    if (error != 0) {
+        // The avFormatContext will be freed on failure.
+        if (-EAGAIN == error) {
+			AISDK_DEBUG5(LX("getContextFailed").d("reason", "Data unavailable. Try again."));
+            return std::make_tuple(Result::TRY_AGAIN, nullptr, std::chrono::milliseconds::zero());
+        }
+		AISDK_ERROR(LX("getContextFailed")
+					.d("reason", "openCachedInputFailed")
+					.d("url", url));
+        return std::make_tuple(Result::ERROR, nullptr, std::chrono::milliseconds::zero());
+    }
+
+    // The context reads through the I/O context and the reader, which live as long as it.
+    return std::make_tuple(Result::OK,
+            std::shared_ptr<AVFormatContext>(
+                avFormatContext,
+                [ioContext, reader](AVFormatContext* context) { AVFormatContextDeleter()(context); }),
+            m_offset);
+}
+
+void FFmpegUrlInputController::startPrefetch() {
+    if (m_done || !m_playlistParser || m_isShuttingDown) {
+        return;
+    }
+    m_hasPrefetchedEntry = false;
+    m_prefetchedContext.reset();
+    m_prefetchThread = std::thread(&FFmpegUrlInputController::prefetchNextEntry, this);
+}
+
+void FFmpegUrlInputController::prefetchNextEntry() {
+    utils::logging::ThreadMoniker::setThisThreadName("UrlPrefetch");
+
+    m_prefetchedEntry = m_playlistParser->next();
+    m_hasPrefetchedEntry = true;
+    if (utils::playlistParser::PlaylistParseResult::ERROR == m_prefetchedEntry.parseResult || m_isShuttingDown) {
+        return;
+    }
+
+    auto avFormatContext = avformat_alloc_context();
+    if (!avFormatContext) {
+		AISDK_ERROR(LX("prefetchFailed").d("reason", "avFormatAllocFailed"));
+        return;
+    }
+    avFormatContext->interrupt_callback.callback = shouldInterruptPrefetch;
+    avFormatContext->interrupt_callback.opaque = this;
+    avFormatContext->probesize = m_probeSize;
+    avFormatContext->max_analyze_duration = m_maxAnalyzeDuration;
+
+    // A failure is not reported here: the decoder opens the entry again when it gets to it.
+    m_prefetchedContext = std::get<1>(openUrl(avFormatContext, m_prefetchedEntry.url));
+    m_prefetchedTime = std::chrono::steady_clock::now();
+	AISDK_DEBUG5(LX("prefetched").d("url", m_prefetchedEntry.url).d("isOpened", m_prefetchedContext != nullptr));
+}
+
+bool FFmpegUrlInputController::isPrefetchedContextUsable() const {
+    auto ioContext = m_prefetchedContext->pb;
+    if (!ioContext || ioContext->error < 0) {
+        return false;
+    }
+    return std::chrono::steady_clock::now() - m_prefetchedTime <= MAX_PREFETCH_IDLE_TIME;
+}
+
+int FFmpegUrlInputController::shouldInterruptPrefetch(void* controller) {
+    auto inputController = static_cast<FFmpegUrlInputController*>(controller);
+    if (inputController->m_isShuttingDown) {
+        return 1;
+    }
+    if (inputController->m_decoderInterruptCallback) {
+        return inputController->m_decoderInterruptCallback(inputController->m_decoderInterruptOpaque);
+    }
+    return 0;
+}
+
 }  // namespace ffmpeg
 }  // namespace mediaPlayer
 } //namespace aisdk
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include <Utils/Logging/Logger.h>
+
+#include "AudioMediaPlayer/FileAudioOutput.h"
+
+/// String to identify log entries originating from this file.
+static const std::string TAG("FileAudioOutput");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/// The size of the WAV header written before the samples.
+static const uint32_t WAV_HEADER_SIZE = 44;
+
+/// The largest number of bytes of samples a WAV file can describe.
+static const uint64_t MAX_WAV_DATA_SIZE = std::numeric_limits<uint32_t>::max() - WAV_HEADER_SIZE;
+
+/**
+ * Append a little endian integer to a header.
+ *
+ * @param header The header.
+ * @param value The value to append.
+ * @param size The number of bytes of the value.
+ */
+static void appendLittleEndian(std::string* header, uint32_t value, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        header->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+std::unique_ptr<FileAudioOutput> FileAudioOutput::create(
+    const std::string& filename,
+    const PlaybackConfiguration& config,
+    FileFormat fileFormat,
+    OutputPacer::Clock clock) {
+    // WAV samples are little endian.
+    if (FileFormat::WAV == fileFormat && !config.isLittleEndian()) {
+        AISDK_ERROR(LX("createFailed").d("reason", "bigEndianWav").d("filename", filename));
+        return nullptr;
+    }
+
+    auto output = std::unique_ptr<FileAudioOutput>(new FileAudioOutput(config, fileFormat, clock));
+    output->m_file.open(filename, std::ofstream::binary | std::ofstream::trunc);
+    if (!output->m_file.is_open()) {
+        AISDK_ERROR(LX("createFailed").d("reason", "openFileFailed").d("filename", filename));
+        return nullptr;
+    }
+    if (FileFormat::WAV == fileFormat && !output->writeWavHeader()) {
+        AISDK_ERROR(LX("createFailed").d("reason", "writeHeaderFailed").d("filename", filename));
+        return nullptr;
+    }
+
+    return output;
+}
+
+FileAudioOutput::FileAudioOutput(const PlaybackConfiguration& config, FileFormat fileFormat, OutputPacer::Clock clock) :
+        m_config{config},
+        m_fileFormat{fileFormat},
+        m_pacer{config, clock},
+        m_bytesWritten{0} {
+}
+
+FileAudioOutput::~FileAudioOutput() {
+    if (FileFormat::WAV == m_fileFormat && m_file.is_open()) {
+        m_file.seekp(0);
+        if (!writeWavHeader()) {
+            AISDK_ERROR(LX("closeFailed").d("reason", "writeHeaderFailed"));
+        }
+    }
+}
+
+bool FileAudioOutput::write(const uint8_t* data, size_t size) {
+    if (!m_file.write(reinterpret_cast<const char*>(data), size)) {
+        AISDK_ERROR(LX("writeFailed").d("size", size));
+        return false;
+    }
+    m_bytesWritten += size;
+    m_pacer.pace(size);
+    return true;
+}
+
+PlaybackConfiguration FileAudioOutput::getConfiguration() const {
+    return m_config;
+}
+
+bool FileAudioOutput::writeWavHeader() {
+    // A file longer than a WAV header can describe is still written, and players read it up to the described size.
+    auto dataSize = static_cast<uint32_t>(std::min(m_bytesWritten, MAX_WAV_DATA_SIZE));
+    auto channels = static_cast<uint32_t>(m_config.numberChannels());
+    auto sampleBytes = static_cast<uint32_t>(m_config.sampleSizeBytes());
+    auto sampleRate = static_cast<uint32_t>(m_config.sampleRate());
+
+    std::string header = "RIFF";
+    appendLittleEndian(&header, WAV_HEADER_SIZE - 8 + dataSize, 4);
+    header += "WAVEfmt ";
+    // The size of the format chunk, and the PCM format tag.
+    appendLittleEndian(&header, 16, 4);
+    appendLittleEndian(&header, 1, 2);
+    appendLittleEndian(&header, channels, 2);
+    appendLittleEndian(&header, sampleRate, 4);
+    appendLittleEndian(&header, sampleRate * channels * sampleBytes, 4);
+    appendLittleEndian(&header, channels * sampleBytes, 2);
+    appendLittleEndian(&header, sampleBytes * 8, 2);
+    header += "data";
+    appendLittleEndian(&header, dataSize, 4);
+
+    return static_cast<bool>(m_file.write(header.data(), header.size()).flush());
+}
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <Utils/Logging/Logger.h>
+
+#include "AudioMediaPlayer/FocusDuckingObserver.h"
+
+/// String to identify log entries originating from this file.
+static const std::string TAG("FocusDuckingObserver");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+using utils::channel::FocusState;
+
+FocusDuckingObserver::FocusDuckingObserver(
+    const std::unordered_map<std::string, std::shared_ptr<AudioMixerInput>>& inputs,
+    float duckLevel,
+    std::chrono::milliseconds duckRamp,
+    std::chrono::milliseconds restoreRamp) :
+        m_inputs{inputs},
+        m_duckLevel{duckLevel},
+        m_duckRamp{duckRamp},
+        m_restoreRamp{restoreRamp} {
+}
+
+void FocusDuckingObserver::onTrackChanged(const std::string& channelName, FocusState newTrace) {
+    AISDK_DEBUG5(LX("onTrackChanged").d("channel", channelName).d("newTrace", newTrace));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_focus[channelName] = newTrace;
+
+    std::string foregroundChannel;
+    for (const auto& focus : m_focus) {
+        if (FocusState::FOREGROUND == focus.second) {
+            foregroundChannel = focus.first;
+        }
+    }
+
+    for (const auto& input : m_inputs) {
+        if (!input.second) {
+            continue;
+        }
+        auto focus = m_focus.find(input.first);
+        bool isBackground = focus != m_focus.end() && FocusState::BACKGROUND == focus->second;
+        bool shouldDuck = isBackground || (!foregroundChannel.empty() && foregroundChannel != input.first);
+        auto& isDucked = m_isDucked[input.first];
+        if (shouldDuck == isDucked) {
+            continue;
+        }
+        isDucked = shouldDuck;
+        AISDK_DEBUG5(LX(shouldDuck ? "duck" : "unduck").d("channel", input.first).d("foreground", foregroundChannel));
+        if (shouldDuck) {
+            input.second->duck(m_duckLevel, m_duckRamp);
+        } else {
+            input.second->unduck(m_restoreRamp);
+        }
+    }
+}
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
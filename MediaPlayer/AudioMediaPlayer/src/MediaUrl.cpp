@@ -0,0 +1,55 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <unordered_set>
+
+#include "AudioMediaPlayer/MediaUrl.h"
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+const char* const USER_AGENT_OPTION{"user_agent"};
+
+const char* const USER_AGENT{"AiSdkv1.0.1"};
+
+/// The file extensions of the playlists which are parsed before FFmpeg opens their entries.
+static const std::unordered_set<std::string> PLAYLIST_EXTENSIONS = {"m3u", "pls"};
+
+/// The file extension of HLS playlists.
+static const std::string HLS_EXTENSION{"m3u8"};
+
+std::string findUrlExtension(const std::string& url) {
+    auto path = url.substr(0, url.find_first_of("?#"));
+    auto dot = path.find_last_of('.');
+    if (std::string::npos == dot || path.find('/', dot) != std::string::npos) {
+        return "";
+    }
+
+    auto extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension;
+}
+
+bool isPlaylistUrl(const std::string& url) {
+    return PLAYLIST_EXTENSIONS.count(findUrlExtension(url)) != 0;
+}
+
+bool isHlsUrl(const std::string& url) {
+    return findUrlExtension(url) == HLS_EXTENSION;
+}
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "AudioMediaPlayer/NullAudioOutput.h"
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+std::unique_ptr<NullAudioOutput> NullAudioOutput::create(
+    const PlaybackConfiguration& config,
+    OutputPacer::Clock clock) {
+    return std::unique_ptr<NullAudioOutput>(new NullAudioOutput(config, clock));
+}
+
+NullAudioOutput::NullAudioOutput(const PlaybackConfiguration& config, OutputPacer::Clock clock) :
+        m_config{config},
+        m_pacer{config, clock},
+        m_bytesWritten{0} {
+}
+
+uint64_t NullAudioOutput::getBytesWritten() const {
+    return m_bytesWritten;
+}
+
+bool NullAudioOutput::write(const uint8_t* /*data*/, size_t size) {
+    m_bytesWritten += size;
+    m_pacer.pace(size);
+    return true;
+}
+
+PlaybackConfiguration NullAudioOutput::getConfiguration() const {
+    return m_config;
+}
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <thread>
+
+#include "AudioMediaPlayer/OutputPacer.h"
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+OutputPacer::OutputPacer(const PlaybackConfiguration& config, Clock clock) :
+        m_clock{clock},
+        m_bytesPerSecond{static_cast<uint64_t>(config.sampleRate()) * config.numberChannels() * config.sampleSizeBytes()},
+        m_bytes{0} {
+}
+
+void OutputPacer::pace(size_t size) {
+    if (Clock::UNTHROTTLED == m_clock || !m_bytesPerSecond) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (!m_bytes || now > playedUntil()) {
+        // The first write, or the audio written before ran out: the clock starts again from this write.
+        m_startTime = now;
+        m_bytes = 0;
+    }
+
+    // Like a device with room for one write queued behind the one playing, wait until the audio before this write
+    // has played.
+    std::this_thread::sleep_until(playedUntil());
+    m_bytes += size;
+}
+
+std::chrono::steady_clock::time_point OutputPacer::playedUntil() const {
+    return m_startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                             std::chrono::microseconds(m_bytes * 1000000 / m_bytesPerSecond));
+}
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
@@ -0,0 +1,778 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+#include <Utils/Logging/Logger.h>
+#include <Utils/Metrics/MetricsRegistry.h>
+#include "AudioMediaPlayer/MediaUrl.h"
+#include "AudioMediaPlayer/PcmCache.h"
+
+/// String to identify log entries originating from this file.
+static const std::string TAG("PcmCache");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+constexpr uint64_t PcmCache::DEFAULT_MAX_CLIP_BYTES;
+constexpr size_t PcmCache::MAX_PLAYED_URLS;
+
+/// The extension of a recording file.
+static const std::string CLIP_EXTENSION{"pcm"};
+
+/// The extension of a file a recording is written to until it is complete.
+static const std::string TEMPORARY_EXTENSION{"tmp"};
+
+/// The prefix of the urls of local files.
+static const std::string FILE_SCHEME{"file://"};
+
+/// The first bytes of a recording file.
+static const char CLIP_MAGIC[8] = {'A', 'I', 'S', 'P', 'C', 'M', '1', '\0'};
+
+/// The alignment of the audio in a recording file, so that it is aligned for the SIMD kernels once mapped.
+static constexpr uint64_t CLIP_DATA_ALIGNMENT{64};
+
+/// The header of a recording file, followed by the key of the recording and, at @c dataOffset, the audio.
+struct ClipHeader {
+    /// @c CLIP_MAGIC.
+    char magic[8];
+    /// The size of the key.
+    uint32_t keyBytes;
+    /// Where the audio starts in the file.
+    uint32_t dataOffset;
+    /// The size of the audio.
+    uint64_t dataBytes;
+};
+
+/// A recording mapped to memory.
+struct PcmCache::Clip {
+    /**
+     * Constructor.
+     *
+     * @param key The key the audio was recorded for.
+     * @param mapping The mapping of the recording file.
+     * @param mappingBytes The size of the mapping.
+     * @param dataOffset Where the audio starts in the mapping.
+     * @param dataBytes The size of the audio.
+     */
+    Clip(const std::string& key, void* mapping, size_t mappingBytes, size_t dataOffset, size_t dataBytes) :
+            key{key},
+            mapping{mapping},
+            mappingBytes{mappingBytes},
+            data{static_cast<const uint8_t*>(mapping) + dataOffset},
+            dataBytes{dataBytes} {
+    }
+
+    /// Destructor, which unmaps the file.
+    ~Clip() {
+        munmap(mapping, mappingBytes);
+    }
+
+    /// The key the audio was recorded for.
+    const std::string key;
+
+    /// The mapping of the recording file.
+    void* const mapping;
+
+    /// The size of the mapping.
+    const size_t mappingBytes;
+
+    /// The audio.
+    const uint8_t* const data;
+
+    /// The size of the audio.
+    const size_t dataBytes;
+};
+
+/// The decoder of a recording, which copies the recorded audio.
+class PcmCache::ClipDecoder : public DecoderInterface {
+public:
+    /**
+     * Constructor.
+     *
+     * @param clip The recording.
+     * @param frameBytes The size of one frame of the output.
+     * @param startTime When the play was requested, which the time to its first audio is measured from.
+     * @param firstSampleHistogram The histogram of the time to the first audio, or @c nullptr.
+     */
+    ClipDecoder(
+        std::shared_ptr<Clip> clip,
+        size_t frameBytes,
+        std::chrono::steady_clock::time_point startTime,
+        std::shared_ptr<utils::metrics::Histogram> firstSampleHistogram) :
+            m_clip{clip},
+            m_frameBytes{frameBytes},
+            m_position{0},
+            m_startTime{startTime},
+            m_firstSampleHistogram{firstSampleHistogram},
+            m_isAborted{false} {
+    }
+
+    /// @name DecoderInterface method overrides.
+    /// @{
+    std::pair<Status, size_t> read(Byte* buffer, size_t size) override {
+        if (!buffer || size < m_frameBytes) {
+            AISDK_ERROR(LX("readFailed").d("reason", "invalidInput").d("buffer", buffer).d("size", size));
+            return {Status::ERROR, 0};
+        }
+        if (m_isAborted) {
+            AISDK_DEBUG2(LX("readFailed").d("reason", "aborted"));
+            return {Status::ERROR, 0};
+        }
+
+        auto bytes = std::min(size / m_frameBytes * m_frameBytes, m_clip->dataBytes - m_position);
+        memcpy(buffer, m_clip->data + m_position, bytes);
+        if (0 == m_position && m_firstSampleHistogram) {
+            m_firstSampleHistogram->record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_startTime)
+                    .count()));
+        }
+        m_position += bytes;
+        return {m_position < m_clip->dataBytes ? Status::OK : Status::DONE, bytes};
+    }
+
+    void abort() override {
+        m_isAborted = true;
+    }
+    /// @}
+
+private:
+    /// The recording.
+    std::shared_ptr<Clip> m_clip;
+
+    /// The size of one frame of the output.
+    const size_t m_frameBytes;
+
+    /// The position of the next read in the audio.
+    size_t m_position;
+
+    /// When the play was requested.
+    const std::chrono::steady_clock::time_point m_startTime;
+
+    /// The histogram of the time to the first audio, or @c nullptr.
+    std::shared_ptr<utils::metrics::Histogram> m_firstSampleHistogram;
+
+    /// Whether @c abort() was called.
+    std::atomic<bool> m_isAborted;
+};
+
+/**
+ * Write exactly the given bytes to a file.
+ *
+ * @param fd The file.
+ * @param buffer The bytes.
+ * @param size The number of bytes.
+ * @param offset The offset in the file.
+ * @return Whether all the bytes were written.
+ */
+static bool writeAll(int fd, const uint8_t* buffer, size_t size, uint64_t offset) {
+    while (size > 0) {
+        auto written = pwrite(fd, buffer, size, offset);
+        if (written < 0 && EINTR == errno) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        buffer += written;
+        size -= written;
+        offset += written;
+    }
+    return true;
+}
+
+/**
+ * Get where the audio starts in a recording file.
+ *
+ * @param keyBytes The size of the key of the recording.
+ * @return The offset of the audio.
+ */
+static uint64_t dataOffsetOf(size_t keyBytes) {
+    return (sizeof(ClipHeader) + keyBytes + CLIP_DATA_ALIGNMENT - 1) / CLIP_DATA_ALIGNMENT * CLIP_DATA_ALIGNMENT;
+}
+
+/**
+ * Check the header of a recording file.
+ *
+ * @param header The header.
+ * @param fileBytes The size of the file.
+ * @return Whether the header is the one of a complete recording of that size.
+ */
+static bool isValidHeader(const ClipHeader& header, uint64_t fileBytes) {
+    return memcmp(header.magic, CLIP_MAGIC, sizeof(CLIP_MAGIC)) == 0 && header.dataBytes > 0 &&
+           header.dataOffset == dataOffsetOf(header.keyBytes) && header.dataOffset + header.dataBytes == fileBytes;
+}
+
+/// The decoder which reads another decoder and records its audio, stored in the cache when it reaches the end.
+class PcmCache::RecordingDecoder : public DecoderInterface {
+public:
+    /**
+     * Constructor.
+     *
+     * @param cache The cache.
+     * @param decoder The decoder to record.
+     * @param key The key of the recording.
+     * @param name The file name of the recording.
+     * @param temporaryPath The file the recording is written to.
+     * @param fd The file, opened for writing.
+     */
+    RecordingDecoder(
+        std::shared_ptr<PcmCache> cache,
+        std::shared_ptr<DecoderInterface> decoder,
+        const std::string& key,
+        const std::string& name,
+        const std::string& temporaryPath,
+        int fd) :
+            m_cache{cache},
+            m_decoder{decoder},
+            m_key{key},
+            m_name{name},
+            m_temporaryPath{temporaryPath},
+            m_fd{fd},
+            m_dataOffset{dataOffsetOf(key.size())},
+            m_dataBytes{0},
+            m_startTime{std::chrono::steady_clock::now()},
+            m_hasFirstSample{false} {
+    }
+
+    /// Destructor, which drops an incomplete recording.
+    ~RecordingDecoder() {
+        discard();
+    }
+
+    /// @name DecoderInterface method overrides.
+    /// @{
+    std::pair<Status, size_t> read(Byte* buffer, size_t size) override {
+        auto result = m_decoder->read(buffer, size);
+        if (Status::ERROR == result.first) {
+            discard();
+            return result;
+        }
+        if (result.second > 0 && !m_hasFirstSample) {
+            m_hasFirstSample = true;
+            if (m_cache->m_missFirstSampleHistogram) {
+                m_cache->m_missFirstSampleHistogram->record(
+                    static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                              std::chrono::steady_clock::now() - m_startTime)
+                                              .count()));
+            }
+        }
+        if (m_fd < 0) {
+            return result;
+        }
+
+        if (m_dataBytes + result.second > m_cache->m_maxClipBytes) {
+            AISDK_DEBUG5(LX("recordingDropped").d("reason", "tooLarge").d("name", m_name));
+            discard();
+        } else if (!writeAll(m_fd, buffer, result.second, m_dataOffset + m_dataBytes)) {
+            AISDK_WARN(LX("recordingDropped").d("reason", "writeFailed").d("name", m_name).d("errno", errno));
+            discard();
+        } else {
+            m_dataBytes += result.second;
+            if (Status::DONE == result.first) {
+                finish();
+            }
+        }
+        return result;
+    }
+
+    void abort() override {
+        // The aborted decoder fails its next read, which drops the recording.
+        m_decoder->abort();
+    }
+    /// @}
+
+private:
+    /// Write the header of the recording and store it in the cache.
+    void finish() {
+        if (0 == m_dataBytes) {
+            discard();
+            return;
+        }
+        std::vector<uint8_t> header(sizeof(ClipHeader) + m_key.size());
+        ClipHeader clipHeader;
+        memcpy(clipHeader.magic, CLIP_MAGIC, sizeof(CLIP_MAGIC));
+        clipHeader.keyBytes = static_cast<uint32_t>(m_key.size());
+        clipHeader.dataOffset = static_cast<uint32_t>(m_dataOffset);
+        clipHeader.dataBytes = m_dataBytes;
+        memcpy(header.data(), &clipHeader, sizeof(clipHeader));
+        memcpy(header.data() + sizeof(clipHeader), m_key.data(), m_key.size());
+        if (!writeAll(m_fd, header.data(), header.size(), 0)) {
+            AISDK_WARN(LX("recordingDropped").d("reason", "writeHeaderFailed").d("name", m_name).d("errno", errno));
+            discard();
+            return;
+        }
+        close(m_fd);
+        m_fd = -1;
+        m_cache->commit(m_name, m_temporaryPath, m_dataOffset + m_dataBytes);
+    }
+
+    /// Drop the recording, unless it was stored.
+    void discard() {
+        if (m_fd >= 0) {
+            close(m_fd);
+            m_fd = -1;
+            std::remove(m_temporaryPath.c_str());
+        }
+    }
+
+    /// The cache.
+    std::shared_ptr<PcmCache> m_cache;
+
+    /// The decoder to record.
+    std::shared_ptr<DecoderInterface> m_decoder;
+
+    /// The key of the recording.
+    const std::string m_key;
+
+    /// The file name of the recording.
+    const std::string m_name;
+
+    /// The file the recording is written to.
+    const std::string m_temporaryPath;
+
+    /// The file, or -1 once the recording was stored or dropped.
+    int m_fd;
+
+    /// Where the audio starts in the file.
+    const uint64_t m_dataOffset;
+
+    /// The size of the audio recorded.
+    uint64_t m_dataBytes;
+
+    /// When the play was requested.
+    const std::chrono::steady_clock::time_point m_startTime;
+
+    /// Whether the decoder gave its first audio.
+    bool m_hasFirstSample;
+};
+
+bool PcmCache::keyOf(const std::string& url, const PlaybackConfiguration& config, std::string* key) const {
+    std::ostringstream stream;
+    stream << url << '\n';
+    bool isLocal = std::string::npos == url.find("://") || url.compare(0, FILE_SCHEME.size(), FILE_SCHEME) == 0;
+    if (isLocal) {
+        // A local file changed in place is decoded again.
+        auto path = url.compare(0, FILE_SCHEME.size(), FILE_SCHEME) == 0 ? url.substr(FILE_SCHEME.size()) : url;
+        struct stat fileStat;
+        if (stat(path.c_str(), &fileStat) != 0) {
+            return false;
+        }
+        stream << fileStat.st_size << ' ' << fileStat.st_mtim.tv_sec << ' ' << fileStat.st_mtim.tv_nsec << '\n';
+    } else {
+        // Content changed on the server is decoded again, once the url cache has validated it.
+        int64_t totalBytes = 0;
+        std::string mimeType;
+        if (!m_urlCache || !m_urlCache->getValidators(url, &totalBytes, &mimeType)) {
+            return false;
+        }
+        stream << totalBytes << ' ' << mimeType << '\n';
+    }
+    stream << config.sampleRate() << ' ' << config.numberChannels() << ' ' << static_cast<int>(config.sampleFormat())
+           << ' ' << config.isLittleEndian();
+    *key = stream.str();
+    return true;
+}
+
+/**
+ * Get the file name of a key.
+ *
+ * @param key The key.
+ * @return The file name, without its extension.
+ */
+static std::string nameOf(const std::string& key) {
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << static_cast<uint64_t>(std::hash<std::string>()(key));
+    return name.str();
+}
+
+std::shared_ptr<PcmCache> PcmCache::create(
+    const std::string& directory,
+    uint64_t maxBytes,
+    uint64_t maxMemoryBytes,
+    uint64_t maxClipBytes,
+    std::shared_ptr<UrlCache> urlCache) {
+    if (directory.empty()) {
+        AISDK_ERROR(LX("createFailed").d("reason", "emptyDirectory"));
+        return nullptr;
+    }
+    if (0 == maxBytes || 0 == maxClipBytes) {
+        AISDK_ERROR(LX("createFailed").d("reason", "zeroSize").d("maxBytes", maxBytes).d("maxClipBytes", maxClipBytes));
+        return nullptr;
+    }
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        AISDK_ERROR(LX("createFailed").d("reason", "mkdirFailed").d("directory", directory).d("errno", errno));
+        return nullptr;
+    }
+
+    auto cache =
+        std::shared_ptr<PcmCache>(new PcmCache(directory, maxBytes, maxMemoryBytes, maxClipBytes, urlCache));
+    if (!cache->load()) {
+        AISDK_ERROR(LX("createFailed").d("reason", "loadFailed").d("directory", directory));
+        return nullptr;
+    }
+    AISDK_INFO(LX("created").d("directory", directory).d("maxBytes", maxBytes).d("cachedBytes", cache->getSizeBytes()));
+    return cache;
+}
+
+bool PcmCache::isCacheable(const std::string& url, std::chrono::milliseconds offset) {
+    if (url.empty() || offset != std::chrono::milliseconds::zero()) {
+        return false;
+    }
+
+    // The entries of playlists, and the segments of HLS playlists, change from play to play.
+    return !isPlaylistUrl(url) && !isHlsUrl(url);
+}
+
+PcmCache::PcmCache(
+    const std::string& directory,
+    uint64_t maxBytes,
+    uint64_t maxMemoryBytes,
+    uint64_t maxClipBytes,
+    std::shared_ptr<UrlCache> urlCache) :
+        m_directory{directory},
+        m_maxBytes{maxBytes},
+        m_maxMemoryBytes{maxMemoryBytes},
+        m_maxClipBytes{maxClipBytes},
+        m_urlCache{urlCache},
+        m_sizeBytes{0},
+        m_memoryBytes{0},
+        m_useCount{0},
+        m_recordingCount{0},
+        m_memoryHitCounter{utils::metrics::MetricsRegistry::instance().getCounter(
+            "aisdk_pcm_cache_lookups_total",
+            {{"result", "memory"}},
+            "Plays looked up in the decoded audio cache, by where their recording was found.")},
+        m_diskHitCounter{utils::metrics::MetricsRegistry::instance().getCounter(
+            "aisdk_pcm_cache_lookups_total", {{"result", "disk"}})},
+        m_missCounter{utils::metrics::MetricsRegistry::instance().getCounter(
+            "aisdk_pcm_cache_lookups_total", {{"result", "miss"}})},
+        m_firstPlayCounter{utils::metrics::MetricsRegistry::instance().getCounter(
+            "aisdk_pcm_cache_first_plays_total",
+            {},
+            "Plays not recorded by the decoded audio cache because their url was not played recently before.")},
+        m_hitFirstSampleHistogram{utils::metrics::MetricsRegistry::instance().getHistogram(
+            "aisdk_pcm_cache_time_to_first_sample_microseconds",
+            {{"result", "hit"}},
+            "Time from the request of a play to its first audio, by whether it was played from a recording.")},
+        m_missFirstSampleHistogram{utils::metrics::MetricsRegistry::instance().getHistogram(
+            "aisdk_pcm_cache_time_to_first_sample_microseconds", {{"result", "miss"}})},
+        m_sizeGauge{utils::metrics::MetricsRegistry::instance().getGauge(
+            "aisdk_pcm_cache_size_bytes", {}, "Decoded audio stored on disk by the decoded audio cache.")},
+        m_memoryGauge{utils::metrics::MetricsRegistry::instance().getGauge(
+            "aisdk_pcm_cache_memory_bytes", {}, "Decoded audio kept mapped between plays by the decoded audio cache.")} {
+}
+
+std::string PcmCache::pathOf(const std::string& name, const std::string& extension) const {
+    return m_directory + "/" + name + "." + extension;
+}
+
+std::shared_ptr<PcmCache::Clip> PcmCache::mapClip(const std::string& path, const std::string& key) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        AISDK_WARN(LX("mapClipFailed").d("reason", "openFailed").d("path", path).d("errno", errno));
+        return nullptr;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || static_cast<uint64_t>(fileStat.st_size) <= sizeof(ClipHeader)) {
+        AISDK_WARN(LX("mapClipFailed").d("reason", "invalidSize").d("path", path));
+        close(fd);
+        return nullptr;
+    }
+    auto mappingBytes = static_cast<size_t>(fileStat.st_size);
+    auto mapping = mmap(nullptr, mappingBytes, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid without the file descriptor, and even once the file is evicted: the cache only removes
+    // its files or replaces them with a rename, and never truncates one, which would raise SIGBUS on a read.
+    close(fd);
+    if (MAP_FAILED == mapping) {
+        AISDK_WARN(LX("mapClipFailed").d("reason", "mmapFailed").d("path", path).d("errno", errno));
+        return nullptr;
+    }
+
+    ClipHeader header;
+    memcpy(&header, mapping, sizeof(header));
+    if (!isValidHeader(header, mappingBytes) || header.keyBytes != key.size() ||
+        memcmp(static_cast<const uint8_t*>(mapping) + sizeof(header), key.data(), key.size()) != 0) {
+        // Another key with the same file name is a miss; its recording is replaced by the one of this key.
+        AISDK_DEBUG5(LX("mapClipFailed").d("reason", "otherKey").d("path", path));
+        munmap(mapping, mappingBytes);
+        return nullptr;
+    }
+    // The whole recording is read right away, so ask for it to be paged in ahead of the reads.
+    madvise(mapping, mappingBytes, MADV_WILLNEED);
+    return std::make_shared<Clip>(key, mapping, mappingBytes, header.dataOffset, header.dataBytes);
+}
+
+bool PcmCache::load() {
+    auto directory = opendir(m_directory.c_str());
+    if (!directory) {
+        AISDK_ERROR(LX("loadFailed").d("reason", "opendirFailed").d("errno", errno));
+        return false;
+    }
+
+    std::vector<std::tuple<std::time_t, std::string, uint64_t>> files;
+    while (auto item = readdir(directory)) {
+        std::string fileName = item->d_name;
+        auto dot = fileName.find('.');
+        if (std::string::npos == dot) {
+            continue;
+        }
+        auto path = m_directory + "/" + fileName;
+        if (fileName.substr(dot + 1) == TEMPORARY_EXTENSION) {
+            // A recording which was not complete when the previous run ended.
+            std::remove(path.c_str());
+            continue;
+        }
+        if (fileName.substr(dot + 1) != CLIP_EXTENSION) {
+            continue;
+        }
+
+        ClipHeader header;
+        struct stat fileStat;
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        bool isValid = fd >= 0 && fstat(fd, &fileStat) == 0 &&
+                       pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+                       isValidHeader(header, static_cast<uint64_t>(fileStat.st_size));
+        if (fd >= 0) {
+            close(fd);
+        }
+        if (!isValid) {
+            AISDK_WARN(LX("loadClipFailed").d("reason", "invalidFile").d("path", path));
+            std::remove(path.c_str());
+            continue;
+        }
+        files.push_back(std::make_tuple(fileStat.st_mtime, fileName.substr(0, dot), fileStat.st_size));
+    }
+    closedir(directory);
+
+    // The files are touched when they are played, so their times give the order of use of the last run.
+    std::sort(files.begin(), files.end());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& file : files) {
+        m_files[std::get<1>(file)] = FileEntry{std::get<2>(file), ++m_useCount};
+        m_sizeBytes += std::get<2>(file);
+    }
+    evictLocked();
+    return true;
+}
+
+std::shared_ptr<DecoderInterface> PcmCache::createDecoder(const std::string& url, const PlaybackConfiguration& config) {
+    auto startTime = std::chrono::steady_clock::now();
+    std::string key;
+    if (!isCacheable(url, std::chrono::milliseconds::zero()) || !keyOf(url, config, &key)) {
+        return nullptr;
+    }
+
+    auto clip = findClip(key, nameOf(key));
+    if (!clip) {
+        if (m_missCounter) {
+            m_missCounter->increment();
+        }
+        return nullptr;
+    }
+    AISDK_DEBUG5(LX("hit").d("url", url).d("bytes", clip->dataBytes));
+    return std::make_shared<ClipDecoder>(
+        clip, config.sampleSizeBytes() * config.numberChannels(), startTime, m_hitFirstSampleHistogram);
+}
+
+std::shared_ptr<DecoderInterface> PcmCache::record(
+    const std::string& url,
+    const PlaybackConfiguration& config,
+    std::shared_ptr<DecoderInterface> decoder) {
+    if (!decoder || !isCacheable(url, std::chrono::milliseconds::zero())) {
+        return decoder;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!markPlayedLocked(url)) {
+            if (m_firstPlayCounter) {
+                m_firstPlayCounter->increment();
+            }
+            return decoder;
+        }
+    }
+    std::string key;
+    if (!keyOf(url, config, &key)) {
+        return decoder;
+    }
+
+    auto name = nameOf(key);
+    uint64_t recording;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        recording = ++m_recordingCount;
+    }
+    // Each recording has its own file, so that plays of the same url at the same time do not mix their audio.
+    auto temporaryPath = pathOf(name + "-" + std::to_string(recording), TEMPORARY_EXTENSION);
+    int fd = open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        AISDK_WARN(LX("recordFailed").d("reason", "openFailed").d("path", temporaryPath).d("errno", errno));
+        return decoder;
+    }
+    return std::make_shared<RecordingDecoder>(shared_from_this(), decoder, key, name, temporaryPath, fd);
+}
+
+bool PcmCache::markPlayedLocked(const std::string& url) {
+    auto hash = std::hash<std::string>()(url);
+    auto it = m_playedUrlIndex.find(hash);
+    if (it != m_playedUrlIndex.end()) {
+        m_playedUrls.splice(m_playedUrls.begin(), m_playedUrls, it->second);
+        return true;
+    }
+    m_playedUrls.push_front(hash);
+    m_playedUrlIndex[hash] = m_playedUrls.begin();
+    if (m_playedUrls.size() > MAX_PLAYED_URLS) {
+        m_playedUrlIndex.erase(m_playedUrls.back());
+        m_playedUrls.pop_back();
+    }
+    return false;
+}
+
+std::shared_ptr<PcmCache::Clip> PcmCache::findClip(const std::string& key, const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto file = m_files.find(name);
+    if (file == m_files.end()) {
+        return nullptr;
+    }
+
+    auto it = m_clipIndex.find(name);
+    if (it != m_clipIndex.end() && it->second->second->key == key) {
+        m_clips.splice(m_clips.begin(), m_clips, it->second);
+        file->second.lastUse = ++m_useCount;
+        if (m_memoryHitCounter) {
+            m_memoryHitCounter->increment();
+        }
+        return m_clips.front().second;
+    }
+
+    auto path = pathOf(name, CLIP_EXTENSION);
+    auto clip = mapClip(path, key);
+    if (!clip) {
+        return nullptr;
+    }
+    file->second.lastUse = ++m_useCount;
+    utime(path.c_str(), nullptr);
+    unmapLocked(name);
+    m_clips.emplace_front(name, clip);
+    m_clipIndex[name] = m_clips.begin();
+    m_memoryBytes += clip->dataBytes;
+    trimMemoryLocked();
+    if (m_diskHitCounter) {
+        m_diskHitCounter->increment();
+    }
+    return clip;
+}
+
+bool PcmCache::commit(const std::string& name, const std::string& temporaryPath, uint64_t fileBytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (std::rename(temporaryPath.c_str(), pathOf(name, CLIP_EXTENSION).c_str()) != 0) {
+        AISDK_ERROR(LX("commitFailed").d("reason", "renameFailed").d("path", temporaryPath).d("errno", errno));
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+
+    auto file = m_files.find(name);
+    if (file != m_files.end()) {
+        m_sizeBytes -= std::min(m_sizeBytes, file->second.bytes);
+    }
+    m_files[name] = FileEntry{fileBytes, ++m_useCount};
+    m_sizeBytes += fileBytes;
+    // A mapping of the replaced file would serve the previous recording.
+    unmapLocked(name);
+    AISDK_DEBUG5(LX("committed").d("name", name).d("bytes", fileBytes));
+    evictLocked();
+    return true;
+}
+
+void PcmCache::evictLocked() {
+    while (m_sizeBytes > m_maxBytes && !m_files.empty()) {
+        auto victim = m_files.begin();
+        for (auto it = m_files.begin(); it != m_files.end(); ++it) {
+            if (it->second.lastUse < victim->second.lastUse) {
+                victim = it;
+            }
+        }
+
+        // Decoders playing the recording keep their mapping, which outlives the file.
+        AISDK_DEBUG5(LX("evicted").d("name", victim->first).d("bytes", victim->second.bytes));
+        std::remove(pathOf(victim->first, CLIP_EXTENSION).c_str());
+        m_sizeBytes -= std::min(m_sizeBytes, victim->second.bytes);
+        unmapLocked(victim->first);
+        m_files.erase(victim);
+    }
+    if (m_sizeGauge) {
+        m_sizeGauge->set(static_cast<int64_t>(m_sizeBytes));
+    }
+}
+
+void PcmCache::trimMemoryLocked() {
+    while (m_memoryBytes > m_maxMemoryBytes && !m_clips.empty()) {
+        unmapLocked(m_clips.back().first);
+    }
+    if (m_memoryGauge) {
+        m_memoryGauge->set(static_cast<int64_t>(m_memoryBytes));
+    }
+}
+
+void PcmCache::unmapLocked(const std::string& name) {
+    auto it = m_clipIndex.find(name);
+    if (it == m_clipIndex.end()) {
+        return;
+    }
+    m_memoryBytes -= std::min<uint64_t>(m_memoryBytes, it->second->second->dataBytes);
+    m_clips.erase(it->second);
+    m_clipIndex.erase(it);
+    if (m_memoryGauge) {
+        m_memoryGauge->set(static_cast<int64_t>(m_memoryBytes));
+    }
+}
+
+uint64_t PcmCache::getSizeBytes() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_sizeBytes;
+}
+
+uint64_t PcmCache::getMemoryBytes() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_memoryBytes;
+}
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <Utils/Logging/Logger.h>
+#include <Utils/Tracing/TraceEventRecorder.h>
+
+#include "AudioMediaPlayer/Endian.h"
+#include "AudioMediaPlayer/PcmDecoder.h"
+#include "AudioMediaPlayer/PcmKernels.h"
+
+/// String to identify log entries originating from this file.
+static const std::string TAG("PcmDecoder");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+using namespace utils::attachment;
+
+/// How long a read waits for the attachment, which also bounds how long @c abort() waits for a blocked read.
+static const std::chrono::milliseconds READ_TIMEOUT{100};
+
+/// How long to wait before reading again when a non-blocking attachment had no data.
+static const std::chrono::milliseconds RETRY_INTERVAL{10};
+
+/// The bytes of input read from the attachment at most per read.
+static constexpr size_t INPUT_BUFFER_SIZE{4096};
+
+/// The size of a byte in bits.
+static constexpr unsigned int BYTE_TO_BITS{8u};
+
+/**
+ * Load one input sample as a signed 32 bit value with its most significant bits aligned.
+ *
+ * @param input The sample.
+ * @param sampleBytes The bytes of the sample: 1 for unsigned 8 bit, 2 or 4 for signed samples.
+ * @param isBigEndian Whether the sample is big endian.
+ * @return The sample value.
+ */
+static int32_t loadSample(const uint8_t* input, size_t sampleBytes, bool isBigEndian) {
+    switch (sampleBytes) {
+        case 1:
+            return (static_cast<int32_t>(input[0]) - 128) * (1 << 24);
+        case 2: {
+            uint16_t value = isBigEndian ? (input[0] << 8 | input[1]) : (input[1] << 8 | input[0]);
+            return static_cast<int32_t>(static_cast<int16_t>(value)) * (1 << 16);
+        }
+        default: {
+            uint32_t value = isBigEndian
+                                 ? (uint32_t(input[0]) << 24 | uint32_t(input[1]) << 16 | input[2] << 8 | input[3])
+                                 : (uint32_t(input[3]) << 24 | uint32_t(input[2]) << 16 | input[1] << 8 | input[0]);
+            return static_cast<int32_t>(value);
+        }
+    }
+}
+
+/**
+ * Store one output sample in native endianness.
+ *
+ * @param value The sample value, with its most significant bits aligned.
+ * @param output Where to store the sample.
+ * @param sampleBytes The bytes of the sample: 1 for unsigned 8 bit, 2 or 4 for signed samples.
+ */
+static void storeSample(int32_t value, uint8_t* output, size_t sampleBytes) {
+    switch (sampleBytes) {
+        case 1:
+            output[0] = static_cast<uint8_t>((value >> 24) + 128);
+            break;
+        case 2: {
+            auto sample = static_cast<int16_t>(value >> 16);
+            memcpy(output, &sample, sizeof(sample));
+            break;
+        }
+        default:
+            memcpy(output, &value, sizeof(value));
+            break;
+    }
+}
+
+bool PcmDecoder::isSupported(const utils::AudioFormat& format, const PlaybackConfiguration& outputConfig) {
+    auto outputChannels = outputConfig.numberChannels();
+    bool isSampleSupported = (BYTE_TO_BITS == format.sampleSizeInBits && !format.dataSigned) ||
+                             ((16 == format.sampleSizeInBits || 32 == format.sampleSizeInBits) && format.dataSigned);
+    bool areChannelsSupported = format.numChannels == outputChannels || 1 == format.numChannels ||
+                                (2 == format.numChannels && 1 == outputChannels);
+    return utils::AudioFormat::Encoding::LPCM == format.encoding && format.sampleRateHz == outputConfig.sampleRate() &&
+           isSampleSupported && areChannelsSupported && outputConfig.isLittleEndian() == littleEndianMachine();
+}
+
+std::unique_ptr<PcmDecoder> PcmDecoder::create(
+    std::shared_ptr<AttachmentReader> reader,
+    const utils::AudioFormat& format,
+    const PlaybackConfiguration& outputConfig) {
+    if (!reader) {
+        AISDK_ERROR(LX("createFailed").d("reason", "nullReader"));
+        return nullptr;
+    }
+    if (!isSupported(format, outputConfig)) {
+        AISDK_ERROR(LX("createFailed")
+                        .d("reason", "formatNotSupported")
+                        .d("encoding", format.encoding)
+                        .d("rate", format.sampleRateHz)
+                        .d("sampleSize", format.sampleSizeInBits)
+                        .d("numChannels", format.numChannels)
+                        .d("signed", format.dataSigned)
+                        .d("outputRate", outputConfig.sampleRate())
+                        .d("outputChannels", outputConfig.numberChannels()));
+        return nullptr;
+    }
+    return std::unique_ptr<PcmDecoder>(new PcmDecoder(reader, format, outputConfig));
+}
+
+PcmDecoder::PcmDecoder(
+    std::shared_ptr<AttachmentReader> reader,
+    const utils::AudioFormat& format,
+    const PlaybackConfiguration& outputConfig) :
+        m_reader{reader},
+        m_inputSampleBytes{format.sampleSizeInBits / BYTE_TO_BITS},
+        m_isInputBigEndian{utils::AudioFormat::Endianness::BIG == format.endianness},
+        m_inputChannels{format.numChannels},
+        m_outputSampleBytes{outputConfig.sampleSizeBytes()},
+        m_outputChannels{outputConfig.numberChannels()},
+        m_input(INPUT_BUFFER_SIZE),
+        m_inputBytes{0},
+        m_inputMemory{utils::metrics::MemoryAccounting::Subsystem::DECODER, INPUT_BUFFER_SIZE},
+        m_isFinished{false},
+        m_isAborted{false} {
+}
+
+std::pair<PcmDecoder::Status, size_t> PcmDecoder::read(Byte* buffer, size_t size) {
+    AISDK_TRACE_SCOPE("decoder", "PcmDecoder::read");
+    if (!buffer || size == 0) {
+        AISDK_ERROR(LX("readFailed").d("reason", "invalidInput").d("buffer", buffer).d("size", size));
+        return {Status::ERROR, 0};
+    }
+
+    if (m_isAborted) {
+        AISDK_DEBUG2(LX("readFailed").d("reason", "aborted"));
+        return {Status::ERROR, 0};
+    }
+
+    if (m_isFinished) {
+        AISDK_INFO(LX("readEmpty").d("reason", "doneDecoding"));
+        return {Status::DONE, 0};
+    }
+
+    auto inputFrameBytes = m_inputSampleBytes * m_inputChannels;
+    auto outputFrameBytes = m_outputSampleBytes * m_outputChannels;
+    auto frames = size / outputFrameBytes;
+    if (frames == 0) {
+        AISDK_ERROR(LX("readFailed").d("reason", "bufferTooSmall").d("bufferSize", size));
+        return {Status::ERROR, 0};
+    }
+
+    // Only read what converts into the caller's buffer, so that no more than a partial frame is left over.
+    auto wanted = std::min(frames * inputFrameBytes, m_input.size());
+    if (m_inputBytes < wanted) {
+        AttachmentReader::ReadStatus readStatus;
+        auto readSize = m_reader->read(m_input.data() + m_inputBytes, wanted - m_inputBytes, &readStatus, READ_TIMEOUT);
+        switch (readStatus) {
+            case AttachmentReader::ReadStatus::OK:
+                break;
+            case AttachmentReader::ReadStatus::OK_WOULDBLOCK:
+            case AttachmentReader::ReadStatus::OK_TIMEDOUT:
+                AISDK_DEBUG3(LX(__func__).d("status", readStatus).d("readSize", readSize));
+                if (!readSize) {
+                    std::unique_lock<std::mutex> lock(m_abortMutex);
+                    m_abortCondition.wait_for(lock, RETRY_INTERVAL, [this]() { return m_isAborted.load(); });
+                }
+                break;
+            case AttachmentReader::ReadStatus::CLOSED:
+                AISDK_DEBUG5(LX(__func__).m("Found EOF"));
+                m_isFinished = true;
+                break;
+            case AttachmentReader::ReadStatus::ERROR_BYTES_LESS_THAN_WORD_SIZE:
+            case AttachmentReader::ReadStatus::ERROR_INTERNAL:
+            case AttachmentReader::ReadStatus::ERROR_OVERRUN:
+                AISDK_ERROR(LX("readFailed").d("reason", readStatus));
+                return {Status::ERROR, 0};
+        }
+        m_inputBytes += readSize;
+    }
+
+    frames = std::min(frames, m_inputBytes / inputFrameBytes);
+    convert(buffer, frames);
+    auto consumedBytes = frames * inputFrameBytes;
+    memmove(m_input.data(), m_input.data() + consumedBytes, m_inputBytes - consumedBytes);
+    m_inputBytes -= consumedBytes;
+
+    // The last bytes of a closed attachment which do not make a whole frame are dropped.
+    return {m_isFinished ? Status::DONE : Status::OK, frames * outputFrameBytes};
+}
+
+void PcmDecoder::convert(Byte* buffer, size_t frames) {
+    auto input = m_input.data();
+    bool isInputNative = 1 == m_inputSampleBytes || m_isInputBigEndian != littleEndianMachine();
+    if (m_inputSampleBytes == m_outputSampleBytes && m_inputChannels == m_outputChannels && isInputNative) {
+        memcpy(buffer, input, frames * m_inputSampleBytes * m_inputChannels);
+        return;
+    }
+    // The common conversions of native samples go through the SIMD kernels.  Both buffers hold whole frames from
+    // their start, so they are aligned for the samples.
+    auto input16 = reinterpret_cast<const int16_t*>(input);
+    auto input32 = reinterpret_cast<const int32_t*>(input);
+    auto output16 = reinterpret_cast<int16_t*>(buffer);
+    if (2 == m_inputSampleBytes && 2 == m_outputSampleBytes) {
+        if (1 == m_inputChannels && 2 == m_outputChannels && isInputNative) {
+            monoToStereo16(input16, output16, frames);
+            return;
+        }
+        if (2 == m_inputChannels && 1 == m_outputChannels && isInputNative) {
+            stereoToMono16(input16, output16, frames);
+            return;
+        }
+        if (m_inputChannels == m_outputChannels && !isInputNative) {
+            byteSwap16(input, buffer, frames * m_inputChannels);
+            return;
+        }
+    }
+    if (m_inputChannels == m_outputChannels && isInputNative) {
+        if (2 == m_inputSampleBytes && 4 == m_outputSampleBytes) {
+            convertS16ToS32(input16, reinterpret_cast<int32_t*>(buffer), frames * m_inputChannels);
+            return;
+        }
+        if (4 == m_inputSampleBytes && 2 == m_outputSampleBytes) {
+            convertS32ToS16(input32, output16, frames * m_inputChannels);
+            return;
+        }
+    }
+
+    // Any other combination goes through 32 bit samples, one at a time.
+    for (size_t frame = 0; frame < frames; ++frame) {
+        auto in = input + frame * m_inputSampleBytes * m_inputChannels;
+        auto out = buffer + frame * m_outputSampleBytes * m_outputChannels;
+        if (m_inputChannels == m_outputChannels) {
+            for (size_t channel = 0; channel < m_outputChannels; ++channel) {
+                storeSample(
+                    loadSample(in + channel * m_inputSampleBytes, m_inputSampleBytes, m_isInputBigEndian),
+                    out + channel * m_outputSampleBytes,
+                    m_outputSampleBytes);
+            }
+        } else if (1 == m_inputChannels) {
+            auto value = loadSample(in, m_inputSampleBytes, m_isInputBigEndian);
+            for (size_t channel = 0; channel < m_outputChannels; ++channel) {
+                storeSample(value, out + channel * m_outputSampleBytes, m_outputSampleBytes);
+            }
+        } else {
+            // Stereo to mono.
+            auto value = loadSample(in, m_inputSampleBytes, m_isInputBigEndian) / 2 +
+                         loadSample(in + m_inputSampleBytes, m_inputSampleBytes, m_isInputBigEndian) / 2;
+            storeSample(value, out, m_outputSampleBytes);
+        }
+    }
+}
+
+void PcmDecoder::abort() {
+    {
+        std::lock_guard<std::mutex> lock(m_abortMutex);
+        m_isAborted = true;
+    }
+    m_abortCondition.notify_all();
+}
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
@@ -0,0 +1,471 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include "AudioMediaPlayer/PcmKernels.h"
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+/// The number of frames a fade keeps the same gain for.
+static constexpr size_t FADE_BLOCK_FRAMES = 32;
+
+/// The gain taken for silence by an exponential fade, -60dB.
+static constexpr float SILENCE_GAIN = 0.001f;
+
+/// The scale of 16 bit samples as floats.
+static constexpr float S16_SCALE = 32768.0f;
+
+/// The scale of 32 bit samples as floats.
+static constexpr float S32_SCALE = 2147483648.0f;
+
+/// The largest float which converts to a 32 bit sample, the one below 2^31.
+static constexpr float S32_MAX_FLOAT = 2147483520.0f;
+
+/**
+ * Clamp a sum of samples to the 16 bit range.
+ *
+ * @param value The sum.
+ * @return The saturated sample.
+ */
+static int16_t saturate16(int32_t value) {
+    return static_cast<int16_t>(std::min<int32_t>(std::max<int32_t>(value, INT16_MIN), INT16_MAX));
+}
+
+/**
+ * Round a float to the nearest 32 bit integer, the way the SIMD conversions do.
+ *
+ * @param value The value, within the 32 bit range.
+ * @return The rounded value.
+ */
+static int32_t roundToInt32(float value) {
+    return static_cast<int32_t>(std::lrint(value));
+}
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+/**
+ * Round floats to the nearest 32 bit integers.  Only AArch64 converts to the nearest; ARMv7 truncates, so add a half
+ * away from zero first, which only differs from the scalar rounding on exact halves.
+ *
+ * @param value The values, within the 32 bit range.
+ * @return The rounded values.
+ */
+static int32x4_t roundToInt32(float32x4_t value) {
+#if defined(__aarch64__)
+    return vcvtnq_s32_f32(value);
+#else
+    auto half = vbslq_f32(vcltq_f32(value, vdupq_n_f32(0.0f)), vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f));
+    return vcvtq_s32_f32(vaddq_f32(value, half));
+#endif
+}
+#endif
+
+void mixSaturating16(int16_t* destination, const int16_t* source, size_t samples) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 8 <= samples; i += 8) {
+        auto sum = _mm_adds_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(destination + i)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), sum);
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 8 <= samples; i += 8) {
+        vst1q_s16(destination + i, vqaddq_s16(vld1q_s16(destination + i), vld1q_s16(source + i)));
+    }
+#endif
+    for (; i < samples; ++i) {
+        destination[i] = saturate16(int32_t(destination[i]) + source[i]);
+    }
+}
+
+void mixScaledSaturating16(int16_t* destination, const int16_t* source, size_t samples, int32_t gainQ15) {
+    if (gainQ15 >= UNITY_GAIN_Q15) {
+        mixSaturating16(destination, source, samples);
+        return;
+    }
+    if (gainQ15 <= 0) {
+        return;
+    }
+
+    size_t i = 0;
+#if defined(__SSE2__)
+    auto gain = _mm_set1_epi16(static_cast<int16_t>(gainQ15));
+    for (; i + 8 <= samples; i += 8) {
+        auto input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        // The 32 bit products, from the low and high halves of the 16 bit multiplications.
+        auto low = _mm_mullo_epi16(input, gain);
+        auto high = _mm_mulhi_epi16(input, gain);
+        auto scaled = _mm_packs_epi32(
+            _mm_srai_epi32(_mm_unpacklo_epi16(low, high), 15), _mm_srai_epi32(_mm_unpackhi_epi16(low, high), 15));
+        auto sum = _mm_adds_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(destination + i)), scaled);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), sum);
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    auto gain = vdupq_n_s16(static_cast<int16_t>(gainQ15));
+    for (; i + 8 <= samples; i += 8) {
+        // The doubling multiply returns the high half of twice the product, which is the product in Q15, truncated
+        // like the scalar loop.
+        auto scaled = vqdmulhq_s16(vld1q_s16(source + i), gain);
+        vst1q_s16(destination + i, vqaddq_s16(vld1q_s16(destination + i), scaled));
+    }
+#endif
+    for (; i < samples; ++i) {
+        destination[i] = saturate16(int32_t(destination[i]) + ((int32_t(source[i]) * gainQ15) >> 15));
+    }
+}
+
+void applyGain16(int16_t* samples, size_t count, int32_t gainQ15) {
+    gainQ15 = std::min(std::max(gainQ15, 0), MAX_GAIN_Q15);
+    if (UNITY_GAIN_Q15 == gainQ15) {
+        return;
+    }
+    if (0 == gainQ15) {
+        std::fill(samples, samples + count, 0);
+        return;
+    }
+    // A gain above unity does not fit in 16 bits: drop its lowest bits, and shift the products less.
+    int shift = 15;
+    while (gainQ15 > INT16_MAX) {
+        gainQ15 >>= 1;
+        --shift;
+    }
+
+    size_t i = 0;
+#if defined(__SSE2__)
+    auto gain = _mm_set1_epi16(static_cast<int16_t>(gainQ15));
+    auto shiftCount = _mm_cvtsi32_si128(shift);
+    for (; i + 8 <= count; i += 8) {
+        auto input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+        auto low = _mm_mullo_epi16(input, gain);
+        auto high = _mm_mulhi_epi16(input, gain);
+        // The pack saturates the products which do not fit in 16 bits.
+        auto scaled = _mm_packs_epi32(
+            _mm_sra_epi32(_mm_unpacklo_epi16(low, high), shiftCount),
+            _mm_sra_epi32(_mm_unpackhi_epi16(low, high), shiftCount));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(samples + i), scaled);
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    auto gain = vdup_n_s16(static_cast<int16_t>(gainQ15));
+    // A shift by a negative count shifts right.
+    auto shiftRight = vdupq_n_s32(-shift);
+    for (; i + 8 <= count; i += 8) {
+        auto input = vld1q_s16(samples + i);
+        auto low = vshlq_s32(vmull_s16(vget_low_s16(input), gain), shiftRight);
+        auto high = vshlq_s32(vmull_s16(vget_high_s16(input), gain), shiftRight);
+        vst1q_s16(samples + i, vcombine_s16(vqmovn_s32(low), vqmovn_s32(high)));
+    }
+#endif
+    for (; i < count; ++i) {
+        samples[i] = saturate16((int32_t(samples[i]) * gainQ15) >> shift);
+    }
+}
+
+void applyGain32(int32_t* samples, size_t count, float gain) {
+    if (1.0f == gain) {
+        return;
+    }
+    gain = std::max(gain, 0.0f);
+
+    size_t i = 0;
+#if defined(__SSE2__)
+    auto scale = _mm_set1_ps(gain);
+    auto minimum = _mm_set1_ps(-S32_SCALE);
+    auto maximum = _mm_set1_ps(S32_MAX_FLOAT);
+    for (; i + 4 <= count; i += 4) {
+        auto value = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i)));
+        value = _mm_min_ps(_mm_max_ps(_mm_mul_ps(value, scale), minimum), maximum);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(samples + i), _mm_cvtps_epi32(value));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    auto minimum = vdupq_n_f32(-S32_SCALE);
+    auto maximum = vdupq_n_f32(S32_MAX_FLOAT);
+    for (; i + 4 <= count; i += 4) {
+        auto value = vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(samples + i)), gain);
+        vst1q_s32(samples + i, roundToInt32(vminq_f32(vmaxq_f32(value, minimum), maximum)));
+    }
+#endif
+    for (; i < count; ++i) {
+        auto value = static_cast<float>(samples[i]) * gain;
+        samples[i] = roundToInt32(std::min(std::max(value, -S32_SCALE), S32_MAX_FLOAT));
+    }
+}
+
+void applyGainF32(float* samples, size_t count, float gain) {
+    gain = std::max(gain, 0.0f);
+
+    size_t i = 0;
+#if defined(__SSE2__)
+    auto scale = _mm_set1_ps(gain);
+    auto minimum = _mm_set1_ps(-1.0f);
+    auto maximum = _mm_set1_ps(1.0f);
+    for (; i + 4 <= count; i += 4) {
+        auto value = _mm_mul_ps(_mm_loadu_ps(samples + i), scale);
+        _mm_storeu_ps(samples + i, _mm_min_ps(_mm_max_ps(value, minimum), maximum));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    auto minimum = vdupq_n_f32(-1.0f);
+    auto maximum = vdupq_n_f32(1.0f);
+    for (; i + 4 <= count; i += 4) {
+        auto value = vmulq_n_f32(vld1q_f32(samples + i), gain);
+        vst1q_f32(samples + i, vminq_f32(vmaxq_f32(value, minimum), maximum));
+    }
+#endif
+    for (; i < count; ++i) {
+        samples[i] = std::min(std::max(samples[i] * gain, -1.0f), 1.0f);
+    }
+}
+
+float fadeGain(float fromGain, float toGain, float position, FadeCurve curve) {
+    if (position <= 0.0f) {
+        return fromGain;
+    }
+    if (position >= 1.0f) {
+        return toGain;
+    }
+    switch (curve) {
+        case FadeCurve::LINEAR:
+            break;
+        case FadeCurve::EXPONENTIAL: {
+            auto from = std::max(fromGain, SILENCE_GAIN);
+            auto to = std::max(toGain, SILENCE_GAIN);
+            return from * std::pow(to / from, position);
+        }
+    }
+    return fromGain + (toGain - fromGain) * position;
+}
+
+void applyFade16(int16_t* samples, size_t frames, size_t channels, float fromGain, float toGain, FadeCurve curve) {
+    for (size_t frame = 0; frame < frames; frame += FADE_BLOCK_FRAMES) {
+        auto blockFrames = std::min(FADE_BLOCK_FRAMES, frames - frame);
+        // Each block takes the gain at its end, so that the last one is at the target.
+        auto gain = fadeGain(fromGain, toGain, static_cast<float>(frame + blockFrames) / frames, curve);
+        applyGain16(
+            samples + frame * channels, blockFrames * channels, static_cast<int32_t>(std::lround(gain * UNITY_GAIN_Q15)));
+    }
+}
+
+void applyFade32(int32_t* samples, size_t frames, size_t channels, float fromGain, float toGain, FadeCurve curve) {
+    for (size_t frame = 0; frame < frames; frame += FADE_BLOCK_FRAMES) {
+        auto blockFrames = std::min(FADE_BLOCK_FRAMES, frames - frame);
+        auto gain = fadeGain(fromGain, toGain, static_cast<float>(frame + blockFrames) / frames, curve);
+        applyGain32(samples + frame * channels, blockFrames * channels, gain);
+    }
+}
+
+void convertS16ToS32(const int16_t* input, int32_t* output, size_t count) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    auto zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        // Interleaving zeros below the samples shifts them to the top of 32 bit lanes.
+        auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_unpacklo_epi16(zero, value));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i + 4), _mm_unpackhi_epi16(zero, value));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 8 <= count; i += 8) {
+        auto value = vld1q_s16(input + i);
+        vst1q_s32(output + i, vshll_n_s16(vget_low_s16(value), 16));
+        vst1q_s32(output + i + 4, vshll_n_s16(vget_high_s16(value), 16));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = static_cast<int32_t>(input[i]) * (1 << 16);
+    }
+}
+
+void convertS32ToS16(const int32_t* input, int16_t* output, size_t count) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 8 <= count; i += 8) {
+        auto low = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)), 16);
+        auto high = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 4)), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packs_epi32(low, high));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 8 <= count; i += 8) {
+        vst1q_s16(output + i, vcombine_s16(vshrn_n_s32(vld1q_s32(input + i), 16), vshrn_n_s32(vld1q_s32(input + i + 4), 16)));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = static_cast<int16_t>(input[i] >> 16);
+    }
+}
+
+void convertS16ToF32(const int16_t* input, float* output, size_t count) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    auto scale = _mm_set1_ps(1.0f / S16_SCALE);
+    for (; i + 8 <= count; i += 8) {
+        auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        // Sign extend to 32 bits by interleaving the samples with themselves and shifting them back down.
+        auto low = _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+        auto high = _mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16);
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 8 <= count; i += 8) {
+        auto value = vld1q_s16(input + i);
+        vst1q_f32(output + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(value))), 1.0f / S16_SCALE));
+        vst1q_f32(output + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(value))), 1.0f / S16_SCALE));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = input[i] * (1.0f / S16_SCALE);
+    }
+}
+
+void convertF32ToS16(const float* input, int16_t* output, size_t count) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    auto scale = _mm_set1_ps(S16_SCALE);
+    auto minimum = _mm_set1_ps(-S16_SCALE);
+    auto maximum = _mm_set1_ps(S16_SCALE - 1.0f);
+    for (; i + 8 <= count; i += 8) {
+        // Clamp before converting: out of range floats convert to INT32_MIN, which the pack would keep negative.
+        auto low = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(input + i), scale), minimum), maximum);
+        auto high = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(input + i + 4), scale), minimum), maximum);
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(output + i), _mm_packs_epi32(_mm_cvtps_epi32(low), _mm_cvtps_epi32(high)));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    auto minimum = vdupq_n_f32(-S16_SCALE);
+    auto maximum = vdupq_n_f32(S16_SCALE - 1.0f);
+    for (; i + 8 <= count; i += 8) {
+        auto low = vminq_f32(vmaxq_f32(vmulq_n_f32(vld1q_f32(input + i), S16_SCALE), minimum), maximum);
+        auto high = vminq_f32(vmaxq_f32(vmulq_n_f32(vld1q_f32(input + i + 4), S16_SCALE), minimum), maximum);
+        vst1q_s16(output + i, vcombine_s16(vqmovn_s32(roundToInt32(low)), vqmovn_s32(roundToInt32(high))));
+    }
+#endif
+    for (; i < count; ++i) {
+        auto value = std::min(std::max(input[i] * S16_SCALE, -S16_SCALE), S16_SCALE - 1.0f);
+        output[i] = static_cast<int16_t>(roundToInt32(value));
+    }
+}
+
+void convertS32ToF32(const int32_t* input, float* output, size_t count) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    auto scale = _mm_set1_ps(1.0f / S32_SCALE);
+    for (; i + 4 <= count; i += 4) {
+        auto value = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)));
+        _mm_storeu_ps(output + i, _mm_mul_ps(value, scale));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(output + i, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(input + i)), 1.0f / S32_SCALE));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = static_cast<float>(input[i]) * (1.0f / S32_SCALE);
+    }
+}
+
+void convertF32ToS32(const float* input, int32_t* output, size_t count) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    auto scale = _mm_set1_ps(S32_SCALE);
+    auto minimum = _mm_set1_ps(-S32_SCALE);
+    auto maximum = _mm_set1_ps(S32_MAX_FLOAT);
+    for (; i + 4 <= count; i += 4) {
+        auto value = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(input + i), scale), minimum), maximum);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_cvtps_epi32(value));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    auto minimum = vdupq_n_f32(-S32_SCALE);
+    auto maximum = vdupq_n_f32(S32_MAX_FLOAT);
+    for (; i + 4 <= count; i += 4) {
+        auto value = vminq_f32(vmaxq_f32(vmulq_n_f32(vld1q_f32(input + i), S32_SCALE), minimum), maximum);
+        vst1q_s32(output + i, roundToInt32(value));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = roundToInt32(std::min(std::max(input[i] * S32_SCALE, -S32_SCALE), S32_MAX_FLOAT));
+    }
+}
+
+void monoToStereo16(const int16_t* input, int16_t* output, size_t frames) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 8 <= frames; i += 8) {
+        auto mono = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 2), _mm_unpacklo_epi16(mono, mono));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 2 + 8), _mm_unpackhi_epi16(mono, mono));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 8 <= frames; i += 8) {
+        auto mono = vld1q_s16(input + i);
+        int16x8x2_t stereo = {{mono, mono}};
+        vst2q_s16(output + i * 2, stereo);
+    }
+#endif
+    for (; i < frames; ++i) {
+        output[i * 2] = input[i];
+        output[i * 2 + 1] = input[i];
+    }
+}
+
+void stereoToMono16(const int16_t* input, int16_t* output, size_t frames) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    auto ones = _mm_set1_epi16(1);
+    for (; i + 8 <= frames; i += 8) {
+        // Multiplying by one and adding pairs gives the sum of the two channels of each frame in 32 bits.
+        auto low = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2)), ones);
+        auto high = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2 + 8)), ones);
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(output + i), _mm_packs_epi32(_mm_srai_epi32(low, 1), _mm_srai_epi32(high, 1)));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 8 <= frames; i += 8) {
+        auto stereo = vld2q_s16(input + i * 2);
+        vst1q_s16(output + i, vhaddq_s16(stereo.val[0], stereo.val[1]));
+    }
+#endif
+    for (; i < frames; ++i) {
+        output[i] = static_cast<int16_t>((int32_t(input[i * 2]) + input[i * 2 + 1]) >> 1);
+    }
+}
+
+void byteSwap16(const uint8_t* input, uint8_t* output, size_t count) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 8 <= count; i += 8) {
+        auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2));
+        value = _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 2), value);
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 8 <= count; i += 8) {
+        vst1q_u8(output + i * 2, vrev16q_u8(vld1q_u8(input + i * 2)));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i * 2] = input[i * 2 + 1];
+        output[i * 2 + 1] = input[i * 2];
+    }
+}
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "AudioMediaPlayer/PcmRingBuffer.h"
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+PcmRingBuffer::PcmRingBuffer(size_t capacity) : m_buffer(capacity), m_writeIndex{0}, m_readIndex{0} {
+}
+
+size_t PcmRingBuffer::write(const uint8_t* data, size_t size) {
+    // Acquire the read index so that the consumer is done with the bytes before they are overwritten.
+    auto readIndex = m_readIndex.load(std::memory_order_acquire);
+    auto writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+    auto count = std::min(size, m_buffer.size() - static_cast<size_t>(writeIndex - readIndex));
+    auto offset = static_cast<size_t>(writeIndex % m_buffer.size());
+    auto firstPart = std::min(count, m_buffer.size() - offset);
+    std::memcpy(m_buffer.data() + offset, data, firstPart);
+    std::memcpy(m_buffer.data(), data + firstPart, count - firstPart);
+    m_writeIndex.store(writeIndex + count, std::memory_order_release);
+    return count;
+}
+
+uint8_t* PcmRingBuffer::reserve(size_t* size) {
+    auto readIndex = m_readIndex.load(std::memory_order_acquire);
+    auto writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+    auto offset = static_cast<size_t>(writeIndex % m_buffer.size());
+    *size = std::min(m_buffer.size() - static_cast<size_t>(writeIndex - readIndex), m_buffer.size() - offset);
+    return m_buffer.data() + offset;
+}
+
+void PcmRingBuffer::commit(size_t size) {
+    m_writeIndex.store(m_writeIndex.load(std::memory_order_relaxed) + size, std::memory_order_release);
+}
+
+size_t PcmRingBuffer::read(uint8_t* data, size_t size) {
+    // Acquire the write index so that the bytes written by the producer are visible.
+    auto writeIndex = m_writeIndex.load(std::memory_order_acquire);
+    auto readIndex = m_readIndex.load(std::memory_order_relaxed);
+    auto count = std::min(size, static_cast<size_t>(writeIndex - readIndex));
+    auto offset = static_cast<size_t>(readIndex % m_buffer.size());
+    auto firstPart = std::min(count, m_buffer.size() - offset);
+    std::memcpy(data, m_buffer.data() + offset, firstPart);
+    std::memcpy(data + firstPart, m_buffer.data(), count - firstPart);
+    m_readIndex.store(readIndex + count, std::memory_order_release);
+    return count;
+}
+
+size_t PcmRingBuffer::size() const {
+    // Seen from a third thread both sides may move between the two loads, so never report more than the capacity.
+    auto readIndex = m_readIndex.load(std::memory_order_acquire);
+    auto count = static_cast<size_t>(m_writeIndex.load(std::memory_order_acquire) - readIndex);
+    return std::min(count, m_buffer.size());
+}
+
+size_t PcmRingBuffer::freeSpace() const {
+    return m_buffer.size() - size();
+}
+
+size_t PcmRingBuffer::capacity() const {
+    return m_buffer.size();
+}
+
+void PcmRingBuffer::clear() {
+    m_readIndex.store(m_writeIndex.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
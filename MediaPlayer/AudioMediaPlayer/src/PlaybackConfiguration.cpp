@@ -12,11 +12,22 @@
 
 #include <list>
 #include <unordered_map>
-#include <iostream>
+
+#include <Utils/Logging/Logger.h>
 
 #include "AudioMediaPlayer/Endian.h"
 #include "AudioMediaPlayer/PlaybackConfiguration.h"
 
+/// String to identify log entries originating from this file.
+static const std::string TAG("PlaybackConfiguration");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
 namespace aisdk {
 namespace mediaPlayer {
 namespace ffmpeg {
@@ -42,7 +53,7 @@ size_t PlaybackConfiguration::layoutToChannels(ChannelLayout layout) {
             return 6;
     }
 
-	std::cout << "invalidLayout:" << "layout:" << static_cast<int>(layout) << std::endl;
+	AISDK_ERROR(LX("invalidLayout").d("layout", static_cast<int>(layout)));
     return 0;
 }
 
@@ -0,0 +1,1005 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avio.h>
+#include <libavutil/dict.h>
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+#include <libavutil/opt.h>
+}
+
+#include <Utils/Logging/Logger.h>
+#include <Utils/Logging/ThreadMoniker.h>
+#include <Utils/Metrics/MetricsRegistry.h>
+#include "AudioMediaPlayer/MediaUrl.h"
+#include "AudioMediaPlayer/UrlCache.h"
+
+/// String to identify log entries originating from this file.
+static const std::string TAG("UrlCache");
+
+/**
+ * Create a LogEntry using this file's TAG and the specified event string.
+ *
+ * @param The event string for this @c LogEntry.
+ */
+#define LX(event) aisdk::utils::logging::LogEntry(TAG, event)
+
+namespace aisdk {
+namespace mediaPlayer {
+namespace ffmpeg {
+
+constexpr uint64_t UrlCache::DEFAULT_MAX_PREFETCH_BYTES;
+constexpr std::chrono::seconds UrlCache::DEFAULT_MAX_AGE;
+
+/// The bytes a fetcher reads from the network at once.
+static const size_t FETCH_CHUNK_SIZE{65536};
+
+/// A read further than this past the fetched content is served by a range request rather than waiting for the fetcher.
+static const int64_t MAX_WAIT_DISTANCE{4 * FETCH_CHUNK_SIZE};
+
+/// How long a blocked open or read sleeps before checking whether it was interrupted.
+static const std::chrono::milliseconds WAIT_INTERVAL{10};
+
+/// The extension of the file holding the fetched content of a url.
+static const std::string DATA_EXTENSION{"data"};
+
+/// The extension of the file describing the content of a url.
+static const std::string META_EXTENSION{"meta"};
+
+/// The cached content of one url.
+struct UrlCache::Entry {
+    /// The states of the content.
+    enum class State {
+        /// The fetcher is opening the url to learn or check its size and content type; readers wait.
+        VALIDATING,
+        /// The size is known and the fetched content can be read.
+        READY,
+        /// The url could not be opened and nothing of it is cached.
+        FAILED,
+        /// The content of the url cannot be cached.
+        UNCACHEABLE
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param url The url.
+     * @param key The key of the entry, which names its files.
+     * @param dataPath The file holding the fetched content.
+     * @param metaPath The file describing the content.
+     */
+    Entry(const std::string& url, const std::string& key, const std::string& dataPath, const std::string& metaPath) :
+            url{url},
+            key{key},
+            dataPath{dataPath},
+            metaPath{metaPath},
+            state{State::VALIDATING},
+            totalBytes{0},
+            fetchedBytes{0},
+            validatedTime{0},
+            isFetchFailed{false},
+            isFetching{false},
+            isStopping{false},
+            lastUse{0} {
+    }
+
+    /// Check whether the whole content is on disk.  @c mutex must be held.
+    bool isComplete() const {
+        return totalBytes > 0 && fetchedBytes >= totalBytes;
+    }
+
+    /// Get the furthest position read from the disk or waited for by the readers.  @c mutex must be held.
+    int64_t furthestReadPosition() const {
+        int64_t position = 0;
+        for (const auto& item : readPositions) {
+            position = std::max(position, item.second);
+        }
+        return position;
+    }
+
+    /// The url.
+    const std::string url;
+
+    /// The key of the entry, which names its files.
+    const std::string key;
+
+    /// The file holding the fetched content.
+    const std::string dataPath;
+
+    /// The file describing the content.
+    const std::string metaPath;
+
+    /// Serializes the members below, but @c lastUse.
+    std::mutex mutex;
+
+    /// Notified when the state, the fetched content, the readers or @c isStopping change.
+    std::condition_variable condition;
+
+    /// The state of the content.
+    State state;
+
+    /// The size of the content, the first validator.
+    int64_t totalBytes;
+
+    /// The content type of the content, the second validator.
+    std::string mimeType;
+
+    /// The bytes at the start of the content which are on disk.
+    int64_t fetchedBytes;
+
+    /// When the validators were last checked with the server, in seconds since the epoch.
+    std::time_t validatedTime;
+
+    /// Whether the last fetch failed before the end of the content.
+    bool isFetchFailed;
+
+    /// Whether the fetcher is running.
+    bool isFetching;
+
+    /// Tells the fetcher to stop, read by the FFmpeg interrupt callback.
+    std::atomic<bool> isStopping;
+
+    /// The fetcher thread.
+    std::thread fetcher;
+
+    /// The position each reader last read from the disk or waited for the fetcher at, which bounds the prefetch.
+    /// Seeks and range reads do not move it.
+    std::unordered_map<const Reader*, int64_t> readPositions;
+
+    /// Orders the entries from the least recently opened, protected by @c UrlCache::m_mutex.
+    uint64_t lastUse;
+};
+
+/**
+ * Get the key of a url, which names the files of its entry.
+ *
+ * @param url The url.
+ * @return The key.
+ */
+static std::string keyOf(const std::string& url) {
+    std::ostringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << static_cast<uint64_t>(std::hash<std::string>()(url));
+    return key.str();
+}
+
+/**
+ * Write the meta file of an entry.  @c Entry::mutex must be held.
+ *
+ * The file is written next to the meta file and renamed over it, so that a crash leaves the old or the new one.
+ *
+ * @param url The url of the entry.
+ * @param path The meta file.
+ * @param totalBytes The size of the content.
+ * @param fetchedBytes The bytes on disk.
+ * @param validatedTime When the validators were last checked.
+ * @param mimeType The content type.
+ */
+static void writeMeta(
+    const std::string& url,
+    const std::string& path,
+    int64_t totalBytes,
+    int64_t fetchedBytes,
+    std::time_t validatedTime,
+    const std::string& mimeType) {
+    auto temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ofstream::trunc);
+        file << url << '\n'
+             << totalBytes << '\n'
+             << fetchedBytes << '\n'
+             << static_cast<int64_t>(validatedTime) << '\n'
+             << mimeType << '\n';
+        if (!file.good()) {
+            AISDK_ERROR(LX("writeMetaFailed").d("path", temporaryPath));
+            std::remove(temporaryPath.c_str());
+            return;
+        }
+    }
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        AISDK_ERROR(LX("writeMetaFailed").d("reason", "renameFailed").d("path", path).d("errno", errno));
+        std::remove(temporaryPath.c_str());
+    }
+}
+
+/**
+ * Write exactly the given bytes to a file.
+ *
+ * @param fd The file.
+ * @param buffer The bytes.
+ * @param size The number of bytes.
+ * @param offset The offset in the file.
+ * @return Whether all the bytes were written.
+ */
+static bool writeAll(int fd, const uint8_t* buffer, size_t size, int64_t offset) {
+    while (size > 0) {
+        auto written = pwrite(fd, buffer, size, offset);
+        if (written < 0 && EINTR == errno) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        buffer += written;
+        size -= written;
+        offset += written;
+    }
+    return true;
+}
+
+std::shared_ptr<UrlCache> UrlCache::create(
+    const std::string& directory,
+    uint64_t maxBytes,
+    uint64_t maxPrefetchBytes,
+    std::chrono::seconds maxAge) {
+    if (directory.empty()) {
+        AISDK_ERROR(LX("createFailed").d("reason", "emptyDirectory"));
+        return nullptr;
+    }
+    if (0 == maxBytes || 0 == maxPrefetchBytes) {
+        AISDK_ERROR(LX("createFailed").d("reason", "zeroSize").d("maxBytes", maxBytes).d("maxPrefetchBytes", maxPrefetchBytes));
+        return nullptr;
+    }
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        AISDK_ERROR(LX("createFailed").d("reason", "mkdirFailed").d("directory", directory).d("errno", errno));
+        return nullptr;
+    }
+
+    auto cache = std::shared_ptr<UrlCache>(new UrlCache(directory, maxBytes, maxPrefetchBytes, maxAge));
+    if (!cache->load()) {
+        AISDK_ERROR(LX("createFailed").d("reason", "loadFailed").d("directory", directory));
+        return nullptr;
+    }
+    AISDK_INFO(LX("created").d("directory", directory).d("maxBytes", maxBytes).d("cachedBytes", cache->getSizeBytes()));
+    return cache;
+}
+
+bool UrlCache::isCacheable(const std::string& url) {
+    auto scheme = url.substr(0, url.find("://"));
+    std::transform(scheme.begin(), scheme.end(), scheme.begin(), ::tolower);
+    if (scheme.size() == url.size() || (scheme != "http" && scheme != "https")) {
+        return false;
+    }
+
+    // The entries of playlists, and the segments of HLS playlists, are played and cached on their own.
+    return !isPlaylistUrl(url) && !isHlsUrl(url);
+}
+
+UrlCache::UrlCache(
+    const std::string& directory,
+    uint64_t maxBytes,
+    uint64_t maxPrefetchBytes,
+    std::chrono::seconds maxAge) :
+        m_directory{directory},
+        m_maxBytes{maxBytes},
+        m_maxPrefetchBytes{maxPrefetchBytes},
+        m_maxAge{maxAge},
+        m_sizeBytes{0},
+        m_useCount{0},
+        m_isShutdown{false},
+        m_hitCounter{utils::metrics::MetricsRegistry::instance().getCounter(
+            "aisdk_url_cache_lookups_total", {{"result", "hit"}}, "Urls opened through the url cache, by what was cached.")},
+        m_partialCounter{utils::metrics::MetricsRegistry::instance().getCounter(
+            "aisdk_url_cache_lookups_total", {{"result", "partial"}})},
+        m_missCounter{utils::metrics::MetricsRegistry::instance().getCounter(
+            "aisdk_url_cache_lookups_total", {{"result", "miss"}})},
+        m_uncacheableCounter{utils::metrics::MetricsRegistry::instance().getCounter(
+            "aisdk_url_cache_lookups_total", {{"result", "uncacheable"}})},
+        m_readyReadCounter{utils::metrics::MetricsRegistry::instance().getCounter(
+            "aisdk_url_cache_reads_total",
+            {{"result", "ready"}},
+            "Reads of cached urls, by whether the content was on disk or the read waited for the network.")},
+        m_waitedReadCounter{utils::metrics::MetricsRegistry::instance().getCounter(
+            "aisdk_url_cache_reads_total", {{"result", "waited"}})},
+        m_rangeReadCounter{utils::metrics::MetricsRegistry::instance().getCounter(
+            "aisdk_url_cache_reads_total", {{"result", "range"}})},
+        m_prefetchDepthHistogram{utils::metrics::MetricsRegistry::instance().getHistogram(
+            "aisdk_url_cache_prefetch_depth_kilobytes",
+            {},
+            "Content of a url on disk ahead of the reader after each read.")},
+        m_sizeGauge{utils::metrics::MetricsRegistry::instance().getGauge(
+            "aisdk_url_cache_size_bytes", {}, "Content of urls stored on disk by the url cache.")} {
+}
+
+UrlCache::~UrlCache() {
+    shutdown();
+}
+
+std::string UrlCache::pathOf(const std::string& key, const std::string& extension) const {
+    return m_directory + "/" + key + "." + extension;
+}
+
+bool UrlCache::load() {
+    auto directory = opendir(m_directory.c_str());
+    if (!directory) {
+        AISDK_ERROR(LX("loadFailed").d("reason", "opendirFailed").d("errno", errno));
+        return false;
+    }
+
+    std::vector<std::pair<std::time_t, std::shared_ptr<Entry>>> entries;
+    while (auto item = readdir(directory)) {
+        std::string name = item->d_name;
+        auto dot = name.find('.');
+        if (std::string::npos == dot || name.substr(dot + 1) != META_EXTENSION) {
+            if (std::string::npos != dot && name.substr(dot + 1) == META_EXTENSION + ".tmp") {
+                std::remove((m_directory + "/" + name).c_str());
+            }
+            continue;
+        }
+
+        auto key = name.substr(0, dot);
+        auto metaPath = pathOf(key, META_EXTENSION);
+        auto dataPath = pathOf(key, DATA_EXTENSION);
+        std::ifstream file(metaPath);
+        std::string url, mimeType;
+        int64_t totalBytes = 0, fetchedBytes = 0, validatedTime = 0;
+        std::getline(file, url);
+        file >> totalBytes >> fetchedBytes >> validatedTime;
+        file.ignore();
+        std::getline(file, mimeType);
+        struct stat dataStat;
+        struct stat metaStat;
+        if (!file || url.empty() || totalBytes <= 0 || keyOf(url) != key || stat(dataPath.c_str(), &dataStat) != 0 ||
+            stat(metaPath.c_str(), &metaStat) != 0) {
+            AISDK_WARN(LX("loadEntryFailed").d("reason", "invalidEntry").d("key", key));
+            std::remove(metaPath.c_str());
+            std::remove(dataPath.c_str());
+            continue;
+        }
+
+        // The data past the fetched bytes of the meta file may be incomplete, from a fetch which did not end.
+        fetchedBytes = std::min({fetchedBytes, totalBytes, static_cast<int64_t>(dataStat.st_size)});
+        if (fetchedBytes <= 0 || truncate(dataPath.c_str(), fetchedBytes) != 0) {
+            std::remove(metaPath.c_str());
+            std::remove(dataPath.c_str());
+            continue;
+        }
+
+        auto entry = std::make_shared<Entry>(url, key, dataPath, metaPath);
+        entry->state = Entry::State::READY;
+        entry->totalBytes = totalBytes;
+        entry->mimeType = mimeType;
+        entry->fetchedBytes = fetchedBytes;
+        entry->validatedTime = static_cast<std::time_t>(validatedTime);
+        entries.push_back(std::make_pair(metaStat.st_mtime, entry));
+    }
+    closedir(directory);
+
+    // The meta files are touched when their url is opened, so their times give the order of use of the last run.
+    std::sort(
+        entries.begin(),
+        entries.end(),
+        [](const std::pair<std::time_t, std::shared_ptr<Entry>>& a,
+           const std::pair<std::time_t, std::shared_ptr<Entry>>& b) { return a.first < b.first; });
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& item : entries) {
+        item.second->lastUse = ++m_useCount;
+        m_sizeBytes += item.second->fetchedBytes;
+        m_entries[item.second->key] = item.second;
+    }
+    evictLocked();
+    return true;
+}
+
+std::shared_ptr<UrlCache::Reader> UrlCache::open(const std::string& url, std::function<bool()> shouldInterrupt) {
+    if (!isCacheable(url)) {
+        return nullptr;
+    }
+
+    std::shared_ptr<Reader> reader;
+    std::shared_ptr<Entry> entry;
+    std::shared_ptr<utils::metrics::Counter> lookupCounter;
+    auto key = keyOf(url);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_isShutdown) {
+            AISDK_WARN(LX("openFailed").d("reason", "isShutdown"));
+            return nullptr;
+        }
+        if (m_uncacheableUrls.count(url) != 0) {
+            if (m_uncacheableCounter) {
+                m_uncacheableCounter->increment();
+            }
+            return nullptr;
+        }
+
+        auto it = m_entries.find(key);
+        if (it != m_entries.end() && it->second->url != url) {
+            // Another url with the same key is replaced, unless it is in use.
+            auto other = it->second;
+            std::lock_guard<std::mutex> otherLock(other->mutex);
+            if (!other->readPositions.empty() || other->isFetching) {
+                AISDK_WARN(LX("openFailed").d("reason", "keyInUse").d("key", key));
+                return nullptr;
+            }
+            if (other->fetcher.joinable()) {
+                other->fetcher.join();
+            }
+            m_sizeBytes -= std::min(m_sizeBytes, static_cast<uint64_t>(other->fetchedBytes));
+            std::remove(other->dataPath.c_str());
+            std::remove(other->metaPath.c_str());
+            m_entries.erase(it);
+            it = m_entries.end();
+        }
+        if (it == m_entries.end()) {
+            entry = std::make_shared<Entry>(url, key, pathOf(key, DATA_EXTENSION), pathOf(key, META_EXTENSION));
+            m_entries[key] = entry;
+        } else {
+            entry = it->second;
+            utime(entry->metaPath.c_str(), nullptr);
+        }
+        entry->lastUse = ++m_useCount;
+
+        std::lock_guard<std::mutex> entryLock(entry->mutex);
+        reader = std::shared_ptr<Reader>(new Reader(shared_from_this(), entry, shouldInterrupt));
+        entry->readPositions[reader.get()] = 0;
+        auto isFresh = std::time(nullptr) - entry->validatedTime < m_maxAge.count();
+        if (entry->isComplete() && isFresh) {
+            lookupCounter = m_hitCounter;
+        } else {
+            lookupCounter = entry->fetchedBytes > 0 ? m_partialCounter : m_missCounter;
+            startFetcherLocked(entry);
+        }
+    }
+
+    bool isOpened = false;
+    {
+        std::unique_lock<std::mutex> lock(entry->mutex);
+        while (Entry::State::VALIDATING == entry->state && !reader->isInterrupted()) {
+            entry->condition.wait_for(lock, WAIT_INTERVAL);
+        }
+        isOpened = Entry::State::READY == entry->state;
+        if (Entry::State::UNCACHEABLE == entry->state) {
+            lookupCounter = m_uncacheableCounter;
+        }
+    }
+    if (lookupCounter) {
+        lookupCounter->increment();
+    }
+    if (!isOpened) {
+        AISDK_DEBUG5(LX("openFailed").d("reason", "notCached").d("url", url));
+        return nullptr;
+    }
+    AISDK_DEBUG5(LX("opened").d("url", url).d("key", key));
+    return reader;
+}
+
+bool UrlCache::getValidators(const std::string& url, int64_t* totalBytes, std::string* mimeType) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(keyOf(url));
+    if (it == m_entries.end() || it->second->url != url) {
+        return false;
+    }
+    auto entry = it->second;
+    std::lock_guard<std::mutex> entryLock(entry->mutex);
+    if (Entry::State::READY != entry->state || std::time(nullptr) - entry->validatedTime >= m_maxAge.count()) {
+        return false;
+    }
+    *totalBytes = entry->totalBytes;
+    *mimeType = entry->mimeType;
+    return true;
+}
+
+uint64_t UrlCache::getSizeBytes() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_sizeBytes;
+}
+
+void UrlCache::shutdown() {
+    std::vector<std::thread> fetchers;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isShutdown = true;
+        for (auto& item : m_entries) {
+            std::lock_guard<std::mutex> entryLock(item.second->mutex);
+            item.second->isStopping = true;
+            item.second->condition.notify_all();
+            if (item.second->fetcher.joinable()) {
+                fetchers.push_back(std::move(item.second->fetcher));
+            }
+        }
+    }
+    for (auto& fetcher : fetchers) {
+        fetcher.join();
+    }
+}
+
+void UrlCache::startFetcherLocked(std::shared_ptr<Entry> entry) {
+    entry->isStopping = false;
+    if (entry->isFetching || m_isShutdown) {
+        return;
+    }
+    // A fetcher which is not fetching anymore is about to return.
+    if (entry->fetcher.joinable()) {
+        entry->fetcher.join();
+    }
+    entry->state = Entry::State::VALIDATING;
+    entry->isFetchFailed = false;
+    entry->isFetching = true;
+    entry->fetcher = std::thread(&UrlCache::fetchLoop, this, entry);
+}
+
+void UrlCache::fetchLoop(std::shared_ptr<Entry> entry) {
+    utils::logging::ThreadMoniker::setThisThreadName("UrlCacheFetcher");
+
+    // The network calls of the fetcher give up when it is told to stop.
+    AVIOInterruptCB interruptCallback;
+    interruptCallback.callback = [](void* opaque) { return static_cast<Entry*>(opaque)->isStopping ? 1 : 0; };
+    interruptCallback.opaque = entry.get();
+    AVDictionary* options = nullptr;
+    av_dict_set(&options, USER_AGENT_OPTION, USER_AGENT, 0);
+    AVIOContext* ioContext = nullptr;
+    auto error = avio_open2(&ioContext, entry->url.c_str(), AVIO_FLAG_READ, &interruptCallback, &options);
+    av_dict_free(&options);
+
+    int64_t totalBytes = 0;
+    std::string mimeType;
+    if (0 == error) {
+        totalBytes = avio_size(ioContext);
+        uint8_t* value = nullptr;
+        if (av_opt_get(ioContext, "mime_type", AV_OPT_SEARCH_CHILDREN, &value) >= 0 && value) {
+            mimeType = reinterpret_cast<char*>(value);
+        }
+        av_free(value);
+        if (totalBytes <= 0) {
+            AISDK_INFO(LX("notCached").d("reason", "unknownSize").d("url", entry->url));
+            avio_closep(&ioContext);
+            dropUncacheable(entry);
+            return;
+        }
+    } else if (!entry->isStopping) {
+        AISDK_WARN(LX("fetchFailed").d("reason", "openFailed").d("error", error).d("url", entry->url));
+    }
+
+    // Validate what is on disk, and find where the fetch resumes.
+    int64_t resumeOffset = 0;
+    int64_t droppedBytes = 0;
+    {
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        resumeOffset = entry->fetchedBytes;
+        if (0 == error && resumeOffset > 0 && (totalBytes != entry->totalBytes || mimeType != entry->mimeType)) {
+            AISDK_INFO(LX("contentChanged")
+                           .d("url", entry->url)
+                           .d("size", totalBytes)
+                           .d("cachedSize", entry->totalBytes)
+                           .d("mimeType", mimeType)
+                           .d("cachedMimeType", entry->mimeType));
+            resumeOffset = 0;
+        }
+    }
+    if (0 == error && resumeOffset > 0 && resumeOffset < totalBytes &&
+        avio_seek(ioContext, resumeOffset, SEEK_SET) != resumeOffset) {
+        AISDK_WARN(LX("resumeFailed").d("offset", resumeOffset).d("url", entry->url));
+        resumeOffset = 0;
+        if (avio_seek(ioContext, 0, SEEK_SET) != 0) {
+            error = AVERROR(EIO);
+        }
+    }
+
+    int fd = -1;
+    if (0 == error) {
+        fd = ::open(entry->dataPath.c_str(), O_WRONLY | O_CREAT, 0644);
+        if (fd < 0 || ftruncate(fd, resumeOffset) != 0) {
+            AISDK_ERROR(LX("fetchFailed").d("reason", "openDataFailed").d("path", entry->dataPath).d("errno", errno));
+            error = AVERROR(EIO);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        if (0 == error) {
+            droppedBytes = entry->fetchedBytes - resumeOffset;
+            entry->fetchedBytes = resumeOffset;
+            entry->totalBytes = totalBytes;
+            entry->mimeType = mimeType;
+            entry->validatedTime = std::time(nullptr);
+            entry->state = Entry::State::READY;
+            writeMeta(entry->url, entry->metaPath, totalBytes, resumeOffset, entry->validatedTime, mimeType);
+        } else {
+            // Content which could not be validated is still played, for example when the network is down.
+            entry->state = entry->fetchedBytes > 0 ? Entry::State::READY : Entry::State::FAILED;
+        }
+        entry->condition.notify_all();
+    }
+    if (droppedBytes > 0) {
+        addSizeBytes(-droppedBytes);
+    }
+
+    auto isFailed = error != 0;
+    std::vector<uint8_t> buffer(FETCH_CHUNK_SIZE);
+    while (!isFailed) {
+        int64_t offset = 0;
+        {
+            std::unique_lock<std::mutex> lock(entry->mutex);
+            if (entry->isComplete()) {
+                break;
+            }
+            entry->condition.wait(lock, [this, &entry]() {
+                return entry->isStopping ||
+                    entry->fetchedBytes < entry->furthestReadPosition() + static_cast<int64_t>(m_maxPrefetchBytes);
+            });
+            if (entry->isStopping) {
+                break;
+            }
+            offset = entry->fetchedBytes;
+        }
+
+        auto bytes = avio_read(ioContext, buffer.data(), static_cast<int>(buffer.size()));
+        if (bytes <= 0) {
+            if (!entry->isStopping) {
+                AISDK_WARN(LX("fetchFailed").d("reason", "readFailed").d("error", bytes).d("offset", offset));
+                isFailed = true;
+            }
+            break;
+        }
+        // A server sending more than it announced only gets the announced size cached.
+        bytes = static_cast<int>(std::min<int64_t>(bytes, totalBytes - offset));
+        if (!writeAll(fd, buffer.data(), bytes, offset)) {
+            AISDK_ERROR(LX("fetchFailed").d("reason", "writeFailed").d("path", entry->dataPath).d("errno", errno));
+            isFailed = true;
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(entry->mutex);
+            entry->fetchedBytes += bytes;
+            entry->condition.notify_all();
+        }
+        addSizeBytes(bytes);
+    }
+
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (ioContext) {
+        avio_closep(&ioContext);
+    }
+
+    std::unique_lock<std::mutex> lock(entry->mutex);
+    if (0 == error) {
+        writeMeta(
+            entry->url, entry->metaPath, entry->totalBytes, entry->fetchedBytes, entry->validatedTime, entry->mimeType);
+    }
+    AISDK_DEBUG5(LX("fetchEnded")
+                     .d("url", entry->url)
+                     .d("fetchedBytes", entry->fetchedBytes)
+                     .d("totalBytes", entry->totalBytes)
+                     .d("isFailed", isFailed));
+    entry->isFetchFailed = isFailed;
+    if (Entry::State::FAILED == entry->state) {
+        // The urls which fail would otherwise pile up in m_entries, since an entry without content is never evicted.
+        lock.unlock();
+        dropFailed(entry);
+        return;
+    }
+    // This is the last use of the entry by the fetcher, which may be joined from now on.
+    entry->isFetching = false;
+    entry->condition.notify_all();
+}
+
+void UrlCache::dropUncacheable(std::shared_ptr<Entry> entry) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_uncacheableUrls.insert(entry->url);
+    auto it = m_entries.find(entry->key);
+    if (it != m_entries.end() && it->second == entry) {
+        m_entries.erase(it);
+    }
+
+    std::lock_guard<std::mutex> entryLock(entry->mutex);
+    m_sizeBytes -= std::min(m_sizeBytes, static_cast<uint64_t>(entry->fetchedBytes));
+    entry->fetchedBytes = 0;
+    std::remove(entry->dataPath.c_str());
+    std::remove(entry->metaPath.c_str());
+    if (m_sizeGauge) {
+        m_sizeGauge->set(static_cast<int64_t>(m_sizeBytes));
+    }
+    entry->state = Entry::State::UNCACHEABLE;
+    // The entry is not in the cache anymore, so nothing joins the fetcher, which returns right after this.
+    entry->fetcher.detach();
+    entry->isFetching = false;
+    entry->condition.notify_all();
+}
+
+void UrlCache::dropFailed(std::shared_ptr<Entry> entry) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(entry->key);
+    auto isCached = it != m_entries.end() && it->second == entry;
+    if (isCached) {
+        m_entries.erase(it);
+    }
+
+    std::lock_guard<std::mutex> entryLock(entry->mutex);
+    if (isCached) {
+        // Another entry with the same key would have the same files.
+        std::remove(entry->dataPath.c_str());
+        std::remove(entry->metaPath.c_str());
+    }
+    // The entry is not in the cache anymore, so nothing joins the fetcher, which returns right after this.  The
+    // fetcher is not joinable anymore if shutdown() took it to join it.
+    if (entry->fetcher.joinable()) {
+        entry->fetcher.detach();
+    }
+    entry->isFetching = false;
+    entry->condition.notify_all();
+}
+
+void UrlCache::addSizeBytes(int64_t delta) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (delta < 0) {
+        m_sizeBytes -= std::min(m_sizeBytes, static_cast<uint64_t>(-delta));
+    } else {
+        m_sizeBytes += delta;
+    }
+    evictLocked();
+}
+
+void UrlCache::evictLocked() {
+    while (m_sizeBytes > m_maxBytes) {
+        std::shared_ptr<Entry> victim;
+        for (auto& item : m_entries) {
+            std::lock_guard<std::mutex> entryLock(item.second->mutex);
+            if (!item.second->readPositions.empty() || item.second->isFetching || 0 == item.second->fetchedBytes) {
+                continue;
+            }
+            if (!victim || item.second->lastUse < victim->lastUse) {
+                victim = item.second;
+            }
+        }
+        if (!victim) {
+            // Everything left is in use; the cache goes back within its budget once it is not.
+            break;
+        }
+
+        std::lock_guard<std::mutex> entryLock(victim->mutex);
+        AISDK_DEBUG5(LX("evicted").d("url", victim->url).d("bytes", victim->fetchedBytes));
+        if (victim->fetcher.joinable()) {
+            victim->fetcher.join();
+        }
+        m_sizeBytes -= std::min(m_sizeBytes, static_cast<uint64_t>(victim->fetchedBytes));
+        victim->fetchedBytes = 0;
+        std::remove(victim->dataPath.c_str());
+        std::remove(victim->metaPath.c_str());
+        m_entries.erase(victim->key);
+    }
+    if (m_sizeGauge) {
+        m_sizeGauge->set(static_cast<int64_t>(m_sizeBytes));
+    }
+}
+
+UrlCache::Reader::Reader(
+    std::shared_ptr<UrlCache> cache,
+    std::shared_ptr<Entry> entry,
+    std::function<bool()> shouldInterrupt) :
+        m_cache{cache},
+        m_entry{entry},
+        m_shouldInterrupt{shouldInterrupt},
+        m_fd{-1},
+        m_position{0},
+        m_rangeContext{nullptr},
+        m_rangePosition{0} {
+}
+
+UrlCache::Reader::~Reader() {
+    closeRange();
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+    std::lock_guard<std::mutex> lock(m_entry->mutex);
+    m_entry->readPositions.erase(this);
+    if (m_entry->readPositions.empty()) {
+        m_entry->isStopping = true;
+        m_entry->condition.notify_all();
+    }
+}
+
+bool UrlCache::Reader::isInterrupted() const {
+    return m_shouldInterrupt && m_shouldInterrupt();
+}
+
+int UrlCache::Reader::read(uint8_t* buffer, int size) {
+    if (!buffer || size <= 0) {
+        return AVERROR(EINVAL);
+    }
+
+    auto hasWaited = false;
+    auto isRangeRead = false;
+    int64_t bytesToRead = 0;
+    {
+        std::unique_lock<std::mutex> lock(m_entry->mutex);
+        while (true) {
+            if (Entry::State::READY == m_entry->state) {
+                if (m_position >= m_entry->totalBytes) {
+                    return AVERROR_EOF;
+                }
+                if (m_position < m_entry->fetchedBytes) {
+                    break;
+                }
+                if (m_position - m_entry->fetchedBytes > MAX_WAIT_DISTANCE) {
+                    // The fetcher only fetches in order, and would take long to get there.
+                    isRangeRead = true;
+                    break;
+                }
+                if (m_entry->isFetchFailed) {
+                    AISDK_ERROR(LX("readFailed").d("reason", "fetchFailed").d("position", m_position));
+                    return AVERROR(EIO);
+                }
+                if (!m_entry->isFetching) {
+                    if (m_cache->m_isShutdown) {
+                        return AVERROR(EIO);
+                    }
+                    m_cache->startFetcherLocked(m_entry);
+                }
+                // Let the fetcher fetch up to the position, which may be past its prefetch bound.
+                if (m_entry->readPositions[this] != m_position) {
+                    m_entry->readPositions[this] = m_position;
+                    m_entry->condition.notify_all();
+                }
+            } else if (Entry::State::VALIDATING != m_entry->state) {
+                return AVERROR(EIO);
+            }
+            if (isInterrupted()) {
+                return AVERROR_EXIT;
+            }
+            hasWaited = true;
+            m_entry->condition.wait_for(lock, WAIT_INTERVAL);
+        }
+        bytesToRead = std::min<int64_t>(size, m_entry->fetchedBytes - m_position);
+    }
+
+    if (isRangeRead) {
+        auto bytes = readRange(buffer, size);
+        if (bytes > 0 && m_cache->m_rangeReadCounter) {
+            m_cache->m_rangeReadCounter->increment();
+        }
+        return bytes;
+    }
+    // Back to the fetched content, where the url opened for a range read is not needed anymore.
+    closeRange();
+
+    if (m_fd < 0) {
+        m_fd = ::open(m_entry->dataPath.c_str(), O_RDONLY);
+        if (m_fd < 0) {
+            AISDK_ERROR(LX("readFailed").d("reason", "openDataFailed").d("path", m_entry->dataPath).d("errno", errno));
+            return AVERROR(EIO);
+        }
+    }
+    auto bytes = pread(m_fd, buffer, bytesToRead, m_position);
+    if (bytes <= 0) {
+        AISDK_ERROR(LX("readFailed").d("reason", "preadFailed").d("position", m_position).d("errno", errno));
+        return AVERROR(EIO);
+    }
+
+    int64_t prefetchDepth = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_entry->mutex);
+        m_position += bytes;
+        m_entry->readPositions[this] = m_position;
+        prefetchDepth = std::max<int64_t>(m_entry->fetchedBytes - m_position, 0);
+        // The fetcher may be waiting for the reader to move.
+        m_entry->condition.notify_all();
+    }
+
+    auto counter = hasWaited ? m_cache->m_waitedReadCounter : m_cache->m_readyReadCounter;
+    if (counter) {
+        counter->increment();
+    }
+    if (m_cache->m_prefetchDepthHistogram) {
+        m_cache->m_prefetchDepthHistogram->record(static_cast<uint64_t>(prefetchDepth / 1024));
+    }
+    return static_cast<int>(bytes);
+}
+
+int64_t UrlCache::Reader::seek(int64_t offset, int whence) {
+    std::lock_guard<std::mutex> lock(m_entry->mutex);
+    if (whence & AVSEEK_SIZE) {
+        return m_entry->totalBytes;
+    }
+
+    int64_t position = 0;
+    switch (whence & ~AVSEEK_FORCE) {
+        case SEEK_SET:
+            position = offset;
+            break;
+        case SEEK_CUR:
+            position = m_position + offset;
+            break;
+        case SEEK_END:
+            position = m_entry->totalBytes + offset;
+            break;
+        default:
+            return AVERROR(EINVAL);
+    }
+    if (position < 0 || position > m_entry->totalBytes) {
+        return AVERROR(EINVAL);
+    }
+
+    // Only the reads move the prefetch bound: the demuxer seeking to the end of the content to look for tags must
+    // not make the fetcher fetch the whole content first.
+    m_position = position;
+    return m_position;
+}
+
+int UrlCache::Reader::readRange(uint8_t* buffer, int size) {
+    if (m_rangeContext && m_rangePosition != m_position) {
+        auto position = avio_seek(m_rangeContext, m_position, SEEK_SET);
+        if (position != m_position) {
+            AISDK_WARN(LX("rangeSeekFailed").d("position", m_position).d("error", position));
+            closeRange();
+        }
+    }
+    if (!m_rangeContext) {
+        AVIOInterruptCB interruptCallback;
+        interruptCallback.callback = [](void* opaque) {
+            auto reader = static_cast<Reader*>(opaque);
+            return reader->isInterrupted() || reader->m_cache->m_isShutdown ? 1 : 0;
+        };
+        interruptCallback.opaque = this;
+        AVDictionary* options = nullptr;
+        av_dict_set(&options, USER_AGENT_OPTION, USER_AGENT, 0);
+        auto error = avio_open2(&m_rangeContext, m_entry->url.c_str(), AVIO_FLAG_READ, &interruptCallback, &options);
+        av_dict_free(&options);
+        if (error != 0) {
+            AISDK_ERROR(LX("readFailed").d("reason", "rangeOpenFailed").d("error", error).d("url", m_entry->url));
+            m_rangeContext = nullptr;
+            return isInterrupted() ? AVERROR_EXIT : error;
+        }
+        // The http protocol asks for the content from the position with a range request.
+        auto position = avio_seek(m_rangeContext, m_position, SEEK_SET);
+        if (position != m_position) {
+            AISDK_ERROR(LX("readFailed").d("reason", "rangeSeekFailed").d("position", m_position).d("error", position));
+            closeRange();
+            return isInterrupted() ? AVERROR_EXIT : AVERROR(EIO);
+        }
+        AISDK_DEBUG5(LX("rangeOpened").d("url", m_entry->url).d("position", m_position));
+    }
+    m_rangePosition = m_position;
+
+    auto bytes = avio_read(m_rangeContext, buffer, size);
+    if (bytes <= 0) {
+        AISDK_ERROR(LX("readFailed").d("reason", "rangeReadFailed").d("position", m_position).d("error", bytes));
+        closeRange();
+        return isInterrupted() ? AVERROR_EXIT : (bytes < 0 ? bytes : AVERROR(EIO));
+    }
+    m_position += bytes;
+    m_rangePosition = m_position;
+    return bytes;
+}
+
+void UrlCache::Reader::closeRange() {
+    if (m_rangeContext) {
+        avio_closep(&m_rangeContext);
+    }
+}
+
+}  // namespace ffmpeg
+}  // namespace mediaPlayer
+}  // namespace aisdk
@@ -12,21 +12,113 @@
  * permissions and limitations under the License.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <dirent.h>
 #include <unistd.h>
+#include <cerrno>
 #include <cstdio>
+#include <cstdlib>
 
 #include "Utils/Attachment/AttachmentReader.h"
+#include "Utils/Metrics/MetricsRegistry.h"
 #include "Utils/MediaPlayer/MediaPlayerObserverInterface.h"
 #include "AudioMediaPlayer/AOWrapper.h"
+#include "AudioMediaPlayer/Endian.h"
+#include "AudioMediaPlayer/FFmpegDecoder.h"
+#include "AudioMediaPlayer/FFmpegStreamInputController.h"
+#include "AudioMediaPlayer/FileAudioOutput.h"
+#include "AudioMediaPlayer/NullAudioOutput.h"
 
 using namespace aisdk::mediaPlayer::ffmpeg;
 
 int flags = 0;
+
+/// The output set with @c -o, or empty to play on the libao device.
+static std::string outputName;
+
+/// The number of heap allocations, counted for the @c -a check.
+static std::atomic<uint64_t> allocationCount{0};
+
+#ifdef __GLIBC__
+/*
+ * Interpose the C allocator, so that the count includes what FFmpeg allocates through av_malloc (frames, packets,
+ * frame buffers, resampler buffers) as well as operator new, which allocates through malloc.  The allocations are
+ * passed on to the glibc entry points the public ones are built on.
+ */
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* memory, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) noexcept {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* memory, size_t size) noexcept {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	return __libc_realloc(memory, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** memory, size_t alignment, size_t size) noexcept {
+	if(!alignment || (alignment & (alignment - 1)) || alignment % sizeof(void*)) {
+		return EINVAL;
+	}
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	*memory = __libc_memalign(alignment, size);
+	return *memory ? 0 : ENOMEM;
+}
+}
+#else
+/*
+ * Without glibc the C allocator cannot be interposed portably, so only operator new is counted and the allocations
+ * FFmpeg makes through av_malloc are missed.
+ */
+void* operator new(std::size_t size) {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	if(void* memory = std::malloc(size ? size : 1)) {
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+#endif
+
+/// The chunks decoded before counting, so that the input is probed and the decoder buffers have reached their size.
+static const int WARMUP_CHUNKS = 16;
+
+/// The size of a chunk read from the decoder, the same as the one @c AOWrapper uses.
+static const size_t CHUNK_SIZE = 16384;
+
+/// The number of times the file is played in each mode of the @c -g measurement.
+static const int GAP_TRACKS = 4;
 	
 namespace util {
 int kbhit();
@@ -47,6 +139,30 @@ int util::kbhit()
 
     return FD_ISSET(STDIN_FILENO, &rdfs);
 }
+/**
+ * Create the output set with @c -o: a null output paced in real time or unthrottled, or a WAV or raw file.
+ *
+ * @param name "null", "null-fast", or the name of a file, which is raw if it ends with ".raw" and WAV otherwise.
+ * @param config The format of the audio.
+ * @return The output, or @c nullptr if it could not be created.
+ */
+static std::shared_ptr<AudioOutputInterface> createOutput(const std::string &name, const PlaybackConfiguration &config) {
+	if(name == "null") {
+		return NullAudioOutput::create(config, OutputPacer::Clock::REAL_TIME);
+	}
+	if(name == "null-fast") {
+		return NullAudioOutput::create(config, OutputPacer::Clock::UNTHROTTLED);
+	}
+	const std::string rawSuffix = ".raw";
+	bool isRaw = name.size() >= rawSuffix.size() &&
+		0 == name.compare(name.size() - rawSuffix.size(), rawSuffix.size(), rawSuffix);
+	return FileAudioOutput::create(
+		name,
+		config,
+		isRaw ? FileAudioOutput::FileFormat::RAW : FileAudioOutput::FileFormat::WAV,
+		OutputPacer::Clock::REAL_TIME);
+}
+
 class MockAttachmentReader : public aisdk::utils::attachment::AttachmentReader {
 public:
 	MockAttachmentReader(std::shared_ptr<std::ifstream> stream):m_stream{stream} {
@@ -164,15 +280,22 @@ std::shared_ptr<AudioPlayerTest> AudioPlayerTest::createNew() {
 }
 
 bool AudioPlayerTest::init(){
-	/// Create object for the @c AOEngine.
-	auto engine = AOEngine::create();
-	if(!engine) {
-		std::cout << "createFailed:reason=createEngineFailed" << std::endl;
-		return false;
+	/// Create object for the @c AOEngine, which is not needed to play to another output.
+	std::shared_ptr<AOEngine> engine;
+	if(outputName.empty() || flags) {
+		engine = AOEngine::create();
+		if(!engine) {
+			std::cout << "createFailed:reason=createEngineFailed" << std::endl;
+			return false;
+		}
 	}
 	
 	/// Create PaWrapper object
-	m_playWrapper = AOWrapper::create(engine);
+	if(outputName.empty()) {
+		m_playWrapper = AOWrapper::create(engine);
+	} else if(auto output = createOutput(outputName, PlaybackConfiguration())) {
+		m_playWrapper = AOWrapper::create(output);
+	}
 	if(!m_playWrapper){
 		std::cout << "CreateFailed:reason=createWrapperFailed" << std::endl;
 		return false;
@@ -264,12 +387,15 @@ bool AudioPlayerTest::play(){
 	std::cout << " p: play sound" << std::endl;
 	std::cout << " r: resume sound" << std::endl;
 	std::cout << " s: stop sound" << std::endl;
-	std::cout << " z: pause sounds" << std::endl << std::endl;
+	std::cout << " z: pause sounds" << std::endl;
+	std::cout << " +: raise the volume" << std::endl;
+	std::cout << " -: lower the volume" << std::endl << std::endl;
 
 	std::cout << "Press 'Q' to quit" << std::endl;
 
 	int ch; 			
 	bool done = false;
+	float volume = 1.0f;
 	while (!done)
 	{
 		if(!util::kbhit()) {
@@ -301,6 +427,13 @@ bool AudioPlayerTest::play(){
 			case 'Z':
 					m_playWrapper->pause(m_sourceID);
 					break;
+			case '+':
+			case '-':
+					volume = std::max(0.0f, std::min(2.0f, volume + ('+' == ch ? 0.1f : -0.1f)));
+					if(m_playWrapper->setVolume(m_sourceID, volume)) {
+						std::cout << " volume: " << volume << std::endl;
+					}
+					break;
 			default:
 					break;
 			}
@@ -367,8 +500,214 @@ void AudioPlayerTest::onPlaybackResumed(SourceId id){
 
 }
 
+/**
+ * Decode a file the way @c AOWrapper does and count the heap allocations made per chunk once decoding reached its
+ * steady state.  With glibc the allocations FFmpeg makes through av_malloc are counted too.
+ *
+ * @param filename The file to decode.
+ * @return 0 if no chunk allocated in the steady state, 1 if some did, -1 if the file could not be decoded.
+ */
+int checkAllocations(std::string &filename){
+	auto input = std::make_shared<std::ifstream>(filename, std::ifstream::binary);
+	if(!input->is_open()){
+		std::cout << "Open the file is failed\n" << std::endl;
+		return -1;
+	}
+	auto decoder = FFmpegDecoder::create(FFmpegStreamInputController::create(input, false), PlaybackConfiguration());
+	if(!decoder){
+		std::cout << "checkAllocations:reason=createDecoderFailed" << std::endl;
+		return -1;
+	}
+
+	static DecoderInterface::Byte buffer[CHUNK_SIZE];
+	int chunks = 0;
+	int steadyChunks = 0;
+	uint64_t steadyAllocations = 0;
+	while(true) {
+		bool wasDecoding = FFmpegDecoder::DecodingState::DECODING == decoder->getState();
+		auto before = allocationCount.load();
+		auto result = decoder->read(buffer, sizeof buffer);
+		auto allocations = allocationCount.load() - before;
+		if(DecoderInterface::Status::OK != result.first) {
+			break;
+		}
+		// State changes are logged, so only the chunks decoded entirely in the DECODING state are counted.
+		if(++chunks <= WARMUP_CHUNKS || !wasDecoding ||
+			FFmpegDecoder::DecodingState::DECODING != decoder->getState()) {
+			continue;
+		}
+		steadyChunks++;
+		steadyAllocations += allocations;
+		if(allocations) {
+			std::cout << "chunk " << chunks << ": allocations=" << allocations << std::endl;
+		}
+	}
+
+	std::cout << "chunks=" << chunks << " steadyChunks=" << steadyChunks
+		<< " allocationsPerChunk=" << (steadyChunks ? static_cast<double>(steadyAllocations) / steadyChunks : 0.0)
+		<< std::endl;
+	if(!steadyChunks) {
+		std::cout << "checkAllocations:reason=fileTooShort" << std::endl;
+		return -1;
+	}
+	return steadyAllocations ? 1 : 0;
+}
+
+/// Counts the sources which finished playing, for the @c -g measurement.
+class GapObserver : public aisdk::utils::mediaPlayer::MediaPlayerObserverInterface {
+public:
+	GapObserver() : m_started{0}, m_finished{0} {
+	}
+
+	/// Wait until the given number of sources started or finished.
+	bool waitFor(int started, int finished) {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		return m_condition.wait_for(lock, std::chrono::seconds(60), [this, started, finished]() {
+			return m_started >= started && m_finished >= finished;
+		});
+	}
+
+	/// @name MediaPlayerObserverInterface functions
+	/// @{
+	void onPlaybackStarted(SourceId id) override { notify(&m_started); }
+	void onPlaybackFinished(SourceId id) override { notify(&m_finished); }
+	void onPlaybackError(SourceId id, const aisdk::utils::mediaPlayer::ErrorType& type, std::string error) override {
+		std::cout << "onPlaybackError: id=" << id << " error=" << error << std::endl;
+	}
+	void onPlaybackStopped(SourceId id) override {}
+	void onPlaybackPaused(SourceId id) override {}
+	void onPlaybackResumed(SourceId id) override {}
+	/// @}
+
+private:
+	void notify(int* counter) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			(*counter)++;
+		}
+		m_condition.notify_all();
+	}
+
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	int m_started;
+	int m_finished;
+};
+
+/**
+ * Open an attachment reading the given file.
+ *
+ * @param filename The file to read.
+ * @return The attachment, or @c nullptr if the file could not be opened.
+ */
+static std::shared_ptr<MockAttachmentReader> openAttachment(const std::string &filename) {
+	auto input = std::make_shared<std::ifstream>(filename, std::ifstream::binary);
+	if(!input->is_open()){
+		std::cout << "Open the file is failed\n" << std::endl;
+		return nullptr;
+	}
+	return std::make_shared<MockAttachmentReader>(input);
+}
+
+/**
+ * Create a player for the @c -g measurement, which plays to a null output in real time, in the format of the
+ * attachment so that no conversion is needed.
+ *
+ * @param name The name of the player, which labels its track gap histogram.
+ * @param observer The observer of the player.
+ * @return The player, or @c nullptr if it could not be created.
+ */
+static std::shared_ptr<AOWrapper> createGapPlayer(const std::string &name, std::shared_ptr<GapObserver> observer) {
+	std::shared_ptr<AOWrapper> player = AOWrapper::create(
+		NullAudioOutput::create(PlaybackConfiguration(littleEndianMachine(), 16000,
+			PlaybackConfiguration::ChannelLayout::LAYOUT_MONO, PlaybackConfiguration::SampleFormat::SIGNED_16)),
+		name);
+	if(!player) {
+		std::cout << "createGapPlayer:reason=createWrapperFailed" << std::endl;
+		return nullptr;
+	}
+	player->setObserver(observer);
+	return player;
+}
+
+/**
+ * Print the gaps recorded by a player.
+ *
+ * @param name The name of the player.
+ */
+static void printGaps(const std::string &name) {
+	// The same histogram as the player's, looked up by its name.
+	auto snapshot = aisdk::utils::metrics::MetricsRegistry::instance().getHistogram(
+		"aisdk_player_track_gap_microseconds", {{"player", name}})->snapshot();
+	std::cout << name << ": gaps=" << snapshot.count
+		<< " meanGapMs=" << snapshot.mean() / 1000
+		<< " maxGapMs=" << snapshot.max / 1000.0 << std::endl;
+}
+
+/**
+ * Play a file several times one after the other, first with @c setSource() and @c play() once the previous play
+ * finished, then with @c prepareNext() while the previous one plays, and print the gaps between the plays from the
+ * @c aisdk_player_track_gap_microseconds histograms of the two players.  The players play to null outputs paced in
+ * real time, so that the measurement does not depend on a sound card.
+ *
+ * @param filename The file to play, s16_le,16000,mono.
+ * @return 0 if all the plays finished, -1 otherwise.
+ */
+int measureGaps(std::string &filename){
+	aisdk::utils::AudioFormat format{.encoding = aisdk::utils::AudioFormat::Encoding::LPCM,
+                       .endianness = aisdk::utils::AudioFormat::Endianness::LITTLE,
+                       .sampleRateHz = 16000,
+                       .sampleSizeInBits = 16,
+                       .numChannels = 1,
+                       .dataSigned = true};
+	auto sequentialObserver = std::make_shared<GapObserver>();
+	auto sequentialPlayer = createGapPlayer("sequential", sequentialObserver);
+	auto gaplessObserver = std::make_shared<GapObserver>();
+	auto gaplessPlayer = createGapPlayer("prepareNext", gaplessObserver);
+	if(!sequentialPlayer || !gaplessPlayer) {
+		return -1;
+	}
+
+	int result = 0;
+	for(int i = 1; i <= GAP_TRACKS && !result; ++i) {
+		auto reader = openAttachment(filename);
+		auto id = reader ? sequentialPlayer->setSource(reader, &format) : AOWrapper::ERROR;
+		if(AOWrapper::ERROR == id || !sequentialPlayer->play(id) || !sequentialObserver->waitFor(i, i)) {
+			result = -1;
+		}
+	}
+
+	// Each source is prepared as soon as the previous one started, and takes its place when it ends.  The first one
+	// plays at once since nothing is playing.
+	for(int i = 1; i <= GAP_TRACKS && !result; ++i) {
+		auto reader = openAttachment(filename);
+		auto id = reader ? gaplessPlayer->prepareNext(reader, &format) : AOWrapper::ERROR;
+		if(AOWrapper::ERROR == id || !gaplessObserver->waitFor(i, i - 1)) {
+			result = -1;
+		}
+	}
+	if(!result && !gaplessObserver->waitFor(GAP_TRACKS, GAP_TRACKS)) {
+		result = -1;
+	}
+
+	if(result) {
+		std::cout << "measureGaps:reason=playFailed" << std::endl;
+	} else {
+		printGaps("sequential");
+		printGaps("prepareNext");
+	}
+	sequentialPlayer->shutdown();
+	gaplessPlayer->shutdown();
+	return result;
+}
+
 void PaHelp(){
 	printf("Options: PaWrapperTest [options]\n" \
+		"\t -a count the heap allocations per decoded chunk of a file in steady state.\n" \
+		"\t -g measure the gaps between plays of an attachment, with setSource and with prepareNext, on a null output.\n" \
+		"\t\t the resource format must be: s16_le,16000,mono\n" \
+		"\t -o play to an output other than the libao device: null, null-fast (unthrottled),\n" \
+		"\t\t or a file, raw if its name ends with .raw and WAV otherwise.\n" \
 		"\t -u set play a url resource.\n" \
 		"\t -f Set play a filename stream resource.\n" \
 		"\t -p set url stream start position[uint: sec]\n" \
@@ -417,12 +756,23 @@ int main(int argc, char *argv[]){
 	std::string url;
 	std::string filename;
 	std::string attachmentName;	
+	std::string allocationCheckName;
+	std::string gapCheckName;
 	std::chrono::milliseconds offset = std::chrono::milliseconds::zero();
 		
 	int opt;
 	
-	while((opt = getopt(argc, argv, "yhu:r:p:f:")) != -1) {
+	while((opt = getopt(argc, argv, "yha:g:o:u:r:p:f:")) != -1) {
 	switch (opt) {
+		case 'a':
+			allocationCheckName = optarg;
+			break;
+		case 'g':
+			gapCheckName = optarg;
+			break;
+		case 'o':
+			outputName = optarg;
+			break;
 		case 'u':
 			url = optarg;
 			break;
@@ -450,6 +800,13 @@ int main(int argc, char *argv[]){
 	}
 	}
 
+	if(!allocationCheckName.empty()) {
+		return checkAllocations(allocationCheckName);
+	}
+	if(!gapCheckName.empty()) {
+		return measureGaps(gapCheckName);
+	}
+
 	work(url, filename, attachmentName, offset);
 
 	getchar();
@@ -0,0 +1,426 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Utils/MediaPlayer/MediaPlayerObserverInterface.h"
+#include "AudioMediaPlayer/AOWrapper.h"
+#include "AudioMediaPlayer/DecoderContextPool.h"
+#include "AudioMediaPlayer/Endian.h"
+#include "AudioMediaPlayer/FFmpegDecoder.h"
+#include "AudioMediaPlayer/FFmpegLocalFileInputController.h"
+#include "AudioMediaPlayer/FFmpegStreamInputController.h"
+#include "AudioMediaPlayer/FFmpegUrlInputController.h"
+#include "AudioMediaPlayer/NullAudioOutput.h"
+#include "AudioMediaPlayer/PcmCache.h"
+#include "AudioMediaPlayer/PlaybackConfiguration.h"
+
+using namespace aisdk::mediaPlayer::ffmpeg;
+
+/// The size of a chunk read from the decoder, the same as the one @c AOWrapper uses.
+static const size_t CHUNK_SIZE = 16384;
+
+/// The result of decoding a file once.
+struct Result {
+	/// Whether the whole file was decoded.
+	bool isComplete;
+	/// The CPU time spent by the decoding thread, in seconds.
+	double cpuSeconds;
+	/// The duration of the decoded audio, in seconds.
+	double audioSeconds;
+	/// The wall time from opening the file to the first audio, in seconds.
+	double firstSampleSeconds;
+};
+
+/**
+ * Get the CPU time used by the calling thread.
+ *
+ * @return The CPU time in seconds.
+ */
+static double threadCpuSeconds() {
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * Decode a file to the end, the way @c AOWrapper reads it.
+ *
+ * @param filename The file to decode.
+ * @param config The output format.
+ * @param allowResamplerBypass Whether the decoder may skip the resampler.
+ * @param isMapped Whether the file is mapped to memory rather than read through an @c istream.
+ * @param contextPool The pool the decoder takes its codec context and resampler from, or @c nullptr.
+ * @return The CPU time spent, the audio decoded and the time to the first audio.
+ */
+static Result decodeFile(
+	const std::string& filename,
+	const PlaybackConfiguration& config,
+	bool allowResamplerBypass,
+	bool isMapped = false,
+	std::shared_ptr<DecoderContextPool> contextPool = nullptr) {
+	Result result{false, 0, 0, 0};
+	auto wallStart = std::chrono::steady_clock::now();
+	auto start = threadCpuSeconds();
+	std::unique_ptr<FFmpegInputControllerInterface> input;
+	if(isMapped) {
+		// Nothing changes the file while the benchmark runs, so it is mapped like a file the SDK owns.
+		input = FFmpegLocalFileInputController::create(filename, std::chrono::milliseconds::zero(), false, true);
+	} else {
+		auto stream = std::make_shared<std::ifstream>(filename, std::ifstream::binary);
+		if(stream->is_open()) {
+			input = FFmpegStreamInputController::create(stream, false);
+		}
+	}
+	if(!input) {
+		std::cout << "Open the file is failed" << std::endl;
+		return result;
+	}
+	auto decoder = FFmpegDecoder::create(
+		std::move(input), config, allowResamplerBypass, ProbeConfiguration(), contextPool);
+	if(!decoder) {
+		std::cout << "decodeFile:reason=createDecoderFailed" << std::endl;
+		return result;
+	}
+
+	static DecoderInterface::Byte buffer[CHUNK_SIZE];
+	size_t bytes = 0;
+	while(true) {
+		auto status = decoder->read(buffer, sizeof buffer);
+		if(0 == bytes && status.second > 0) {
+			result.firstSampleSeconds =
+				std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+		}
+		bytes += status.second;
+		if(DecoderInterface::Status::OK != status.first) {
+			result.isComplete = DecoderInterface::Status::DONE == status.first;
+			break;
+		}
+	}
+	result.cpuSeconds = threadCpuSeconds() - start;
+	result.audioSeconds = static_cast<double>(bytes) /
+		(config.sampleRate() * config.numberChannels() * config.sampleSizeBytes());
+	return result;
+}
+
+/// Waits for the end of a play, for the @c -p benchmark.
+class PlayObserver : public aisdk::utils::mediaPlayer::MediaPlayerObserverInterface {
+public:
+	PlayObserver() : m_isDone{false}, m_isFinished{false} {
+	}
+
+	/// Wait until the play finished or failed, and get whether it finished.
+	bool waitForEnd() {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_condition.wait(lock, [this]() { return m_isDone; });
+		return m_isFinished;
+	}
+
+	/// @name MediaPlayerObserverInterface functions
+	/// @{
+	void onPlaybackStarted(SourceId id) override {}
+	void onPlaybackFinished(SourceId id) override { setDone(true); }
+	void onPlaybackError(SourceId id, const aisdk::utils::mediaPlayer::ErrorType& type, std::string error) override {
+		setDone(false);
+	}
+	void onPlaybackStopped(SourceId id) override { setDone(false); }
+	void onPlaybackPaused(SourceId id) override {}
+	void onPlaybackResumed(SourceId id) override {}
+	/// @}
+
+private:
+	void setDone(bool isFinished) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_isDone = true;
+			m_isFinished = isFinished;
+		}
+		m_condition.notify_all();
+	}
+
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	bool m_isDone;
+	bool m_isFinished;
+};
+
+/**
+ * Play a file through an @c AOWrapper to an unthrottled null output, which measures the whole playback path without
+ * a sound card: decoding, the ring and the output thread.
+ *
+ * @param filename The file to play.
+ * @param config The output format.
+ * @return The wall time spent, in @c cpuSeconds, and the audio played.
+ */
+static Result playFile(const std::string& filename, const PlaybackConfiguration& config) {
+	Result result{false, 0, 0, 0};
+	auto input = std::make_shared<std::ifstream>(filename, std::ifstream::binary);
+	if(!input->is_open()) {
+		std::cout << "Open the file is failed" << std::endl;
+		return result;
+	}
+	std::shared_ptr<NullAudioOutput> output = NullAudioOutput::create(config, OutputPacer::Clock::UNTHROTTLED);
+	AOWrapper::Options options;
+	options.prebufferTarget = std::chrono::milliseconds::zero();
+	auto player = AOWrapper::create(output, "DecoderBenchmark", options);
+	if(!player) {
+		std::cout << "playFile:reason=createPlayerFailed" << std::endl;
+		return result;
+	}
+	auto observer = std::make_shared<PlayObserver>();
+	player->setObserver(observer);
+
+	auto start = std::chrono::steady_clock::now();
+	auto id = player->setSource(input, false);
+	if(AOWrapper::ERROR == id || !player->play(id)) {
+		std::cout << "playFile:reason=playFailed" << std::endl;
+		return result;
+	}
+	result.isComplete = observer->waitForEnd();
+	result.cpuSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	result.audioSeconds = static_cast<double>(output->getBytesWritten()) /
+		(config.sampleRate() * config.numberChannels() * config.sampleSizeBytes());
+	player->shutdown();
+	return result;
+}
+
+/**
+ * Measure the time from the request of a play of a file to its first audio, decoded or played from a @c PcmCache.
+ *
+ * @param filename The file to play.
+ * @param config The output format.
+ * @param cache The cache the file was recorded in, or @c nullptr to decode the file.
+ * @return The time to the first audio in milliseconds, or a negative value on failure.
+ */
+static double firstSampleMs(const std::string& filename, const PlaybackConfiguration& config, std::shared_ptr<PcmCache> cache) {
+	auto start = std::chrono::steady_clock::now();
+	std::shared_ptr<DecoderInterface> decoder = cache ? cache->createDecoder(filename, config) : nullptr;
+	if(!decoder) {
+		decoder = FFmpegDecoder::create(
+			FFmpegUrlInputController::create(filename, std::chrono::milliseconds::zero()), config);
+	}
+	if(!decoder) {
+		std::cout << "firstSampleMs:reason=createDecoderFailed" << std::endl;
+		return -1;
+	}
+
+	static DecoderInterface::Byte buffer[CHUNK_SIZE];
+	std::pair<DecoderInterface::Status, size_t> status{DecoderInterface::Status::OK, 0};
+	while(DecoderInterface::Status::OK == status.first && 0 == status.second) {
+		status = decoder->read(buffer, sizeof buffer);
+	}
+	auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return DecoderInterface::Status::ERROR == status.first ? -1 : elapsed;
+}
+
+/**
+ * Record a file in a @c PcmCache by decoding it to the end.
+ *
+ * @param filename The file to record.
+ * @param config The output format.
+ * @param cache The cache.
+ * @return Whether the file was decoded to the end.
+ */
+static bool recordFile(const std::string& filename, const PlaybackConfiguration& config, std::shared_ptr<PcmCache> cache) {
+	auto decoder = cache->record(filename, config, FFmpegDecoder::create(
+		FFmpegUrlInputController::create(filename, std::chrono::milliseconds::zero()), config));
+	if(!decoder) {
+		return false;
+	}
+	static DecoderInterface::Byte buffer[CHUNK_SIZE];
+	while(true) {
+		auto status = decoder->read(buffer, sizeof buffer);
+		if(DecoderInterface::Status::OK != status.first) {
+			return DecoderInterface::Status::DONE == status.first;
+		}
+	}
+}
+
+void BenchmarkHelp() {
+	printf("Options: DecoderBenchmark [options]\n" \
+		"\t -f the file to decode, for example a 16kHz mono PCM wav or an mp3.\n" \
+		"\t -r the output sample rate, 48000 by default.\n" \
+		"\t -c the output channels, 1 or 2, 2 by default.\n" \
+		"\t -n the number of times the file is decoded, 5 by default.\n" \
+		"\t -p also play the file through an AOWrapper to an unthrottled null output.\n" \
+		"\t -k a directory for a decoded audio cache, to compare the time to the first audio of decoded and cached plays.\n" \
+		"\t -m also decode the file mapped to memory, to compare it with reading it through an istream.\n" \
+		"\t -w also decode the file with a decoder context pool, like the dialog turns of a player sharing one.\n" \
+		"\t Prints the decoding CPU time per second of audio, with and without the resampler bypass.\n" \
+		"\t The bypass only applies when the output format is the format of the file.\n" \
+		"\t With -p, also prints the wall time per second of audio of the whole playback path.\n" \
+		"\t With -k, also prints the time to the first audio of a play, decoded and from the cache.\n" \
+		"\t With -m, also prints the time to the first audio and the decoding CPU time of each input.\n" \
+		"\t With -w, also prints the time to the first audio of a turn, with and without the pool.\n");
+}
+
+int main(int argc, char *argv[]) {
+	std::string filename;
+	size_t sampleRate = 48000;
+	int channels = 2;
+	int repeats = 5;
+	bool isPlaying = false;
+	bool isComparingInputs = false;
+	bool isComparingPool = false;
+	std::string cacheDirectory;
+
+	int opt;
+	while((opt = getopt(argc, argv, "hpmwf:r:c:n:k:")) != -1) {
+		switch (opt) {
+			case 'f':
+				filename = optarg;
+				break;
+			case 'r':
+				sampleRate = atoi(optarg);
+				break;
+			case 'c':
+				channels = atoi(optarg);
+				break;
+			case 'n':
+				repeats = atoi(optarg);
+				break;
+			case 'p':
+				isPlaying = true;
+				break;
+			case 'k':
+				cacheDirectory = optarg;
+				break;
+			case 'm':
+				isComparingInputs = true;
+				break;
+			case 'w':
+				isComparingPool = true;
+				break;
+			default:
+				BenchmarkHelp();
+				exit(EXIT_FAILURE);
+		}
+	}
+	if(filename.empty() || sampleRate == 0 || (channels != 1 && channels != 2) || repeats <= 0) {
+		BenchmarkHelp();
+		exit(EXIT_FAILURE);
+	}
+
+	PlaybackConfiguration config(
+		littleEndianMachine(),
+		sampleRate,
+		1 == channels ? PlaybackConfiguration::ChannelLayout::LAYOUT_MONO
+			: PlaybackConfiguration::ChannelLayout::LAYOUT_STEREO,
+		PlaybackConfiguration::SampleFormat::SIGNED_16);
+
+	for(auto allowResamplerBypass : {true, false}) {
+		double cpuSeconds = 0;
+		double audioSeconds = 0;
+		for(int i = 0; i < repeats; ++i) {
+			auto result = decodeFile(filename, config, allowResamplerBypass);
+			if(!result.isComplete) {
+				std::cout << "decodeFailed: bypass=" << allowResamplerBypass << std::endl;
+				return EXIT_FAILURE;
+			}
+			cpuSeconds += result.cpuSeconds;
+			audioSeconds += result.audioSeconds;
+		}
+		std::cout << "bypass=" << (allowResamplerBypass ? "allowed" : "disabled")
+			<< " audioSeconds=" << audioSeconds / repeats
+			<< " cpuMsPerAudioSecond=" << (audioSeconds > 0 ? cpuSeconds * 1000 / audioSeconds : 0) << std::endl;
+	}
+
+	if(isPlaying) {
+		double wallSeconds = 0;
+		double audioSeconds = 0;
+		for(int i = 0; i < repeats; ++i) {
+			auto result = playFile(filename, config);
+			if(!result.isComplete) {
+				std::cout << "playFailed" << std::endl;
+				return EXIT_FAILURE;
+			}
+			wallSeconds += result.cpuSeconds;
+			audioSeconds += result.audioSeconds;
+		}
+		std::cout << "player audioSeconds=" << audioSeconds / repeats
+			<< " wallMsPerAudioSecond=" << (audioSeconds > 0 ? wallSeconds * 1000 / audioSeconds : 0) << std::endl;
+	}
+
+	if(isComparingInputs) {
+		for(auto isMapped : {false, true}) {
+			double cpuSeconds = 0;
+			double audioSeconds = 0;
+			double firstSampleSeconds = 0;
+			for(int i = 0; i < repeats; ++i) {
+				auto result = decodeFile(filename, config, true, isMapped);
+				if(!result.isComplete) {
+					std::cout << "decodeFailed: mapped=" << isMapped << std::endl;
+					return EXIT_FAILURE;
+				}
+				cpuSeconds += result.cpuSeconds;
+				audioSeconds += result.audioSeconds;
+				firstSampleSeconds += result.firstSampleSeconds;
+			}
+			std::cout << "input=" << (isMapped ? "mapped" : "stream")
+				<< " firstSampleMs=" << firstSampleSeconds * 1000 / repeats
+				<< " cpuMsPerAudioSecond=" << (audioSeconds > 0 ? cpuSeconds * 1000 / audioSeconds : 0) << std::endl;
+		}
+	}
+
+	if(isComparingPool) {
+		for(auto isPooled : {false, true}) {
+			// The first turn with the pool sets its contexts up, and the following ones take them back.
+			auto pool = isPooled ? DecoderContextPool::create() : nullptr;
+			double firstSampleSeconds = 0;
+			for(int i = 0; i < repeats; ++i) {
+				auto result = decodeFile(filename, config, true, false, pool);
+				if(!result.isComplete) {
+					std::cout << "decodeFailed: pooled=" << isPooled << std::endl;
+					return EXIT_FAILURE;
+				}
+				firstSampleSeconds += result.firstSampleSeconds;
+			}
+			std::cout << "pool=" << (isPooled ? "on" : "off")
+				<< " firstSampleMs=" << firstSampleSeconds * 1000 / repeats << std::endl;
+		}
+	}
+
+	if(!cacheDirectory.empty()) {
+		auto cache = PcmCache::create(cacheDirectory, 64 * 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024);
+		// The cache records a url from its second play.
+		if(!cache || !recordFile(filename, config, cache) || !recordFile(filename, config, cache)) {
+			std::cout << "recordFailed" << std::endl;
+			return EXIT_FAILURE;
+		}
+		for(auto isCached : {false, true}) {
+			double totalMs = 0;
+			for(int i = 0; i < repeats; ++i) {
+				auto ms = firstSampleMs(filename, config, isCached ? cache : nullptr);
+				if(ms < 0) {
+					std::cout << "firstSampleFailed: cached=" << isCached << std::endl;
+					return EXIT_FAILURE;
+				}
+				totalMs += ms;
+			}
+			std::cout << "play=" << (isCached ? "cached" : "decoded")
+				<< " firstSampleMs=" << totalMs / repeats << std::endl;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
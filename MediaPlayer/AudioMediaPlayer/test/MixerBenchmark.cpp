@@ -0,0 +1,251 @@
+/*
+ * Copyright 2019 gm its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <Utils/Channel/AudioTrackManagerInterface.h>
+
+#include "AudioMediaPlayer/AudioMixer.h"
+#include "AudioMediaPlayer/Endian.h"
+#include "AudioMediaPlayer/FocusDuckingObserver.h"
+#include "AudioMediaPlayer/NullAudioOutput.h"
+#include "AudioMediaPlayer/PcmKernels.h"
+#include "AudioMediaPlayer/PlaybackConfiguration.h"
+
+using namespace aisdk::mediaPlayer::ffmpeg;
+
+/// The number of samples mixed at once, a 20ms period of 48kHz stereo like the mixer's.
+static const size_t PERIOD_SAMPLES = 1920;
+
+/// The gain of the scaled inputs, in Q15.
+static const int32_t BENCHMARK_GAIN_Q15 = UNITY_GAIN_Q15 / 4;
+
+/// The channels the mixer inputs stand for, the first one being the dialog channel the others are ducked under.
+static const std::string CHANNEL_NAMES[] = {
+	aisdk::utils::channel::AudioTrackManagerInterface::DIALOG_CHANNEL_NAME,
+	aisdk::utils::channel::AudioTrackManagerInterface::MEDIA_CHANNEL_NAME,
+	aisdk::utils::channel::AudioTrackManagerInterface::ALARMS_CHANNEL_NAME,
+	"Extra"};
+
+/**
+ * Get the CPU time used by the calling thread.
+ *
+ * @return The CPU time in seconds.
+ */
+static double threadCpuSeconds() {
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * The plain loop the kernels replace, which also gives the expected results.
+ */
+static void mixScaledReference(int16_t* destination, const int16_t* source, size_t samples, int32_t gainQ15) {
+	for(size_t i = 0; i < samples; ++i) {
+		int32_t sum = destination[i] + ((int32_t(source[i]) * gainQ15) >> 15);
+		destination[i] = static_cast<int16_t>(std::min<int32_t>(std::max<int32_t>(sum, INT16_MIN), INT16_MAX));
+	}
+}
+
+/**
+ * Mix the inputs period by period, the way the mixer thread does, and get the CPU time it took.
+ *
+ * @param inputs The samples of each input.
+ * @param useKernels Whether to mix with the kernels or with the reference loop.
+ * @param mix Receives the mix.
+ * @return The CPU time in seconds.
+ */
+static double mixInputs(const std::vector<std::vector<int16_t>>& inputs, bool useKernels, std::vector<int16_t>* mix) {
+	auto samples = inputs.front().size();
+	mix->assign(samples, 0);
+	auto start = threadCpuSeconds();
+	for(size_t offset = 0; offset + PERIOD_SAMPLES <= samples; offset += PERIOD_SAMPLES) {
+		for(size_t input = 0; input < inputs.size(); ++input) {
+			// The first input is at unity gain, the others are ducked.
+			auto gain = 0 == input ? UNITY_GAIN_Q15 : BENCHMARK_GAIN_Q15;
+			if(useKernels) {
+				mixScaledSaturating16(mix->data() + offset, inputs[input].data() + offset, PERIOD_SAMPLES, gain);
+			} else {
+				mixScaledReference(mix->data() + offset, inputs[input].data() + offset, PERIOD_SAMPLES, gain);
+			}
+		}
+	}
+	return threadCpuSeconds() - start;
+}
+
+/**
+ * Check which mixer inputs a @c FocusDuckingObserver ducked.
+ *
+ * @param inputs The inputs, the first one being the dialog one.
+ * @param isDialogForeground Whether the dialog channel is in the foreground, so that every other input must be ducked.
+ * @return Whether exactly the expected inputs are ducked.
+ */
+static bool checkDucking(const std::vector<std::shared_ptr<AudioMixerInput>>& inputs, bool isDialogForeground) {
+	for(size_t input = 0; input < inputs.size(); ++input) {
+		bool shouldBeDucked = isDialogForeground && input != 0;
+		if(inputs[input]->isDucked() != shouldBeDucked) {
+			std::cout << std::endl << "duckingFailed: channel=" << CHANNEL_NAMES[input]
+				<< " ducked=" << !shouldBeDucked << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Write the inputs to an @c AudioMixer writing to an unthrottled null output, and get the wall time it took.
+ *
+ * The inputs stand for the players of the channels in @c CHANNEL_NAMES.  The dialog channel goes to the foreground
+ * before the audio is written, the way an answer acquires it, and a @c FocusDuckingObserver must duck all the other
+ * inputs, which only the dialog player acquires a channel for; it must bring them back up once the dialog channel is
+ * released.
+ *
+ * @param inputs The samples of each input.
+ * @param config The format of the samples.
+ * @return The wall time in seconds, or a negative value on failure.
+ */
+static double runMixer(const std::vector<std::vector<int16_t>>& inputs, const PlaybackConfiguration& config) {
+	std::shared_ptr<NullAudioOutput> output = NullAudioOutput::create(config, OutputPacer::Clock::UNTHROTTLED);
+	auto mixer = AudioMixer::create(output, "MixerBenchmark");
+	if(!mixer) {
+		return -1;
+	}
+	std::vector<std::shared_ptr<AudioMixerInput>> mixerInputs;
+	std::unordered_map<std::string, std::shared_ptr<AudioMixerInput>> channelInputs;
+	for(size_t input = 0; input < inputs.size(); ++input) {
+		auto mixerInput = mixer->createInput(CHANNEL_NAMES[input], 1.0f);
+		if(!mixerInput) {
+			return -1;
+		}
+		mixerInputs.push_back(mixerInput);
+		channelInputs[CHANNEL_NAMES[input]] = mixerInput;
+	}
+
+	FocusDuckingObserver duckingObserver(channelInputs);
+	duckingObserver.onTrackChanged(CHANNEL_NAMES[0], aisdk::utils::channel::FocusState::FOREGROUND);
+	if(!checkDucking(mixerInputs, true)) {
+		return -1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> writers;
+	for(size_t input = 0; input < inputs.size(); ++input) {
+		writers.emplace_back([&inputs, &mixerInputs, input]() {
+			auto data = reinterpret_cast<const uint8_t*>(inputs[input].data());
+			mixerInputs[input]->write(data, inputs[input].size() * sizeof(int16_t));
+		});
+	}
+	for(auto& writer : writers) {
+		writer.join();
+	}
+	// The inputs are written once the mixer took their last samples; wait for them to reach the output.
+	auto totalBytes = inputs.front().size() * sizeof(int16_t);
+	while(output->getBytesWritten() < totalBytes) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	duckingObserver.onTrackChanged(CHANNEL_NAMES[0], aisdk::utils::channel::FocusState::NONE);
+	bool isUnducked = checkDucking(mixerInputs, false);
+	mixer->shutdown();
+	return isUnducked ? seconds : -1;
+}
+
+void BenchmarkHelp() {
+	printf("Options: MixerBenchmark [options]\n" \
+		"\t -s the seconds of 48kHz stereo audio mixed per input, 60 by default.\n" \
+		"\t -m also run the inputs through an AudioMixer to an unthrottled null output, with the inputs after the\n" \
+		"\t    first ducked by a FocusDuckingObserver while the first one holds the dialog channel.\n" \
+		"\t Prints the mixing CPU time per second of audio for 1 to 4 inputs, with the kernels and with a plain loop,\n" \
+		"\t and checks that both give the same mix.\n" \
+		"\t With -m, also prints the wall time per second of audio of the whole mixer.\n");
+}
+
+int main(int argc, char *argv[]) {
+	int seconds = 60;
+	bool isRunningMixer = false;
+
+	int opt;
+	while((opt = getopt(argc, argv, "hms:")) != -1) {
+		switch (opt) {
+			case 's':
+				seconds = atoi(optarg);
+				break;
+			case 'm':
+				isRunningMixer = true;
+				break;
+			default:
+				BenchmarkHelp();
+				exit(EXIT_FAILURE);
+		}
+	}
+	if(seconds <= 0) {
+		BenchmarkHelp();
+		exit(EXIT_FAILURE);
+	}
+
+	PlaybackConfiguration config(
+		littleEndianMachine(),
+		48000,
+		PlaybackConfiguration::ChannelLayout::LAYOUT_STEREO,
+		PlaybackConfiguration::SampleFormat::SIGNED_16);
+	size_t samples = static_cast<size_t>(seconds) * 48000 * 2;
+
+	// Loud noise, so that the sums saturate now and then.
+	srand(1);
+	std::vector<std::vector<int16_t>> allInputs(
+		sizeof(CHANNEL_NAMES) / sizeof(CHANNEL_NAMES[0]), std::vector<int16_t>(samples));
+	for(auto& input : allInputs) {
+		for(auto& sample : input) {
+			sample = static_cast<int16_t>(rand() % 65536 - 32768);
+		}
+	}
+
+	for(size_t count = 1; count <= allInputs.size(); ++count) {
+		std::vector<std::vector<int16_t>> inputs(allInputs.begin(), allInputs.begin() + count);
+		std::vector<int16_t> kernelMix;
+		std::vector<int16_t> referenceMix;
+		auto kernelSeconds = mixInputs(inputs, true, &kernelMix);
+		auto referenceSeconds = mixInputs(inputs, false, &referenceMix);
+		if(kernelMix != referenceMix) {
+			std::cout << "mixMismatch: inputs=" << count << std::endl;
+			return EXIT_FAILURE;
+		}
+		std::cout << "inputs=" << count
+			<< " kernelCpuMsPerAudioSecond=" << kernelSeconds * 1000 / seconds
+			<< " loopCpuMsPerAudioSecond=" << referenceSeconds * 1000 / seconds;
+		if(isRunningMixer) {
+			auto mixerSeconds = runMixer(inputs, config);
+			if(mixerSeconds < 0) {
+				std::cout << std::endl << "mixerFailed: inputs=" << count << std::endl;
+				return EXIT_FAILURE;
+			}
+			std::cout << " mixerWallMsPerAudioSecond=" << mixerSeconds * 1000 / seconds;
+		}
+		std::cout << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -23,6 +23,7 @@
 #include <thread>
 
 #include <Utils/Channel/ChannelObserverInterface.h>
+#include <Utils/Threading/StallWatchdog.h>
 #include <DMInterface/DomainHandlerInterface.h>
 #include <DMInterface/DomainHandlerResultInterface.h>
 
@@ -148,6 +149,9 @@ private:
 	/// condition variable used to wake when waiting.
 	std::condition_variable m_wakeProcessingTask;
 
+	/// The heartbeat of @c processorLoop(), watched by the @c StallWatchdog.
+	utils::threading::Heartbeat m_heartbeat;
+
 	/// Thread to receive processor handler.
 	std::thread m_processingThread;
 
@@ -12,6 +12,7 @@
 #include <algorithm>
 
 #include <Utils/Logging/Logger.h>
+#include <Utils/Logging/ThreadMoniker.h>
 #include <Utils/Threading/Memory.h>
 
 #include "NLP/DomainProcessor.h"
@@ -31,7 +32,8 @@ std::unordered_map<DomainProcessor::ProcessorHandle, DomainProcessor*> DomainPro
 DomainProcessor::DomainProcessor(DomainRouter *domainRouter):
 	m_domainRouter{domainRouter},
 	m_isShuttingDown{false},
-	m_isHandlingDirective{false} {
+	m_isHandlingDirective{false},
+	m_heartbeat{"DomainProcessor"} {
 	std::lock_guard<std::mutex> lock(m_handleMapMutex);
 	m_handle = ++m_nextProcessorHandle;
 	m_handleMap[m_handle] = this;
@@ -172,12 +174,14 @@ void DomainProcessor::removeDirectiveLocked(std::shared_ptr<NLPDomain> domain) {
 }
 
 void DomainProcessor::processorLoop() {
+    utils::logging::ThreadMoniker::setThisThreadName("DomainProcessor");
     auto wake = [this]() {
         return !m_cancelingQueue.empty() || (!m_handlingQueue.empty() && !m_isHandlingDirective) || m_isShuttingDown;
     };
 
     while (true) {
         std::unique_lock<std::mutex> lock(m_mutex);
+        m_heartbeat.idle();
         m_wakeProcessingTask.wait(lock, wake);
         if (!processorCancelingQueueDomainLocked(lock) && !handleDirectiveLocked(lock) && m_isShuttingDown) {
             break;
@@ -191,6 +195,7 @@ bool DomainProcessor::processorCancelingQueueDomainLocked(std::unique_lock<std::
     }
     std::deque<std::shared_ptr<NLPDomain>> temp(std::move(m_cancelingQueue));
     lock.unlock();
+    m_heartbeat.beat("cancelDomain");
     for (auto domain : temp) {
         m_domainRouter->cancelDomain(domain);
     }
@@ -210,6 +215,7 @@ bool DomainProcessor::handleDirectiveLocked(std::unique_lock<std::mutex>& lock)
     auto domain = m_handlingQueue.front();
     m_isHandlingDirective = true;
     lock.unlock();
+    m_heartbeat.beat("handleDomain");
     auto handled = m_domainRouter->handleDomain(domain);
     lock.lock();
     if (!handled) {
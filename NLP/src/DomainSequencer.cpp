@@ -19,6 +19,7 @@
 #include <Utils/Channel/ChannelObserverInterface.h>
 #include <DMInterface/DomainHandlerInterface.h>
 #include <Utils/Logging/Logger.h>
+#include <Utils/Logging/ThreadMoniker.h>
 
 #include "NLP/DomainSequencer.h"
 
@@ -86,6 +87,7 @@ void DomainSequencer::doShutdown() {
 }
 
 void DomainSequencer::receivingLoop() {
+	utils::logging::ThreadMoniker::setThisThreadName("DomainSequencer");
 #if 0
 	auto wake = [this](){
 		return !m_receivingQueue.empty();
@@ -6,6 +6,15 @@ list(APPEND CMAKE_MODULE_PATH ${CMAKE_CURRENT_LIST_DIR}/cmake)
 # Setup build options variables.
 include(BuildOption)
 
+# Setup logging variables.
+include(Logging)
+
+# Setup tracing variables.
+include(Tracing)
+
+# Setup the check for std::cout in library targets.
+include(StdoutCheck)
+
 # Setup PortAudio variables.
 include(PortAudio)
 
@@ -0,0 +1,45 @@
+#
+# Setup the log sink and its options.
+#
+# To send logs to a file instead of the console, run the following command,
+#     cmake <path-to-source>
+#       -DACSDK_LOG_SINK=File
+#           -DACSDK_FILE_LOGGER_PATH=<path-to-log-file>
+#           -DACSDK_FILE_LOGGER_MAX_SIZE=<bytes-before-rotation>
+#           -DACSDK_FILE_LOGGER_MAX_FILES=<number-of-files-kept>
+#
+
+set(ACSDK_LOG_SINK "Console" CACHE STRING "Log sink, options are: Console or File.")
+set_property(CACHE ACSDK_LOG_SINK PROPERTY STRINGS Console File)
+
+if(NOT ACSDK_LOG_SINK STREQUAL "Console" AND NOT ACSDK_LOG_SINK STREQUAL "File")
+    message(FATAL_ERROR "Unsupported log sink '${ACSDK_LOG_SINK}', options are: Console or File.")
+endif()
+
+message("Creating ${PROJECT_NAME} with log sink: ${ACSDK_LOG_SINK}")
+add_definitions(-DACSDK_LOG_SINK=${ACSDK_LOG_SINK})
+
+if(ACSDK_LOG_SINK STREQUAL "File")
+    if(ACSDK_FILE_LOGGER_PATH)
+        add_definitions(-DACSDK_FILE_LOGGER_PATH="${ACSDK_FILE_LOGGER_PATH}")
+    endif()
+    if(ACSDK_FILE_LOGGER_MAX_SIZE)
+        add_definitions(-DACSDK_FILE_LOGGER_MAX_SIZE=${ACSDK_FILE_LOGGER_MAX_SIZE})
+    endif()
+    if(ACSDK_FILE_LOGGER_MAX_FILES)
+        add_definitions(-DACSDK_FILE_LOGGER_MAX_FILES=${ACSDK_FILE_LOGGER_MAX_FILES})
+    endif()
+endif()
+
+#
+# The DEBUG logs are compiled out of release builds.  To compile them in for the flight recorder only, so that it keeps
+# the DEBUG history leading to an error while the logger emits the levels it is set to, run the following command,
+#     cmake <path-to-source> -DAISDK_FLIGHT_RECORDER_DEBUG_LOG=ON
+#
+
+option(AISDK_FLIGHT_RECORDER_DEBUG_LOG "Compile the DEBUG logs in for the flight recorder." OFF)
+
+if(AISDK_FLIGHT_RECORDER_DEBUG_LOG)
+    message("Creating ${PROJECT_NAME} with DEBUG logs for the flight recorder")
+    add_definitions(-DAISDK_FLIGHT_RECORDER_DEBUG_LOG_ENABLED)
+endif()
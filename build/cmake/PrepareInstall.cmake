@@ -5,6 +5,7 @@
 
 # Function to install the target
 function(asdk_install)
+    asdk_check_no_stdout(${PROJECT_NAME})
     SET(PKG_CONFIG_LIBS "${PKG_CONFIG_LIBS} -l${PROJECT_NAME}" CACHE INTERNAL "" FORCE)
     install(TARGETS ${PROJECT_NAME} DESTINATION "${ASDK_LIB_INSTALL_DIR}")
     install(DIRECTORY "${PROJECT_SOURCE_DIR}/include" DESTINATION "${ASDK_INCLUDE_INSTALL_DIR}")
@@ -12,6 +13,7 @@ endfunction()
 
 # Function to install the target with list of include paths
 function(asdk_install_multiple path_list)
+    asdk_check_no_stdout(${PROJECT_NAME})
     SET(PKG_CONFIG_LIBS "${PKG_CONFIG_LIBS} -l${PROJECT_NAME}" CACHE INTERNAL "" FORCE)
     install(TARGETS ${PROJECT_NAME} DESTINATION "${ASDK_LIB_INSTALL_DIR}")
     foreach(path IN LISTS path_list)
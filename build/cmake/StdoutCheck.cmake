@@ -0,0 +1,48 @@
+#
+# Setup a check that keeps std::cout out of the SDK libraries.
+#
+# Diagnostics in library code must go through the AISDK_* logging macros so that they are level filtered and
+# compiled out of release builds. Every target installed with asdk_install() or asdk_install_multiple() is scanned
+# at configure time; a std::cout use outside a comment is reported as a warning in DEBUG builds and as an error in
+# other builds. Sources which are allowed to write to stdout (the console log sink) are listed below.
+#
+# To only warn in any build type, run the following command,
+#     cmake <path-to-source> -DASDK_STDOUT_CHECK_WARN_ONLY=ON
+#
+
+option(ASDK_STDOUT_CHECK_WARN_ONLY "Report std::cout in library targets as a warning instead of an error." OFF)
+
+# Sources which may legitimately write to stdout.
+set(ASDK_STDOUT_ALLOWED_SOURCES
+    ConsoleLogger.cpp)
+
+# Function to check that the sources of a target do not use std::cout.
+function(asdk_check_no_stdout target)
+    get_target_property(sources ${target} SOURCES)
+    set(offenders "")
+    foreach(source IN LISTS sources)
+        if(NOT IS_ABSOLUTE "${source}")
+            set(source "${CMAKE_CURRENT_SOURCE_DIR}/${source}")
+        endif()
+        get_filename_component(sourceName "${source}" NAME)
+        list(FIND ASDK_STDOUT_ALLOWED_SOURCES "${sourceName}" allowedIndex)
+        if(allowedIndex EQUAL -1 AND EXISTS "${source}")
+            file(STRINGS "${source}" lines REGEX "std::cout")
+            foreach(line IN LISTS lines)
+                if(NOT line MATCHES "^[ \t]*//")
+                    string(STRIP "${line}" line)
+                    set(offenders "${offenders}\n    ${sourceName}: ${line}")
+                endif()
+            endforeach()
+        endif()
+    endforeach()
+
+    if(offenders)
+        set(report "Target ${target} writes to std::cout, use the AISDK_* logging macros instead:${offenders}")
+        if(ASDK_STDOUT_CHECK_WARN_ONLY OR CMAKE_BUILD_TYPE MATCHES "^[Dd][Ee][Bb][Uu][Gg]$")
+            message(WARNING "${report}")
+        else()
+            message(FATAL_ERROR "${report}")
+        endif()
+    endif()
+endfunction()
@@ -0,0 +1,17 @@
+#
+# Setup the trace-event recorder.
+#
+# The AISDK_TRACE_SCOPE and AISDK_TRACE_INSTANT macros compile to nothing unless tracing is enabled. With tracing
+# enabled, spans are recorded between TraceEventRecorder::startTracing() and stopTracing() and written as Chrome
+# trace-event JSON, which can be opened in chrome://tracing or https://ui.perfetto.dev.
+#
+# To build with tracing, run the following command,
+#     cmake <path-to-source> -DAISDK_TRACING=ON
+#
+
+option(AISDK_TRACING "Enable the trace-event recorder macros." OFF)
+
+if(AISDK_TRACING)
+    message("Creating ${PROJECT_NAME} with trace-event recording")
+    add_definitions(-DAISDK_TRACING_ENABLED)
+endif()